@@ -0,0 +1,119 @@
+#!/bin/sh
+# 剖析引导 + 链接时优化 (PGO + LTO) 构建，并逐组件比较加速比
+# 用法: cmake/pgo_build.sh [阶段] [-- 额外的 cmake 参数]
+#   阶段 (默认 all)：
+#     baseline  $ROOT/baseline  -O3
+#     lto       $ROOT/lto       -O3 + LTO
+#     generate  $ROOT/pgo       -O3 + LTO + 插桩
+#     train     在 $ROOT/pgo 里跑训练负载，剖析数据写到 $ROOT/pgo/pgo-profile
+#     use       在同一目录用剖析数据重新构建
+#     compare   三个构建各跑一遍 bench_components，打印 ns/op 和相对基线的加速比
+#     all       以上全部
+#   环境变量：ROOT 构建根目录 (默认 build-pgo)，JOBS 并行数，REPEAT bench_components 的重复次数 (默认 5)
+#   例: cmake/pgo_build.sh all -- -DBUILD_SHARED_LIBS=OFF
+#
+# 剖析数据按目标文件的绝对路径命名，generate / train / use 必须用同一个构建目录。
+# 交叉编译 (-DCMAKE_TOOLCHAIN_FILE=cmake/toolchain-rpi.cmake) 时训练要在树莓派上跑：
+#   宿主机  cmake/pgo_build.sh generate -- -DCMAKE_TOOLCHAIN_FILE=...
+#   把 $ROOT/pgo 拷到树莓派上 *相同的绝对路径*，在那里跑 cmake/pgo_build.sh train，再把 pgo-profile 目录拷回
+#   宿主机  cmake/pgo_build.sh use
+# 训练负载只用离线回放 / 基准程序 (合成帧、仿真 IMU 和仿真总线、模拟舵机后端)，不需要硬件
+
+set -e
+
+ROOT=${ROOT:-build-pgo}
+JOBS=${JOBS:-$(nproc 2>/dev/null || echo 2)}
+REPEAT=${REPEAT:-5}
+SRC=$(cd "$(dirname "$0")/.." && pwd)
+
+PHASE=${1:-all}
+[ $# -gt 0 ] && shift
+[ "$1" = "--" ] && shift
+mkdir -p "$ROOT"
+ROOT=$(cd "$ROOT" && pwd)
+
+configure() {
+    # $1 目录，其后为该构建的选项
+    dir=$1
+    shift
+    cmake -S "$SRC" -B "$dir" -DCMAKE_BUILD_TYPE=Release "$@" $EXTRA >/dev/null
+    cmake --build "$dir" -j"$JOBS" >/dev/null
+    echo "built $dir"
+}
+
+# 基准自带的通过 / 失败判定与训练无关 (繁忙的主机上可能不满足)，非零返回只提示不中止
+run() {
+    echo "  $*"
+    "$@" >>"$log" 2>&1 || echo "    exit $?, profile still recorded"
+}
+
+train() {
+    b=$ROOT/pgo
+    data=$b/pgo-data
+    rm -rf "$b/pgo-profile" "$data"
+    mkdir -p "$data"
+    log=$data/train.log
+    cd "$b"
+    echo "training in $b (output in $log)"
+    # 各组件的固定工作量
+    run dart003/bench_components --repeat 1
+    # 检测：BGR / I420 / Bayer 三种判据、两级检测和多线程
+    run dart003/bench_detector --frames 200 --threads 2
+    # 检测器整定：合成录像 + 小网格 (I420 路径、ROI、降采样)
+    run dart003/detector_tune --synth "$data/synth.mwfr" --frames 300
+    run dart003/detector_tune --data "$data/synth.mwfr" --green 180,200 --diff 60,80 --sub 1,2 --roi 0,48 --passes 1 \
+        --config "$SRC/dart003/config/guidance.conf" --out "$data/tuned.conf"
+    run dart003/bench_bearing --points 20000
+    run dart003/bench_tracker 10 5
+    # IMU：滤波、预积分、传感器接口、多片 BMI088 采样和 SPI 总线调度
+    run dart003/bench_imu_filter --seconds 2
+    run dart003/bench_preint --seconds 5
+    run dart003/bench_sensor --samples 50000 --passes 4
+    run pi_bmi088/bench_multi_imu --seconds 0.5
+    run dart003/bench_spi_bus --seconds 1
+    # 端到端：合成相机 + 仿真 IMU + 模拟舵机，与 guidance_runtime 相同的任务链路
+    run dart003/bench_pipeline --seconds 3
+    run dart003/bench_governor --seconds 3
+    run dart003/servo_sim 1
+    cd - >/dev/null
+    echo "profile written to $b/pgo-profile"
+}
+
+compare() {
+    for v in baseline lto pgo; do
+        "$ROOT/$v/dart003/bench_components" --repeat "$REPEAT" >"$ROOT/$v.txt"
+    done
+    # 表头之后每行：组件名 ns/op 次数 checksum；表头之前是器件初始化的输出
+    awk '
+        FNR == 1 { table = 0 }
+        $1 == "component" { f++; row = 0; table = 1; next }
+        table && NF == 4 { row++; name[row] = $1; ns[f, row] = $2; if (row > n) n = row }
+        END {
+            printf "%-12s %12s %12s %12s %8s %8s\n", "component", "baseline", "lto", "pgo+lto", "lto", "pgo+lto"
+            for (i = 1; i <= n; i++)
+                printf "%-12s %12.1f %12.1f %12.1f %7.2fx %7.2fx\n", name[i], ns[1, i], ns[2, i], ns[3, i],
+                       ns[1, i] / ns[2, i], ns[1, i] / ns[3, i]
+        }' "$ROOT/baseline.txt" "$ROOT/lto.txt" "$ROOT/pgo.txt"
+}
+
+EXTRA="$*"
+case $PHASE in
+    baseline) configure "$ROOT/baseline" -DMILKYWAY_LTO=OFF -DMILKYWAY_PGO=off ;;
+    lto) configure "$ROOT/lto" -DMILKYWAY_LTO=ON -DMILKYWAY_PGO=off ;;
+    generate) configure "$ROOT/pgo" -DMILKYWAY_LTO=ON -DMILKYWAY_PGO=generate ;;
+    train) train ;;
+    use) configure "$ROOT/pgo" -DMILKYWAY_LTO=ON -DMILKYWAY_PGO=use ;;
+    compare) compare ;;
+    all)
+        configure "$ROOT/baseline" -DMILKYWAY_LTO=OFF -DMILKYWAY_PGO=off
+        configure "$ROOT/lto" -DMILKYWAY_LTO=ON -DMILKYWAY_PGO=off
+        configure "$ROOT/pgo" -DMILKYWAY_LTO=ON -DMILKYWAY_PGO=generate
+        train
+        configure "$ROOT/pgo" -DMILKYWAY_LTO=ON -DMILKYWAY_PGO=use
+        compare
+        ;;
+    *)
+        echo "unknown phase: $PHASE (baseline, lto, generate, train, use, compare, all)" >&2
+        exit 2
+        ;;
+esac
@@ -0,0 +1,53 @@
+# 树莓派交叉编译工具链
+#   cmake -S . -B build-pi -DCMAKE_TOOLCHAIN_FILE=cmake/toolchain-rpi.cmake -DPI_CPU=cortex-a53 -DPI_SYSROOT=/opt/rpi-sysroot
+# PI_CPU:     cortex-a7 (Pi 2，默认)、cortex-a53 (Pi 3 / Zero 2)、cortex-a72 (Pi 4)
+# PI_64BIT:   目标系统为 64 位 (aarch64)，默认 32 位 armhf
+# PI_SYSROOT: 从目标机拷出的 /usr 和 /lib (rsync -a pi:/usr pi:/lib 到同一目录)，pigpio、raspicam 在其中查找
+# 工具链前缀默认 arm-linux-gnueabihf- / aarch64-linux-gnu-，可用 PI_TOOLCHAIN_PREFIX 覆盖
+
+set(PI_CPU "cortex-a7" CACHE STRING "target core: cortex-a7, cortex-a53 or cortex-a72")
+option(PI_64BIT "target a 64-bit (aarch64) system" OFF)
+set(PI_SYSROOT "" CACHE PATH "target root filesystem")
+
+# try_compile 会在新的子工程里重新读本文件，把选项传过去
+set(CMAKE_TRY_COMPILE_PLATFORM_VARIABLES PI_CPU PI_64BIT PI_SYSROOT PI_TOOLCHAIN_PREFIX)
+
+set(CMAKE_SYSTEM_NAME Linux)
+if(PI_64BIT)
+    set(CMAKE_SYSTEM_PROCESSOR aarch64)
+    set(PI_DEFAULT_PREFIX aarch64-linux-gnu-)
+    set(PI_CPU_FLAGS "-mcpu=${PI_CPU}")
+else()
+    set(CMAKE_SYSTEM_PROCESSOR arm)
+    set(PI_DEFAULT_PREFIX arm-linux-gnueabihf-)
+    # Cortex-A7 只有 VFPv4 + NEON；A53 / A72 在 32 位下用 ARMv8 的 NEON
+    if(PI_CPU STREQUAL "cortex-a7")
+        set(PI_FPU neon-vfpv4)
+    else()
+        set(PI_FPU neon-fp-armv8)
+    endif()
+    set(PI_CPU_FLAGS "-mcpu=${PI_CPU} -mfpu=${PI_FPU} -mfloat-abi=hard")
+endif()
+
+if(NOT PI_TOOLCHAIN_PREFIX)
+    set(PI_TOOLCHAIN_PREFIX ${PI_DEFAULT_PREFIX})
+endif()
+set(CMAKE_C_COMPILER ${PI_TOOLCHAIN_PREFIX}gcc)
+set(CMAKE_CXX_COMPILER ${PI_TOOLCHAIN_PREFIX}g++)
+# LTO 需要与编译器配套的 ar / ranlib 插件版本
+set(CMAKE_AR ${PI_TOOLCHAIN_PREFIX}gcc-ar CACHE FILEPATH "")
+set(CMAKE_RANLIB ${PI_TOOLCHAIN_PREFIX}gcc-ranlib CACHE FILEPATH "")
+
+set(CMAKE_C_FLAGS_INIT "${PI_CPU_FLAGS}")
+set(CMAKE_CXX_FLAGS_INIT "${PI_CPU_FLAGS}")
+
+if(PI_SYSROOT)
+    set(CMAKE_SYSROOT ${PI_SYSROOT})
+    set(CMAKE_FIND_ROOT_PATH ${PI_SYSROOT})
+endif()
+
+# 程序 (编译器、工具) 在宿主机找，库和头文件只在目标系统里找
+set(CMAKE_FIND_ROOT_PATH_MODE_PROGRAM NEVER)
+set(CMAKE_FIND_ROOT_PATH_MODE_LIBRARY ONLY)
+set(CMAKE_FIND_ROOT_PATH_MODE_INCLUDE ONLY)
+set(CMAKE_FIND_ROOT_PATH_MODE_PACKAGE ONLY)
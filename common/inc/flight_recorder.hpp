@@ -0,0 +1,556 @@
+#ifndef FLIGHT_RECORDER_HPP
+#define FLIGHT_RECORDER_HPP
+
+#include "lockfree_channel.hpp"
+#include "rt_clock.hpp"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 飞行数据记录：生产者把定长、带时间戳的二进制记录写进各自的无锁环形队列，永不阻塞（满时丢弃并计数）；
+// 后台线程把记录编码后顺序写进预先分配好的内存映射文件，IMU 按流做差分 + 变长整数编码
+//
+// 文件格式 (小端)：FileHeader，从 kDataOffset 开始是编码后的记录，字节 0 (REC_END) 结束
+//   记录 := type(1) channel(1) zigzag-varint(dt) 负载
+//   dt 为同一 (type, channel) 流上一条记录以来的纳秒数，流的第一条相对 0
+//   REC_IMU 的负载为 7 个 zigzag-varint：gyro[3]、accel[3]、temp 相对该流上一个样本的差
+//   REC_TEXT 的负载为 varint 长度 + 字节，其余类型按结构体原样写入
+// 异常退出时 dataBytes 为 0，解码读到 REC_END 或文件末尾为止
+namespace flight {
+
+enum RecordType { REC_END = 0, REC_IMU, REC_DETECTION, REC_SERVO, REC_TEXT, REC_TYPE_COUNT };
+
+// 原始计数，物理量 = 计数 x FileHeader 中的 LSB
+struct ImuRecord {
+    int16_t gyro[3];
+    int16_t accel[3];
+    int16_t temp;                        // 传感器原始温度，没有时为 0
+};
+
+// 一帧检测结果：连通域数和面积最大的两个
+struct DetectionRecord {
+    int64_t captureNs;
+    uint32_t frameId;
+    int32_t count;
+    float cx[2], cy[2];
+    int32_t area[2];
+};
+
+struct ServoRecord {
+    float angle[4];                      // rad
+    uint16_t pulseUs[4];                 // 0 为未知
+};
+
+struct TextRecord {
+    char text[40];                       // 不要求以 0 结尾
+};
+
+struct Record {
+    int64_t tNs;
+    uint8_t type;                        // RecordType
+    uint8_t channel;                     // 同类记录的来源编号，例如第几个 IMU
+    uint16_t reserved;
+    union {
+        ImuRecord imu;
+        DetectionRecord detection;
+        ServoRecord servo;
+        TextRecord text;
+    };
+};
+
+const int kMaxProducers = 8;
+const uint32_t kRingSize = 2048;         // 每个生产者 2048 条，2 kHz 下够后台线程停顿 1 s
+const size_t kDataOffset = 4096;
+
+// BMI088 ±2000 dps、±12 g 量程的分辨率，与 pi_bmi088 的换算系数相同
+const float kDefaultGyroLsb = 0.0010652644f;   // rad/s
+const float kDefaultAccelLsb = 0.0035888672f;  // m/s^2
+
+struct FileHeader {
+    char magic[4];                       // "MWFL"
+    uint32_t version;
+    float gyroLsb, accelLsb;
+    uint32_t producerCount;
+    uint32_t reserved;
+    char producers[kMaxProducers][16];   // 生产者名称
+    uint64_t dataBytes;                  // 编码数据长度，正常关闭时写入
+    uint64_t records;                    // 已写入的记录数
+    uint64_t dropped;                    // 生产者队列满丢弃的记录数
+    uint64_t lost;                       // 文件写满后丢弃的记录数
+};
+
+namespace detail {
+
+inline uint64_t zigzag(int64_t v) {
+    return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+}
+
+inline int64_t unzigzag(uint64_t v) {
+    return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+}
+
+inline uint8_t* putVarint(uint8_t* p, uint64_t v) {
+    while (v >= 0x80) {
+        *p++ = static_cast<uint8_t>(v | 0x80);
+        v >>= 7;
+    }
+    *p++ = static_cast<uint8_t>(v);
+    return p;
+}
+
+inline bool getVarint(const uint8_t*& p, const uint8_t* end, uint64_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 64 && p < end; shift += 7) {
+        uint8_t b = *p++;
+        v |= static_cast<uint64_t>(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+inline size_t payloadBytes(int type) {
+    return type == REC_DETECTION ? sizeof(DetectionRecord) : type == REC_SERVO ? sizeof(ServoRecord) : 0;
+}
+
+// 编码器和解码器共用的流状态
+struct StreamState {
+    int64_t lastNs[REC_TYPE_COUNT][256];
+    int16_t lastImu[256][7];
+
+    void reset() { std::memset(this, 0, sizeof(*this)); }
+};
+
+inline int16_t quantize(float v, float lsb) {
+    float c = std::round(v / lsb);
+    return static_cast<int16_t>(std::max(-32768.0f, std::min(32767.0f, c)));
+}
+
+} // namespace detail
+
+class FlightRecorder;
+
+// 一个写线程一个；push 只写本生产者的环形队列，不加锁、不分配、不做系统调用
+class FlightProducer {
+public:
+    bool push(const Record& r) { return ring.push(r); }
+
+    bool imu(int64_t tNs, int channel, const ImuRecord& s) {
+        Record r = make(tNs, REC_IMU, channel);
+        r.imu = s;
+        return push(r);
+    }
+
+    // 物理量按文件的 LSB 量化；来自 BMI088 换算值时与原始计数一致
+    bool imu(int64_t tNs, int channel, const float (&gyro)[3], const float (&accel)[3]) {
+        Record r = make(tNs, REC_IMU, channel);
+        for (int i = 0; i < 3; i++) {
+            r.imu.gyro[i] = detail::quantize(gyro[i], gyroLsb);
+            r.imu.accel[i] = detail::quantize(accel[i], accelLsb);
+        }
+        r.imu.temp = 0;
+        return push(r);
+    }
+
+    bool detection(int64_t tNs, int channel, const DetectionRecord& d) {
+        Record r = make(tNs, REC_DETECTION, channel);
+        r.detection = d;
+        return push(r);
+    }
+
+    bool servo(int64_t tNs, int channel, const ServoRecord& s) {
+        Record r = make(tNs, REC_SERVO, channel);
+        r.servo = s;
+        return push(r);
+    }
+
+    bool text(int64_t tNs, int channel, const char* s) {
+        Record r = make(tNs, REC_TEXT, channel);
+        std::strncpy(r.text.text, s, sizeof(r.text.text));
+        return push(r);
+    }
+
+    uint32_t dropped() const { return ring.droppedCount(); }
+    const char* name() const { return label; }
+
+private:
+    friend class FlightRecorder;
+    SpscRing<Record, kRingSize> ring;
+    float gyroLsb, accelLsb;
+    char label[16];
+
+    static Record make(int64_t tNs, int type, int channel) {
+        Record r;
+        std::memset(&r, 0, sizeof(r));
+        r.tNs = tNs;
+        r.type = static_cast<uint8_t>(type);
+        r.channel = static_cast<uint8_t>(channel);
+        return r;
+    }
+};
+
+class FlightRecorder {
+public:
+    FlightRecorder()
+        : fd(-1), map(nullptr), capacity(0), windowBytes(0), lockBegin(0), lockEnd(0), pos(0), producerCount(0),
+          running(false), records(0), lost(0) {
+        for (auto& p : producers) p = nullptr;
+    }
+
+    ~FlightRecorder() {
+        close();
+        for (auto& p : producers) {
+            if (!p) continue;
+            p->~FlightProducer();
+            std::free(p);
+        }
+    }
+
+    FlightRecorder(const FlightRecorder&) = delete;
+    FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+    // 进程 mlockall 时调用 (open 之前)：映射本身不锁定，只锁住文件头和写入位置前后 bytes 字节的窗口，
+    // 由写线程随写入前移；0 为整个映射都不锁定
+    void lockWindow(size_t bytes) { windowBytes = bytes; }
+
+    // 创建并预分配 capacityBytes 字节的文件，映射进内存
+    bool open(const std::string& path, size_t capacityBytes, std::string& err, float gyroLsb = kDefaultGyroLsb,
+              float accelLsb = kDefaultAccelLsb) {
+        close();
+        capacity = std::max(capacityBytes, kDataOffset + 4096);
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            err = path + ": " + std::strerror(errno);
+            return false;
+        }
+        // posix_fallocate 真正分配磁盘块，写入时不会因空间不足产生 SIGBUS；不支持时退回 ftruncate
+        int rc = posix_fallocate(fd, 0, static_cast<off_t>(capacity));
+        if (rc != 0 && ftruncate(fd, static_cast<off_t>(capacity)) != 0) rc = errno;
+        else rc = 0;
+        // mlockall(MCL_FUTURE) 会把新映射整体锁定并读入内存：先以 PROT_NONE 映射 (锁定时不缺页)，
+        // 解除锁定后再开放读写，常驻的只有 lockWindow 的窗口
+        void* m = rc == 0 ? mmap(nullptr, capacity, PROT_NONE, MAP_SHARED, fd, 0) : MAP_FAILED;
+        if (m != MAP_FAILED && (munlock(m, capacity) != 0 || mprotect(m, capacity, PROT_READ | PROT_WRITE) != 0)) {
+            rc = errno;
+            munmap(m, capacity);
+            m = MAP_FAILED;
+        }
+        if (m == MAP_FAILED) {
+            err = path + ": " + std::strerror(rc ? rc : errno);
+            ::close(fd);
+            fd = -1;
+            return false;
+        }
+        map = static_cast<uint8_t*>(m);
+        madvise(map, capacity, MADV_SEQUENTIAL);
+        FileHeader& h = header();
+        std::memset(&h, 0, sizeof(h));
+        std::memcpy(h.magic, "MWFL", 4);
+        h.version = 1;
+        h.gyroLsb = gyroLsb;
+        h.accelLsb = accelLsb;
+        // 重新打开时沿用已登记的生产者
+        int n = producerCount.load(std::memory_order_acquire);
+        for (int i = 0; i < n; i++) {
+            std::strncpy(h.producers[i], producers[i]->label, sizeof(h.producers[i]));
+            producers[i]->gyroLsb = gyroLsb;
+            producers[i]->accelLsb = accelLsb;
+        }
+        h.producerCount = static_cast<uint32_t>(n);
+        pos = 0;
+        records = lost = 0;
+        state.reset();
+        lockBegin = lockEnd = 0;
+        if (windowBytes) {
+            mlock(map, kDataOffset);
+            slideLock();
+        }
+        return true;
+    }
+
+    // 初始化时调用，每个写线程取一个；超过 kMaxProducers 返回 nullptr
+    FlightProducer* producer(const std::string& name) {
+        std::lock_guard<std::mutex> lock(registerMutex);
+        int n = producerCount.load(std::memory_order_relaxed);
+        if (n == kMaxProducers || !map) return nullptr;
+        // 队列成员按缓存行对齐，C++11 的 new 不保证
+        void* mem = nullptr;
+        if (posix_memalign(&mem, 64, sizeof(FlightProducer)) != 0) return nullptr;
+        FlightProducer* p = new (mem) FlightProducer();
+        p->gyroLsb = header().gyroLsb;
+        p->accelLsb = header().accelLsb;
+        std::strncpy(p->label, name.c_str(), sizeof(p->label) - 1);
+        p->label[sizeof(p->label) - 1] = 0;
+        std::strncpy(header().producers[n], p->label, sizeof(header().producers[n]));
+        producers[n] = p;
+        header().producerCount = static_cast<uint32_t>(n + 1);
+        producerCount.store(n + 1, std::memory_order_release);
+        return p;
+    }
+
+    // 后台线程每 pollNs 取一次所有队列，普通调度优先级
+    void start(int64_t pollNs = 2000000) {
+        if (!map || running) return;
+        running = true;
+        writer = std::thread([this, pollNs] {
+            pthread_setname_np(pthread_self(), "recorder");
+            int64_t next = monotonicNs();
+            int64_t nextSync = next + 1000000000LL;
+            while (running.load(std::memory_order_acquire)) {
+                drain();
+                slideLock();
+                next += pollNs;
+                int64_t now = monotonicNs();
+                if (now >= nextSync) {
+                    // 定期刷写统计并异步落盘，断电时最多丢最近 1 s
+                    updateHeader(false);
+                    msync(map, kDataOffset + pos, MS_ASYNC);
+                    nextSync = now + 1000000000LL;
+                }
+                if (next < now) next = now;
+                sleepUntilNs(next);
+            }
+        });
+    }
+
+    // 停止后台线程，写完队列里剩下的记录，截掉未用的预分配空间
+    void close() {
+        if (running) {
+            running = false;
+            writer.join();
+        }
+        if (!map) return;
+        drain();
+        updateHeader(true);
+        msync(map, kDataOffset + pos, MS_SYNC);
+        munmap(map, capacity);
+        map = nullptr;
+        if (ftruncate(fd, static_cast<off_t>(kDataOffset + pos + 1)) != 0) {
+            std::perror("flight recorder ftruncate");
+        }
+        ::close(fd);
+        fd = -1;
+    }
+
+    bool isOpen() const { return map != nullptr; }
+    uint64_t recordCount() const { return records.load(std::memory_order_relaxed); }
+    uint64_t lostCount() const { return lost.load(std::memory_order_relaxed); }
+    uint64_t bytesWritten() const { return pos.load(std::memory_order_relaxed); }
+    uint64_t droppedCount() const {
+        uint64_t d = 0;
+        int n = producerCount.load(std::memory_order_acquire);
+        for (int i = 0; i < n; i++) d += producers[i]->dropped();
+        return d;
+    }
+
+private:
+    int fd;
+    uint8_t* map;
+    size_t capacity;
+    size_t windowBytes;
+    size_t lockBegin, lockEnd;           // 已锁定的数据区 [lockBegin, lockEnd)，相对 kDataOffset
+    std::atomic<size_t> pos;             // 只由写线程修改
+    FlightProducer* producers[kMaxProducers];
+    std::atomic<int> producerCount;
+    std::mutex registerMutex;
+    std::thread writer;
+    std::atomic<bool> running;
+    std::atomic<uint64_t> records, lost;
+    detail::StreamState state;
+
+    FileHeader& header() { return *reinterpret_cast<FileHeader*>(map); }
+
+    void updateHeader(bool closing) {
+        FileHeader& h = header();
+        h.records = records.load(std::memory_order_relaxed);
+        h.dropped = droppedCount();
+        h.lost = lost.load(std::memory_order_relaxed);
+        if (closing) h.dataBytes = pos.load(std::memory_order_relaxed);
+    }
+
+    // 写入位置进入锁定窗口的后半段时，窗口前移半个窗口：先锁前面的新页，再解锁已写过的旧页
+    void slideLock() {
+        if (!windowBytes) return;
+        const size_t page = 4096;
+        size_t half = std::max(page, (windowBytes / 2 + page - 1) / page * page);
+        size_t dataCap = capacity - kDataOffset;
+        if (lockEnd == 0) {
+            lockEnd = std::min(2 * half, dataCap);
+            mlock(map + kDataOffset, lockEnd);
+        }
+        size_t at = pos.load(std::memory_order_relaxed);
+        while (at + half > lockEnd && lockEnd < dataCap) {
+            size_t next = std::min(lockEnd + half, dataCap);
+            mlock(map + kDataOffset + lockEnd, next - lockEnd);
+            munlock(map + kDataOffset + lockBegin, half);
+            lockBegin += half;
+            lockEnd = next;
+        }
+    }
+
+    void drain() {
+        int n = producerCount.load(std::memory_order_acquire);
+        Record r;
+        for (int i = 0; i < n; i++) {
+            // 每轮最多取一个队列长度，单个生产者写得再快也不会饿死其他队列
+            for (uint32_t k = 0; k < kRingSize && producers[i]->ring.pop(r); k++) encode(r);
+        }
+    }
+
+    void encode(const Record& r) {
+        const size_t maxBytes = 2 + 10 + 1 + sizeof(TextRecord) + sizeof(DetectionRecord);
+        size_t at = pos.load(std::memory_order_relaxed);
+        if (r.type == REC_END || r.type >= REC_TYPE_COUNT) return;
+        // 留一个字节给结尾的 REC_END
+        if (kDataOffset + at + maxBytes + 1 > capacity) {
+            lost.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        uint8_t* start = map + kDataOffset + at;
+        uint8_t* p = start;
+        *p++ = r.type;
+        *p++ = r.channel;
+        int64_t& last = state.lastNs[r.type][r.channel];
+        p = detail::putVarint(p, detail::zigzag(r.tNs - last));
+        last = r.tNs;
+        switch (r.type) {
+        case REC_IMU: {
+            int16_t* prev = state.lastImu[r.channel];
+            const int16_t v[7] = {r.imu.gyro[0],  r.imu.gyro[1],  r.imu.gyro[2], r.imu.accel[0],
+                                  r.imu.accel[1], r.imu.accel[2], r.imu.temp};
+            for (int i = 0; i < 7; i++) {
+                p = detail::putVarint(p, detail::zigzag(static_cast<int64_t>(v[i]) - prev[i]));
+                prev[i] = v[i];
+            }
+            break;
+        }
+        case REC_TEXT: {
+            size_t len = strnlen(r.text.text, sizeof(r.text.text));
+            p = detail::putVarint(p, len);
+            std::memcpy(p, r.text.text, len);
+            p += len;
+            break;
+        }
+        default: {
+            size_t len = detail::payloadBytes(r.type);
+            std::memcpy(p, &r.detection, len);
+            p += len;
+            break;
+        }
+        }
+        pos.store(at + (p - start), std::memory_order_relaxed);
+        records.fetch_add(1, std::memory_order_relaxed);
+    }
+};
+
+// 离线读取记录文件，整文件读进内存逐条解码
+class FlightReader {
+public:
+    bool open(const std::string& path, std::string& err) {
+        FILE* f = std::fopen(path.c_str(), "rb");
+        if (!f) {
+            err = path + ": " + std::strerror(errno);
+            return false;
+        }
+        std::fseek(f, 0, SEEK_END);
+        long size = std::ftell(f);
+        std::fseek(f, 0, SEEK_SET);
+        data.resize(size > 0 ? static_cast<size_t>(size) : 0);
+        size_t got = data.empty() ? 0 : std::fread(data.data(), 1, data.size(), f);
+        std::fclose(f);
+        if (got < kDataOffset || std::memcmp(data.data(), "MWFL", 4) != 0) {
+            err = path + ": 不是飞行记录文件";
+            return false;
+        }
+        std::memcpy(&head, data.data(), sizeof(head));
+        if (head.version != 1) {
+            err = path + ": 不支持的版本 " + std::to_string(head.version);
+            return false;
+        }
+        end = data.size();
+        if (head.dataBytes > 0) end = std::min(end, static_cast<size_t>(kDataOffset + head.dataBytes));
+        pos = kDataOffset;
+        corrupt = false;
+        state.reset();
+        return true;
+    }
+
+    const FileHeader& header() const { return head; }
+
+    // 解码下一条记录，结束或数据损坏时返回 false
+    bool next(Record& r) {
+        const uint8_t* p = data.data() + pos;
+        const uint8_t* e = data.data() + end;
+        if (p + 2 > e || *p == REC_END) return false;
+        std::memset(&r, 0, sizeof(r));
+        r.type = *p++;
+        r.channel = *p++;
+        uint64_t v;
+        if (r.type >= REC_TYPE_COUNT || !detail::getVarint(p, e, v)) return fail();
+        int64_t& last = state.lastNs[r.type][r.channel];
+        last += detail::unzigzag(v);
+        r.tNs = last;
+        switch (r.type) {
+        case REC_IMU: {
+            int16_t* prev = state.lastImu[r.channel];
+            for (int i = 0; i < 7; i++) {
+                if (!detail::getVarint(p, e, v)) return fail();
+                prev[i] = static_cast<int16_t>(prev[i] + detail::unzigzag(v));
+            }
+            std::memcpy(r.imu.gyro, prev, sizeof(r.imu.gyro));
+            std::memcpy(r.imu.accel, prev + 3, sizeof(r.imu.accel));
+            r.imu.temp = prev[6];
+            break;
+        }
+        case REC_TEXT:
+            if (!detail::getVarint(p, e, v) || v > sizeof(r.text.text) || p + v > e) return fail();
+            std::memcpy(r.text.text, p, v);
+            p += v;
+            break;
+        default: {
+            size_t len = detail::payloadBytes(r.type);
+            if (p + len > e) return fail();
+            std::memcpy(&r.detection, p, len);
+            p += len;
+            break;
+        }
+        }
+        pos = p - data.data();
+        return true;
+    }
+
+    // next() 因数据不完整而停止
+    bool truncated() const { return corrupt; }
+    size_t offset() const { return pos; }
+
+private:
+    std::vector<uint8_t> data;
+    FileHeader head;
+    size_t pos = 0, end = 0;
+    bool corrupt = false;
+    detail::StreamState state;
+
+    bool fail() {
+        corrupt = true;
+        return false;
+    }
+};
+
+} // namespace flight
+
+#endif
@@ -0,0 +1,381 @@
+#ifndef IMU_FILTER_HPP
+#define IMU_FILTER_HPP
+
+#include "imu_sensor.hpp"
+#include "simd_f32.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// IMU 软件滤波：低通 / 陷波二阶节级联，陀螺三轴和加速度计三轴放进 8 个通道，
+// 每级用两个 4 路向量同时算完 6 个轴，样本从第一级到最后一级都留在寄存器里。
+// 二阶节是递归的，单个样本逐级串行；按样本外层、级内层排列时相邻样本的不同级可以重叠执行，
+// 所以批量处理也按样本顺序走，不逐级扫整批。
+// 可选的振动峰检测对原始陀螺做滑动 FFT，按找到的峰值频率重调动态陷波。
+// configure 时分配，之后 process / feed 不分配
+namespace imufilter {
+
+const int kLanes = 8;                    // gyro x y z, accel x y z, 两个空位
+const int kMaxStages = 8;
+
+enum StageType { STAGE_LOWPASS, STAGE_NOTCH };
+
+enum { AXES_GYRO = 1, AXES_ACCEL = 2, AXES_ALL = 3 };
+
+struct StageConfig {
+    int type = STAGE_LOWPASS;
+    int axes = AXES_GYRO;
+    float hz = 100.0f;                   // 低通截止 / 陷波中心频率
+    float q = 0.70710678f;
+    int harmonic = 0;                    // 仅陷波：>0 时按 harmonic x 振动峰频率动态重调
+};
+
+// 直接 II 型转置的系数，a0 归一化为 1 (RBJ 公式)
+struct Biquad {
+    float b0, b1, b2, a1, a2;
+
+    static Biquad identity() { return Biquad{1.0f, 0.0f, 0.0f, 0.0f, 0.0f}; }
+
+    static Biquad lowPass(float fs, float fc, float q) {
+        double w = 2.0 * M_PI * clampHz(fs, fc) / fs, c = std::cos(w), alpha = std::sin(w) / (2.0 * q);
+        double a0 = 1.0 + alpha;
+        return make((1.0 - c) / 2.0 / a0, (1.0 - c) / a0, (1.0 - c) / 2.0 / a0, -2.0 * c / a0, (1.0 - alpha) / a0);
+    }
+
+    static Biquad notch(float fs, float f0, float q) {
+        double w = 2.0 * M_PI * clampHz(fs, f0) / fs, c = std::cos(w), alpha = std::sin(w) / (2.0 * q);
+        double a0 = 1.0 + alpha;
+        return make(1.0 / a0, -2.0 * c / a0, 1.0 / a0, -2.0 * c / a0, (1.0 - alpha) / a0);
+    }
+
+private:
+    static double clampHz(float fs, float f) { return std::max(1e-3 * fs, std::min(0.45 * fs, static_cast<double>(f))); }
+    static Biquad make(double b0, double b1, double b2, double a1, double a2) {
+        return Biquad{static_cast<float>(b0), static_cast<float>(b1), static_cast<float>(b2), static_cast<float>(a1),
+                      static_cast<float>(a2)};
+    }
+};
+
+// "lpf gyro 150; notch gyro 180 q=4 harmonic=1; lpf accel 40"
+//   类型 lpf / notch，轴 gyro / accel / all，频率 Hz，可选 q=、harmonic= (仅 notch)
+inline bool parseStages(const std::string& text, std::vector<StageConfig>& stages, std::string& err) {
+    std::vector<StageConfig> out;
+    std::stringstream all(text);
+    std::string item;
+    while (std::getline(all, item, ';')) {
+        std::stringstream fields(item);
+        std::string type, axes, hz, kv;
+        if (!(fields >> type)) continue;
+        StageConfig s;
+        char* end = nullptr;
+        if (!(fields >> axes >> hz) || (type != "lpf" && type != "notch")) {
+            err = "滤波级 \"" + item + "\" 应为 lpf|notch gyro|accel|all 频率 [q=..] [harmonic=..]";
+            return false;
+        }
+        s.type = type == "lpf" ? STAGE_LOWPASS : STAGE_NOTCH;
+        s.axes = axes == "gyro" ? AXES_GYRO : axes == "accel" ? AXES_ACCEL : axes == "all" ? AXES_ALL : 0;
+        s.hz = std::strtof(hz.c_str(), &end);
+        if (!s.axes || *end || s.hz <= 0.0f) {
+            err = "滤波级 \"" + item + "\"：轴为 gyro、accel 或 all，频率为正";
+            return false;
+        }
+        if (s.type == STAGE_NOTCH) s.q = 3.0f;
+        while (fields >> kv) {
+            size_t eq = kv.find('=');
+            std::string key = kv.substr(0, eq);
+            double v = eq == std::string::npos ? 0.0 : std::strtod(kv.c_str() + eq + 1, &end);
+            if (eq == std::string::npos || *end || v <= 0.0) {
+                err = "滤波级 \"" + kv + "\" 应为 键=正数";
+                return false;
+            }
+            if (key == "q") s.q = static_cast<float>(v);
+            else if (key == "harmonic" && s.type == STAGE_NOTCH) s.harmonic = static_cast<int>(v);
+            else {
+                err = "滤波级 \"" + kv + "\"：只支持 q，陷波另有 harmonic";
+                return false;
+            }
+        }
+        out.push_back(s);
+    }
+    if (out.size() > static_cast<size_t>(kMaxStages)) {
+        err = "滤波级最多 " + std::to_string(kMaxStages) + " 个";
+        return false;
+    }
+    stages.swap(out);
+    return true;
+}
+
+class FilterBank {
+public:
+    FilterBank() : count(0), fs(0.0f) { reset(); }
+
+    bool configure(const std::vector<StageConfig>& stages, float sampleHz, std::string& err) {
+        if (stages.size() > static_cast<size_t>(kMaxStages) || sampleHz <= 0.0f) {
+            err = "滤波器：最多 " + std::to_string(kMaxStages) + " 级，采样率为正";
+            return false;
+        }
+        fs = sampleHz;
+        count = static_cast<int>(stages.size());
+        std::copy(stages.begin(), stages.end(), cfg);
+        for (int i = 0; i < count; i++) retune(i, cfg[i].hz);
+        reset();
+        return true;
+    }
+
+    int size() const { return count; }
+    float sampleHz() const { return fs; }
+    const StageConfig& stage(int i) const { return cfg[i]; }
+
+    // 改一级的频率，保留状态，下一个样本起生效
+    void retune(int i, float hz) {
+        StageConfig& s = cfg[i];
+        s.hz = hz;
+        Biquad c = s.type == STAGE_LOWPASS ? Biquad::lowPass(fs, hz, s.q) : Biquad::notch(fs, hz, s.q);
+        Biquad id = Biquad::identity();
+        for (int l = 0; l < kLanes; l++) {
+            bool on = l < 3 ? (s.axes & AXES_GYRO) : l < 6 ? (s.axes & AXES_ACCEL) : false;
+            const Biquad& k = on ? c : id;
+            coef[i].b0[l] = k.b0;
+            coef[i].b1[l] = k.b1;
+            coef[i].b2[l] = k.b2;
+            coef[i].na1[l] = -k.a1;
+            coef[i].na2[l] = -k.a2;
+        }
+    }
+
+    void reset() { std::memset(state, 0, sizeof(state)); }
+
+    void process(float (&gyro)[3], float (&accel)[3]) {
+        using namespace simd;
+        F32x4 xl = setF32(gyro[0], gyro[1], gyro[2], accel[0]), xh = setF32(accel[1], accel[2], 0.0f, 0.0f);
+        runSample(xl, xh);
+        float x[kLanes];
+        storeF32(x, xl);
+        storeF32(x + 4, xh);
+        unpack(x, gyro, accel);
+    }
+
+    // 一批按时间排列的样本；样本应同时带陀螺和加速度
+    void process(sensor::ImuSample* s, int n) {
+        for (int k = 0; k < n; k++) process(s[k].gyro, s[k].accel);
+    }
+
+    // 逐通道标量实现，与 process 共用系数和状态，用于对照和基准
+    void processScalar(float (&gyro)[3], float (&accel)[3]) {
+        float x[kLanes];
+        pack(x, gyro, accel);
+        for (int i = 0; i < count; i++) {
+            const Coeffs& c = coef[i];
+            State& z = state[i];
+            for (int l = 0; l < kLanes; l++) {
+                float y = z.z1[l] + c.b0[l] * x[l];
+                float b1x = c.b1[l] * x[l];
+                float na1y = c.na1[l] * y;
+                z.z1[l] = z.z2[l] + b1x + na1y;
+                float b2x = c.b2[l] * x[l];
+                float na2y = c.na2[l] * y;
+                z.z2[l] = b2x + na2y;
+                x[l] = y;
+            }
+        }
+        unpack(x, gyro, accel);
+    }
+
+private:
+    struct Coeffs {
+        float b0[kLanes], b1[kLanes], b2[kLanes], na1[kLanes], na2[kLanes];   // na = -a
+    };
+    struct State {
+        float z1[kLanes], z2[kLanes];
+    };
+
+    StageConfig cfg[kMaxStages];
+    Coeffs coef[kMaxStages];
+    State state[kMaxStages];
+    int count;
+    float fs;
+
+    static void pack(float* x, const float (&gyro)[3], const float (&accel)[3]) {
+        x[0] = gyro[0];
+        x[1] = gyro[1];
+        x[2] = gyro[2];
+        x[3] = accel[0];
+        x[4] = accel[1];
+        x[5] = accel[2];
+        x[6] = x[7] = 0.0f;
+    }
+
+    static void unpack(const float* x, float (&gyro)[3], float (&accel)[3]) {
+        gyro[0] = x[0];
+        gyro[1] = x[1];
+        gyro[2] = x[2];
+        accel[0] = x[3];
+        accel[1] = x[4];
+        accel[2] = x[5];
+    }
+
+    // 一个样本依次过所有级，样本在寄存器里不落回内存
+    void runSample(simd::F32x4& xl, simd::F32x4& xh) {
+        using namespace simd;
+        for (int i = 0; i < count; i++) {
+            const Coeffs& c = coef[i];
+            State& st = state[i];
+            F32x4 z1l = loadF32(st.z1), z1h = loadF32(st.z1 + 4);
+            F32x4 yl = mla(z1l, loadF32(c.b0), xl), yh = mla(z1h, loadF32(c.b0 + 4), xh);
+            storeF32(st.z1, mla(mla(loadF32(st.z2), loadF32(c.b1), xl), loadF32(c.na1), yl));
+            storeF32(st.z1 + 4, mla(mla(loadF32(st.z2 + 4), loadF32(c.b1 + 4), xh), loadF32(c.na1 + 4), yh));
+            storeF32(st.z2, mla(mul(loadF32(c.b2), xl), loadF32(c.na2), yl));
+            storeF32(st.z2 + 4, mla(mul(loadF32(c.b2 + 4), xh), loadF32(c.na2 + 4), yh));
+            xl = yl;
+            xh = yh;
+        }
+    }
+};
+
+struct PeakConfig {
+    int fftSize = 256;                   // 2 的幂，16 ~ 4096
+    int hop = 32;                        // 每 hop 个样本做一次 FFT，三轴轮流
+    float minHz = 80.0f;                 // 搜索范围
+    float maxHz = 400.0f;
+    float minSnr = 8.0f;                 // 峰值功率 / 范围内平均功率，低于它不更新
+    float smoothing = 0.3f;              // 峰值频率的一阶平滑系数，1 = 不平滑
+};
+
+// 原始陀螺 -> 振动峰频率。每次 FFT 只算一个轴 (汉宁窗，去均值)，三轴的功率谱相加后找峰，
+// 抛物线插值到子频点；一次 feed 最多做一次 N 点复数 FFT
+class PeakFinder {
+public:
+    PeakFinder() : n(0), fs(0.0f), pos(0), filled(0), sinceHop(0), axis(0), kMin(0), kMax(0), hz(0.0f), lastSnr(0.0f),
+                   found(0) {}
+
+    bool configure(const PeakConfig& c, float sampleHz, std::string& err) {
+        if (c.fftSize < 16 || c.fftSize > 4096 || (c.fftSize & (c.fftSize - 1)) || c.hop <= 0 || sampleHz <= 0.0f) {
+            err = "振动峰检测：fft_size 为 16 ~ 4096 的 2 的幂，hop 为正";
+            return false;
+        }
+        cfg = c;
+        n = c.fftSize;
+        fs = sampleHz;
+        kMin = std::max(1, static_cast<int>(std::ceil(c.minHz * n / fs)));
+        kMax = std::min(n / 2 - 2, static_cast<int>(std::floor(c.maxHz * n / fs)));
+        if (kMax - kMin < 2) {
+            err = "振动峰检测：搜索范围内不足 3 个频点，增大 fft_size 或放宽 min_hz / max_hz";
+            return false;
+        }
+        for (int a = 0; a < 3; a++) {
+            ring[a].assign(n, 0.0f);
+            power[a].assign(n / 2, 0.0f);
+        }
+        re.assign(n, 0.0f);
+        im.assign(n, 0.0f);
+        window.resize(n);
+        for (int i = 0; i < n; i++) window[i] = static_cast<float>(0.5 - 0.5 * std::cos(2.0 * M_PI * i / n));
+        cosTable.resize(n / 2);
+        sinTable.resize(n / 2);
+        for (int i = 0; i < n / 2; i++) {
+            cosTable[i] = static_cast<float>(std::cos(2.0 * M_PI * i / n));
+            sinTable[i] = static_cast<float>(-std::sin(2.0 * M_PI * i / n));
+        }
+        bitrev.resize(n);
+        int bits = 0;
+        while ((1 << bits) < n) bits++;
+        for (int i = 0; i < n; i++) {
+            int r = 0;
+            for (int b = 0; b < bits; b++) r |= ((i >> b) & 1) << (bits - 1 - b);
+            bitrev[i] = r;
+        }
+        pos = filled = sinceHop = axis = 0;
+        hz = lastSnr = 0.0f;
+        found = 0;
+        return true;
+    }
+
+    // 送入一个原始陀螺样本；峰值频率有更新时返回 true
+    bool feed(const float (&gyro)[3]) {
+        if (!n) return false;
+        for (int a = 0; a < 3; a++) ring[a][pos] = gyro[a];
+        pos = (pos + 1) & (n - 1);
+        if (filled < n) filled++;
+        if (++sinceHop < cfg.hop || filled < n) return false;
+        sinceHop = 0;
+        spectrum(axis);
+        axis = (axis + 1) % 3;
+        return findPeak();
+    }
+
+    float peakHz() const { return hz; }
+    float snr() const { return lastSnr; }
+    uint64_t updates() const { return found; }
+
+private:
+    PeakConfig cfg;
+    int n;
+    float fs;
+    std::vector<float> ring[3];
+    std::vector<float> power[3];
+    std::vector<float> re, im, window, cosTable, sinTable;
+    std::vector<int> bitrev;
+    int pos, filled, sinceHop, axis;
+    int kMin, kMax;
+    float hz, lastSnr;
+    uint64_t found;
+
+    void spectrum(int a) {
+        const std::vector<float>& r = ring[a];
+        float mean = 0.0f;
+        for (int i = 0; i < n; i++) mean += r[i];
+        mean /= n;
+        // 最老的样本在 pos，按时间顺序取出并按位反转放置
+        for (int i = 0; i < n; i++) {
+            re[bitrev[i]] = (r[(pos + i) & (n - 1)] - mean) * window[i];
+            im[bitrev[i]] = 0.0f;
+        }
+        for (int len = 2; len <= n; len <<= 1) {
+            int half = len >> 1, step = n / len;
+            for (int i = 0; i < n; i += len) {
+                for (int j = 0; j < half; j++) {
+                    float wr = cosTable[j * step], wi = sinTable[j * step];
+                    int p = i + j, q = p + half;
+                    float tr = re[q] * wr - im[q] * wi;
+                    float ti = re[q] * wi + im[q] * wr;
+                    re[q] = re[p] - tr;
+                    im[q] = im[p] - ti;
+                    re[p] += tr;
+                    im[p] += ti;
+                }
+            }
+        }
+        for (int k = kMin - 1; k <= kMax + 1; k++) power[a][k] = re[k] * re[k] + im[k] * im[k];
+    }
+
+    float total(int k) const { return power[0][k] + power[1][k] + power[2][k]; }
+
+    bool findPeak() {
+        int best = kMin;
+        float sum = 0.0f;
+        for (int k = kMin; k <= kMax; k++) {
+            float p = total(k);
+            sum += p;
+            if (p > total(best)) best = k;
+        }
+        float mean = sum / (kMax - kMin + 1);
+        lastSnr = mean > 0.0f ? total(best) / mean : 0.0f;
+        if (lastSnr < cfg.minSnr) return false;
+        float l = total(best - 1), c = total(best), r = total(best + 1);
+        float den = l - 2.0f * c + r;
+        float delta = den != 0.0f ? 0.5f * (l - r) / den : 0.0f;
+        float f = (best + std::max(-0.5f, std::min(0.5f, delta))) * fs / n;
+        hz = found ? hz + cfg.smoothing * (f - hz) : f;
+        found++;
+        return true;
+    }
+};
+
+} // namespace imufilter
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef IMU_REPLAY_HPP
+#define IMU_REPLAY_HPP
+
+#include "flight_recorder.hpp"
+#include "imu_sensor.hpp"
+
+#include <string>
+#include <vector>
+
+// 飞行记录 <-> ImuSensor：记录一侧对任意传感器的样本只写一份，回放一侧把记录文件当作传感器
+namespace sensor {
+
+// 有陀螺和加速度的样本写成一条 REC_IMU，按文件的 LSB 量化
+inline bool logSample(flight::FlightProducer& log, const ImuSample& s) {
+    if (!s.has(SAMPLE_GYRO | SAMPLE_ACCEL)) return false;
+    return log.imu(s.tNs, s.channel, s.gyro, s.accel);
+}
+
+// 回放记录文件中某个通道的 IMU 样本，不按时间节拍，read() 立即返回下一条，用于基准和离线调参。
+// open 时整段解码进内存，之后 read 只是拷贝；读完返回 SENSOR_END，rewind() 从头再来
+class ReplayImuSensor : public ImuSensor<ReplayImuSensor> {
+public:
+    explicit ReplayImuSensor(const std::string& path, int channel = 0) : path(path), channel(channel), pos(0) {}
+
+    bool openImpl(std::string& err) {
+        flight::FlightReader reader;
+        if (!reader.open(path, err)) return false;
+        const flight::FileHeader& h = reader.header();
+        samples.clear();
+        flight::Record r;
+        while (reader.next(r)) {
+            if (r.type != flight::REC_IMU || r.channel != channel) continue;
+            ImuSample s;
+            s.clear();
+            s.tNs = r.tNs;
+            s.flags = SAMPLE_GYRO | SAMPLE_ACCEL;
+            s.channel = static_cast<uint16_t>(channel);
+            for (int i = 0; i < 3; i++) {
+                s.gyro[i] = r.imu.gyro[i] * h.gyroLsb;
+                s.accel[i] = r.imu.accel[i] * h.accelLsb;
+            }
+            samples.push_back(s);
+        }
+        if (samples.empty()) {
+            err = path + ": 通道 " + std::to_string(channel) + " 没有 IMU 记录";
+            return false;
+        }
+        pos = 0;
+        return true;
+    }
+
+    SensorStatus readImpl(ImuSample& s) {
+        if (pos >= samples.size()) return SENSOR_END;
+        s = samples[pos++];
+        return SENSOR_OK;
+    }
+
+    const char* nameImpl() const { return "replay"; }
+
+    void rewind() { pos = 0; }
+    size_t size() const { return samples.size(); }
+    // 记录覆盖的时长
+    int64_t spanNs() const { return samples.empty() ? 0 : samples.back().tNs - samples.front().tNs; }
+
+private:
+    std::string path;
+    int channel;
+    std::vector<ImuSample> samples;
+    size_t pos;
+};
+
+} // namespace sensor
+
+#endif
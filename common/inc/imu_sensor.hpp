@@ -0,0 +1,103 @@
+#ifndef IMU_SENSOR_HPP
+#define IMU_SENSOR_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+// 惯性传感器的统一样本和编译期接口
+//
+// 驱动从 ImuSensor<驱动> 派生 (CRTP)，实现 readImpl，需要时再实现 openImpl / nameImpl；
+// 融合、记录等代码写成以传感器类型为参数的模板，调用在编译期确定，可内联，没有虚函数开销。
+// 需要运行时替换来源的地方 (例如 GuidanceRuntime) 在最外层包一次虚接口即可
+namespace sensor {
+
+enum SampleFlags {
+    SAMPLE_GYRO = 1 << 0,
+    SAMPLE_ACCEL = 1 << 1,
+    SAMPLE_QUAT = 1 << 2,
+    SAMPLE_TEMP = 1 << 3,
+};
+
+enum SensorStatus {
+    SENSOR_OK = 0,
+    SENSOR_NO_DATA,                      // 暂时没有新样本，不算错误
+    SENSOR_FAULT,                        // 总线或器件错误，fault() 给出驱动自己的错误码
+    SENSOR_END,                          // 回放来源已读完
+    SENSOR_STATUS_COUNT
+};
+
+struct ImuSample {
+    int64_t tNs;                         // 采样时刻 (CLOCK_MONOTONIC，回放时为记录中的时刻)
+    uint32_t seq;                        // 本传感器的样本序号
+    uint16_t flags;                      // SampleFlags，只有置位的字段有效
+    uint16_t channel;                    // 同类传感器的编号
+    float gyro[3];                       // rad/s
+    float accel[3];                      // m/s^2
+    float quat[4];                       // w x y z
+    float tempC;
+
+    void clear() { std::memset(this, 0, sizeof(*this)); }
+    // flags 中的位全部有效
+    bool has(int flag) const { return (flags & flag) == flag; }
+};
+
+template <class Derived>
+class ImuSensor {
+public:
+    bool open(std::string& err) { return self().openImpl(err); }
+
+    // 读一个样本；成功时 s.seq 由基类按本传感器的计数填写
+    SensorStatus read(ImuSample& s) {
+        SensorStatus st = self().readImpl(s);
+        if (st == SENSOR_OK) s.seq = counts[SENSOR_OK];
+        counts[st]++;
+        return st;
+    }
+
+    const char* name() const { return static_cast<const Derived&>(*this).nameImpl(); }
+
+    uint64_t count(SensorStatus st) const { return counts[st]; }
+    int fault() const { return lastFault; }
+
+protected:
+    ImuSensor() : counts(), lastFault(0) {}
+    ~ImuSensor() {}
+
+    // 派生类不实现时的缺省
+    bool openImpl(std::string&) { return true; }
+    const char* nameImpl() const { return "imu"; }
+
+    SensorStatus failWith(int code) {
+        lastFault = code;
+        return SENSOR_FAULT;
+    }
+
+private:
+    uint64_t counts[SENSOR_STATUS_COUNT];
+    int lastFault;
+
+    Derived& self() { return static_cast<Derived&>(*this); }
+};
+
+// 编译期检查：模板参数必须是 ImuSensor<S> 的派生类
+template <class S>
+struct IsImuSensor : std::is_base_of<ImuSensor<S>, S> {};
+
+// 读到没有新数据为止，每个样本调用一次 fn，最多 max 个；返回读到的样本数
+template <class S, class Fn>
+int drain(S& sensor, Fn&& fn, int max = 64) {
+    static_assert(IsImuSensor<S>::value, "S must derive from sensor::ImuSensor<S>");
+    ImuSample s;
+    int n = 0;
+    while (n < max && sensor.read(s) == SENSOR_OK) {
+        fn(s);
+        n++;
+    }
+    return n;
+}
+
+} // namespace sensor
+
+#endif
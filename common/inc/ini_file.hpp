@@ -0,0 +1,86 @@
+#ifndef INI_FILE_HPP
+#define INI_FILE_HPP
+
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <string>
+
+// 极简 INI 配置：[section] 下的 key = value，# 或 ; 开头为注释
+// 只在启动和重载时使用，不在实时路径上
+
+class IniFile {
+public:
+    bool load(const std::string& path, std::string* err = nullptr) {
+        std::ifstream in(path.c_str());
+        if (!in) {
+            if (err) *err = "无法打开配置文件 " + path;
+            return false;
+        }
+        values.clear();
+        std::string line, section;
+        int lineNo = 0;
+        while (std::getline(in, line)) {
+            lineNo++;
+            line = trim(line);
+            if (line.empty() || line[0] == '#' || line[0] == ';') continue;
+            if (line[0] == '[') {
+                size_t end = line.find(']');
+                if (end == std::string::npos) {
+                    if (err) *err = path + ":" + std::to_string(lineNo) + " 节名缺少 ]";
+                    return false;
+                }
+                section = trim(line.substr(1, end - 1));
+                continue;
+            }
+            size_t eq = line.find('=');
+            if (eq == std::string::npos) {
+                if (err) *err = path + ":" + std::to_string(lineNo) + " 缺少 =";
+                return false;
+            }
+            std::string value = line.substr(eq + 1);
+            size_t hash = value.find('#');
+            if (hash != std::string::npos) value = value.substr(0, hash);
+            values[section + "." + trim(line.substr(0, eq))] = trim(value);
+        }
+        return true;
+    }
+
+    bool has(const std::string& section, const std::string& key) const {
+        return values.count(section + "." + key) != 0;
+    }
+
+    std::string getString(const std::string& section, const std::string& key, const std::string& def) const {
+        std::map<std::string, std::string>::const_iterator it = values.find(section + "." + key);
+        return it == values.end() ? def : it->second;
+    }
+
+    double getDouble(const std::string& section, const std::string& key, double def) const {
+        std::map<std::string, std::string>::const_iterator it = values.find(section + "." + key);
+        return it == values.end() ? def : std::strtod(it->second.c_str(), nullptr);
+    }
+
+    int getInt(const std::string& section, const std::string& key, int def) const {
+        std::map<std::string, std::string>::const_iterator it = values.find(section + "." + key);
+        return it == values.end() ? def : static_cast<int>(std::strtol(it->second.c_str(), nullptr, 0));
+    }
+
+    bool getBool(const std::string& section, const std::string& key, bool def) const {
+        std::map<std::string, std::string>::const_iterator it = values.find(section + "." + key);
+        if (it == values.end()) return def;
+        const std::string& v = it->second;
+        return v == "1" || v == "true" || v == "yes" || v == "on";
+    }
+
+private:
+    std::map<std::string, std::string> values;
+
+    static std::string trim(const std::string& s) {
+        size_t b = s.find_first_not_of(" \t\r\n");
+        if (b == std::string::npos) return std::string();
+        size_t e = s.find_last_not_of(" \t\r\n");
+        return s.substr(b, e - b + 1);
+    }
+};
+
+#endif
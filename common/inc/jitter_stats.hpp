@@ -0,0 +1,79 @@
+#ifndef JITTER_STATS_HPP
+#define JITTER_STATS_HPP
+
+#include <cstdint>
+#include <cstdio>
+
+// 定长延迟直方图，无动态分配，可在实时线程中记录
+//   0 ~ 2 ms 按 1 µs 分桶，2 ~ 102 ms 按 100 µs 分桶，其余进溢出桶
+
+class JitterStats {
+public:
+    static const int kFineBuckets = 2000;
+    static const int kCoarseBuckets = 1000;
+    static const int kCoarseUs = 100;
+    static const int kBuckets = kFineBuckets + kCoarseBuckets;
+
+    JitterStats() { reset(); }
+
+    void reset() {
+        for (int i = 0; i <= kBuckets; i++) hist[i] = 0;
+        count = 0;
+        sumNs = 0;
+        minNs = INT64_MAX;
+        maxNs = 0;
+    }
+
+    void add(int64_t ns) {
+        if (ns < 0) ns = 0;
+        int64_t us = ns / 1000;
+        int64_t b = us < kFineBuckets ? us : kFineBuckets + (us - kFineBuckets) / kCoarseUs;
+        hist[b < kBuckets ? b : kBuckets]++;
+        count++;
+        sumNs += ns;
+        if (ns < minNs) minNs = ns;
+        if (ns > maxNs) maxNs = ns;
+    }
+
+    void merge(const JitterStats& o) {
+        for (int i = 0; i <= kBuckets; i++) hist[i] += o.hist[i];
+        count += o.count;
+        sumNs += o.sumNs;
+        if (o.minNs < minNs) minNs = o.minNs;
+        if (o.maxNs > maxNs) maxNs = o.maxNs;
+    }
+
+    // 百分位 (µs)，落入溢出桶时返回最大值
+    double percentileUs(double p) const {
+        if (count == 0) return 0.0;
+        uint64_t target = static_cast<uint64_t>(p / 100.0 * (count - 1));
+        uint64_t seen = 0;
+        for (int i = 0; i < kBuckets; i++) {
+            seen += hist[i];
+            if (seen > target) {
+                return i < kFineBuckets ? i : kFineBuckets + (i - kFineBuckets) * kCoarseUs;
+            }
+        }
+        return maxNs / 1000.0;
+    }
+
+    uint64_t samples() const { return count; }
+    double meanUs() const { return count ? sumNs / 1000.0 / count : 0.0; }
+    double minUs() const { return count ? minNs / 1000.0 : 0.0; }
+    double maxUs() const { return maxNs / 1000.0; }
+
+    void print(const char* name) const {
+        std::printf("%-16s n=%-8llu min=%8.1f mean=%8.1f p50=%7.0f p99=%7.0f p99.9=%7.0f max=%8.1f (us)\n",
+                    name, static_cast<unsigned long long>(count), minUs(), meanUs(),
+                    percentileUs(50), percentileUs(99), percentileUs(99.9), maxUs());
+    }
+
+private:
+    uint32_t hist[kBuckets + 1];
+    uint64_t count;
+    int64_t sumNs;
+    int64_t minNs;
+    int64_t maxNs;
+};
+
+#endif
@@ -0,0 +1,136 @@
+#ifndef LOCKFREE_CHANNEL_HPP
+#define LOCKFREE_CHANNEL_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// 线程间无锁通道，T 必须可平凡拷贝，结构体本身可直接放进共享内存（见 shm_topic.hpp）
+//   SeqlockSlot<T>: 单写者“最新值”，读者永不阻塞写者
+//   SeqlockReader<T>: 实时线程读 SeqlockSlot 用，有限次重试，读不到时保留上次的值
+//   SpscRing<T, N>: 单生产者单消费者环形队列，满时丢弃新数据
+
+template <typename T>
+class SeqlockSlot {
+    static_assert(std::is_trivially_copyable<T>::value, "SeqlockSlot needs a trivially copyable type");
+
+public:
+    SeqlockSlot() : seq(0), value() {}
+
+    void write(const T& v) {
+        uint32_t s = seq.load(std::memory_order_relaxed);
+        seq.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(&value, &v, sizeof(T));
+        seq.store(s + 2, std::memory_order_release);
+    }
+
+    // 返回写入次数，0 表示尚未写过。
+    // 无限重试：读者与写者在同一 CPU 上且读者优先级更高时，抢占了写到一半的写者就永远等不到它，实时线程用 SeqlockReader
+    uint32_t read(T& out) const {
+        for (;;) {
+            uint32_t s0 = seq.load(std::memory_order_acquire);
+            if (s0 & 1) continue;
+            std::memcpy(&out, &value, sizeof(T));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            uint32_t s1 = seq.load(std::memory_order_relaxed);
+            if (s0 == s1) return s0 / 2;
+        }
+    }
+
+    // 有限次尝试，写者一直停在写入中途（跨进程时写者崩溃）时返回 false
+    bool tryRead(T& out, uint32_t& ver, int attempts = 64) const {
+        for (int i = 0; i < attempts; i++) {
+            uint32_t s0 = seq.load(std::memory_order_acquire);
+            if (s0 & 1) continue;
+            std::memcpy(&out, &value, sizeof(T));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq.load(std::memory_order_relaxed) == s0) {
+                ver = s0 / 2;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    uint32_t version() const { return seq.load(std::memory_order_acquire) / 2; }
+
+    // 新写者接管前调用：上一个写者在写入中途退出时 seq 停在奇数，读者会一直重试
+    // 之后的值可能是半写的，接管后应尽快写一次
+    void recover() {
+        uint32_t s = seq.load(std::memory_order_relaxed);
+        if (s & 1) seq.store(s + 1, std::memory_order_release);
+    }
+
+private:
+    std::atomic<uint32_t> seq;
+    T value;
+};
+
+// 一个读线程一个。tryRead 失败 (写者停在写入中途) 时不重试到底，保留上次读到的值，下个周期再读
+template <typename T>
+class SeqlockReader {
+public:
+    explicit SeqlockReader(const SeqlockSlot<T>& slot) : slot(slot), seen(0), last() {}
+
+    // 返回最近一次读到的写入次数，0 表示从未读到
+    uint32_t poll() {
+        T v;
+        uint32_t ver;
+        if (slot.tryRead(v, ver)) {
+            last = v;
+            seen = ver;
+        }
+        return seen;
+    }
+
+    const T& value() const { return last; }
+
+private:
+    const SeqlockSlot<T>& slot;
+    uint32_t seen;
+    T last;
+};
+
+template <typename T, uint32_t N>
+class SpscRing {
+    static_assert(std::is_trivially_copyable<T>::value, "SpscRing needs a trivially copyable type");
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscRing size must be a power of two");
+
+public:
+    SpscRing() : head(0), tail(0), dropped(0) {}
+
+    bool push(const T& v) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) >= N) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        slots[h & (N - 1)] = v;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& out) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) return false;
+        out = slots[t & (N - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    uint32_t size() const {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+    uint32_t droppedCount() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    // 生产者和消费者的索引分开放，避免伪共享
+    alignas(64) std::atomic<uint32_t> head;
+    alignas(64) std::atomic<uint32_t> tail;
+    alignas(64) std::atomic<uint32_t> dropped;
+    T slots[N];
+};
+
+#endif
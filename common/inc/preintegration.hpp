@@ -0,0 +1,262 @@
+#ifndef PREINTEGRATION_HPP
+#define PREINTEGRATION_HPP
+
+#include "lockfree_channel.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// IMU 预积分：IMU 任务按全速率把每个陀螺 / 加速度计样本积进累计姿态和累计速度增量，
+// 带圆锥 (coning) 和划桨 (sculling) 补偿；慢速消费者各自按自己的周期取两次快照之间的
+// 角度增量和速度增量，不丢中间样本、不混叠。
+//
+// 每个样本：BMI088 / BNO080 给的是角速度和比力的瞬时采样 (不是角增量)，相邻两样本
+// (w0,f0) (w1,f1) 间隔 h，过前三个样本二次插值积分得到 alpha (rad) 和 nu (m/s)，
+//   phi = alpha + h^2/12 w0 x w1                                  (圆锥补偿)
+//   dv  = nu + 1/2 alpha x nu + h^2/12 (w0 x f1 + f0 x w1)        (旋转 + 划桨补偿)
+//   q  <- q * exp(phi)，v <- v + R(q_prev) dv
+// 补偿项按区间内线性变化推出；梯形积分对振动频率的幅值衰减 (~(wh)^2/12) 本身就会造成圆锥漂移，
+// 所以增量用二次插值，断流后的第一段退回梯形
+// q 为当前机体系相对起始机体系的姿态，v 为起始系中的累计比力速度增量 (含重力，不做重力补偿)。
+// 累计量用 double，长时间运行也不损失增量的精度。
+//
+// 写者 (IMU 线程) 每个样本发布一次快照到 SeqlockSlot；每个消费者持有一个 Reader，
+// fetch 只读一次快照并做一次四元数运算，与间隔内的样本数无关
+namespace preint {
+
+// 累计量，起点为 reset() 时的机体系
+struct Snapshot {
+    int64_t tNs;                         // 最近一个样本的时刻
+    uint64_t samples;                    // 已积分的样本数
+    double q[4];                         // w x y z
+    double v[3];                         // m/s
+};
+
+// 两个快照之间的增量，均在前一快照时刻的机体系中表示
+struct Delta {
+    int64_t t0Ns, t1Ns;
+    uint64_t samples;
+    float dq[4];                         // 机体系旋转，w x y z
+    float dTheta[3];                     // 等效旋转矢量，rad
+    float dv[3];                         // 比力速度增量，m/s
+
+    float seconds() const { return (t1Ns - t0Ns) * 1e-9f; }
+};
+
+namespace detail {
+
+inline void cross(const double* a, const double* b, double* out) {
+    double x = a[1] * b[2] - a[2] * b[1];
+    double y = a[2] * b[0] - a[0] * b[2];
+    double z = a[0] * b[1] - a[1] * b[0];
+    out[0] = x;
+    out[1] = y;
+    out[2] = z;
+}
+
+inline void qmul(const double* a, const double* b, double* out) {
+    double w = a[0] * b[0] - a[1] * b[1] - a[2] * b[2] - a[3] * b[3];
+    double x = a[0] * b[1] + a[1] * b[0] + a[2] * b[3] - a[3] * b[2];
+    double y = a[0] * b[2] - a[1] * b[3] + a[2] * b[0] + a[3] * b[1];
+    double z = a[0] * b[3] + a[1] * b[2] - a[2] * b[1] + a[3] * b[0];
+    out[0] = w;
+    out[1] = x;
+    out[2] = y;
+    out[3] = z;
+}
+
+// 旋转矢量 -> 单位四元数
+inline void qexp(const double* phi, double* q) {
+    double a2 = phi[0] * phi[0] + phi[1] * phi[1] + phi[2] * phi[2];
+    double a = std::sqrt(a2);
+    // 小角度用泰勒展开，避免 sin(a/2)/a 的 0/0
+    double s = a < 1e-6 ? 0.5 - a2 / 48.0 : std::sin(0.5 * a) / a;
+    q[0] = a < 1e-6 ? 1.0 - a2 / 8.0 : std::cos(0.5 * a);
+    q[1] = phi[0] * s;
+    q[2] = phi[1] * s;
+    q[3] = phi[2] * s;
+}
+
+// 单位四元数 -> 旋转矢量 (取 w >= 0 的一支，角度 <= pi)
+inline void qlog(const double* q, double* phi) {
+    double sign = q[0] < 0.0 ? -1.0 : 1.0;
+    double n = std::sqrt(q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+    double k = n < 1e-12 ? 2.0 * sign : 2.0 * sign * std::atan2(n, sign * q[0]) / n;
+    for (int i = 0; i < 3; i++) phi[i] = q[i + 1] * k;
+}
+
+// v 从 q 的机体系旋到参考系：q * v * q^-1
+inline void rotate(const double* q, const double* v, double* out) {
+    double t[3], u[3];
+    cross(q + 1, v, t);
+    for (int i = 0; i < 3; i++) t[i] *= 2.0;
+    cross(q + 1, t, u);
+    for (int i = 0; i < 3; i++) out[i] = v[i] + q[0] * t[i] + u[i];
+}
+
+} // namespace detail
+
+// b 相对 a 的增量
+inline Delta between(const Snapshot& a, const Snapshot& b) {
+    Delta d;
+    d.t0Ns = a.tNs;
+    d.t1Ns = b.tNs;
+    d.samples = b.samples - a.samples;
+    double conj[4] = {a.q[0], -a.q[1], -a.q[2], -a.q[3]};
+    double dq[4], phi[3], dvRef[3], dv[3];
+    detail::qmul(conj, b.q, dq);
+    detail::qlog(dq, phi);
+    for (int i = 0; i < 3; i++) dvRef[i] = b.v[i] - a.v[i];
+    detail::rotate(conj, dvRef, dv);
+    for (int i = 0; i < 4; i++) d.dq[i] = static_cast<float>(dq[i]);
+    for (int i = 0; i < 3; i++) {
+        d.dTheta[i] = static_cast<float>(phi[i]);
+        d.dv[i] = static_cast<float>(dv[i]);
+    }
+    return d;
+}
+
+// 累计姿态的偏航 / 俯仰 (Z-Y-X 欧拉角，rad)
+inline void yawPitch(const Snapshot& s, float& yaw, float& pitch) {
+    const double* q = s.q;
+    yaw = static_cast<float>(std::atan2(2.0 * (q[0] * q[3] + q[1] * q[2]), 1.0 - 2.0 * (q[2] * q[2] + q[3] * q[3])));
+    double sp = 2.0 * (q[0] * q[2] - q[3] * q[1]);
+    pitch = static_cast<float>(std::asin(sp > 1.0 ? 1.0 : sp < -1.0 ? -1.0 : sp));
+}
+
+class Preintegrator {
+public:
+    // 相邻样本间隔超过 maxGapNs 视为断流：不积分这一段，只计数
+    // coningSculling 为 false 时只做梯形积分、不加圆锥 / 划桨项，只用于对照
+    explicit Preintegrator(int64_t maxGapNs = 20000000, bool coningSculling = true)
+        : maxGap(maxGapNs), compensate(coningSculling) {
+        reset();
+    }
+
+    void reset() {
+        std::memset(&cur, 0, sizeof(cur));
+        cur.q[0] = 1.0;
+        havePrev = false;
+        haveInc = false;
+        prevDt = 0.0;
+        lastNs = 0;
+        gaps = 0;
+        slot.write(cur);
+    }
+
+    // 只在写者线程调用；gyro rad/s，accel m/s^2
+    void add(int64_t tNs, const float (&gyro)[3], const float (&accel)[3]) {
+        double w[3] = {gyro[0], gyro[1], gyro[2]};
+        double f[3] = {accel[0], accel[1], accel[2]};
+        int64_t dtNs = tNs - lastNs;
+        if (havePrev && dtNs > 0 && dtNs <= maxGap) {
+            double dt = dtNs * 1e-9;
+            // 有上一段时过前三个样本做二次插值再积分，否则梯形
+            double k0 = 0.5 * dt, k1 = 0.5 * dt, km = 0.0;
+            if (compensate && haveInc) {
+                double g = prevDt;
+                km = -dt * dt * dt / (6.0 * g * (g + dt));
+                k0 = dt * (dt + 3.0 * g) / (6.0 * g);
+                k1 = dt * (2.0 * dt + 3.0 * g) / (6.0 * (dt + g));
+            }
+            double alpha[3], nu[3];
+            for (int i = 0; i < 3; i++) {
+                alpha[i] = k1 * w[i] + k0 * lastW[i] + km * prevW[i];
+                nu[i] = k1 * f[i] + k0 * lastF[i] + km * prevF[i];
+            }
+            double phi[3], dv[3], c[3];
+            detail::cross(alpha, nu, c);
+            for (int i = 0; i < 3; i++) {
+                phi[i] = alpha[i];
+                dv[i] = nu[i] + 0.5 * c[i];
+            }
+            if (compensate) {
+                double cone[3], s1[3], s2[3];
+                double k = dt * dt / 12.0;
+                detail::cross(lastW, w, cone);
+                detail::cross(lastW, f, s1);
+                detail::cross(lastF, w, s2);
+                for (int i = 0; i < 3; i++) {
+                    phi[i] += k * cone[i];
+                    dv[i] += k * (s1[i] + s2[i]);
+                }
+            }
+            double dvRef[3], dq[4], q[4];
+            detail::rotate(cur.q, dv, dvRef);
+            detail::qexp(phi, dq);
+            detail::qmul(cur.q, dq, q);
+            // 每步归一化，抵消舍入使模长慢慢偏离 1
+            double n = 1.0 / std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+            for (int i = 0; i < 4; i++) cur.q[i] = q[i] * n;
+            for (int i = 0; i < 3; i++) cur.v[i] += dvRef[i];
+            prevDt = dt;
+            haveInc = true;
+        } else {
+            if (havePrev) gaps++;
+            haveInc = false;
+        }
+        for (int i = 0; i < 3; i++) {
+            prevW[i] = lastW[i];
+            prevF[i] = lastF[i];
+            lastW[i] = w[i];
+            lastF[i] = f[i];
+        }
+        lastNs = tNs;
+        havePrev = true;
+        cur.tNs = tNs;
+        cur.samples++;
+        slot.write(cur);
+    }
+
+    // 写者线程内直接取最新累计量
+    const Snapshot& snapshot() const { return cur; }
+    uint64_t gapCount() const { return gaps; }
+
+    // 供 Reader 使用，任意线程
+    const SeqlockSlot<Snapshot>& published() const { return slot; }
+
+private:
+    int64_t maxGap;
+    bool compensate;
+    Snapshot cur;
+    SeqlockSlot<Snapshot> slot;
+    bool havePrev, haveInc;
+    int64_t lastNs;
+    double prevDt;
+    double lastW[3], lastF[3];
+    double prevW[3], prevF[3];
+    uint64_t gaps;
+};
+
+// 一个消费者一个，只在该消费者的线程里使用
+class Reader {
+public:
+    explicit Reader(const Preintegrator& p) : src(p.published()), seen(0), started(false), last() {}
+
+    // 取上次 fetch 以来的增量；没有新样本时返回 false。第一次调用只记下起点
+    bool fetch(Delta& d) {
+        Snapshot s;
+        uint32_t v = src.read(s);
+        if (v == seen) return false;
+        seen = v;
+        bool ok = started && s.samples > last.samples;
+        if (ok) d = between(last, s);
+        last = s;
+        started = true;
+        return ok;
+    }
+
+    // 最近一次 fetch 读到的累计量
+    const Snapshot& latest() const { return last; }
+
+private:
+    const SeqlockSlot<Snapshot>& src;
+    uint32_t seen;
+    bool started;
+    Snapshot last;
+};
+
+} // namespace preint
+
+#endif
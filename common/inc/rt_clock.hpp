@@ -0,0 +1,30 @@
+#ifndef RT_CLOCK_HPP
+#define RT_CLOCK_HPP
+
+#include <cerrno>
+#include <cstdint>
+#include <time.h>
+
+// 统一时间基准：CLOCK_MONOTONIC 纳秒
+
+inline int64_t monotonicNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+inline struct timespec nsToTimespec(int64_t ns) {
+    struct timespec ts;
+    ts.tv_sec = static_cast<time_t>(ns / 1000000000LL);
+    ts.tv_nsec = static_cast<long>(ns % 1000000000LL);
+    return ts;
+}
+
+// 绝对时刻睡眠，周期任务用它避免 sleep_for 的累积漂移
+inline void sleepUntilNs(int64_t deadlineNs) {
+    struct timespec ts = nsToTimespec(deadlineNs);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+    }
+}
+
+#endif
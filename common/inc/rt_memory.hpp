@@ -0,0 +1,178 @@
+#ifndef RT_MEMORY_HPP
+#define RT_MEMORY_HPP
+
+#include <alloca.h>
+#include <malloc.h>
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+
+// 实时线程的内存纪律
+//   lockMemory()：mlockall 锁住现有和以后的页，并让 malloc 不再把内存还给内核、不用 mmap 分配大块，
+//                 之后 free 掉的内存留在已锁定、已缺页的堆里，再分配不会缺页
+//   prefaultStack()：线程启动时把栈写一遍，之后的深调用不缺页
+//   Arena / BlockPool：启动时一次分配，周期内按需取用，不进 malloc
+//   分配计数：某一个翻译单元 #define RTMEM_COUNT_ALLOCATIONS 后包含本文件，替换全局 operator new，
+//             threadAllocations() 返回当前线程的分配次数（未替换时恒为 0）
+namespace rtmem {
+
+inline bool lockMemory(std::string& err) {
+    mallopt(M_TRIM_THRESHOLD, -1);
+    mallopt(M_MMAP_MAX, 0);
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        err = std::string("mlockall 失败: ") + std::strerror(errno) + "（需要 root 或 CAP_IPC_LOCK / 提高 memlock 限制）";
+        return false;
+    }
+    return true;
+}
+
+// 不内联，alloca 的空间在本函数返回时才释放，写到的页此后一直在
+__attribute__((noinline)) inline void prefaultStack(size_t bytes) {
+    volatile unsigned char* p = static_cast<volatile unsigned char*>(alloca(bytes));
+    for (size_t i = 0; i < bytes; i += 4096) p[i] = 0;
+}
+
+inline uint64_t& threadAllocCounter() {
+    static thread_local uint64_t count = 0;
+    return count;
+}
+
+inline std::atomic<uint64_t>& totalAllocCounter() {
+    static std::atomic<uint64_t> count(0);
+    return count;
+}
+
+inline uint64_t threadAllocations() { return threadAllocCounter(); }
+inline uint64_t totalAllocations() { return totalAllocCounter().load(std::memory_order_relaxed); }
+
+// 线性分配器：alloc 只移动偏移，reset 一次全部释放；满时返回 nullptr 并计数
+class Arena {
+public:
+    explicit Arena(size_t bytes = 0) : base(nullptr), cap(0), used(0), peak(0), failures(0) { reserve(bytes); }
+    ~Arena() { std::free(base); }
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // 启动时调用；会写一遍缓冲区，锁定内存时此后不再缺页
+    void reserve(size_t bytes) {
+        std::free(base);
+        base = bytes ? static_cast<unsigned char*>(std::malloc(bytes)) : nullptr;
+        cap = base ? bytes : 0;
+        if (base) std::memset(base, 0, cap);
+        used = peak = 0;
+    }
+
+    void* alloc(size_t bytes, size_t align = alignof(std::max_align_t)) {
+        size_t start = (used + align - 1) & ~(align - 1);
+        if (start + bytes > cap) {
+            failures++;
+            return nullptr;
+        }
+        used = start + bytes;
+        peak = std::max(peak, used);
+        return base + start;
+    }
+
+    template <typename T>
+    T* allocArray(size_t n) {
+        return static_cast<T*>(alloc(n * sizeof(T), alignof(T)));
+    }
+
+    void reset() { used = 0; }
+
+    size_t capacity() const { return cap; }
+    size_t highWater() const { return peak; }
+    uint64_t failedAllocs() const { return failures; }
+
+private:
+    unsigned char* base;
+    size_t cap, used, peak;
+    uint64_t failures;
+};
+
+// 定长块池：空闲块串成链表，分配和释放都是 O(1)；同一时刻只允许一个线程使用
+class BlockPool {
+public:
+    static const size_t kAlign = alignof(std::max_align_t);
+
+    BlockPool(size_t blockBytes, size_t blocks)
+        : size((std::max(blockBytes, sizeof(void*)) + kAlign - 1) & ~(kAlign - 1)),
+          count(blocks), base(static_cast<unsigned char*>(std::malloc(size * blocks))), head(nullptr), inUse(0) {
+        if (!base) count = 0;
+        if (base) std::memset(base, 0, size * count);
+        for (size_t i = count; i-- > 0;) {
+            void* b = base + i * size;
+            *static_cast<void**>(b) = head;
+            head = b;
+        }
+    }
+    ~BlockPool() { std::free(base); }
+    BlockPool(const BlockPool&) = delete;
+    BlockPool& operator=(const BlockPool&) = delete;
+
+    // 没有空闲块时返回 nullptr
+    void* allocate() {
+        void* b = head;
+        if (!b) return nullptr;
+        head = *static_cast<void**>(b);
+        inUse++;
+        return b;
+    }
+
+    void deallocate(void* b) {
+        if (!b) return;
+        *static_cast<void**>(b) = head;
+        head = b;
+        inUse--;
+    }
+
+    size_t blockSize() const { return size; }
+    size_t available() const { return count - inUse; }
+
+private:
+    size_t size, count;
+    unsigned char* base;
+    void* head;
+    size_t inUse;
+};
+
+// 当前线程的周期 arena，由 RtTask 在每个周期开始时 reset；没有时为 nullptr
+inline Arena*& threadArenaSlot() {
+    static thread_local Arena* arena = nullptr;
+    return arena;
+}
+
+inline Arena* cycleArena() { return threadArenaSlot(); }
+
+} // namespace rtmem
+
+#ifdef RTMEM_COUNT_ALLOCATIONS
+// 只能在一个翻译单元里定义
+void* operator new(size_t n) {
+    rtmem::threadAllocCounter()++;
+    rtmem::totalAllocCounter().fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t n) { return operator new(n); }
+void* operator new(size_t n, const std::nothrow_t&) noexcept {
+    rtmem::threadAllocCounter()++;
+    rtmem::totalAllocCounter().fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(n ? n : 1);
+}
+void* operator new[](size_t n, const std::nothrow_t& t) noexcept { return operator new(n, t); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+#endif
+
+#endif
@@ -0,0 +1,240 @@
+#ifndef RT_TASK_HPP
+#define RT_TASK_HPP
+
+#include "jitter_stats.hpp"
+#include "rt_clock.hpp"
+#include "rt_memory.hpp"
+#include "trace_zone.hpp"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <thread>
+
+// 周期实时任务：独立线程、绑核、SCHED_FIFO 优先级、绝对时刻调度、截止时间统计
+// 前 kWarmupCycles 个周期之后任务体里的堆分配计入 steadyAllocations()（需要替换 operator new，见 rt_memory.hpp）
+
+struct RtTaskConfig {
+    std::string name;
+    int64_t periodNs = 0;       // 0 = 自由运行，由任务体内部阻塞（例如等待相机帧）
+    int64_t deadlineNs = 0;     // 0 = 与周期相同
+    int cpu = -1;               // -1 不绑核
+    int priority = 0;           // SCHED_FIFO 优先级 1~99，0 = 普通调度
+    size_t stackPrefaultBytes = 0; // 线程启动时预先写一遍的栈深度
+    size_t arenaBytes = 0;      // 周期 arena 大小 (rtmem::cycleArena())，每周期开始时清空；0 = 不分配
+
+    int64_t effectiveDeadlineNs() const { return deadlineNs > 0 ? deadlineNs : periodNs; }
+};
+
+class RtTask {
+public:
+    typedef std::function<void(int64_t nowNs)> Body;
+
+    RtTask(const RtTaskConfig& config, Body body)
+        : cfg(config), body(body), running(false), stalledCycle(false), heartbeatNs(0), cycleCount(0), missCount(0),
+          allocCount(0) {}
+
+    static const uint64_t kWarmupCycles = 50;
+
+    ~RtTask() {
+        stop();
+        join();
+    }
+
+    RtTask(const RtTask&) = delete;
+    RtTask& operator=(const RtTask&) = delete;
+
+    void start() {
+        running = true;
+        heartbeatNs = monotonicNs();
+        worker = std::thread(&RtTask::loop, this);
+    }
+
+    void stop() { running = false; }
+
+    // 任务体在本周期没拿到新数据时调用 (只在任务线程内)：本周期不更新心跳，
+    // 持续没有数据时看门狗与任务停转同样处理
+    void stalled() { stalledCycle = true; }
+
+    void join() {
+        if (worker.joinable()) worker.join();
+    }
+
+    const RtTaskConfig& config() const { return cfg; }
+    int64_t lastHeartbeatNs() const { return heartbeatNs.load(std::memory_order_relaxed); }
+    uint64_t cycles() const { return cycleCount.load(std::memory_order_relaxed); }
+    uint64_t misses() const { return missCount.load(std::memory_order_relaxed); }
+    uint64_t steadyAllocations() const { return allocCount.load(std::memory_order_relaxed); }
+
+    // 线程结束后读取
+    const JitterStats& wakeLatency() const { return wake; }
+    const JitterStats& execTime() const { return exec; }
+
+    void printStats() const {
+        std::printf("[%s] cycles %llu deadline misses %llu\n", cfg.name.c_str(),
+                    static_cast<unsigned long long>(cycles()), static_cast<unsigned long long>(misses()));
+        if (steadyAllocations()) {
+            std::printf("  steady-state allocations %llu\n", static_cast<unsigned long long>(steadyAllocations()));
+        }
+        if (arena.capacity()) {
+            std::printf("  arena high water %zu of %zu bytes, failed %llu\n", arena.highWater(), arena.capacity(),
+                        static_cast<unsigned long long>(arena.failedAllocs()));
+        }
+        if (cfg.periodNs > 0) wake.print("  wakeup");
+        exec.print("  exec");
+    }
+
+private:
+    RtTaskConfig cfg;
+    Body body;
+    std::thread worker;
+    std::atomic<bool> running;
+    bool stalledCycle;
+    std::atomic<int64_t> heartbeatNs;
+    std::atomic<uint64_t> cycleCount;
+    std::atomic<uint64_t> missCount;
+    std::atomic<uint64_t> allocCount;
+    rtmem::Arena arena;
+    JitterStats wake;
+    JitterStats exec;
+
+    void applyScheduling() {
+        pthread_t self = pthread_self();
+        pthread_setname_np(self, cfg.name.substr(0, 15).c_str());
+
+        if (cfg.cpu >= 0) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cfg.cpu, &set);
+            int err = pthread_setaffinity_np(self, sizeof(set), &set);
+            if (err != 0) {
+                std::fprintf(stderr, "[%s] 绑定 CPU %d 失败: %s\n", cfg.name.c_str(), cfg.cpu, strerror(err));
+            }
+        }
+        if (cfg.priority > 0) {
+            struct sched_param sp;
+            sp.sched_priority = cfg.priority;
+            int err = pthread_setschedparam(self, SCHED_FIFO, &sp);
+            if (err != 0) {
+                std::fprintf(stderr, "[%s] 设置 SCHED_FIFO %d 失败: %s\n", cfg.name.c_str(), cfg.priority, strerror(err));
+            }
+        }
+    }
+
+    void loop() {
+        applyScheduling();
+        if (cfg.stackPrefaultBytes) rtmem::prefaultStack(cfg.stackPrefaultBytes);
+        if (cfg.arenaBytes) {
+            arena.reserve(cfg.arenaBytes);
+            rtmem::threadArenaSlot() = &arena;
+        }
+        const int64_t deadline = cfg.effectiveDeadlineNs();
+        int64_t release = monotonicNs();
+
+        while (running.load(std::memory_order_relaxed)) {
+            int64_t begin;
+            if (cfg.periodNs > 0) {
+                release += cfg.periodNs;
+                sleepUntilNs(release);
+                begin = monotonicNs();
+                wake.add(begin - release);
+            } else {
+                begin = release = monotonicNs();
+            }
+
+            arena.reset();
+            stalledCycle = false;
+            uint64_t allocsBefore = rtmem::threadAllocations();
+            body(begin);
+            uint64_t allocs = rtmem::threadAllocations() - allocsBefore;
+            if (allocs && cycleCount.load(std::memory_order_relaxed) >= kWarmupCycles) {
+                allocCount.fetch_add(allocs, std::memory_order_relaxed);
+            }
+
+            int64_t end = monotonicNs();
+            TRACE_SPAN("wake late", release, begin);
+            TRACE_SPAN(cfg.name.c_str(), begin, end);
+            exec.add(end - begin);
+            if (deadline > 0 && end - release > deadline) missCount.fetch_add(1, std::memory_order_relaxed);
+            cycleCount.fetch_add(1, std::memory_order_relaxed);
+            if (!stalledCycle) heartbeatNs.store(end, std::memory_order_relaxed);
+
+            // 落后整周期时重新对齐，不补跑积压的周期
+            if (cfg.periodNs > 0 && end - release > cfg.periodNs) {
+                release += (end - release) / cfg.periodNs * cfg.periodNs;
+            }
+        }
+    }
+};
+
+// 看门狗：任务心跳超时触发回调（进入失效保护），截止时间丢失累计后打印
+class Watchdog {
+public:
+    static const int kMaxTasks = 16;
+    typedef std::function<void(const RtTask& task, bool stale)> Handler;
+
+    Watchdog(int64_t checkPeriodNs, double staleFactor, Handler onChange)
+        : staleFactor(staleFactor), onChange(onChange), count(0),
+          task(makeConfig(checkPeriodNs), [this](int64_t now) { check(now); }) {}
+
+    void watch(const RtTask* t) {
+        if (count >= kMaxTasks) return;
+        tasks[count] = t;
+        stale[count] = false;
+        reportedMisses[count] = 0;
+        count++;
+    }
+
+    void start() { task.start(); }
+    void stop() {
+        task.stop();
+        task.join();
+    }
+
+private:
+    double staleFactor;
+    Handler onChange;
+    const RtTask* tasks[kMaxTasks];
+    bool stale[kMaxTasks];
+    uint64_t reportedMisses[kMaxTasks];
+    int count;
+    RtTask task;
+
+    static RtTaskConfig makeConfig(int64_t periodNs) {
+        RtTaskConfig c;
+        c.name = "watchdog";
+        c.periodNs = periodNs;
+        return c;
+    }
+
+    void check(int64_t now) {
+        for (int i = 0; i < count; i++) {
+            const RtTask& t = *tasks[i];
+            int64_t limit = t.config().effectiveDeadlineNs();
+            if (limit <= 0) limit = t.config().periodNs;
+            limit = static_cast<int64_t>(limit * staleFactor);
+
+            bool isStale = limit > 0 && now - t.lastHeartbeatNs() > limit;
+            if (isStale != stale[i]) {
+                stale[i] = isStale;
+                std::fprintf(stderr, "[watchdog] %s %s\n", t.config().name.c_str(), isStale ? "心跳超时" : "恢复");
+                if (onChange) onChange(t, isStale);
+            }
+
+            uint64_t m = t.misses();
+            if (m != reportedMisses[i]) {
+                std::fprintf(stderr, "[watchdog] %s 截止时间丢失 +%llu (累计 %llu)\n", t.config().name.c_str(),
+                             static_cast<unsigned long long>(m - reportedMisses[i]),
+                             static_cast<unsigned long long>(m));
+                reportedMisses[i] = m;
+            }
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,423 @@
+#ifndef SHM_TOPIC_HPP
+#define SHM_TOPIC_HPP
+
+#include "lockfree_channel.hpp"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+
+// 进程间话题：/dev/shm 下的一个段放一个 SeqlockSlot（最新值）或 SpscRing（数据流）
+// 打开时做一次 shm_open + mmap，之后读写都是普通内存访问，不分配、不做系统调用
+// 时间戳用 CLOCK_MONOTONIC (rt_clock.hpp)，各进程之间可以直接相减
+//
+// 写者打开时：已有格式相同的段就接管（序号、队列内容保留），否则把旧段标记为退役、删除后新建
+// 读者打开时检查格式（类型编号、大小、容量），不符或写者尚未初始化完成时失败，调用者稍后重试
+// 读者可随时查 retired()，为 true 说明写者换了新段，需要重新 open
+namespace ipc {
+
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "shared memory topics need lock-free 32-bit atomics");
+
+// ---- 话题格式 ----
+
+const int kMaxBlobs = 16;
+
+struct Blob {
+    float cx, cy;                        // 质心 (像素)
+    int32_t area;                        // 像素数
+    int16_t x0, y0, x1, y1;              // 外接矩形，闭区间
+};
+
+// 一帧检测结果
+struct BlobList {
+    int64_t captureNs;                   // 曝光时刻，未知时为 0
+    int64_t detectNs;                    // 检测完成时刻
+    uint32_t frameId;
+    int32_t count;                       // blobs 中的有效个数
+    uint16_t width, height;              // 图像尺寸
+    Blob blobs[kMaxBlobs];
+};
+
+struct ImuSample {
+    int64_t tNs;                         // 采样时刻
+    uint32_t seq;                        // 写者的采样序号，读者据此发现丢失
+    float gyro[3];                       // rad/s
+    float accel[3];                      // m/s^2
+    float tempC;
+};
+
+struct ServoSetpoint {
+    int64_t tNs;
+    float angle[4];                      // rad，舵面指令
+    uint16_t pulseUs[4];                 // 实际输出的脉宽，0 为未知
+    uint32_t tracking;                   // 1 为正在跟踪目标，0 为回中
+};
+
+template <typename T>
+struct Schema;
+template <>
+struct Schema<BlobList> {
+    enum { id = 1 };
+};
+template <>
+struct Schema<ImuSample> {
+    enum { id = 2 };
+};
+template <>
+struct Schema<ServoSetpoint> {
+    enum { id = 3 };
+};
+
+// 各进程约定的话题名
+const char* const kBlobTopic = "/milkyway.blobs";            // 视觉 (dart002 或 dart003)，LatestWriter<BlobList>
+const char* const kImuTopic = "/milkyway.imu";               // pi_bmi088，LatestWriter<ImuSample>
+const char* const kImuStreamTopic = "/milkyway.imu_stream";  // pi_bmi088，StreamWriter<ImuSample, kImuStreamSize>
+const char* const kServoTopic = "/milkyway.servo";           // dart003，LatestWriter<ServoSetpoint>
+const uint32_t kImuStreamSize = 1024;
+
+// ---- 共享内存段 ----
+
+const uint32_t kTopicMagic = 0x5054574d;  // "MWTP"
+const uint32_t kLayoutVersion = 1;
+
+enum TopicKind { TOPIC_LATEST = 1, TOPIC_STREAM };
+
+// 段开头的描述，magic 在写者初始化完成后最后写入
+struct TopicHeader {
+    std::atomic<uint32_t> magic;
+    uint32_t layoutVersion;
+    uint32_t schema;                     // Schema<T>::id
+    uint32_t payloadBytes;               // sizeof(T)
+    uint32_t kind;                       // TopicKind
+    uint32_t capacity;                   // 队列容量，最新值为 1
+    uint64_t segmentBytes;
+    std::atomic<int32_t> writerPid;
+    std::atomic<int32_t> readerPid;      // 数据流唯一的读者
+    std::atomic<uint32_t> generation;    // 每次有写者接管加 1
+    std::atomic<uint32_t> retired;       // 1 为已被新段取代
+};
+
+struct TopicShape {
+    uint32_t schema, payloadBytes, kind, capacity;
+    uint64_t segmentBytes;
+
+    bool matches(const TopicHeader& h) const {
+        return h.magic.load(std::memory_order_acquire) == kTopicMagic && h.layoutVersion == kLayoutVersion &&
+               h.schema == schema && h.payloadBytes == payloadBytes && h.kind == kind && h.capacity == capacity &&
+               h.segmentBytes == segmentBytes;
+    }
+};
+
+namespace detail {
+
+inline bool processAlive(int32_t pid) { return pid > 0 && (kill(pid, 0) == 0 || errno == EPERM); }
+
+inline std::string sysError(const std::string& what, const std::string& name) {
+    return what + " " + name + ": " + std::strerror(errno);
+}
+
+} // namespace detail
+
+// 一个映射好的段，析构时解除映射（不删除段）
+class Segment {
+public:
+    Segment() : base(nullptr), bytes(0) {}
+    ~Segment() { unmap(); }
+    Segment(const Segment&) = delete;
+    Segment& operator=(const Segment&) = delete;
+
+    void* data() const { return base; }
+    TopicHeader& header() const { return *static_cast<TopicHeader*>(base); }
+
+    void unmap() {
+        if (base) munmap(base, bytes);
+        base = nullptr;
+        bytes = 0;
+    }
+
+    // 写者：接管格式相同且没有其他活着的写者的段 (reused = true)，否则新建一个清零的段
+    bool create(const std::string& name, const TopicShape& shape, std::string& err, bool& reused) {
+        unmap();
+        reused = false;
+        int fd = shm_open(name.c_str(), O_RDWR, 0);
+        if (fd >= 0) {
+            struct stat st;
+            void* p = MAP_FAILED;
+            if (fstat(fd, &st) == 0 && st.st_size >= static_cast<off_t>(sizeof(TopicHeader))) {
+                p = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            }
+            ::close(fd);
+            if (p != MAP_FAILED) {
+                TopicHeader* h = static_cast<TopicHeader*>(p);
+                if (static_cast<uint64_t>(st.st_size) == shape.segmentBytes && shape.matches(*h)) {
+                    int32_t pid = h->writerPid.load(std::memory_order_relaxed);
+                    if (pid != getpid() && detail::processAlive(pid)) {
+                        munmap(p, st.st_size);
+                        err = "话题 " + name + " 已有写者 (pid " + std::to_string(pid) + ")";
+                        return false;
+                    }
+                    base = p;
+                    bytes = st.st_size;
+                    reused = true;
+                    return true;
+                }
+                if (h->magic.load(std::memory_order_acquire) == kTopicMagic) {
+                    h->retired.store(1, std::memory_order_release);
+                }
+                munmap(p, st.st_size);
+            }
+            shm_unlink(name.c_str());
+        }
+
+        fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0660);
+        if (fd < 0) {
+            err = detail::sysError("无法创建话题", name);
+            return false;
+        }
+        if (ftruncate(fd, static_cast<off_t>(shape.segmentBytes)) != 0) {
+            err = detail::sysError("无法设置话题大小", name);
+            ::close(fd);
+            shm_unlink(name.c_str());
+            return false;
+        }
+        // 写者预先缺页，之后的写入不再进内核
+        void* p = mmap(nullptr, shape.segmentBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) {
+            err = detail::sysError("无法映射话题", name);
+            shm_unlink(name.c_str());
+            return false;
+        }
+        base = p;
+        bytes = shape.segmentBytes;
+        return true;
+    }
+
+    // 读者：段必须存在、初始化完成且格式相同
+    bool attach(const std::string& name, const TopicShape& shape, bool writable, std::string& err) {
+        unmap();
+        int fd = shm_open(name.c_str(), writable ? O_RDWR : O_RDONLY, 0);
+        if (fd < 0) {
+            err = detail::sysError("无法打开话题 (写者未启动?)", name);
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || static_cast<uint64_t>(st.st_size) != shape.segmentBytes) {
+            ::close(fd);
+            err = "话题 " + name + " 大小不符，写者与读者的格式版本不同或写者尚未初始化";
+            return false;
+        }
+        int prot = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+        void* p = mmap(nullptr, shape.segmentBytes, prot, MAP_SHARED | MAP_POPULATE, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) {
+            err = detail::sysError("无法映射话题", name);
+            return false;
+        }
+        base = p;
+        bytes = shape.segmentBytes;
+        if (!shape.matches(header())) {
+            err = "话题 " + name + " 格式不符或写者尚未初始化完成";
+            unmap();
+            return false;
+        }
+        return true;
+    }
+
+private:
+    void* base;
+    size_t bytes;
+};
+
+template <typename T>
+struct LatestLayout {
+    TopicHeader header;
+    SeqlockSlot<T> slot;
+};
+
+template <typename T, uint32_t N>
+struct StreamLayout {
+    TopicHeader header;
+    SpscRing<T, N> ring;
+};
+
+namespace detail {
+
+template <typename T, typename Layout>
+TopicShape shapeOf(TopicKind kind, uint32_t capacity) {
+    TopicShape s;
+    s.schema = Schema<T>::id;
+    s.payloadBytes = sizeof(T);
+    s.kind = kind;
+    s.capacity = capacity;
+    s.segmentBytes = sizeof(Layout);
+    return s;
+}
+
+// 新段上构造布局，magic 最后写入；接管的段保留原内容
+template <typename Layout>
+Layout* openWriter(Segment& seg, const std::string& name, const TopicShape& shape, std::string& err, bool& reused) {
+    if (!seg.create(name, shape, err, reused)) return nullptr;
+    Layout* l = static_cast<Layout*>(seg.data());
+    if (!reused) {
+        new (l) Layout();
+        TopicHeader& h = l->header;
+        h.layoutVersion = kLayoutVersion;
+        h.schema = shape.schema;
+        h.payloadBytes = shape.payloadBytes;
+        h.kind = shape.kind;
+        h.capacity = shape.capacity;
+        h.segmentBytes = shape.segmentBytes;
+        h.magic.store(kTopicMagic, std::memory_order_release);
+    }
+    l->header.writerPid.store(getpid(), std::memory_order_relaxed);
+    l->header.generation.fetch_add(1, std::memory_order_release);
+    return l;
+}
+
+// 进程放弃写者/读者身份，段本身保留
+inline void release(std::atomic<int32_t>& owner) {
+    int32_t self = getpid();
+    owner.compare_exchange_strong(self, 0, std::memory_order_relaxed);
+}
+
+} // namespace detail
+
+// 最新值话题的写者，一个话题同时只能有一个
+template <typename T>
+class LatestWriter {
+public:
+    typedef LatestLayout<T> Layout;
+
+    ~LatestWriter() {
+        if (layout) detail::release(layout->header.writerPid);
+    }
+
+    bool open(const std::string& name, std::string& err) {
+        bool reused = false;
+        layout = detail::openWriter<Layout>(seg, name, detail::shapeOf<T, Layout>(TOPIC_LATEST, 1), err, reused);
+        if (layout && reused) layout->slot.recover();
+        return layout != nullptr;
+    }
+
+    bool isOpen() const { return layout != nullptr; }
+    void publish(const T& v) { layout->slot.write(v); }
+    uint32_t version() const { return layout->slot.version(); }
+
+private:
+    Segment seg;
+    Layout* layout = nullptr;
+};
+
+// 最新值话题的读者，只读映射，数量不限
+template <typename T>
+class LatestReader {
+public:
+    typedef LatestLayout<T> Layout;
+
+    bool open(const std::string& name, std::string& err) {
+        seen = 0;
+        layout = seg.attach(name, detail::shapeOf<T, Layout>(TOPIC_LATEST, 1), false, err)
+                     ? static_cast<const Layout*>(seg.data())
+                     : nullptr;
+        return layout != nullptr;
+    }
+
+    bool isOpen() const { return layout != nullptr; }
+
+    // 返回写入次数；尚未写过或写者停在写入中途时返回 0
+    uint32_t read(T& out) const {
+        uint32_t v = 0;
+        return layout->slot.tryRead(out, v) ? v : 0;
+    }
+
+    // 自上次 poll 以来有新值时返回 true
+    bool poll(T& out) {
+        uint32_t v = read(out);
+        if (v == 0 || v == seen) return false;
+        seen = v;
+        return true;
+    }
+
+    bool retired() const { return layout->header.retired.load(std::memory_order_acquire) != 0; }
+    int32_t writerPid() const { return layout->header.writerPid.load(std::memory_order_relaxed); }
+
+private:
+    Segment seg;
+    const Layout* layout = nullptr;
+    uint32_t seen = 0;
+};
+
+// 数据流话题的写者，满时丢弃新数据并计数
+template <typename T, uint32_t N>
+class StreamWriter {
+public:
+    typedef StreamLayout<T, N> Layout;
+
+    ~StreamWriter() {
+        if (layout) detail::release(layout->header.writerPid);
+    }
+
+    bool open(const std::string& name, std::string& err) {
+        bool reused = false;
+        layout = detail::openWriter<Layout>(seg, name, detail::shapeOf<T, Layout>(TOPIC_STREAM, N), err, reused);
+        return layout != nullptr;
+    }
+
+    bool isOpen() const { return layout != nullptr; }
+    bool push(const T& v) { return layout->ring.push(v); }
+    uint32_t dropped() const { return layout->ring.droppedCount(); }
+
+private:
+    Segment seg;
+    Layout* layout = nullptr;
+};
+
+// 数据流话题的读者，同时只能有一个（出队要写 tail）
+template <typename T, uint32_t N>
+class StreamReader {
+public:
+    typedef StreamLayout<T, N> Layout;
+
+    ~StreamReader() {
+        if (layout) detail::release(layout->header.readerPid);
+    }
+
+    bool open(const std::string& name, std::string& err) {
+        layout = nullptr;
+        if (!seg.attach(name, detail::shapeOf<T, Layout>(TOPIC_STREAM, N), true, err)) return false;
+        Layout* l = static_cast<Layout*>(seg.data());
+        int32_t pid = l->header.readerPid.load(std::memory_order_relaxed);
+        if (pid != getpid() && detail::processAlive(pid)) {
+            err = "话题 " + name + " 已有读者 (pid " + std::to_string(pid) + ")";
+            seg.unmap();
+            return false;
+        }
+        l->header.readerPid.store(getpid(), std::memory_order_relaxed);
+        layout = l;
+        return true;
+    }
+
+    bool isOpen() const { return layout != nullptr; }
+    bool pop(T& out) { return layout->ring.pop(out); }
+    uint32_t size() const { return layout->ring.size(); }
+    uint32_t dropped() const { return layout->ring.droppedCount(); }
+    bool retired() const { return layout->header.retired.load(std::memory_order_acquire) != 0; }
+
+private:
+    Segment seg;
+    Layout* layout = nullptr;
+};
+
+} // namespace ipc
+
+#endif
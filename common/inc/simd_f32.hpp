@@ -0,0 +1,91 @@
+#ifndef SIMD_F32_HPP
+#define SIMD_F32_HPP
+
+// 4 路 float 的最小封装：NEON (树莓派) 或 SSE (PC)，都没有时退回逐元素循环，SIMD_F32_AVAILABLE 为 0
+// 乘加不融合 (NEON 的 vmlaq_f32 也是先乘后加)，与逐元素的标量写法结果一致
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SIMD_F32_AVAILABLE 1
+
+namespace simd {
+
+typedef float32x4_t F32x4;
+
+inline F32x4 loadF32(const float* p) { return vld1q_f32(p); }
+inline void storeF32(float* p, F32x4 v) { vst1q_f32(p, v); }
+inline F32x4 splatF32(float v) { return vdupq_n_f32(v); }
+// 直接在寄存器里拼，避免逐个写栈再整体读回时的存储转发停顿
+inline F32x4 setF32(float a, float b, float c, float d) {
+    F32x4 v = {a, b, c, d};
+    return v;
+}
+inline F32x4 add(F32x4 a, F32x4 b) { return vaddq_f32(a, b); }
+inline F32x4 mul(F32x4 a, F32x4 b) { return vmulq_f32(a, b); }
+// acc + a * b
+inline F32x4 mla(F32x4 acc, F32x4 a, F32x4 b) { return vmlaq_f32(acc, a, b); }
+
+} // namespace simd
+
+#elif defined(__SSE__)
+#include <xmmintrin.h>
+#define SIMD_F32_AVAILABLE 1
+
+namespace simd {
+
+typedef __m128 F32x4;
+
+inline F32x4 loadF32(const float* p) { return _mm_loadu_ps(p); }
+inline void storeF32(float* p, F32x4 v) { _mm_storeu_ps(p, v); }
+inline F32x4 splatF32(float v) { return _mm_set1_ps(v); }
+inline F32x4 setF32(float a, float b, float c, float d) { return _mm_setr_ps(a, b, c, d); }
+inline F32x4 add(F32x4 a, F32x4 b) { return _mm_add_ps(a, b); }
+inline F32x4 mul(F32x4 a, F32x4 b) { return _mm_mul_ps(a, b); }
+inline F32x4 mla(F32x4 acc, F32x4 a, F32x4 b) { return _mm_add_ps(acc, _mm_mul_ps(a, b)); }
+
+} // namespace simd
+
+#else
+#define SIMD_F32_AVAILABLE 0
+
+namespace simd {
+
+struct F32x4 {
+    float v[4];
+};
+
+inline F32x4 loadF32(const float* p) {
+    F32x4 r;
+    for (int i = 0; i < 4; i++) r.v[i] = p[i];
+    return r;
+}
+inline void storeF32(float* p, F32x4 a) {
+    for (int i = 0; i < 4; i++) p[i] = a.v[i];
+}
+inline F32x4 splatF32(float x) {
+    F32x4 r;
+    for (int i = 0; i < 4; i++) r.v[i] = x;
+    return r;
+}
+inline F32x4 setF32(float a, float b, float c, float d) {
+    F32x4 r = {{a, b, c, d}};
+    return r;
+}
+inline F32x4 add(F32x4 a, F32x4 b) {
+    for (int i = 0; i < 4; i++) a.v[i] += b.v[i];
+    return a;
+}
+inline F32x4 mul(F32x4 a, F32x4 b) {
+    for (int i = 0; i < 4; i++) a.v[i] *= b.v[i];
+    return a;
+}
+inline F32x4 mla(F32x4 acc, F32x4 a, F32x4 b) {
+    for (int i = 0; i < 4; i++) acc.v[i] += a.v[i] * b.v[i];
+    return acc;
+}
+
+} // namespace simd
+
+#endif
+
+#endif
@@ -0,0 +1,417 @@
+#ifndef SPI_BUS_HPP
+#define SPI_BUS_HPP
+
+#include "jitter_stats.hpp"
+#include "rt_clock.hpp"
+#include "trace_zone.hpp"
+
+#include <fcntl.h>
+#include <linux/spi/spidev.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 一个 SPI 控制器上多个设备、多个线程的事务调度
+//   设备：每个片选一个 spidev 节点，各自的速率和模式，执行时按设备切换
+//   客户端：一个线程一个，带优先级；acquire() 排队拿到总线后独占，直到 release()
+//     总线空闲时交给等待中优先级最高的客户端，同优先级按截止时间、再按到达顺序
+//   预约：周期性的高优先级客户端用 reserve() 声明下一次突发的时间窗，
+//     低优先级客户端按预估时长会跨进这个窗口时先不授予，等窗口过去（能在窗口前做完的照常执行）
+//   批处理：一次 transfer() 里连续发往同一设备的传输合成一个 SPI_IOC_MESSAGE(n)，组内每个传输单独拉一次片选
+// 正在进行的 ioctl 不能打断，高优先级客户端最多等一组传输；长传输用预约避开
+// 设备和客户端在启动时添加，之后不再分配内存
+namespace spibus {
+
+const int kMaxBatch = 16;
+
+struct DeviceConfig {
+    std::string name;
+    std::string path = "/dev/spidev0.0";
+    uint32_t speedHz = 1000000;
+    uint8_t mode = SPI_MODE_0;
+};
+
+struct Transfer {
+    int device;                 // SpiBus::addDevice() 的返回值
+    const uint8_t* tx;          // nullptr 时发送全 0
+    uint8_t* rx;                // nullptr 时丢弃
+    uint32_t len;
+};
+
+// 执行同一设备上的一组传输 (n <= kMaxBatch)
+class Backend {
+public:
+    virtual ~Backend() {}
+    // 按 addDevice 的顺序调用，device 即编号
+    virtual bool open(int device, const DeviceConfig& cfg, std::string& err) = 0;
+    virtual bool execute(int device, const DeviceConfig& cfg, const Transfer* xfers, int n) = 0;
+};
+
+// spidev：同一节点上的设备共用一个 fd，模式与上一次不同时先切换，速率写在每个传输里
+class SpidevBackend : public Backend {
+public:
+    ~SpidevBackend() {
+        for (auto& n : nodes) ::close(n.fd);
+    }
+
+    bool open(int device, const DeviceConfig& cfg, std::string& err) override {
+        for (size_t i = 0; i < nodes.size(); i++) {
+            if (nodes[i].path == cfg.path) {
+                setNode(device, static_cast<int>(i));
+                return true;
+            }
+        }
+        int fd = ::open(cfg.path.c_str(), O_RDWR);
+        if (fd < 0) {
+            err = "无法打开 " + cfg.path + ": " + std::strerror(errno);
+            return false;
+        }
+        uint8_t bits = 8;
+        if (ioctl(fd, SPI_IOC_WR_BITS_PER_WORD, &bits) < 0) {
+            err = cfg.path + " 设置字长失败: " + std::strerror(errno);
+            ::close(fd);
+            return false;
+        }
+        Node n;
+        n.path = cfg.path;
+        n.fd = fd;
+        n.mode = -1;
+        nodes.push_back(n);
+        setNode(device, static_cast<int>(nodes.size()) - 1);
+        return true;
+    }
+
+    bool execute(int device, const DeviceConfig& cfg, const Transfer* xfers, int n) override {
+        Node& node = nodes[nodeOf[device]];
+        if (node.mode != cfg.mode) {
+            uint8_t m = cfg.mode;
+            if (ioctl(node.fd, SPI_IOC_WR_MODE, &m) < 0) return false;
+            node.mode = m;
+        }
+        struct spi_ioc_transfer tr[kMaxBatch];
+        std::memset(tr, 0, sizeof(tr[0]) * n);
+        for (int i = 0; i < n; i++) {
+            tr[i].tx_buf = reinterpret_cast<uintptr_t>(xfers[i].tx);
+            tr[i].rx_buf = reinterpret_cast<uintptr_t>(xfers[i].rx);
+            tr[i].len = xfers[i].len;
+            tr[i].speed_hz = cfg.speedHz;
+            tr[i].bits_per_word = 8;
+            tr[i].cs_change = i + 1 < n;   // 组内传输之间释放片选
+        }
+        return ioctl(node.fd, SPI_IOC_MESSAGE(n), tr) >= 0;
+    }
+
+private:
+    struct Node {
+        std::string path;
+        int fd;
+        int mode;
+    };
+    std::vector<Node> nodes;
+    std::vector<int> nodeOf;
+
+    void setNode(int device, int node) {
+        if (static_cast<int>(nodeOf.size()) <= device) nodeOf.resize(device + 1, 0);
+        nodeOf[device] = node;
+    }
+};
+
+// 仿真：每个设备一个应答函数，耗时 = 每次调用开销 + 每个传输 (片选间隔 + 线上时间)
+// 应答函数拿到传输中点的时刻；长于 20 µs 的等待睡眠（像内核 DMA 传输那样让出 CPU），短的自旋
+class SimBackend : public Backend {
+public:
+    typedef std::function<void(const uint8_t* tx, uint8_t* rx, uint32_t len, int64_t midNs)> Responder;
+
+    explicit SimBackend(int64_t callOverheadNs = 8000, int64_t csGapNs = 1000)
+        : callOverheadNs(callOverheadNs), csGapNs(csGapNs), modeSwitches(0), lastMode(-1) {}
+
+    // 在 SpiBus::addDevice 之前按设备名登记；没有应答的设备收到全 0
+    void setResponder(const std::string& name, Responder r) { pending.push_back(std::make_pair(name, r)); }
+
+    bool open(int device, const DeviceConfig& cfg, std::string&) override {
+        if (static_cast<int>(responders.size()) <= device) responders.resize(device + 1);
+        for (auto& p : pending) {
+            if (p.first == cfg.name) responders[device] = p.second;
+        }
+        return true;
+    }
+
+    bool execute(int device, const DeviceConfig& cfg, const Transfer* xfers, int n) override {
+        int64_t t = monotonicNs() + callOverheadNs;
+        if (lastMode != cfg.mode) {
+            modeSwitches++;
+            lastMode = cfg.mode;
+        }
+        for (int i = 0; i < n; i++) {
+            int64_t end = t + csGapNs + static_cast<int64_t>(8ULL * xfers[i].len * 1000000000ULL / cfg.speedHz);
+            if (xfers[i].rx) std::memset(xfers[i].rx, 0, xfers[i].len);
+            if (responders[device]) responders[device](xfers[i].tx, xfers[i].rx, xfers[i].len, t + (end - t) / 2);
+            t = end;
+        }
+        if (t - monotonicNs() > 20000) sleepUntilNs(t);
+        while (monotonicNs() < t) {
+        }
+        return true;
+    }
+
+    uint64_t modeChanges() const { return modeSwitches; }
+
+private:
+    int64_t callOverheadNs, csGapNs;
+    uint64_t modeSwitches;
+    int lastMode;
+    std::vector<std::pair<std::string, Responder>> pending;
+    std::vector<Responder> responders;
+};
+
+struct ClientStats {
+    std::string name;
+    int priority = 0;
+    uint64_t grants = 0;
+    uint64_t transfers = 0;
+    uint64_t batches = 0;       // 执行的 ioctl 次数
+    uint64_t bytes = 0;
+    uint64_t deadlineMisses = 0; // release 时已过截止时间
+    int64_t holdNs = 0;
+    int64_t maxHoldNs = 0;
+    JitterStats wait;           // acquire 到拿到总线
+};
+
+class SpiBus {
+public:
+    explicit SpiBus(Backend& backend, int64_t callOverheadNs = 10000)
+        : backend(backend), callOverheadNs(callOverheadNs), busy(false), holder(-1), arrivals(0),
+          startNs(monotonicNs()), busyNs(0) {}
+
+    SpiBus(const SpiBus&) = delete;
+    SpiBus& operator=(const SpiBus&) = delete;
+
+    // 失败返回 -1
+    int addDevice(const DeviceConfig& cfg, std::string& err) {
+        int id = static_cast<int>(devices.size());
+        if (!backend.open(id, cfg, err)) return -1;
+        devices.push_back(cfg);
+        return id;
+    }
+
+    // 数值大的优先
+    int addClient(const std::string& name, int priority) {
+        std::unique_ptr<Client> c(new Client());
+        c->stats.name = name;
+        c->stats.priority = priority;
+        clients.push_back(std::move(c));
+        return static_cast<int>(clients.size()) - 1;
+    }
+
+    // 阻塞到拿到总线；deadlineNs 为 0 表示没有截止时间，estimateNs 为预计占用时长（用于避开预约窗口）
+    void acquire(int client, int64_t deadlineNs = 0, int64_t estimateNs = 0) {
+        Client& c = *clients[client];
+        std::unique_lock<std::mutex> lock(mutex);
+        int64_t t0 = monotonicNs();
+        c.waiting = true;
+        c.deadlineNs = deadlineNs;
+        c.estimateNs = estimateNs;
+        c.arrival = arrivals++;
+        int64_t now = t0;
+        for (;;) {
+            int64_t until = blockedUntil(client, now);
+            if (until) {
+                c.cv.wait_until(lock, std::chrono::steady_clock::time_point(std::chrono::nanoseconds(until)));
+            } else if (!busy && pick(now) == client) {
+                break;
+            } else {
+                c.cv.wait(lock);
+            }
+            now = monotonicNs();
+        }
+        c.waiting = false;
+        c.reserveEndNs = 0;          // 预约已兑现
+        busy = true;
+        holder = client;
+        c.grantNs = now;
+        c.stats.grants++;
+        c.stats.wait.add(now - t0);
+    }
+
+    void release(int client) {
+        Client& c = *clients[client];
+        std::lock_guard<std::mutex> lock(mutex);
+        if (holder != client) return;
+        int64_t now = monotonicNs();
+        int64_t held = now - c.grantNs;
+        c.stats.holdNs += held;
+        c.stats.maxHoldNs = std::max(c.stats.maxHoldNs, held);
+        if (c.deadlineNs && now > c.deadlineNs) c.stats.deadlineMisses++;
+        busy = false;
+        holder = -1;
+        int next = pick(now);
+        if (next >= 0) clients[next]->cv.notify_one();
+    }
+
+    // 必须持有总线
+    bool transfer(int client, const Transfer* xfers, int n) {
+        if (holder != client) return false;
+        ClientStats& s = clients[client]->stats;
+        bool ok = true;
+        for (int i = 0; i < n;) {
+            int j = i + 1;
+            while (j < n && j - i < kMaxBatch && xfers[j].device == xfers[i].device) j++;
+            int dev = xfers[i].device;
+            int64_t t0 = monotonicNs();
+            {
+                TRACE_ZONE("spi batch");
+                ok = backend.execute(dev, devices[dev], xfers + i, j - i) && ok;
+            }
+            busyNs += monotonicNs() - t0;
+            s.batches++;
+            s.transfers += j - i;
+            for (int k = i; k < j; k++) s.bytes += xfers[k].len;
+            i = j;
+        }
+        return ok;
+    }
+
+    // acquire + transfer + release
+    bool submit(int client, const Transfer* xfers, int n, int64_t deadlineNs = 0) {
+        acquire(client, deadlineNs, estimateNs(xfers, n));
+        bool ok = transfer(client, xfers, n);
+        release(client);
+        return ok;
+    }
+
+    // 声明 [startNs, startNs + durationNs) 内会用总线；同一客户端只保留最近一次预约
+    void reserve(int client, int64_t startNs, int64_t durationNs) {
+        std::lock_guard<std::mutex> lock(mutex);
+        clients[client]->reserveStartNs = startNs;
+        clients[client]->reserveEndNs = startNs + durationNs;
+    }
+
+    // 按设备速率估算的占用时长，含每组的调用开销
+    int64_t estimateNs(const Transfer* xfers, int n) const {
+        int64_t ns = 0;
+        for (int i = 0; i < n; i++) {
+            if (i == 0 || xfers[i].device != xfers[i - 1].device) ns += callOverheadNs;
+            ns += static_cast<int64_t>(8ULL * xfers[i].len * 1000000000ULL / devices[xfers[i].device].speedHz);
+        }
+        return ns;
+    }
+
+    const DeviceConfig& device(int id) const { return devices[id]; }
+    const ClientStats& stats(int client) const { return clients[client]->stats; }
+    int clientCount() const { return static_cast<int>(clients.size()); }
+
+    // 自创建或上次 resetStats() 起总线忙的比例
+    double utilization() const {
+        int64_t elapsed = monotonicNs() - startNs;
+        return elapsed > 0 ? static_cast<double>(busyNs) / elapsed : 0.0;
+    }
+
+    // 各客户端停下后调用
+    void resetStats() {
+        for (auto& c : clients) {
+            ClientStats fresh;
+            fresh.name = c->stats.name;
+            fresh.priority = c->stats.priority;
+            c->stats = fresh;
+        }
+        startNs = monotonicNs();
+        busyNs = 0;
+    }
+
+    void printStats(FILE* out = stdout) const {
+        std::fprintf(out, "spi bus: %.1f%% busy over %.2f s\n", 100.0 * utilization(), (monotonicNs() - startNs) * 1e-9);
+        std::fprintf(out, "  %-10s %4s %8s %8s %8s %10s %22s %6s %9s\n", "client", "prio", "grants", "xfers", "ioctls",
+                     "bytes", "wait p50/p99/max us", "misses", "hold max");
+        for (auto& c : clients) {
+            const ClientStats& s = c->stats;
+            std::fprintf(out, "  %-10s %4d %8llu %8llu %8llu %10llu %6.0f / %5.0f / %7.1f %6llu %7.1fus\n",
+                         s.name.c_str(), s.priority, static_cast<unsigned long long>(s.grants),
+                         static_cast<unsigned long long>(s.transfers), static_cast<unsigned long long>(s.batches),
+                         static_cast<unsigned long long>(s.bytes), s.wait.percentileUs(50), s.wait.percentileUs(99),
+                         s.wait.maxUs(), static_cast<unsigned long long>(s.deadlineMisses), s.maxHoldNs / 1000.0);
+        }
+    }
+
+private:
+    struct Client {
+        ClientStats stats;
+        std::condition_variable cv;
+        bool waiting = false;
+        int64_t deadlineNs = 0;
+        int64_t estimateNs = 0;
+        uint64_t arrival = 0;
+        int64_t grantNs = 0;
+        int64_t reserveStartNs = 0;
+        int64_t reserveEndNs = 0;
+    };
+
+    Backend& backend;
+    int64_t callOverheadNs;
+    std::vector<DeviceConfig> devices;
+    std::vector<std::unique_ptr<Client>> clients;
+    std::mutex mutex;
+    bool busy;
+    int holder;
+    uint64_t arrivals;
+    int64_t startNs;
+    int64_t busyNs;   // 只由持有者写
+
+    // 优先级高、截止时间早、先到的在前
+    bool before(const Client& a, const Client& b) const {
+        if (a.stats.priority != b.stats.priority) return a.stats.priority > b.stats.priority;
+        int64_t da = a.deadlineNs ? a.deadlineNs : INT64_MAX, db = b.deadlineNs ? b.deadlineNs : INT64_MAX;
+        if (da != db) return da < db;
+        return a.arrival < b.arrival;
+    }
+
+    // 现在开始会跨进更高优先级客户端的预约窗口时，返回该窗口的结束时刻，否则 0
+    int64_t blockedUntil(int client, int64_t now) const {
+        const Client& c = *clients[client];
+        int64_t until = 0;
+        for (auto& r : clients) {
+            if (r->stats.priority <= c.stats.priority || r->reserveEndNs <= now) continue;
+            if (now + c.estimateNs > r->reserveStartNs) until = std::max(until, r->reserveEndNs);
+        }
+        return until;
+    }
+
+    int pick(int64_t now) const {
+        int best = -1;
+        for (int i = 0; i < static_cast<int>(clients.size()); i++) {
+            if (!clients[i]->waiting || blockedUntil(i, now)) continue;
+            if (best < 0 || before(*clients[i], *clients[best])) best = i;
+        }
+        return best;
+    }
+};
+
+// 作用域内持有总线
+class Grant {
+public:
+    Grant(SpiBus& bus, int client, int64_t deadlineNs = 0, int64_t estimateNs = 0) : bus(bus), client(client) {
+        bus.acquire(client, deadlineNs, estimateNs);
+    }
+    ~Grant() { bus.release(client); }
+    Grant(const Grant&) = delete;
+    Grant& operator=(const Grant&) = delete;
+
+private:
+    SpiBus& bus;
+    int client;
+};
+
+} // namespace spibus
+
+#endif
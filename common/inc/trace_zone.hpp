@@ -0,0 +1,163 @@
+#ifndef TRACE_ZONE_HPP
+#define TRACE_ZONE_HPP
+
+#include "rt_clock.hpp"
+
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 热路径追踪：TRACE_ZONE("名字") 在作用域开始和结束各取一次时间，结束时写进本线程的环形缓冲
+// TRACE_SPAN("名字", 开始, 结束) 直接记一段已经量好的时间，不再读时钟
+// 只有定义 MILKYWAY_TRACE（cmake -DMILKYWAY_TRACE=ON）才编译进去，否则两个宏都展开为空，参数不求值
+//
+// 名字必须是静态存储期的字符串：字面量，或活得比 dump 久的 c_str()
+// 每个线程第一次记录时分配一次缓冲区，保留最近 kEventsPerThread 个事件，更早的被覆盖
+// dumpChromeJson() 写 Chrome trace JSON，在 ui.perfetto.dev 或 chrome://tracing 打开；
+// 时间戳是 CLOCK_MONOTONIC 的绝对值，不同进程的文件可以合并到一起看
+// 最好在各线程停止后 dump，运行中 dump 时正在写的最后几个事件可能不完整
+namespace trace {
+
+#ifdef MILKYWAY_TRACE
+const bool kEnabled = true;
+#else
+const bool kEnabled = false;
+#endif
+
+const uint32_t kEventsPerThread = 1 << 14;
+
+struct Event {
+    const char* name;
+    int64_t beginNs;
+    int64_t endNs;
+};
+
+// 只由所属线程写
+class ThreadBuffer {
+public:
+    ThreadBuffer() : head(0), tid(static_cast<int>(syscall(SYS_gettid))), events() {
+        name[0] = 0;
+        pthread_getname_np(pthread_self(), name, sizeof(name));
+    }
+
+    void record(const char* n, int64_t beginNs, int64_t endNs) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        Event& e = events[h & (kEventsPerThread - 1)];
+        e.name = n;
+        e.beginNs = beginNs;
+        e.endNs = endNs;
+        head.store(h + 1, std::memory_order_release);
+    }
+
+    std::atomic<uint32_t> head;
+    int tid;
+    char name[16];
+    Event events[kEventsPerThread];
+};
+
+class Registry {
+public:
+    static Registry& instance() {
+        static Registry r;
+        return r;
+    }
+
+    ThreadBuffer* add() {
+        std::unique_ptr<ThreadBuffer> b(new ThreadBuffer());
+        std::lock_guard<std::mutex> lock(mutex);
+        buffers.push_back(std::move(b));
+        return buffers.back().get();
+    }
+
+    // 返回写出的事件数，打不开文件时返回 -1
+    long dumpChromeJson(const std::string& path) {
+        FILE* f = std::fopen(path.c_str(), "w");
+        if (!f) return -1;
+        std::lock_guard<std::mutex> lock(mutex);
+        int pid = static_cast<int>(getpid());
+        long count = 0;
+        std::fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+        bool first = true;
+        for (auto& b : buffers) {
+            std::fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"",
+                         first ? "" : ",\n", pid, b->tid);
+            writeEscaped(f, b->name[0] ? b->name : "thread");
+            std::fprintf(f, "\"}}");
+            first = false;
+
+            uint32_t h = b->head.load(std::memory_order_acquire);
+            uint32_t n = h < kEventsPerThread ? h : kEventsPerThread;
+            for (uint32_t i = h - n; i != h; i++) {
+                const Event& e = b->events[i & (kEventsPerThread - 1)];
+                std::fprintf(f, ",\n{\"name\":\"");
+                writeEscaped(f, e.name);
+                // 微秒，保留纳秒精度
+                std::fprintf(f, "\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%lld.%03d,\"dur\":%lld.%03d}", pid, b->tid,
+                             static_cast<long long>(e.beginNs / 1000), static_cast<int>(e.beginNs % 1000),
+                             static_cast<long long>((e.endNs - e.beginNs) / 1000),
+                             static_cast<int>((e.endNs - e.beginNs) % 1000));
+                count++;
+            }
+        }
+        std::fprintf(f, "\n]}\n");
+        std::fclose(f);
+        return count;
+    }
+
+private:
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers; // 线程退出后保留，dump 时仍可读
+
+    static void writeEscaped(FILE* f, const char* s) {
+        for (; *s; s++) {
+            if (*s == '"' || *s == '\\') std::fputc('\\', f);
+            if (static_cast<unsigned char>(*s) >= 0x20) std::fputc(*s, f);
+        }
+    }
+};
+
+inline ThreadBuffer& threadBuffer() {
+    static thread_local ThreadBuffer* buffer = nullptr;
+    if (!buffer) buffer = Registry::instance().add();
+    return *buffer;
+}
+
+inline void span(const char* name, int64_t beginNs, int64_t endNs) { threadBuffer().record(name, beginNs, endNs); }
+
+class Zone {
+public:
+    explicit Zone(const char* name) : name(name), beginNs(monotonicNs()) {}
+    ~Zone() { span(name, beginNs, monotonicNs()); }
+    Zone(const Zone&) = delete;
+    Zone& operator=(const Zone&) = delete;
+
+private:
+    const char* name;
+    int64_t beginNs;
+};
+
+// 未定义 MILKYWAY_TRACE 时没有事件，写出一个空的 trace
+inline long dumpChromeJson(const std::string& path) { return Registry::instance().dumpChromeJson(path); }
+
+} // namespace trace
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+#ifdef MILKYWAY_TRACE
+#define TRACE_ZONE(name) ::trace::Zone TRACE_CONCAT(traceZone_, __LINE__)(name)
+#define TRACE_SPAN(name, beginNs, endNs) ::trace::span((name), (beginNs), (endNs))
+#else
+#define TRACE_ZONE(name) do {} while (0)
+#define TRACE_SPAN(name, beginNs, endNs) do {} while (0)
+#endif
+
+#endif
@@ -0,0 +1,161 @@
+#ifndef WORKER_POOL_HPP
+#define WORKER_POOL_HPP
+
+#include "rt_clock.hpp"
+#include "rt_memory.hpp"
+#include "trace_zone.hpp"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 常驻工作线程的 fork-join 池：run(n, fn) 把 fn(0) ... fn(n-1) 分给调用线程和工作线程，全部完成后返回
+// 线程在构造时创建，每帧不再创建线程；空闲时先自旋 spinNs 再睡眠，连续帧之间唤醒不走系统调用
+// 工作线程沿用最近一次调用 run() 的线程的调度策略和优先级（实时任务里调用时一起提升）
+
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__arm__) || defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+class WorkerPool {
+public:
+    typedef std::function<void(int task)> Job;
+
+    explicit WorkerPool(int workers, const std::string& name = "worker", int64_t spinNs = 50000)
+        : spinNs(spinNs), ticket(0), pendingTasks(0), sleeping(0), schedVersion(0), job(nullptr), gen(0),
+          quit(false), policy(SCHED_OTHER), priority(0) {
+        for (int i = 0; i < workers; i++) {
+            threads.emplace_back(&WorkerPool::loop, this, name + std::to_string(i + 1));
+        }
+    }
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            quit = true;
+            ticket.store(static_cast<uint64_t>(++gen) << 32);
+        }
+        cv.notify_all();
+        for (auto& t : threads) t.join();
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    static const size_t kStackPrefaultBytes = 64 * 1024;
+
+    // 调用线程也算一个
+    int size() const { return static_cast<int>(threads.size()) + 1; }
+
+    // 不可重入，同一时刻只允许一个线程调用；tasks 不超过 65535
+    void run(int tasks, const Job& fn) {
+        if (tasks <= 0) return;
+        if (threads.empty() || tasks == 1) {
+            for (int i = 0; i < tasks; i++) fn(i);
+            return;
+        }
+
+        syncScheduling();
+        job = &fn;
+        pendingTasks.store(tasks, std::memory_order_relaxed);
+        ticket.store((static_cast<uint64_t>(++gen) << 32) | (static_cast<uint64_t>(tasks) << 16));
+        // 先发布再看有没有睡眠的线程（都是顺序一致），两边至少有一方能看到对方
+        if (sleeping.load() > 0) {
+            { std::lock_guard<std::mutex> lock(m); }
+            cv.notify_all();
+        }
+
+        work(gen);
+        while (pendingTasks.load(std::memory_order_acquire) > 0) cpuRelax();
+    }
+
+private:
+    int64_t spinNs;
+    std::vector<std::thread> threads;
+    std::mutex m;
+    std::condition_variable cv;
+    // 高 32 位轮次，中 16 位任务数，低 16 位下一个任务；轮次和任务一次 CAS 领取，
+    // 落后的工作线程不会领到下一轮的任务，领到任务后 job 在本轮结束前不会变
+    std::atomic<uint64_t> ticket;
+    std::atomic<int> pendingTasks;
+    std::atomic<int> sleeping;
+    std::atomic<uint32_t> schedVersion;
+    const Job* job;
+    uint32_t gen;
+    std::atomic<bool> quit;
+    int policy, priority;
+
+    static uint32_t ticketGen(uint64_t t) { return static_cast<uint32_t>(t >> 32); }
+
+    void work(uint32_t round) {
+        uint64_t t = ticket.load(std::memory_order_acquire);
+        for (;;) {
+            if (ticketGen(t) != round || (t & 0xFFFF) >= ((t >> 16) & 0xFFFF)) return;
+            if (!ticket.compare_exchange_weak(t, t + 1, std::memory_order_acq_rel, std::memory_order_acquire)) continue;
+            {
+                TRACE_ZONE("pool job");
+                (*job)(static_cast<int>(t & 0xFFFF));
+            }
+            pendingTasks.fetch_sub(1, std::memory_order_release);
+            t = ticket.load(std::memory_order_acquire);
+        }
+    }
+
+    void syncScheduling() {
+        int p;
+        struct sched_param sp;
+        if (pthread_getschedparam(pthread_self(), &p, &sp) != 0) return;
+        if (p != policy || sp.sched_priority != priority) {
+            policy = p;
+            priority = sp.sched_priority;
+            schedVersion.fetch_add(1, std::memory_order_release);
+        }
+    }
+
+    void loop(std::string name) {
+        pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+        rtmem::prefaultStack(kStackPrefaultBytes);
+        uint32_t seen = 0, schedSeen = 0;
+
+        for (;;) {
+            // 先自旋等下一轮，超时再睡眠
+            int64_t spinUntil = monotonicNs() + spinNs;
+            int spins = 0;
+            while (ticketGen(ticket.load(std::memory_order_acquire)) == seen) {
+                cpuRelax();
+                if (++spins % 64 == 0 && monotonicNs() > spinUntil) {
+                    std::unique_lock<std::mutex> lock(m);
+                    sleeping.fetch_add(1);
+                    cv.wait(lock, [&] { return ticketGen(ticket.load()) != seen; });
+                    sleeping.fetch_sub(1);
+                }
+            }
+            seen = ticketGen(ticket.load(std::memory_order_acquire));
+            if (quit.load()) return;
+
+            uint32_t v = schedVersion.load(std::memory_order_acquire);
+            if (v != schedSeen) {
+                schedSeen = v;
+                struct sched_param sp;
+                sp.sched_priority = priority;
+                int err = pthread_setschedparam(pthread_self(), policy, &sp);
+                if (err != 0) std::fprintf(stderr, "[%s] 设置调度优先级 %d 失败\n", name.c_str(), priority);
+            }
+            work(seen);
+        }
+    }
+};
+
+#endif
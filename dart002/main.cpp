@@ -2,6 +2,11 @@
 #include <opencv2/opencv.hpp>
 #include <iostream>
 #include <chrono>
+#include <algorithm>
+#include "rt_clock.hpp"
+#include "rt_memory.hpp"
+#include "shm_topic.hpp"
+#include "trace_zone.hpp"
 
 const uchar GREEN_THRESHOLD = 200;
 const uchar MIN_RB_DIFF = 100;
@@ -29,14 +34,33 @@ int main() {
         return -1;
     }
 
+    // 检测结果发布到共享内存话题，其他进程直接读，不用解析标准输出
+    ipc::LatestWriter<ipc::BlobList> blobTopic;
+    std::string topicErr;
+    if (!blobTopic.open(ipc::kBlobTopic, topicErr)) {
+        std::cerr << topicErr << "，不发布检测结果" << std::endl;
+    }
+    ipc::BlobList blobs = ipc::BlobList();
+    uint32_t frameId = 0;
+
     cv::Mat frame, mask(240, 320, CV_8UC1);
     std::vector<std::vector<cv::Point>> contours;
+    contours.reserve(64);
+
+    // 缓冲区都建好后锁定内存；findContours 内部仍会分配，锁定后这些分配落在已缺页的堆里
+    std::string memErr;
+    if (!rtmem::lockMemory(memErr)) std::cerr << memErr << std::endl;
 
     int frameCount = 0, fps = 0;
     auto lastTime = std::chrono::high_resolution_clock::now();
 
     while (true) {
-        camera.grab();
+        TRACE_ZONE("frame");
+        {
+            TRACE_ZONE("camera grab");
+            camera.grab();
+        }
+        int64_t captureNs = monotonicNs();  // grab 返回时刻，近似为曝光时刻
         camera.retrieve(frame);
         if (frame.empty()) {
             std::cerr << "获取帧失败!" << std::endl;
@@ -47,26 +71,55 @@ int main() {
         uchar* maskData = mask.data;
         int totalPixels = frame.rows * frame.cols;
 
-        for (int i = 0; i < totalPixels; i++) {
-            uchar b = imgData[i * 3];
-            uchar g = imgData[i * 3 + 1];
-            uchar r = imgData[i * 3 + 2];
-            maskData[i] = (g > GREEN_THRESHOLD && g - r > MIN_RB_DIFF && g - b > MIN_RB_DIFF) ? 255 : 0;
+        {
+            TRACE_ZONE("threshold");
+            for (int i = 0; i < totalPixels; i++) {
+                uchar b = imgData[i * 3];
+                uchar g = imgData[i * 3 + 1];
+                uchar r = imgData[i * 3 + 2];
+                maskData[i] = (g > GREEN_THRESHOLD && g - r > MIN_RB_DIFF && g - b > MIN_RB_DIFF) ? 255 : 0;
+            }
         }
 
         contours.clear();
-        cv::findContours(mask, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+        {
+            TRACE_ZONE("contours");
+            cv::findContours(mask, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+        }
 
+        blobs.count = 0;
         for (const auto& contour : contours) {
-            if (cv::contourArea(contour) < MIN_AREA) continue;
+            double area = cv::contourArea(contour);
+            if (area < MIN_AREA) continue;
 
             cv::Rect rect = cv::boundingRect(contour);
             int cx = rect.x + rect.width / 2;
             int cy = rect.y + rect.height / 2;
 
+            // 超过 kMaxBlobs 时替换面积最小的
+            ipc::Blob b = {static_cast<float>(cx), static_cast<float>(cy), static_cast<int32_t>(area),
+                           static_cast<int16_t>(rect.x), static_cast<int16_t>(rect.y),
+                           static_cast<int16_t>(rect.x + rect.width - 1), static_cast<int16_t>(rect.y + rect.height - 1)};
+            if (blobs.count < ipc::kMaxBlobs) {
+                blobs.blobs[blobs.count++] = b;
+            } else {
+                ipc::Blob* smallest = std::min_element(blobs.blobs, blobs.blobs + blobs.count,
+                    [](const ipc::Blob& x, const ipc::Blob& y) { return x.area < y.area; });
+                if (smallest->area < b.area) *smallest = b;
+            }
+
             // 仅打印，不显示图像
             std::cout << "中心: (" << cx << ", " << cy << ")" << std::endl;
         }
+        if (blobTopic.isOpen()) {
+            blobs.captureNs = captureNs;
+            blobs.detectNs = monotonicNs();
+            blobs.frameId = frameId;
+            blobs.width = static_cast<uint16_t>(frame.cols);
+            blobs.height = static_cast<uint16_t>(frame.rows);
+            blobTopic.publish(blobs);
+        }
+        frameId++;
 
         frameCount++;
         auto now = std::chrono::high_resolution_clock::now();
@@ -83,5 +136,9 @@ int main() {
     }
 
     camera.release();
+    if (trace::kEnabled) {
+        std::cout << "green_detector_trace.json: " << trace::dumpChromeJson("green_detector_trace.json") << " events"
+                  << std::endl;
+    }
     return 0;
 }
@@ -0,0 +1,55 @@
+#ifndef BNO080_SENSOR_HPP
+#define BNO080_SENSOR_HPP
+
+#include "imu_sensor.hpp"
+#include "pose_estimation.hpp"
+#include "rt_clock.hpp"
+
+#include <string>
+
+// BNO080 -> sensor::ImuSensor：每次 read 轮询一个 SHTP 包，旋转向量报告给出 SAMPLE_QUAT 样本；
+// 其它包或没有数据为 SENSOR_NO_DATA，SPI 传输失败为 SENSOR_FAULT (fault() 为累计失败次数)
+class Bno080Sensor : public sensor::ImuSensor<Bno080Sensor> {
+public:
+    // reportIntervalUs 为 0 时 open 不开启报告 (已由调用者开启)
+    explicit Bno080Sensor(BNO080_SPI& bno, uint32_t reportIntervalUs = 0, int channel = 0)
+        : bno(bno), intervalUs(reportIntervalUs), channel(channel) {}
+
+    bool openImpl(std::string& err) {
+        if (!bno.openDevice()) {
+            err = "BNO080 打开失败";
+            return false;
+        }
+        if (intervalUs && !bno.enableReport(SH2_REPORT_ROTATION_VECTOR, intervalUs)) {
+            err = "BNO080 开启旋转向量报告失败";
+            return false;
+        }
+        return true;
+    }
+
+    sensor::SensorStatus readImpl(sensor::ImuSample& s) {
+        uint32_t failedBefore = bno.failedTransfers();
+        Quaternion q;
+        if (!bno.pollRotationVector(q)) {
+            uint32_t failed = bno.failedTransfers();
+            return failed != failedBefore ? failWith(static_cast<int>(failed)) : sensor::SENSOR_NO_DATA;
+        }
+        s.tNs = monotonicNs();
+        s.flags = sensor::SAMPLE_QUAT;
+        s.channel = static_cast<uint16_t>(channel);
+        s.quat[0] = q.w;
+        s.quat[1] = q.x;
+        s.quat[2] = q.y;
+        s.quat[3] = q.z;
+        return sensor::SENSOR_OK;
+    }
+
+    const char* nameImpl() const { return "bno080"; }
+
+private:
+    BNO080_SPI& bno;
+    uint32_t intervalUs;
+    int channel;
+};
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef CAMERA_MODEL_HPP
+#define CAMERA_MODEL_HPP
+
+#include <string>
+#include <vector>
+
+namespace vision {
+
+// 针孔 + 径向/切向畸变 (与 OpenCV 的 plumb bob 模型相同，像素中心为整数坐标)：
+//   归一化坐标 (x, y) -> r2 = x^2 + y^2
+//   xd = x (1 + k1 r2 + k2 r2^2 + k3 r2^3) + 2 p1 x y + p2 (r2 + 2 x^2)
+//   yd = y (1 + k1 r2 + k2 r2^2 + k3 r2^3) + p1 (r2 + 2 y^2) + 2 p2 x y
+//   u = fx xd + cx   v = fy yd + cy
+// 相机系：x 向右，y 向下，z 沿光轴向前
+struct CameraModel {
+    int width = 320, height = 240;       // 标定时的分辨率
+    double fx = 0, fy = 0, cx = 0, cy = 0;
+    double k1 = 0, k2 = 0, k3 = 0, p1 = 0, p2 = 0;
+
+    // 无畸变针孔，主点在图像中心，焦距由水平视场角得到
+    static CameraModel pinhole(int width, int height, double hfovDeg);
+
+    // 标定文件 (INI)：
+    //   [calibration]
+    //   width = 640      height = 480
+    //   fx = ...  fy = ...  cx = ...  cy = ...
+    //   k1 = ...  k2 = ...  p1 = ...  p2 = ...  k3 = ...
+    bool load(const std::string& path, std::string& err);
+
+    // 换算到另一分辨率（同一传感器区域按比例缩放，例如 640x480 标定、320x240 采集）。
+    // 宽高比不同意味着传感器裁切了另一块区域，不能按比例换算，先用 sameAspect 检查
+    CameraModel scaled(int w, int h) const;
+    bool sameAspect(int w, int h, double tolerance = 0.01) const;
+
+    // 归一化无畸变坐标 -> 像素
+    void project(double x, double y, double& u, double& v) const;
+
+    // 像素 -> 归一化无畸变坐标，不动点迭代求逆畸变
+    void undistort(double u, double v, double& x, double& y, int iterations = 20) const;
+};
+
+// 逐像素方位查找表：每个像素中心预先求出归一化无畸变坐标，亚像素质心按双线性插值
+// 只换算检测到的质心，不对整帧去畸变；表在构造时一次建好
+class BearingLut {
+public:
+    // step 为表格点间距 (像素)，1 为逐像素；畸变平滑时可取 2、4 节省内存
+    explicit BearingLut(const CameraModel& model, int step = 1);
+
+    // 像素坐标 -> 单位方向向量，超出图像的坐标截断到边缘
+    void bearing(float px, float py, float (&dir)[3]) const;
+
+    // 像素坐标 -> 方位角（向右为正）、俯仰角（向上为正）(rad)：az = atan(x)，el = -atan(y)，
+    // 与原来针孔换算的定义相同
+    void angles(float px, float py, float& az, float& el) const;
+
+    // 像素坐标 -> 归一化无畸变坐标
+    void normalized(float px, float py, float& x, float& y) const;
+
+    size_t bytes() const { return table.size() * sizeof(float); }
+    const CameraModel& model() const { return cam; }
+
+private:
+    CameraModel cam;
+    int step, cols, rows;
+    float maxX, maxY;
+    std::vector<float> table;            // 每个格点 (x, y) 两个值，行优先
+};
+
+} // namespace vision
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef COLOR_CLASSIFIER_HPP
+#define COLOR_CLASSIFIER_HPP
+
+#include <cstdint>
+#include <string>
+
+namespace vision {
+
+// 全范围 BT.601 (JFIF) 色度偏移，u = U - 128，v = V - 128，Q10 定点：
+//   R = Y + 1.402v   G = Y - 0.344u - 0.714v   B = Y + 1.772u
+inline void chromaOffsets(int u, int v, int& rOff, int& gOff, int& bOff) {
+    rOff = (1436 * v + 512) >> 10;
+    gOff = (-(352 * u + 731 * v) + 512) >> 10;
+    bOff = (1815 * u + 512) >> 10;
+}
+
+// 可配置的颜色判据：若干条 b、g、r 的整系数线性不等式取与成一组，组之间取或，例如
+//   g > 200 && g - r > 100 && g - b > 100 || r > 220 && 2*r - g - b > 240
+// 编译成 32x32x32 单元的查找表（每通道取高 5 位），每单元 2 位：全部满足 / 全部不满足 / 跨边界，共 8 KB
+// 逐像素查一次表，只有落在跨边界单元里的像素才逐条计算不等式，结果与直接计算完全一致
+// 可平凡复制，可以放进 SeqlockSlot 在线程间传递
+class ColorClassifier {
+public:
+    static const int kMaxTerms = 16;
+    static const int kMaxGroups = 4;
+
+    // 默认为 GreenRule() 的判据
+    ColorClassifier();
+
+    // g > threshold && g - r > rDiff && g - b > bDiff
+    static ColorClassifier green(int threshold, int rDiff, int bDiff);
+
+    // 解析并编译表达式，失败时保持原判据不变
+    bool compile(const std::string& expr, std::string& err);
+
+    bool match(int b, int g, int r) const {
+        int cell = (b >> 3) << 10 | (g >> 3) << 5 | (r >> 3);
+        int state = static_cast<int>(cells[cell >> 5] >> ((cell & 31) * 2)) & 3;
+        return state == kMixed ? evaluate(b, g, r) : state == kInside;
+    }
+
+    // I420 预筛：色度 (U, V) 所在的 8x8 单元在某个亮度下可能满足判据（必要条件）
+    bool chromaPossible(int u, int v) const {
+        int cell = (u >> 3) << 5 | (v >> 3);
+        return (chroma[cell >> 6] >> (cell & 63)) & 1;
+    }
+
+    // 判据恰好是 g > threshold && g - r > rDiff && g - b > bDiff 这种形式时返回 true，
+    // 检测器对它走饱和减法的 SIMD 路径，不查表
+    bool simple(int& threshold, int& rDiff, int& bDiff) const;
+
+    // 所有可能满足判据的颜色的外接盒 (b, g, r，闭区间，按单元取整)，盒外的像素一定不满足
+    // 检测器的 SIMD 粗检对查表判据用它代替查表，不需要 gather
+    void bounds(uint8_t (&lo)[3], uint8_t (&hi)[3]) const;
+
+    // 跨边界单元占比，表示需要逐条计算的颜色空间比例
+    double mixedFraction() const;
+
+private:
+    enum { kOutside = 0, kInside = 1, kMixed = 2 };
+
+    struct Empty {};
+    explicit ColorClassifier(Empty);
+
+    // 第 i 条不等式：coef[i][0] * b + coef[i][1] * g + coef[i][2] * r > bound[i]
+    int16_t coef[kMaxTerms][3];
+    int32_t bound[kMaxTerms];
+    uint8_t groupEnd[kMaxGroups];        // 第 k 组的不等式为 [groupEnd[k-1], groupEnd[k])
+    int groupCount;
+
+    uint64_t cells[32 * 32 * 32 * 2 / 64];
+    uint64_t chroma[32 * 32 / 64];
+    uint8_t boxLo[3], boxHi[3];
+
+    bool evaluate(int b, int g, int r) const {
+        int first = 0;
+        for (int k = 0; k < groupCount; k++) {
+            int i = first;
+            for (; i < groupEnd[k]; i++) {
+                if (coef[i][0] * b + coef[i][1] * g + coef[i][2] * r <= bound[i]) break;
+            }
+            if (i == groupEnd[k]) return true;
+            first = groupEnd[k];
+        }
+        return false;
+    }
+
+    void build();
+};
+
+} // namespace vision
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef FRAME_REPLAY_HPP
+#define FRAME_REPLAY_HPP
+
+#include "frame_source.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// 帧录像文件：FrameFileHeader + 逐帧 (FrameRecordHeader + 像素数据)，小端，格式/尺寸全文件固定
+namespace vision {
+
+struct FrameFileHeader {
+    char magic[4];                       // "MWFR"
+    uint32_t version;
+    uint32_t format;                     // PixelFormat
+    uint32_t width, height, stride;
+    uint32_t bayer;                      // BayerOrder，仅 Bayer 格式有效
+};
+
+struct FrameRecordHeader {
+    int64_t captureNs;
+    uint32_t id;
+    uint32_t bytes;
+};
+
+// 录制，写入阻塞，不要放进实时任务；每帧的格式、尺寸和 stride 须与 open() 时一致
+class FrameRecorder {
+public:
+    ~FrameRecorder() { close(); }
+
+    bool open(const std::string& path, PixelFormat format, int width, int height, int stride,
+              BayerOrder bayer = BAYER_RGGB);
+    bool write(const Frame& frame);
+    void close();
+
+private:
+    FILE* file = nullptr;
+    FrameFileHeader header;
+};
+
+// 回放；paced 时按录制的曝光间隔出帧，captureNs 换算到当前时钟
+class ReplayFrameSource : public FrameSource {
+public:
+    explicit ReplayFrameSource(const std::string& path, bool paced = false, bool loop = false);
+    ~ReplayFrameSource() override { close(); }
+
+    bool open() override;
+    bool grab(Frame& frame) override;
+    void close() override;
+
+    PixelFormat format() const { return static_cast<PixelFormat>(header.format); }
+    int width() const { return static_cast<int>(header.width); }
+    int height() const { return static_cast<int>(header.height); }
+
+private:
+    std::string path;
+    bool paced, loop;
+    FILE* file = nullptr;
+    FrameFileHeader header;
+    long firstRecord = 0;
+    std::vector<uint8_t> buffer;
+    int64_t firstCaptureNs = 0;
+    int64_t originNs = 0;
+};
+
+} // namespace vision
+
+#endif
@@ -0,0 +1,120 @@
+#ifndef FRAME_SOURCE_HPP
+#define FRAME_SOURCE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vision {
+
+enum PixelFormat {
+    PIXEL_BGR24,                         // 打包 BGR，每像素 3 字节
+    PIXEL_I420,                          // 平面 YUV420：Y 全分辨率，其后 U、V 各为 1/4，每像素 1.5 字节
+    PIXEL_BAYER10,                       // 原始 10 位 Bayer，每像素一个小端 uint16 (V4L2 SRGGB10 等)
+    PIXEL_BAYER10P,                      // 原始 10 位 Bayer，MIPI 打包：4 像素 5 字节 (V4L2 SRGGB10P 等)
+};
+
+// Bayer 排列，按左上 2x2 从左到右、从上到下命名
+enum BayerOrder {
+    BAYER_RGGB,
+    BAYER_BGGR,
+    BAYER_GRBG,
+    BAYER_GBRG,
+};
+
+// 整帧字节数；I420 的 stride 指 Y 平面，色度平面行宽为 stride / 2
+size_t frameBytes(PixelFormat format, int stride, int height);
+
+// 一行像素的最小字节数
+int minStride(PixelFormat format, int width);
+
+// 一帧图像的只读视图，data 在下一次 grab() 之前有效
+struct Frame {
+    PixelFormat format;
+    int width;
+    int height;
+    int stride;                          // 每行字节数
+    const uint8_t* data;
+    int64_t captureNs;                   // 曝光时刻 (CLOCK_MONOTONIC)
+    uint32_t id;
+    BayerOrder bayer;                    // 仅 Bayer 格式有效
+
+    // I420 色度平面
+    const uint8_t* planeU() const { return data + static_cast<size_t>(stride) * height; }
+    const uint8_t* planeV() const { return planeU() + static_cast<size_t>(stride / 2) * (height / 2); }
+};
+
+// 相机参数，单位与 dart001/dart002 中 CAP_PROP_* 的取值一致 (0~100)
+struct CameraConfig {
+    PixelFormat format = PIXEL_BGR24;    // I420 时宽需为 32 的倍数、高为 16 的倍数（无行填充）
+    BayerOrder bayerOrder = BAYER_RGGB;  // 原始 Bayer 格式的排列 (IMX219 默认 RGGB)
+    std::string device = "/dev/video0";  // 原始 Bayer 格式走 V4L2 设备
+    int width = 320;
+    int height = 240;
+    int fps = 120;
+    int exposure = 1;                    // 1~100 手动快门，0 自动
+    int gain = 1;
+    int brightness = 50;
+    int contrast = 70;
+    int saturation = 80;
+    int sharpness = 20;
+    float wbRedGain = 0.0f;              // 白平衡增益，0 为自动白平衡
+    float wbBlueGain = 0.0f;
+    int captureLatencyUs = 0;            // 曝光到 grab() 返回的固定延迟
+    int rawExposureLines = 0;            // 原始 Bayer：传感器曝光行数，0 为驱动默认
+    int rawAnalogGain = 0;               // 原始 Bayer：传感器模拟增益寄存器值，0 为驱动默认
+};
+
+class FrameSource {
+public:
+    virtual ~FrameSource() {}
+    virtual bool open() = 0;
+    virtual bool grab(Frame& frame) = 0;
+    virtual void close() = 0;
+};
+
+#ifdef HAVE_RASPICAM
+// 树莓派摄像头，直接读取 raspicam 内部缓冲区，不经过 OpenCV
+class RaspicamFrameSource : public FrameSource {
+public:
+    explicit RaspicamFrameSource(const CameraConfig& config);
+    ~RaspicamFrameSource() override;
+
+    bool open() override;
+    bool grab(Frame& frame) override;
+    void close() override;
+
+private:
+    struct Impl;
+    Impl* impl;
+    CameraConfig cfg;
+    uint32_t frameId = 0;
+};
+#endif
+
+// V4L2 原始 Bayer 采集 (树莓派 unicam 等)，绕过 ISP 的去马赛克、白平衡和色彩转换
+// mmap 缓冲区零拷贝，帧数据在下一次 grab() 之前有效；曝光时刻取驱动的单调时钟时间戳
+class V4l2BayerFrameSource : public FrameSource {
+public:
+    explicit V4l2BayerFrameSource(const CameraConfig& config);
+    ~V4l2BayerFrameSource() override;
+
+    bool open() override;
+    bool grab(Frame& frame) override;
+    void close() override;
+
+private:
+    CameraConfig cfg;
+    int fd = -1;
+    int width = 0, height = 0, stride = 0;
+    std::vector<std::pair<void*, size_t>> buffers;
+    int held = -1;                       // 上一次 grab() 交给调用者、尚未归还驱动的缓冲区
+    uint32_t frameId = 0;
+
+    void setControl(uint32_t id, int32_t value);
+};
+
+} // namespace vision
+
+#endif
@@ -0,0 +1,147 @@
+#ifndef GUIDANCE_HPP
+#define GUIDANCE_HPP
+
+#include "camera_model.hpp"
+#include "imu_sensor.hpp"
+#include "light_detector.hpp"
+#include "servo_controller.hpp"
+#include "target_tracker.hpp"
+
+#include <cstdint>
+#include <utility>
+
+namespace guidance {
+
+// IMU 任务发布的最新状态；yaw/pitch 由全速率预积分的四元数换算，yaw 连续展开不回绕
+struct ImuState {
+    int64_t tNs;
+    float gyro[3];                       // rad/s
+    float accel[3];                      // m/s^2
+    float yaw, pitch;                    // rad
+    float yawRate, pitchRate;            // rad/s
+};
+
+// BNO080 发布的姿态四元数
+struct AhrsState {
+    int64_t tNs;
+    float w, x, y, z;
+};
+
+// 融合任务发布给舵机任务的跟踪器快照
+struct TrackSnapshot {
+    tracker::CaTargetTracker tracker;    // 惯性系方位
+    int64_t lastCaptureNs;               // 最近一次被融合的测量的曝光时刻
+    int64_t lastDetectNs;                // 该测量的检测完成时刻
+    int64_t fusedNs;                     // 融合完成时刻
+    uint32_t frameId;
+};
+
+// 原始 IMU 读数来源（BMI088、进程间话题或仿真）
+//   SENSOR_OK 时写入读数；SENSOR_NO_DATA 只是这个周期还没有新样本，
+//   SENSOR_FAULT / SENSOR_END 才表示来源失效，IMU 任务据此停止心跳交给看门狗
+class ImuSource {
+public:
+    virtual ~ImuSource() {}
+    virtual sensor::SensorStatus read(float (&gyro)[3], float (&accel)[3]) = 0;
+};
+
+// 绝对姿态来源（BNO080 或仿真）；没有新数据时返回 false
+class AhrsSource {
+public:
+    virtual ~AhrsSource() {}
+    virtual bool poll(AhrsState& state) = 0;
+};
+
+// 编译期传感器 (sensor::ImuSensor) -> 运行时接口；传感器由适配器持有，构造参数原样转发。
+// 每周期只有这一次虚调用，传感器内部全部静态分派
+template <class S>
+class SensorImuSource : public ImuSource {
+    static_assert(sensor::IsImuSensor<S>::value, "S must derive from sensor::ImuSensor<S>");
+
+public:
+    template <class... Args>
+    explicit SensorImuSource(Args&&... args) : dev(std::forward<Args>(args)...) {}
+
+    sensor::SensorStatus read(float (&gyro)[3], float (&accel)[3]) override {
+        sensor::ImuSample s;
+        sensor::SensorStatus st = dev.read(s);
+        if (st != sensor::SENSOR_OK) return st;
+        if (!s.has(sensor::SAMPLE_GYRO | sensor::SAMPLE_ACCEL)) return sensor::SENSOR_NO_DATA;
+        for (int i = 0; i < 3; i++) {
+            gyro[i] = s.gyro[i];
+            accel[i] = s.accel[i];
+        }
+        return sensor::SENSOR_OK;
+    }
+
+    S& get() { return dev; }
+
+private:
+    S dev;
+};
+
+template <class S>
+class SensorAhrsSource : public AhrsSource {
+    static_assert(sensor::IsImuSensor<S>::value, "S must derive from sensor::ImuSensor<S>");
+
+public:
+    template <class... Args>
+    explicit SensorAhrsSource(Args&&... args) : dev(std::forward<Args>(args)...) {}
+
+    bool poll(AhrsState& state) override {
+        sensor::ImuSample s;
+        if (dev.read(s) != sensor::SENSOR_OK || !s.has(sensor::SAMPLE_QUAT)) return false;
+        state.w = s.quat[0];
+        state.x = s.quat[1];
+        state.y = s.quat[2];
+        state.z = s.quat[3];
+        return true;
+    }
+
+    S& get() { return dev; }
+
+private:
+    S dev;
+};
+
+struct ControlConfig {
+    float hfovDeg = 62.2f;               // 水平视场角 (树莓派 v2 摄像头)，没有标定文件时按它构造针孔模型
+    float kp = 1.5f;                     // 视线角比例增益
+    float kn = 0.3f;                     // 视线角速度增益
+    float maxFinRad = 0.6f;
+    // 舵面混控：angle[i] = mix[i][0] * pitch + mix[i][1] * yaw
+    float mix[servo::kServoCount][2] = {{1, 1}, {1, -1}, {-1, -1}, {-1, 1}};
+};
+
+// 融合：检测结果 + 曝光时刻的机体姿态 -> 惯性系方位测量，更新跟踪器
+class FusionStage {
+public:
+    // camera 为采集分辨率下的相机模型
+    FusionStage(const tracker::TrackerConfig& trackerCfg, const vision::CameraModel& camera);
+
+    // 返回 true 表示跟踪器被更新
+    bool process(const vision::BlobList& blobs, const ImuState& imu, TrackSnapshot& out);
+
+    const tracker::CaTargetTracker& tracker() const { return trk; }
+
+private:
+    tracker::CaTargetTracker trk;
+    vision::BearingLut bearing;
+};
+
+// 控制：把惯性系方位预测到执行时刻，减去同一时刻的预测机体姿态，输出舵面角
+class ControlStage {
+public:
+    explicit ControlStage(const ControlConfig& cfg);
+
+    // 跟踪无效时输出 0 并返回 false
+    bool compute(const TrackSnapshot& snap, const ImuState& imu, int64_t nowNs,
+                 float (&angles)[servo::kServoCount]) const;
+
+private:
+    ControlConfig cfg;
+};
+
+} // namespace guidance
+
+#endif
@@ -0,0 +1,134 @@
+#ifndef GUIDANCE_RUNTIME_HPP
+#define GUIDANCE_RUNTIME_HPP
+
+#include "flight_recorder.hpp"
+#include "frame_source.hpp"
+#include "guidance.hpp"
+#include "imu_filter.hpp"
+#include "jitter_stats.hpp"
+#include "light_detector.hpp"
+#include "lockfree_channel.hpp"
+#include "preintegration.hpp"
+#include "quality_governor.hpp"
+#include "rt_task.hpp"
+#include "runtime_config.hpp"
+#include "servo_controller.hpp"
+#include "shm_topic.hpp"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// 各级时间戳统计：曝光 -> 检测 -> 融合 -> 舵机提交
+struct PipelineLatency {
+    JitterStats captureToDetect;
+    JitterStats detectToFusion;
+    JitterStats fusionToServo;
+    JitterStats captureToServo;
+
+    void print() const;
+};
+
+// 相机检测、IMU、AHRS、融合和舵机输出的任务组合
+// 传感器与舵机后端由调用者注入，真实硬件和离线基准共用同一条链路
+// governor.enabled 时视觉任务按处理时间和温度/频率 (thermal，可为 nullptr) 调节检测质量
+class GuidanceRuntime {
+public:
+    GuidanceRuntime(const RuntimeConfig& cfg, servo::ServoBank& bank, vision::FrameSource* camera,
+                    guidance::ImuSource* imu, guidance::AhrsSource* ahrs, vision::ThermalSource* thermal = nullptr);
+    ~GuidanceRuntime();
+
+    bool begin();                        // 打开舵机组并回中
+    void start();                        // 启动全部任务和看门狗
+    void stop();                         // 停止并等待全部任务
+    void end();                          // 回中并关闭舵机组
+
+    void printStats() const;
+
+    // 运行中替换检测器的颜色判据，下一帧生效；同一时刻只允许一个线程调用
+    void retuneDetector(const vision::ColorClassifier& c) { detector.retune(c); }
+
+    // 在 start() 之前调用：IMU、视觉、舵机任务各登记一个生产者，每个周期写一条记录
+    void attachRecorder(flight::FlightRecorder& rec);
+
+    // 在 start() 之前调用：创建检测结果和舵机指令的进程间话题，之后每个周期发布
+    bool openTopics(std::string& err);
+
+    // 取出检测质量的档位变化事件，可在任意一个线程调用
+    bool pollQualityEvent(vision::QualityEvent& e) { return governed && governor.pollEvent(e); }
+
+    const PipelineLatency& latency() const { return hops; }
+    const std::vector<std::unique_ptr<RtTask>>& allTasks() const { return tasks; }
+    uint32_t blobDrops() const { return blobRing.droppedCount(); }
+    const servo::ServoLoop& servoLoop() const { return loop; }
+
+private:
+    RuntimeConfig cfg;
+    servo::ServoBank& bank;
+    vision::FrameSource* camera;
+    guidance::ImuSource* imu;
+    guidance::AhrsSource* ahrs;
+    vision::ThermalSource* thermal;
+
+    std::atomic<float> setpoints[servo::kServoCount];
+    std::atomic<int> failsafeCount;
+    servo::ServoLoop loop;
+
+    // 任务间通道
+    SpscRing<vision::BlobList, 8> blobRing;
+    SeqlockSlot<guidance::ImuState> imuSlot;
+    SeqlockSlot<guidance::AhrsState> ahrsSlot;
+    SeqlockSlot<guidance::TrackSnapshot> trackSlot;
+    SeqlockSlot<vision::ThermalSample> thermalSlot;
+    // 各读线程自己的读端：同一 CPU 上高优先级读者 (servo 读 fusion、imu 读 ahrs) 不能无限等写者
+    SeqlockReader<guidance::ImuState> fusionImu;
+    SeqlockReader<guidance::ImuState> servoImu;
+    SeqlockReader<guidance::TrackSnapshot> servoTrack;
+    SeqlockReader<guidance::AhrsState> imuAhrs;
+    SeqlockReader<vision::ThermalSample> visionThermal;
+
+    // 各任务私有状态，只在各自线程内访问
+    vision::LightDetector detector;
+    vision::QualityGovernor governor;    // 含对齐的事件通道，按值存放
+    bool governed;
+    vision::Blob target;                 // 上一帧最大的目标，质量档位或 detector.roi 的区域以它为中心
+    bool hasTarget;
+    guidance::FusionStage fusion;
+    guidance::ControlStage control;
+    guidance::ImuState imuState;
+    imufilter::FilterBank imuFilter;     // 级数为 0 时不滤波
+    imufilter::PeakFinder imuPeak;
+    bool imuPeakTracking;
+    preint::Preintegrator imuPreint;     // IMU 线程全速率积分，姿态取自它的累计四元数
+    float yawUnwrapped, lastYaw;         // 累计偏航展开成连续角，不在 ±pi 处跳变
+    float yawTrim, pitchTrim;            // AHRS 修正量，叠加在积分姿态上
+    uint32_t ahrsSeen;
+    guidance::TrackSnapshot fusionSnap;
+    preint::Reader fusionPreint;         // 融合、舵机各取自己周期内的角增量
+    preint::Reader servoPreint;
+    int64_t lastServoCapture;
+    PipelineLatency hops;
+
+    // 飞行记录，未接入时为 nullptr
+    flight::FlightProducer* imuLog;
+    flight::FlightProducer* visionLog;
+    flight::FlightProducer* servoLog;
+
+    // 进程间话题，未打开时不发布
+    ipc::LatestWriter<ipc::BlobList> blobTopic;
+    ipc::LatestWriter<ipc::ServoSetpoint> servoTopic;
+
+    std::vector<std::unique_ptr<RtTask>> tasks;
+    RtTask* imuTask;
+    RtTask* fusionTask;
+    std::unique_ptr<Watchdog> watchdog;
+
+    void visionCycle(int64_t now);
+    void imuCycle(int64_t now);
+    void ahrsCycle(int64_t now);
+    void fusionCycle(int64_t now);
+    void servoCycle(int64_t now);
+    void thermalCycle(int64_t now);
+};
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef IMAGE_CONVERT_HPP
+#define IMAGE_CONVERT_HPP
+
+#include "frame_source.hpp"
+
+#include <cstdint>
+
+// 全范围 BT.601 (JFIF) 的 BGR24 <-> I420 转换和 Bayer 马赛克，用于离线比较和仿真，不在实时链路中使用
+namespace vision {
+
+// 色度取 2x2 平均；width、height 需为偶数
+void bgrToI420(const uint8_t* bgr, int bgrStride, int width, int height, uint8_t* i420, int yStride);
+
+// 色度最近邻上采样
+void i420ToBgr(const uint8_t* i420, int yStride, int width, int height, uint8_t* bgr, int bgrStride);
+
+// BGR24 -> 10 位 Bayer (PIXEL_BAYER10 或 PIXEL_BAYER10P)：8 位值左移 2 位，红、蓝除以白平衡增益
+// 模拟传感器原始输出；width 为 4 的倍数，height 为偶数
+void bgrToBayer10(const uint8_t* bgr, int bgrStride, int width, int height, PixelFormat format, BayerOrder order,
+                  float redGain, float blueGain, uint8_t* raw, int rawStride);
+
+// 10 位 Bayer -> BGR24：每个 2x2 单元还原成同一颜色（取高 8 位，两个绿取平均，乘白平衡增益）
+void bayer10ToBgr(const uint8_t* raw, int rawStride, int width, int height, PixelFormat format, BayerOrder order,
+                  float redGain, float blueGain, uint8_t* bgr, int bgrStride);
+
+} // namespace vision
+
+#endif
@@ -0,0 +1,225 @@
+#ifndef LIGHT_DETECTOR_HPP
+#define LIGHT_DETECTOR_HPP
+
+#include "color_classifier.hpp"
+#include "frame_source.hpp"
+#include "lockfree_channel.hpp"
+#include "worker_pool.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace vision {
+
+const int kMaxBlobs = 16;
+
+// 绿色目标判据：g > greenThreshold && g - r > minRbDiff && g - b > minRbDiff
+// 其他颜色或多组判据用 ColorClassifier，见 LightDetector::setClassifier()
+struct GreenRule {
+    uint8_t greenThreshold = 200;
+    uint8_t minRbDiff = 100;
+    int minArea = 1;                     // 最小连通域面积 (像素)
+    float rawRedGain = 1.0f;             // 原始 Bayer 数据不经 ISP 白平衡，判别前红、蓝乘此增益
+    float rawBlueGain = 1.0f;
+};
+
+// 检测方式
+struct DetectorOptions {
+    // 两级检测：先按 8x8 块判断有没有满足判据的像素，只在候选块内写掩码、标记连通域，
+    // 工作量随目标大小而不是帧大小增长；结果与整帧检测相同。false 为整帧写掩码再标记
+    bool tiled = true;
+    // BGR / I420 路径按 8 行对齐的横条分给多个线程（调用线程也算一个），条带边界处合并连通域，
+    // 结果与单线程相同；Bayer 路径始终单线程
+    int threads = 1;
+    // 2 为隔行隔列取样：每个 2x2 单元只判别左上角像素，在半分辨率上单线程标记，结果换算回全分辨率
+    // （与 Bayer 路径相同），像素工作量约为 1/4，小目标可能漏检；1 为逐像素
+    int subsample = 1;
+    // 质心按像素亮度 (BGR 三通道之和 / I420 的 Y) 加权，亚像素精度更高，多扫一遍保留连通域的行程
+    // 只对逐像素 (subsample = 1) 的 BGR / I420 路径生效
+    bool refine = false;
+};
+
+const int kTileSize = 8;
+
+struct Blob {
+    float cx, cy;                        // 质心 (像素)
+    int32_t area;                        // 像素数
+    int16_t x0, y0, x1, y1;              // 外接矩形，闭区间
+};
+
+// 定长检测结果，可直接放进无锁通道
+struct BlobList {
+    int64_t captureNs;                   // 曝光时刻
+    int64_t detectNs;                    // 检测完成时刻
+    uint32_t frameId;
+    int32_t count;
+    Blob blobs[kMaxBlobs];
+
+    // 面积最大的连通域，没有时返回 nullptr
+    const Blob* largest() const;
+};
+
+// 行程编码连通域标记（8 邻域），缓冲区在构造时一次分配
+// 输出按连通域第一个行程的光栅顺序排列；超过 kMaxBlobs 时保留面积最大的
+class BlobLabeler {
+public:
+    BlobLabeler(int width, int height);
+
+    // 标记 mask 的 [y0, y1) 行，非零为前景
+    void label(const uint8_t* mask, int stride, int y0, int y1, int minArea, BlobList& out);
+
+    // 分块标记：begin() 按行把帧分成若干条带 (rowStarts 有 stripes + 1 个元素，nullptr 为整帧一个条带)，
+    // 再对每个条带内互不重叠的矩形调用 addRect()，finish() 连接跨条带边界的连通域并输出
+    // 各条带的行程写在各自的下标区间，不同条带的 addRect() 可以在不同线程里同时调用
+    // 调用者保证条带内的前景连通域不跨矩形，结果与对整帧调用 label() 相同
+    void begin(const int* rowStarts = nullptr, int stripes = 1);
+    void addRect(int stripe, const uint8_t* mask, int stride, int x0, int x1, int y0, int y1);
+    // weights 非空时质心按权重加权：像素 (x, y) 的权重为 weights + y * weightStride + x * weightBytes
+    // 开始的 weightBytes 个字节之和，权重全为 0 的连通域仍用几何质心
+    void finish(int minArea, BlobList& out, const uint8_t* weights = nullptr, int weightStride = 0,
+                int weightBytes = 1);
+
+    static const int kMaxStripes = 16;
+
+private:
+    int width, height;
+    std::vector<int16_t> runX0, runX1, runY;
+    std::vector<int32_t> parent;
+    std::vector<int64_t> sumX, sumY;
+    std::vector<int32_t> area;
+    std::vector<int16_t> bx0, by0, bx1, by1;
+    std::vector<int32_t> roots;
+    std::vector<int8_t> slot;            // 加权质心：保留的根节点在输出中的序号，其余为 -1
+    int stripeCount;
+    int32_t stripeBegin[kMaxStripes], stripeEnd[kMaxStripes];
+    int stripeRow[kMaxStripes + 1];
+    std::vector<int32_t> above, below;   // 条带边界两侧的行程
+
+    int32_t find(int32_t i);
+    void mergeStripes();
+    bool rasterBefore(int32_t a, int32_t b) const;
+    void unite(int32_t a, int32_t b);
+};
+
+class LightDetector {
+public:
+    LightDetector(int width, int height, const GreenRule& rule = GreenRule(),
+                  const DetectorOptions& options = DetectorOptions());
+
+    // 同时把颜色判据重置为 rule 对应的绿色判据
+    void setRule(const GreenRule& r);
+    const GreenRule& getRule() const { return rule; }
+
+    // 替换颜色判据（最小面积、原始增益仍取自 GreenRule），只能在检测线程调用
+    void setClassifier(const ColorClassifier& c);
+    const ColorClassifier& getClassifier() const { return classifier; }
+
+    // 可在另一个线程调用（同一时刻只允许一个线程），下一帧开始时生效，检测线程不加锁
+    void retune(const ColorClassifier& c) { retuned.write(c); }
+
+    void setOptions(const DetectorOptions& o);
+    const DetectorOptions& getOptions() const { return opts; }
+
+    // 感兴趣区域 [x0, x1) x [y0, y1) (像素)，之后的帧只检测区域内：x 向外对齐到 16 像素，y 对齐到 8 行，
+    // 截断到图像内；空区域等同 clearRoi()。只能在检测线程调用
+    void setRoi(int x0, int y0, int x1, int y1);
+    void clearRoi();
+    bool hasRoi() const { return roiX0 > 0 || roiY0 > 0 || roiX1 < width || roiY1 < height; }
+
+    // 打包 BGR24 帧
+    void detectBgr(const uint8_t* bgr, int stride, BlobList& out);
+
+    // 平面 YUV420 帧：色度按 1/4 分辨率判别，只在候选 2x2 块内读全分辨率亮度细化
+    // 与在同一帧的 BGR 转换结果上运行 detectBgr 等价（色度最近邻上采样）
+    void detectI420(const uint8_t* y, int yStride, const uint8_t* u, const uint8_t* v, int cStride,
+                    BlobList& out);
+
+    // 原始 10 位 Bayer 帧 (PIXEL_BAYER10 / PIXEL_BAYER10P)：每个 2x2 单元取 r、两个 g 的平均、b
+    // 的高 8 位按同一判据判别，在半分辨率上标记，结果换算回全分辨率坐标（面积按 4 像素计）
+    // 打包格式要求宽为 4 的倍数
+    void detectBayer(const uint8_t* raw, int stride, PixelFormat format, BayerOrder order, BlobList& out);
+
+    // 按帧格式分派，尺寸不符或格式不支持时返回 false
+    bool detect(const Frame& frame, BlobList& out);
+
+    // 上一次 detectI420 细化的 2x2 块数
+    int32_t candidateBlocks() const { return blockCount; }
+    // 上一次两级检测的候选 8x8 块数
+    int32_t candidateTiles() const { return tileCount; }
+
+    // 全分辨率掩码，逐像素的 BGR / I420 路径有效，区域外为 0
+    const uint8_t* mask() const { return maskBuf.data(); }
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+
+private:
+    int width, height;
+    GreenRule rule;
+    DetectorOptions opts;
+    std::vector<uint8_t> maskBuf;
+    BlobLabeler labeler;
+
+    // 颜色判据；是简单绿色形式时用阈值直接判别（BGR 粗检走 SIMD），否则逐像素查表
+    ColorClassifier classifier;
+    bool simpleRule;
+    int thr, rDiff, bDiff;
+    SeqlockSlot<ColorClassifier> retuned;
+    uint32_t retunedSeen;
+    ColorClassifier retunedScratch;      // pollRetune 的读缓冲，构造时分配，检测线程里不再构造判据
+
+    // 两级检测只写候选 8x8 块，下一帧只需清掉这些块；整帧检测写满区域，下一帧清掉这个矩形
+    int tilesX, tilesY;
+    std::vector<uint8_t> tileFlags;
+    int32_t tileCount;
+    int dirtyX0, dirtyY0, dirtyX1, dirtyY1;
+
+    // 感兴趣区域，以及本帧对齐后的列范围 [colX0, colX1)
+    int roiX0, roiY0, roiX1, roiY1;
+    int colX0, colX1;
+
+    // 每个线程处理一个横条，只读写自己的行和块行；每帧按区域的块行重新切分，前 activeStripes 个有效
+    struct Stripe {
+        int y0, y1;                      // 像素行 [y0, y1)
+        int ty0, ty1;                    // 块行 [ty0, ty1)
+        std::vector<int32_t> tiles;      // 本帧候选块，同时是下一帧要清的块
+        int32_t tileCount;
+        std::vector<int32_t> stack;
+        std::vector<int16_t> regions;    // 每 4 个一组：候选块连通区域的 x0, y0, x1, y1（块坐标，闭区间）
+        std::vector<uint8_t> candidate;  // I420 路径：一行 1/4 分辨率候选块
+        int32_t blockCount;
+    };
+    std::vector<Stripe> stripes;
+    int activeStripes;
+    int stripeRows[BlobLabeler::kMaxStripes + 1];
+    std::unique_ptr<WorkerPool> pool;    // 按最大线程数创建，只增不减
+
+    // I420 路径细化的 2x2 块数
+    int32_t blockCount;
+
+    // Bayer 和隔行取样路径：半分辨率掩码和行解码缓冲
+    std::vector<uint8_t> quadMask;
+    std::vector<uint8_t> rowTop, rowBottom;
+    BlobLabeler quadLabeler;
+
+    void configure();
+    void pollRetune();
+    template <class Fn> void runStripes(const Fn& fn);
+    void beginFrame();
+    void clearMask(Stripe& st);
+    void quadRange(int& qx0, int& qy0, int& qx1, int& qy1) const;
+    void labelQuads(int qx0, int qy0, int qx1, int qy1, BlobList& out);
+    void subsampleBgr(const uint8_t* bgr, int stride, BlobList& out);
+    void subsampleI420(const uint8_t* yPlane, int yStride, const uint8_t* uPlane, const uint8_t* vPlane, int cStride,
+                       BlobList& out);
+    void coarseBgr(const uint8_t* bgr, int stride, Stripe& st);
+    void fineBgr(const uint8_t* bgr, int stride, Stripe& st);
+    void collectTiles(Stripe& st);
+    void labelTiles(Stripe& st, int index);
+    void i420Stripe(const uint8_t* yPlane, int yStride, const uint8_t* uPlane, const uint8_t* vPlane, int cStride,
+                    Stripe& st);
+};
+
+} // namespace vision
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef POSE_ESTIMATION_HPP
+#define POSE_ESTIMATION_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// BNO080 SHTP 通道
+enum {
+    SHTP_CHANNEL_COMMAND = 0,
+    SHTP_CHANNEL_EXECUTABLE = 1,
+    SHTP_CHANNEL_CONTROL = 2,
+    SHTP_CHANNEL_REPORTS = 3,
+    SHTP_CHANNEL_WAKE_REPORTS = 4,
+    SHTP_CHANNEL_GYRO = 5,
+};
+
+// SH-2 报告 ID
+enum {
+    SH2_REPORT_ROTATION_VECTOR = 0x05,
+    SH2_REPORT_GAME_ROTATION_VECTOR = 0x08,
+    SH2_BASE_TIMESTAMP = 0xFB,
+    SH2_SET_FEATURE_COMMAND = 0xFD,
+};
+
+namespace spibus {
+class SpiBus;
+}
+
+struct Quaternion {
+    float w, x, y, z;
+};
+
+// BNO080 SPI接口类（简化）
+class BNO080_SPI {
+public:
+    BNO080_SPI(const char* device = "/dev/spidev0.0", uint32_t speed = 1000000);
+    // 经共享总线调度器访问：device、client 为 bus 上已添加的设备和客户端，速率和模式由设备配置决定
+    BNO080_SPI(spibus::SpiBus& bus, int device, int client);
+    ~BNO080_SPI();
+
+    // 使用调度器时直接返回 true
+    bool openDevice();
+
+    // SPI 全双工传输，tx_buf 为 nullptr 时发送全 0
+    bool transfer(const uint8_t* tx_buf, uint8_t* rx_buf, size_t len);
+
+    // 读取SHTP包头，返回包长度，通道号，序号
+    bool readHeader(uint16_t& length, uint8_t& channel, uint8_t& seq);
+
+    // 读取包体数据
+    bool readPayload(uint8_t* buffer, size_t len);
+
+    // 发送一个 SHTP 包
+    bool sendPacket(uint8_t channel, const uint8_t* data, size_t len);
+
+    // 以 intervalUs 周期开启某个传感器报告
+    bool enableReport(uint8_t reportId, uint32_t intervalUs);
+
+    // 读一个包，若是旋转向量报告则解析为四元数；无数据或其它报告返回 false
+    bool pollRotationVector(Quaternion& q);
+
+    // 失败的 SPI 传输累计次数，用来区分“没有数据”和总线错误
+    uint32_t failedTransfers() const { return failed; }
+
+private:
+    char spi_device[64];
+    int fd;
+    uint32_t spi_speed;
+    uint8_t txSeq[6];
+    spibus::SpiBus* bus;
+    int busDevice;
+    int busClient;
+    uint32_t failed;
+};
+
+#endif
@@ -0,0 +1,156 @@
+#ifndef QUALITY_GOVERNOR_HPP
+#define QUALITY_GOVERNOR_HPP
+
+#include "light_detector.hpp"
+#include "lockfree_channel.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vision {
+
+// 一档检测质量，档位表由高到低排列
+struct QualityLevel {
+    int roiHalfSize = 0;                 // 以上一帧最大目标为中心的区域半边长 (像素)，0 为整帧；没有目标时整帧
+    int subsample = 1;                   // 见 DetectorOptions::subsample
+    int threads = 0;                     // 0 沿用 detector.threads
+    bool refine = false;                 // 见 DetectorOptions::refine
+};
+
+// 解析 "roi=96 sub=2 threads=2 refine=0; ..."，各档用 ';' 分隔，档内没写的项取 QualityLevel 的默认值
+bool parseQualityLevels(const std::string& text, std::vector<QualityLevel>& levels, std::string& err);
+
+struct GovernorConfig {
+    bool enabled = false;
+    std::vector<QualityLevel> levels;    // 空时用 defaultLevels()
+    int64_t deadlineNs = 0;              // 单帧处理截止时间，0 为帧周期
+    double budgetFraction = 0.6;         // 处理时间预算 = 截止时间 x 此比例，留给调度抖动和后级
+    double upFraction = 0.8;             // 升档要求上一档的预估耗时低于预算 x 此比例
+    int window = 32;                     // 处理时间 p90 的统计窗口 (帧)
+    int holdFrames = 120;                // 升档前持续有余量的帧数；过热时每隔这么多帧降一档
+    int probeFrames = 1200;              // 上一档曾经超预算时，隔这么久才重新试探
+    float hotC = 78.0f;                  // 达到此温度主动降档，树莓派 80 度开始降频
+    float coolC = 70.0f;                 // 低于此温度才允许升档
+    double throttleRatio = 0.95;         // 频率低于观测到的最高频率 x 此比例视为降频，降频时不升档
+
+    static std::vector<QualityLevel> defaultLevels();
+};
+
+// 温度 (摄氏度) 与 CPU 频率 (MHz)，读不到的项为 0
+struct ThermalSample {
+    int64_t tNs;
+    float tempC;
+    float freqMHz;
+};
+
+class ThermalSource {
+public:
+    virtual ~ThermalSource() {}
+    virtual bool read(ThermalSample& s) = 0;
+};
+
+// sysfs：thermal_zone 的温度单位为 0.001 度，cpufreq 的频率单位为 kHz；文件保持打开，每次从头 pread
+class SysfsThermalSource : public ThermalSource {
+public:
+    explicit SysfsThermalSource(const std::string& tempPath = "/sys/class/thermal/thermal_zone0/temp",
+                                const std::string& freqPath = "/sys/devices/system/cpu/cpu0/cpufreq/scaling_cur_freq");
+    ~SysfsThermalSource();
+
+    // 两个文件都打不开时返回 false
+    bool read(ThermalSample& s) override;
+
+private:
+    int tempFd, freqFd;
+};
+
+// 温度/频率曲线回放，用于离线验证策略：按时间线性插值温度，频率取不晚于该时刻的最后一个点
+class TraceThermalSource : public ThermalSource {
+public:
+    // CSV 每行 t_s,temp_c,freq_mhz，时间递增，'#' 开头为注释
+    bool load(const std::string& path, std::string& err);
+
+    // 合成曲线：durationS 内先升温到 85 度，80 度以上从 1500 MHz 降到 1000 MHz，后 30% 散热恢复
+    static TraceThermalSource synthetic(double durationS);
+
+    // 场景时刻 tS 的取值
+    void at(double tS, ThermalSample& s) const;
+
+    // 以第一次调用的时刻为场景起点
+    bool read(ThermalSample& s) override;
+
+    double duration() const { return points.empty() ? 0.0 : points.back().t; }
+
+private:
+    struct Point {
+        double t;
+        float tempC, freqMHz;
+    };
+    std::vector<Point> points;
+    int64_t originNs = 0;
+};
+
+enum QualityReason { QUALITY_MISS, QUALITY_LOAD, QUALITY_THERMAL, QUALITY_HEADROOM };
+
+const char* qualityReasonName(int reason);
+
+// 档位变化事件，定长，可放进无锁通道
+struct QualityEvent {
+    int64_t tNs;
+    int16_t from, to;
+    int16_t reason;                      // QualityReason
+    float costUs;                        // 按当前频率预估的窗口 p90 处理时间，单帧超时时为该帧耗时
+    float tempC, freqMHz;
+};
+
+void printQualityEvent(const QualityEvent& e);
+
+// 截止时间感知的质量调节：每帧检测后输入处理时间和最近的温度/频率，在档位表上升降
+//   降档 (立即，降档后至少观察 2 帧)：单帧超过截止时间；窗口 p90 超过预算；温度达到 hotC (每 holdFrames 一档)
+//   升档：连续 holdFrames 帧 p90 低于预算 x upFraction，温度低于 coolC 且未降频；
+//         上一档留下的耗时记录按当前频率预估仍超预算时不升，probeFrames 后再试
+// 处理时间按采样时的频率换算到最高频率再进窗口，降频时立即按新频率预估，不用等窗口刷新
+// 档位变化写进事件通道，由其他线程取走打印；只在检测线程调用 update() / apply()
+class QualityGovernor {
+public:
+    QualityGovernor(const GovernorConfig& cfg, int64_t frameDeadlineNs, const DetectorOptions& base);
+
+    // 返回 true 表示档位变了
+    bool update(int64_t nowNs, int64_t processNs, const ThermalSample& thermal);
+
+    // 把当前档位用到检测器：选项变化时 setOptions()，区域以 target 为中心，nullptr 为整帧
+    void apply(LightDetector& detector, const Blob* target) const;
+
+    int level() const { return current; }
+    int levelCount() const { return static_cast<int>(levels.size()); }
+    const QualityLevel& currentLevel() const { return levels[current]; }
+    int64_t budgetNs() const { return budget; }
+    uint32_t changes() const { return changeCount; }
+
+    // 可在另一个线程调用
+    bool pollEvent(QualityEvent& e) { return events.pop(e); }
+    uint32_t droppedEvents() const { return events.droppedCount(); }
+
+private:
+    GovernorConfig cfg;
+    std::vector<QualityLevel> levels;
+    DetectorOptions base;
+    int64_t deadline, budget;
+    int current;
+
+    std::vector<int64_t> samples, scratch; // 换算到最高频率的处理时间，环形
+    int sampleCount, sampleNext;
+    std::vector<int64_t> levelCost;      // 各档离开时的 p90 (最高频率)，0 为未知
+    float nominalMHz;
+    int framesAtLevel, idleFrames;
+    uint32_t changeCount;
+
+    SpscRing<QualityEvent, 64> events;
+
+    int64_t windowP90();
+    void change(int64_t nowNs, int to, int reason, double costNs, const ThermalSample& thermal);
+};
+
+} // namespace vision
+
+#endif
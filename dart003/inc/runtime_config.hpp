@@ -0,0 +1,99 @@
+#ifndef RUNTIME_CONFIG_HPP
+#define RUNTIME_CONFIG_HPP
+
+#include "camera_model.hpp"
+#include "frame_source.hpp"
+#include "guidance.hpp"
+#include "imu_filter.hpp"
+#include "light_detector.hpp"
+#include "quality_governor.hpp"
+#include "rt_task.hpp"
+#include "servo_controller.hpp"
+#include "target_tracker.hpp"
+
+#include <string>
+#include <vector>
+
+// 一片 BMI088 的陀螺 / 加速度计片选 (BCM 编号)
+// 使用 SPI 总线调度器时改用两个 spidev 节点 (SPI0 的 CE1 = GPIO7, CE0 = GPIO8)
+struct ImuUnitConfig {
+    int csGyro = 7;
+    int csAccel = 8;
+    std::string gyroDevice = "/dev/spidev0.1";
+    std::string accelDevice = "/dev/spidev0.0";
+};
+
+// 制导运行时的全部配置，来自同一个 INI 文件 (见 config/guidance.conf)
+struct RuntimeConfig {
+    bool cameraEnabled = true;
+    bool imuEnabled = true;
+    bool ahrsEnabled = false;
+
+    vision::CameraConfig camera;
+    vision::CameraModel cameraModel;    // camera.calibration 换算到采集分辨率，未给出时为 control.hfov_deg 的针孔模型
+    vision::GreenRule detector;
+    vision::ColorClassifier classifier; // detector.classifier，未给出时由 detector 的绿色阈值生成
+    vision::DetectorOptions detectorOptions;
+    int detectorRoi = 0;                 // 以上一帧最大目标为中心的检测区域半边长，0 为整帧；governor 开启时由档位决定
+    vision::GovernorConfig governor;
+    std::string thermalTempPath = "/sys/class/thermal/thermal_zone0/temp";
+    std::string thermalFreqPath = "/sys/devices/system/cpu/cpu0/cpufreq/scaling_cur_freq";
+    tracker::TrackerConfig tracker;
+    guidance::ControlConfig control;
+
+    servo::ServoBankConfig servoBank;
+    servo::ServoCalibration servoCal[servo::kServoCount];
+
+    // 同一条 SPI 上的 BMI088，最多 4 片；多片时每周期连续读取一轮，对齐到同一时刻后逐轴取中值
+    std::vector<ImuUnitConfig> imuUnits;
+    int imuSpiChannel = 0;
+    int imuSpiBaud = 10000000;
+    bool imuAlign = true;
+    int imuOdrHz = 100;                  // BMI088 输出数据率，取最接近的档位
+
+    // IMU 软件滤波：在 IMU 任务内对读数做低通 / 陷波级联，采样率为 imu.period_us 的倒数
+    bool imuFilterEnabled = false;
+    std::vector<imufilter::StageConfig> imuFilterStages;
+    bool imuPeakTracking = false;        // 按陀螺振动峰重调 harmonic > 0 的陷波
+    imufilter::PeakConfig imuPeak;
+
+    std::string ahrsDevice = "/dev/spidev0.2";   // BNO080，SPI0 第三个片选 (dtoverlay=spi0-3cs)；CE0 / CE1 归 BMI088
+    int ahrsSpeedHz = 1000000;
+    int ahrsMode = 0;
+
+    // BMI088 和 BNO080 经同一个总线调度器访问 spidev：IMU 突发优先，并在每个 IMU 周期前预约 guard_us
+    bool spiScheduler = false;
+    int spiImuPriority = 10;
+    int spiAhrsPriority = 1;
+    int spiGuardUs = 50;                 // 0 = 不预约
+
+    RtTaskConfig visionTask;
+    RtTaskConfig imuTask;
+    RtTaskConfig ahrsTask;
+    RtTaskConfig fusionTask;
+    RtTaskConfig servoTask;
+    RtTaskConfig thermalTask;
+
+    bool recorderEnabled = false;
+    std::string recorderPath = "/tmp/flight.mwfl";
+    int recorderCapacityMb = 256;
+    int recorderLockWindowKb = 4096;     // memory.lock 时记录文件只锁定写入位置附近的窗口，不整体常驻
+
+    bool ipcPublish = false;             // 检测结果和舵机指令发布到 /dev/shm 话题
+    bool ipcImu = false;                 // IMU 读 pi_bmi088 发布的话题，不在本进程打开 BMI088
+    int ipcImuMaxAgeMs = 50;             // 话题最新样本超过这个时间判为 IMU 失效
+
+    bool memoryLock = false;             // mlockall，实时任务启动时预写栈、分配周期 arena（大小见各任务配置）
+
+    std::string tracePath = "/tmp/guidance_trace.json"; // 仅 MILKYWAY_TRACE 编译时使用
+
+    int watchdogPeriodMs = 50;
+    double watchdogStaleFactor = 5.0;
+
+    RuntimeConfig();
+};
+
+// 文件中没有出现的键保持默认值
+bool loadRuntimeConfig(const std::string& path, RuntimeConfig& cfg, std::string& err);
+
+#endif
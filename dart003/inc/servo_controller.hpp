@@ -0,0 +1,194 @@
+#ifndef SERVO_CONTROLLER_HPP
+#define SERVO_CONTROLLER_HPP
+
+#include "jitter_stats.hpp"
+
+#include <atomic>
+#include <cstdint>
+
+namespace servo {
+
+const int kServoCount = 4;
+
+// 单个舵机的角度-脉宽标定与限幅，通道号与 ServoBankConfig::pins 对应
+struct ServoCalibration {
+    float centerUs;          // 0 rad 对应的脉宽
+    float usPerRad;          // 脉宽/角度 斜率，负值表示反向安装
+    float minUs;             // 机械限位
+    float maxUs;
+    float maxRateRadS;       // 指令角速度限制，<=0 不限制
+    float maxSlewUs;         // 每个周期脉宽最大变化量，<=0 不限制
+};
+
+// 默认标定：±45° 对应 1000~2000 µs
+void defaultCalibration(ServoCalibration (&cal)[kServoCount]);
+
+// 一帧四路脉宽 (µs)，作为整体提交
+struct PulseFrame {
+    uint16_t us[kServoCount];
+
+    bool operator==(const PulseFrame& o) const {
+        for (int i = 0; i < kServoCount; i++) {
+            if (us[i] != o.us[i]) return false;
+        }
+        return true;
+    }
+    bool operator!=(const PulseFrame& o) const { return !(*this == o); }
+};
+
+// 脉冲下降沿之后到下一周期起点至少留出的时间 (µs)，脉宽上限 = 帧周期 - 它
+const int kPulseMarginUs = 100;
+
+struct ServoBankConfig {
+    int pins[kServoCount] = {17, 18, 22, 23};
+    int frameHz = 50;        // 模拟舵机 50 Hz，数字舵机可用 333 Hz
+
+    int periodUs() const { return 1000000 / frameHz; }
+};
+
+// 舵机输出后端：一次调用提交全部通道
+class ServoBackend {
+public:
+    virtual ~ServoBackend() {}
+    virtual bool open(const ServoBankConfig& config) = 0;
+    virtual bool apply(const PulseFrame& frame) = 0;
+    virtual void close() = 0;
+    // 帧未变化、跳过 apply 的周期也会调用，供后端做维护 (回收旧波形等)
+    virtual void idle() {}
+};
+
+#ifdef HAVE_PIGPIO
+// pigpio DMA 波形后端：四路脉冲编进同一个周期波形，所有通道同一时刻上升沿，
+// 用 PI_WAVE_MODE_REPEAT_SYNC 在当前周期结束时整体切换，不会出现半新半旧的帧
+class PigpioWaveBackend : public ServoBackend {
+public:
+    bool open(const ServoBankConfig& config) override;
+    bool apply(const PulseFrame& frame) override;
+    void close() override;
+    void idle() override;
+
+private:
+    static const int kMaxRetired = 4;
+
+    ServoBankConfig cfg;
+    uint32_t pinMask = 0;
+    int currentWave = -1;
+    int retired[kMaxRetired];
+    int retiredCount = 0;
+    bool opened = false;
+
+    void reapRetired();
+};
+
+// 逐通道 gpioServo 后端（固定 50 Hz，各通道相位不对齐），用于对比和兼容
+class PigpioServoBackend : public ServoBackend {
+public:
+    bool open(const ServoBankConfig& config) override;
+    bool apply(const PulseFrame& frame) override;
+    void close() override;
+
+private:
+    ServoBankConfig cfg;
+    bool opened = false;
+};
+#endif
+
+// 模拟后端：记录每次提交的时间和内容，PC 上测试调度
+class SimServoBackend : public ServoBackend {
+public:
+    static const int kHistory = 1024;
+
+    struct Record {
+        int64_t tNs;
+        PulseFrame frame;
+    };
+
+    bool open(const ServoBankConfig& config) override;
+    bool apply(const PulseFrame& frame) override;
+    void close() override;
+
+    uint64_t applyCount() const { return count; }
+    const PulseFrame& last() const { return lastFrame; }
+    const JitterStats& intervals() const { return interval; }
+    // i = 0 为最近一次
+    const Record& history(int i) const { return ring[(count - 1 - i) % kHistory]; }
+
+private:
+    ServoBankConfig cfg;
+    Record ring[kHistory];
+    PulseFrame lastFrame = {{0, 0, 0, 0}};
+    uint64_t count = 0;
+    int64_t lastNs = 0;
+    JitterStats interval;
+};
+
+// 舵机组：持有引脚，四路一次性提交，帧内容不变时不触碰后端
+class ServoBank {
+public:
+    ServoBank(ServoBackend& backend, const ServoBankConfig& config = ServoBankConfig());
+    ~ServoBank();
+
+    bool open();
+    void close();
+
+    // 返回 true 表示帧已下发
+    bool commit(const PulseFrame& frame);
+
+    const ServoBankConfig& config() const { return cfg; }
+    const PulseFrame& current() const { return last; }
+    uint64_t commits() const { return commitCount; }
+    uint64_t skipped() const { return skipCount; }
+    uint64_t failures() const { return failCount; }
+
+private:
+    ServoBackend& backend;
+    ServoBankConfig cfg;
+    PulseFrame last;
+    bool opened = false;
+    bool primed = false;
+    uint64_t commitCount = 0;
+    uint64_t skipCount = 0;
+    uint64_t failCount = 0;
+};
+
+// 固定周期舵机控制环
+//   - 从 setpoints 无锁读取目标角度 (rad)
+//   - 角速度 / 脉宽斜率限幅，标定后转换为脉宽
+//   - 每周期整帧提交给 ServoBank
+//   - clock_nanosleep(TIMER_ABSTIME) 绝对时刻调度，统计唤醒抖动
+class ServoLoop {
+public:
+    ServoLoop(ServoBank& bank, const ServoCalibration (&cal)[kServoCount],
+              const std::atomic<float>* setpoints, int64_t periodNs = 20000000);
+
+    bool begin();
+    void run(const std::atomic<bool>& stop);
+    void step(float dt);
+    void end();
+
+    // 所有通道回中
+    void neutral();
+
+    const JitterStats& jitter() const { return wakeJitter; }
+    uint64_t ticks() const { return tickCount; }
+    uint64_t overruns() const { return overrunCount; }
+    int pulse(int ch) const { return bank.current().us[ch]; }
+    float angle(int ch) const { return cmdAngle[ch]; }
+
+private:
+    ServoBank& bank;
+    ServoCalibration cal[kServoCount];
+    const std::atomic<float>* setpoints;
+    int64_t periodNs;
+
+    float cmdAngle[kServoCount];
+    float pulseUs[kServoCount];
+
+    JitterStats wakeJitter;
+    uint64_t tickCount = 0;
+    uint64_t overrunCount = 0;
+};
+
+} // namespace servo
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef SIM_SOURCES_HPP
+#define SIM_SOURCES_HPP
+
+#include "frame_source.hpp"
+#include "guidance.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// 离线仿真用的传感器：合成相机帧和 IMU，时间戳已知，用于基准和回归
+namespace sim {
+
+// 仿真场景：目标惯性系方位 + 机体姿态，t 为相对场景起点的秒数
+struct Scene {
+    float targetAzAmp = 0.15f, targetAzHz = 0.5f;
+    float targetElAmp = 0.08f, targetElHz = 0.8f;
+    float bodyYawAmp = 0.05f, bodyYawHz = 2.0f;
+    float bodyPitchAmp = 0.03f, bodyPitchHz = 3.0f;
+    int targetRadiusPx = 3;
+
+    float targetAz(double t) const;
+    float targetEl(double t) const;
+    float bodyYaw(double t) const;
+    float bodyPitch(double t) const;
+    float bodyYawRate(double t) const;
+    float bodyPitchRate(double t) const;
+};
+
+// 按帧率输出合成帧（cam.format 为 BGR24、I420 或 Bayer，Bayer 不加白平衡偏色）；realtime 时 grab() 会等到该帧的交付时刻
+class SyntheticFrameSource : public vision::FrameSource {
+public:
+    SyntheticFrameSource(const vision::CameraConfig& cam, float hfovDeg, const Scene& scene,
+                         int64_t originNs, bool realtime = true, int deliveryUs = 0);
+
+    bool open() override;
+    bool grab(vision::Frame& frame) override;
+    void close() override {}
+
+    // 第 k 帧的目标真值像素坐标
+    void truthPixel(uint32_t k, float& px, float& py) const;
+
+private:
+    vision::CameraConfig cam;
+    Scene scene;
+    int64_t originNs;
+    int64_t periodNs;
+    bool realtime;
+    int64_t deliveryNs;
+    float f, cx, cy;
+    uint32_t next = 0;
+    std::vector<uint8_t> background;
+    std::vector<uint8_t> image;
+    std::vector<uint8_t> converted;      // I420 / Bayer 格式的输出
+
+    void render(uint32_t k);
+};
+
+// 按场景机体角速度输出陀螺读数
+class SimImuSource : public guidance::ImuSource {
+public:
+    SimImuSource(const Scene& scene, int64_t originNs) : scene(scene), originNs(originNs) {}
+    sensor::SensorStatus read(float (&gyro)[3], float (&accel)[3]) override;
+
+private:
+    Scene scene;
+    int64_t originNs;
+};
+
+} // namespace sim
+
+#endif
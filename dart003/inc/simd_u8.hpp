@@ -0,0 +1,65 @@
+#ifndef SIMD_U8_HPP
+#define SIMD_U8_HPP
+
+#include <cstdint>
+
+// 16 字节无符号饱和运算的最小封装：NEON (树莓派) 或 SSE2 (PC)，都没有时 SIMD_U8_AVAILABLE 为 0
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SIMD_U8_AVAILABLE 1
+
+namespace simd {
+
+typedef uint8x16_t U8x16;
+
+inline U8x16 load(const uint8_t* p) { return vld1q_u8(p); }
+inline U8x16 splat(uint8_t v) { return vdupq_n_u8(v); }
+inline U8x16 zero() { return vdupq_n_u8(0); }
+inline U8x16 subs(U8x16 a, U8x16 b) { return vqsubq_u8(a, b); }
+inline U8x16 min(U8x16 a, U8x16 b) { return vminq_u8(a, b); }
+inline U8x16 max(U8x16 a, U8x16 b) { return vmaxq_u8(a, b); }
+inline U8x16 bitAnd(U8x16 a, U8x16 b) { return vandq_u8(a, b); }
+inline U8x16 bitOr(U8x16 a, U8x16 b) { return vorrq_u8(a, b); }
+
+// 第 i 字节取 v[i-1]，第 0 字节取 prev[15]
+inline U8x16 shiftInPrev(U8x16 v, U8x16 prev) { return vextq_u8(prev, v, 15); }
+// 第 i 字节取 v[i+1]，第 15 字节取 next[0]
+inline U8x16 shiftInNext(U8x16 v, U8x16 next) { return vextq_u8(v, next, 1); }
+
+inline bool any(U8x16 v) {
+    uint64x2_t w = vreinterpretq_u64_u8(v);
+    return (vgetq_lane_u64(w, 0) | vgetq_lane_u64(w, 1)) != 0;
+}
+
+} // namespace simd
+
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define SIMD_U8_AVAILABLE 1
+
+namespace simd {
+
+typedef __m128i U8x16;
+
+inline U8x16 load(const uint8_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+inline U8x16 splat(uint8_t v) { return _mm_set1_epi8(static_cast<char>(v)); }
+inline U8x16 zero() { return _mm_setzero_si128(); }
+inline U8x16 subs(U8x16 a, U8x16 b) { return _mm_subs_epu8(a, b); }
+inline U8x16 min(U8x16 a, U8x16 b) { return _mm_min_epu8(a, b); }
+inline U8x16 max(U8x16 a, U8x16 b) { return _mm_max_epu8(a, b); }
+inline U8x16 bitAnd(U8x16 a, U8x16 b) { return _mm_and_si128(a, b); }
+inline U8x16 bitOr(U8x16 a, U8x16 b) { return _mm_or_si128(a, b); }
+
+inline U8x16 shiftInPrev(U8x16 v, U8x16 prev) { return _mm_or_si128(_mm_slli_si128(v, 1), _mm_srli_si128(prev, 15)); }
+inline U8x16 shiftInNext(U8x16 v, U8x16 next) { return _mm_or_si128(_mm_srli_si128(v, 1), _mm_slli_si128(next, 15)); }
+
+inline bool any(U8x16 v) { return _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128())) != 0xFFFF; }
+
+} // namespace simd
+
+#else
+#define SIMD_U8_AVAILABLE 0
+#endif
+
+#endif
@@ -0,0 +1,277 @@
+#ifndef TARGET_TRACKER_HPP
+#define TARGET_TRACKER_HPP
+
+#include <cstdint>
+#include <cmath>
+
+// 目标方位跟踪器（纯头文件，定长，无动态分配）
+//
+// 每个方位轴（方位角 az / 俯仰角 el）一个独立的线性卡尔曼滤波器：
+//   N = 2: 匀速模型   x = [角度, 角速度]
+//   N = 3: 匀加速模型 x = [角度, 角速度, 角加速度]
+// 时间戳统一为 CLOCK_MONOTONIC 纳秒。测量值携带曝光时刻，滤波器先外推到
+// 曝光时刻再更新；舵机环可以在任意时刻调用 predict() 外推到执行时刻。
+
+namespace tracker {
+
+struct TrackerConfig {
+    float processNoise = 50.0f;          // 最高阶导数的白噪声谱密度
+    float measurementSigma = 0.002f;     // 单次测量标准差 (rad)
+    float initialRateSigma = 0.5f;       // 初始化时角速度标准差 (rad/s)
+    float initialAccelSigma = 5.0f;      // 初始化时角加速度标准差 (rad/s^2)
+    float gateSigma = 5.0f;              // 新息门限 (标准差倍数)，<=0 关闭
+    int64_t actuationLatencyNs = 0;      // 指令发出到舵面响应的延迟
+    int64_t maxCoastNs = 200000000;      // 无测量超过该时间判定丢失
+};
+
+struct BearingMeasurement {
+    int64_t captureNs;                   // 曝光时刻
+    float az;                            // 方位角 (rad)
+    float el;                            // 俯仰角 (rad)
+    float sigma;                         // 测量标准差，<=0 使用配置值
+};
+
+struct TargetState {
+    int64_t tNs;
+    float az, el;                        // 角度
+    float azRate, elRate;                // 角速度
+    float azVar, elVar;                  // 角度方差
+    bool valid;
+};
+
+struct TrackerStats {
+    uint32_t updates;
+    uint32_t staleRejected;              // 比滤波器时间更早的测量
+    uint32_t gateRejected;               // 超出新息门限
+    uint32_t resets;
+};
+
+// 单轴卡尔曼滤波器，H = [1 0 ...]
+template <int N>
+class AxisKalman {
+    static_assert(N == 2 || N == 3, "AxisKalman supports CV (2) or CA (3) models");
+
+public:
+    void init(float angle, float var, float rateVar, float accelVar) {
+        for (int i = 0; i < N; i++) {
+            x[i] = 0.0f;
+            for (int j = 0; j < N; j++) P[i][j] = 0.0f;
+        }
+        x[0] = angle;
+        P[0][0] = var;
+        P[1][1] = rateVar;
+        if (N == 3) P[N - 1][N - 1] = accelVar;
+    }
+
+    // x = F x, P = F P F' + Q
+    void propagate(float dt, float q) {
+        if (dt <= 0.0f) return;
+        propagateState(x, dt);
+
+        float F[N][N];
+        transition(F, dt);
+        float FP[N][N];
+        for (int i = 0; i < N; i++)
+            for (int j = 0; j < N; j++) {
+                float s = 0.0f;
+                for (int k = i; k < N; k++) s += F[i][k] * P[k][j];
+                FP[i][j] = s;
+            }
+        float Q[N][N];
+        processNoise(Q, dt, q);
+        for (int i = 0; i < N; i++)
+            for (int j = i; j < N; j++) {
+                float s = 0.0f;
+                for (int k = j; k < N; k++) s += FP[i][k] * F[j][k];
+                P[i][j] = s + Q[i][j];
+                P[j][i] = P[i][j];
+            }
+    }
+
+    // 标量测量更新；返回 false 表示被门限拒绝
+    bool correct(float z, float r, float gate) {
+        float y = z - x[0];
+        float s = P[0][0] + r;
+        if (gate > 0.0f && y * y > gate * gate * s) return false;
+
+        float inv = 1.0f / s;
+        float K[N];
+        for (int i = 0; i < N; i++) K[i] = P[i][0] * inv;
+        for (int i = 0; i < N; i++) x[i] += K[i] * y;
+
+        float row0[N];
+        for (int j = 0; j < N; j++) row0[j] = P[0][j];
+        for (int i = 0; i < N; i++)
+            for (int j = i; j < N; j++) {
+                P[i][j] -= K[i] * row0[j];
+                P[j][i] = P[i][j];
+            }
+        return true;
+    }
+
+    // 只外推均值和角度方差，不修改滤波器。
+    // dt <= 0 (查询时刻早于滤波器时刻) 不向后外推：均值和方差都停在滤波器时刻，两者保持一致
+    void predict(float dt, float q, float& angle, float& rate, float& var) const {
+        if (dt < 0.0f) dt = 0.0f;
+        float xs[N];
+        for (int i = 0; i < N; i++) xs[i] = x[i];
+        propagateState(xs, dt);
+        angle = xs[0];
+        rate = xs[1];
+
+        // 仅需 (F P F')[0][0] + Q[0][0]
+        float F[N][N];
+        transition(F, dt);
+        float v = 0.0f;
+        for (int k = 0; k < N; k++)
+            for (int l = 0; l < N; l++) v += F[0][k] * P[k][l] * F[0][l];
+        float Q[N][N];
+        processNoise(Q, dt, q);
+        var = v + Q[0][0];
+    }
+
+    float angle() const { return x[0]; }
+    float rate() const { return x[1]; }
+    float variance() const { return P[0][0]; }
+
+private:
+    float x[N];
+    float P[N][N];
+
+    static void propagateState(float* s, float dt) {
+        if (N == 3) {
+            s[0] += dt * s[1] + 0.5f * dt * dt * s[N - 1];
+            s[1] += dt * s[N - 1];
+        } else {
+            s[0] += dt * s[1];
+        }
+    }
+
+    static void transition(float (&F)[N][N], float dt) {
+        for (int i = 0; i < N; i++)
+            for (int j = 0; j < N; j++) F[i][j] = (i == j) ? 1.0f : 0.0f;
+        F[0][1] = dt;
+        if (N == 3) {
+            F[0][N - 1] = 0.5f * dt * dt;
+            F[1][N - 1] = dt;
+        }
+    }
+
+    // 离散化的连续白噪声模型 (CV: 白加速度, CA: 白加加速度)
+    static void processNoise(float (&Q)[N][N], float dt, float q) {
+        float dt2 = dt * dt, dt3 = dt2 * dt;
+        if (N == 3) {
+            float dt4 = dt3 * dt, dt5 = dt4 * dt;
+            float v[3][3] = {{dt5 / 20.0f, dt4 / 8.0f, dt3 / 6.0f},
+                             {dt4 / 8.0f, dt3 / 3.0f, dt2 / 2.0f},
+                             {dt3 / 6.0f, dt2 / 2.0f, dt}};
+            for (int i = 0; i < N; i++)
+                for (int j = 0; j < N; j++) Q[i][j] = q * v[i][j];
+        } else {
+            float v[2][2] = {{dt3 / 3.0f, dt2 / 2.0f}, {dt2 / 2.0f, dt}};
+            for (int i = 0; i < N; i++)
+                for (int j = 0; j < N; j++) Q[i][j] = q * v[i][j];
+        }
+    }
+};
+
+// 双轴目标跟踪器
+template <int N = 3>
+class TargetTracker {
+public:
+    explicit TargetTracker(const TrackerConfig& config = TrackerConfig())
+        : cfg(config), stateNs(0), lastMeasNs(0), initialized(false) {
+        stats.updates = stats.staleRejected = stats.gateRejected = stats.resets = 0;
+    }
+
+    void reset() {
+        initialized = false;
+        stats.resets++;
+    }
+
+    void setConfig(const TrackerConfig& config) { cfg = config; }
+    const TrackerConfig& config() const { return cfg; }
+    const TrackerStats& statistics() const { return stats; }
+
+    // 融合一次测量；测量时间早于滤波器当前时间时丢弃（乱序到达）
+    bool update(const BearingMeasurement& m) {
+        float sigma = m.sigma > 0.0f ? m.sigma : cfg.measurementSigma;
+        float r = sigma * sigma;
+
+        if (!initialized || m.captureNs - lastMeasNs > cfg.maxCoastNs) {
+            if (initialized) stats.resets++;
+            float rv = cfg.initialRateSigma * cfg.initialRateSigma;
+            float av = cfg.initialAccelSigma * cfg.initialAccelSigma;
+            az.init(m.az, r, rv, av);
+            el.init(m.el, r, rv, av);
+            stateNs = lastMeasNs = m.captureNs;
+            initialized = true;
+            stats.updates++;
+            return true;
+        }
+
+        if (m.captureNs < stateNs) {
+            stats.staleRejected++;
+            return false;
+        }
+
+        float dt = (m.captureNs - stateNs) * 1e-9f;
+        az.propagate(dt, cfg.processNoise);
+        el.propagate(dt, cfg.processNoise);
+        stateNs = m.captureNs;
+
+        // 两轴一起门限：任一轴超限则整条测量丢弃
+        AxisKalman<N> azTry = az, elTry = el;
+        if (!azTry.correct(m.az, r, cfg.gateSigma) || !elTry.correct(m.el, r, cfg.gateSigma)) {
+            stats.gateRejected++;
+            return false;
+        }
+        az = azTry;
+        el = elTry;
+        lastMeasNs = m.captureNs;
+        stats.updates++;
+        return true;
+    }
+
+    // 外推到任意时刻 tNs（不改变滤波器状态，可在舵机线程按自身节拍调用）；早于滤波器时刻时返回滤波器时刻的状态
+    TargetState predict(int64_t tNs) const {
+        TargetState s;
+        s.tNs = tNs;
+        s.valid = valid(tNs);
+        if (!initialized) {
+            s.az = s.el = s.azRate = s.elRate = 0.0f;
+            s.azVar = s.elVar = INFINITY;
+            return s;
+        }
+        float dt = (tNs - stateNs) * 1e-9f;
+        az.predict(dt, cfg.processNoise, s.az, s.azRate, s.azVar);
+        el.predict(dt, cfg.processNoise, s.el, s.elRate, s.elVar);
+        return s;
+    }
+
+    // 延迟补偿：外推到 nowNs 发出的指令真正作用的时刻
+    TargetState predictForActuation(int64_t nowNs) const {
+        return predict(nowNs + cfg.actuationLatencyNs);
+    }
+
+    bool valid(int64_t tNs) const {
+        return initialized && tNs - lastMeasNs <= cfg.maxCoastNs;
+    }
+
+    int64_t lastMeasurementNs() const { return lastMeasNs; }
+
+private:
+    TrackerConfig cfg;
+    AxisKalman<N> az, el;
+    int64_t stateNs;
+    int64_t lastMeasNs;
+    bool initialized;
+    TrackerStats stats;
+};
+
+typedef TargetTracker<2> CvTargetTracker;
+typedef TargetTracker<3> CaTargetTracker;
+
+} // namespace tracker
+
+#endif
@@ -0,0 +1,375 @@
+#include "bmi088.h"
+#include "bmi088_sampler.h"
+#include "bmi088_sim.h"
+#include "camera_model.hpp"
+#include "guidance.hpp"
+#include "imu_filter.hpp"
+#include "light_detector.hpp"
+#include "preintegration.hpp"
+#include "rt_clock.hpp"
+#include "servo_controller.hpp"
+#include "sim_sources.hpp"
+#include "target_tracker.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// 各组件固定工作量的单次耗时 (ns/op)，用于比较不同构建 (基线 / LTO / PGO+LTO) 的加速比，也是 PGO 的训练负载之一
+// 用法: bench_components [--repeat N] [--scale K] [--only 组件名]
+//   detector  320x240 BGR 合成帧检测，每帧一次
+//   fusion    检测结果 + 姿态 -> 跟踪器更新，再为舵机算一次舵面角
+//   tracker   跟踪器更新 + 执行时刻外推
+//   imu_filter 两级低通 + 陷波，每个样本一次 (SIMD 路径)
+//   preint    IMU 预积分，每个样本一次
+//   bmi088    两片 BMI088 在仿真总线上的对齐采样 (总线速率设得极高，只剩驱动和采样器本身的开销)
+//   servo     舵机控制环一步：限幅、标定、整帧提交给模拟后端
+// 每个组件跑 N 次 (默认 5) 取最小值；checksum 由各组件的输出算出，不同构建间应一致
+
+namespace {
+
+struct Options {
+    int repeat = 5;
+    int scale = 1;
+    const char* only = nullptr;
+};
+
+struct Result {
+    const char* name;
+    double nsPerOp;
+    long ops;
+    double checksum;
+};
+
+bool parseOptions(int argc, char** argv, Options& o) {
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (!std::strcmp(a, "--repeat") && hasValue) {
+            o.repeat = std::atoi(argv[++i]);
+        } else if (!std::strcmp(a, "--scale") && hasValue) {
+            o.scale = std::atoi(argv[++i]);
+        } else if (!std::strcmp(a, "--only") && hasValue) {
+            o.only = argv[++i];
+        } else {
+            return false;
+        }
+    }
+    return o.repeat > 0 && o.scale > 0;
+}
+
+// 同一组合成帧和对应的机体姿态，供检测和融合共用
+struct Scenario {
+    vision::CameraConfig cam;
+    sim::Scene scene;
+    std::vector<std::vector<uint8_t> > images;
+    std::vector<vision::BlobList> blobs;
+    std::vector<guidance::ImuState> imu;
+    std::vector<int64_t> captureNs;
+};
+
+guidance::ImuState bodyState(const sim::Scene& scene, double t, int64_t tNs) {
+    guidance::ImuState s;
+    std::memset(&s, 0, sizeof(s));
+    s.tNs = tNs;
+    s.yaw = scene.bodyYaw(t);
+    s.pitch = scene.bodyPitch(t);
+    s.yawRate = scene.bodyYawRate(t);
+    s.pitchRate = scene.bodyPitchRate(t);
+    s.gyro[1] = s.pitchRate;
+    s.gyro[2] = s.yawRate;
+    s.accel[2] = 9.81f;
+    return s;
+}
+
+bool buildScenario(Scenario& sc, int frames) {
+    sc.cam.width = 320;
+    sc.cam.height = 240;
+    sc.cam.fps = 120;
+    sim::SyntheticFrameSource src(sc.cam, 62.2f, sc.scene, 0, false);
+    if (!src.open()) return false;
+    vision::LightDetector det(sc.cam.width, sc.cam.height);
+    vision::Frame f;
+    for (int k = 0; k < frames; k++) {
+        if (!src.grab(f)) return false;
+        sc.images.emplace_back(f.data, f.data + static_cast<size_t>(f.stride) * f.height);
+        vision::BlobList b;
+        det.detect(f, b);
+        b.captureNs = f.captureNs;
+        b.frameId = f.id;
+        sc.blobs.push_back(b);
+        sc.captureNs.push_back(f.captureNs);
+        sc.imu.push_back(bodyState(sc.scene, f.captureNs * 1e-9, f.captureNs));
+    }
+    return true;
+}
+
+Result benchDetector(const Scenario& sc, int scale) {
+    vision::LightDetector det(sc.cam.width, sc.cam.height);
+    vision::Frame f;
+    f.format = vision::PIXEL_BGR24;
+    f.width = sc.cam.width;
+    f.height = sc.cam.height;
+    f.stride = sc.cam.width * 3;
+    f.bayer = vision::BAYER_RGGB;
+    long ops = 400L * scale;
+    double sum = 0.0;
+    vision::BlobList b;
+    int64_t t0 = monotonicNs();
+    for (long i = 0; i < ops; i++) {
+        size_t k = i % sc.images.size();
+        f.data = sc.images[k].data();
+        f.captureNs = sc.captureNs[k];
+        f.id = static_cast<uint32_t>(k);
+        det.detect(f, b);
+        const vision::Blob* l = b.largest();
+        if (l) sum += l->cx + l->cy;
+    }
+    int64_t t1 = monotonicNs();
+    return Result{"detector", double(t1 - t0) / ops, ops, sum / ops};
+}
+
+Result benchFusion(const Scenario& sc, int scale) {
+    vision::CameraModel model = vision::CameraModel::pinhole(sc.cam.width, sc.cam.height, 62.2);
+    guidance::FusionStage fusion(tracker::TrackerConfig(), model);
+    guidance::ControlConfig ccfg;
+    guidance::ControlStage control(ccfg);
+    guidance::TrackSnapshot snap;
+    long ops = 20000L * scale;
+    size_t n = sc.blobs.size();
+    int64_t span = sc.captureNs.back() - sc.captureNs.front() + (sc.captureNs[1] - sc.captureNs[0]);
+    double sum = 0.0;
+    int64_t t0 = monotonicNs();
+    for (long i = 0; i < ops; i++) {
+        // 每圈整体后移，时间戳保持递增，跟踪器不会按乱序丢弃
+        size_t k = i % n;
+        int64_t shift = static_cast<int64_t>(i / n) * span;
+        vision::BlobList b = sc.blobs[k];
+        guidance::ImuState s = sc.imu[k];
+        b.captureNs += shift;
+        s.tNs += shift;
+        fusion.process(b, s, snap);
+        float angles[servo::kServoCount];
+        control.compute(snap, s, b.captureNs + 5000000, angles);
+        sum += angles[0] - angles[1];
+    }
+    int64_t t1 = monotonicNs();
+    return Result{"fusion", double(t1 - t0) / ops, ops, sum};
+}
+
+Result benchTracker(int scale) {
+    sim::Scene scene;
+    tracker::TrackerConfig cfg;
+    cfg.actuationLatencyNs = 15000000;
+    tracker::CaTargetTracker trk(cfg);
+    long ops = 200000L * scale;
+    uint32_t rng = 12345;
+    double sum = 0.0;
+    int64_t t0 = monotonicNs();
+    for (long i = 0; i < ops; i++) {
+        int64_t tNs = i * 8333333LL;
+        double t = tNs * 1e-9;
+        rng = rng * 1664525u + 1013904223u;
+        float noise = ((rng >> 8) * (1.0f / 16777216.0f) - 0.5f) * 0.004f;
+        tracker::BearingMeasurement m = {tNs, scene.targetAz(t) + noise, scene.targetEl(t) - noise, 0.0f};
+        trk.update(m);
+        tracker::TargetState s = trk.predictForActuation(tNs);
+        sum += s.az + s.el;
+    }
+    int64_t t1 = monotonicNs();
+    return Result{"tracker", double(t1 - t0) / ops, ops, sum};
+}
+
+// 1 kHz 的陀螺 / 加速度：机体慢速转动 + 180 Hz 振动
+void imuSample(long i, float (&gyro)[3], float (&accel)[3]) {
+    double t = i * 1e-3;
+    double vib = std::sin(2.0 * M_PI * 180.0 * t);
+    gyro[0] = static_cast<float>(0.3 * std::sin(2.0 * M_PI * 2.0 * t) + 0.2 * vib);
+    gyro[1] = static_cast<float>(0.2 * std::cos(2.0 * M_PI * 3.0 * t) + 0.1 * vib);
+    gyro[2] = static_cast<float>(0.1 + 0.05 * vib);
+    accel[0] = static_cast<float>(0.5 * vib);
+    accel[1] = static_cast<float>(0.2 * std::sin(2.0 * M_PI * 1.0 * t));
+    accel[2] = static_cast<float>(9.81 + 1.0 * vib);
+}
+
+struct ImuTrace {
+    std::vector<float> gyro, accel;
+    long size() const { return static_cast<long>(gyro.size() / 3); }
+};
+
+ImuTrace makeImuTrace(long n) {
+    ImuTrace tr;
+    tr.gyro.resize(n * 3);
+    tr.accel.resize(n * 3);
+    for (long i = 0; i < n; i++) {
+        float g[3], a[3];
+        imuSample(i, g, a);
+        std::copy(g, g + 3, &tr.gyro[i * 3]);
+        std::copy(a, a + 3, &tr.accel[i * 3]);
+    }
+    return tr;
+}
+
+Result benchImuFilter(const ImuTrace& tr, int scale) {
+    std::vector<imufilter::StageConfig> stages;
+    std::string err;
+    imufilter::FilterBank bank;
+    if (!imufilter::parseStages("lpf gyro 150; notch gyro 180 q=4; lpf accel 40", stages, err) ||
+        !bank.configure(stages, 1000.0f, err)) {
+        std::fprintf(stderr, "imu_filter: %s\n", err.c_str());
+        std::exit(1);
+    }
+    long ops = 500000L * scale;
+    double sum = 0.0;
+    int64_t t0 = monotonicNs();
+    for (long i = 0; i < ops; i++) {
+        long k = i % tr.size();
+        float g[3] = {tr.gyro[k * 3], tr.gyro[k * 3 + 1], tr.gyro[k * 3 + 2]};
+        float a[3] = {tr.accel[k * 3], tr.accel[k * 3 + 1], tr.accel[k * 3 + 2]};
+        bank.process(g, a);
+        sum += g[0] + a[2];
+    }
+    int64_t t1 = monotonicNs();
+    return Result{"imu_filter", double(t1 - t0) / ops, ops, sum / ops};
+}
+
+Result benchPreint(const ImuTrace& tr, int scale) {
+    preint::Preintegrator p;
+    preint::Reader reader(p);
+    long ops = 500000L * scale;
+    double sum = 0.0;
+    preint::Delta d;
+    int64_t t0 = monotonicNs();
+    for (long i = 0; i < ops; i++) {
+        long k = i % tr.size();
+        const float(&g)[3] = *reinterpret_cast<const float(*)[3]>(&tr.gyro[k * 3]);
+        const float(&a)[3] = *reinterpret_cast<const float(*)[3]>(&tr.accel[k * 3]);
+        p.add(i * 1000000LL, g, a);
+        // 消费者按 100 Hz 取增量
+        if (i % 10 == 0 && reader.fetch(d)) sum += d.dTheta[0] + d.dv[2];
+    }
+    int64_t t1 = monotonicNs();
+    return Result{"preint", double(t1 - t0) / ops, ops, sum};
+}
+
+// 1 Gbit/s、片选无开销：传输几乎不等待，测的是寄存器读写、换算和对齐
+// 器件只初始化一次 (构造函数里有自检和打印)
+struct Bmi088Rig {
+    SimBmi088Bus bus;
+    std::unique_ptr<BMI088> a, b;
+
+    Bmi088Rig() : bus(1000000000u, 0) {
+        const float bias0[3] = {0.01f, -0.02f, 0.005f};
+        const float bias1[3] = {-0.01f, 0.015f, 0.0f};
+        bus.addDevice(7, 8, bias0);
+        bus.addDevice(9, 10, bias1);
+        a.reset(new BMI088(bus, 7, 8, 1000));
+        b.reset(new BMI088(bus, 9, 10, 1000));
+    }
+};
+
+Result benchBmi088(Bmi088Rig& rig, int scale) {
+    std::vector<BMI088*> devs = {rig.a.get(), rig.b.get()};
+    Bmi088Sampler sampler(devs, true);
+    MultiImuSample s;
+    long ops = 50000L * scale;
+    double sum = 0.0;
+    int64_t t0 = monotonicNs();
+    for (long i = 0; i < ops; i++) {
+        sampler.sample(s);
+        sum += s.gyroMedian[2];
+    }
+    int64_t t1 = monotonicNs();
+    // 仿真数据按真实时间生成，checksum 不跨构建比较
+    return Result{"bmi088", double(t1 - t0) / ops, ops, NAN};
+}
+
+Result benchServo(int scale) {
+    servo::SimServoBackend backend;
+    servo::ServoBank bank(backend);
+    servo::ServoCalibration cal[servo::kServoCount];
+    servo::defaultCalibration(cal);
+    std::atomic<float> setpoints[servo::kServoCount];
+    for (int i = 0; i < servo::kServoCount; i++) setpoints[i].store(0.0f);
+    servo::ServoLoop loop(bank, cal, setpoints, 3000000);
+    if (!loop.begin()) {
+        std::fprintf(stderr, "servo: 模拟后端打开失败\n");
+        std::exit(1);
+    }
+    long ops = 500000L * scale;
+    double sum = 0.0;
+    int64_t t0 = monotonicNs();
+    for (long i = 0; i < ops; i++) {
+        float a = 0.5f * std::sin(i * 0.01f);
+        for (int c = 0; c < servo::kServoCount; c++)
+            setpoints[c].store(c & 1 ? -a : a, std::memory_order_relaxed);
+        loop.step(0.003f);
+        sum += loop.pulse(0) - loop.pulse(1);
+    }
+    int64_t t1 = monotonicNs();
+    loop.end();
+    return Result{"servo", double(t1 - t0) / ops, ops, sum / ops};
+}
+
+bool selected(const Options& o, const char* name) {
+    return !o.only || !std::strcmp(o.only, name);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options o;
+    if (!parseOptions(argc, argv, o)) {
+        std::fprintf(stderr, "用法: bench_components [--repeat N] [--scale K] [--only 组件名]\n");
+        return 2;
+    }
+
+    Scenario sc;
+    if (!buildScenario(sc, 64)) {
+        std::fprintf(stderr, "合成帧生成失败\n");
+        return 1;
+    }
+    ImuTrace imu = makeImuTrace(4000);
+
+    std::unique_ptr<Bmi088Rig> rig;
+    if (selected(o, "bmi088")) {
+        try {
+            rig.reset(new Bmi088Rig());
+        } catch (const std::exception& e) {
+            std::fprintf(stderr, "bmi088: %s\n", e.what());
+            return 1;
+        }
+    }
+
+    std::vector<Result> results;
+    for (int r = 0; r < o.repeat; r++) {
+        std::vector<Result> run;
+        if (selected(o, "detector")) run.push_back(benchDetector(sc, o.scale));
+        if (selected(o, "fusion")) run.push_back(benchFusion(sc, o.scale));
+        if (selected(o, "tracker")) run.push_back(benchTracker(o.scale));
+        if (selected(o, "imu_filter")) run.push_back(benchImuFilter(imu, o.scale));
+        if (selected(o, "preint")) run.push_back(benchPreint(imu, o.scale));
+        if (rig) run.push_back(benchBmi088(*rig, o.scale));
+        if (selected(o, "servo")) run.push_back(benchServo(o.scale));
+        if (results.empty()) {
+            results = run;
+            continue;
+        }
+        for (size_t i = 0; i < run.size(); i++) results[i].nsPerOp = std::min(results[i].nsPerOp, run[i].nsPerOp);
+    }
+    if (results.empty()) {
+        std::fprintf(stderr, "没有名为 %s 的组件\n", o.only);
+        return 2;
+    }
+
+    std::printf("%-12s %12s %10s %16s\n", "component", "ns/op", "ops", "checksum");
+    for (const Result& r : results) std::printf("%-12s %12.1f %10ld %16.6g\n", r.name, r.nsPerOp, r.ops, r.checksum);
+    return 0;
+}
@@ -0,0 +1,517 @@
+#include "frame_replay.hpp"
+#include "image_convert.hpp"
+#include "jitter_stats.hpp"
+#include "light_detector.hpp"
+#include "rt_clock.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 检测器离线基准：同一组帧分别走 BGR、I420 和原始 Bayer 判据，比较掩码、连通域和耗时
+// 用法: bench_detector [--replay 录像.mwfr] [--record 输出.mwfr] [--frames N] [--size 宽x高] [--raw-gains 红 蓝]
+//                      [--threads N] [--classifier 表达式]
+//   录像为 BGR 时用软件转换得到 I420（模拟 ISP 输出）和 10 位打包 Bayer（红、蓝除以 --raw-gains 模拟传感器偏色）；
+//   录像为 I420 时反向转换得到 BGR；录像为 Bayer 时按 2x2 单元还原 BGR
+//   不给录像时生成合成帧：软边缘绿色目标 + 白色、黄色、青色、暗绿干扰点
+//   --record 把合成帧存为 BGR 录像，供以后回放
+//   另外比较两级检测（8x8 候选块）与整帧检测的结果是否一致及耗时，
+//   以及 1..N 个线程 (默认 4) 的加速比、单帧延迟分布和与单线程结果是否一致
+//   颜色判据查表路径与阈值路径比较：默认用与绿色判据等价但不是简单形式的表达式，结果应完全一致；
+//   --classifier 给出其他判据时只报告耗时和与绿色判据的差异
+
+namespace {
+
+// 合成帧尺寸，--size 可改；目标和干扰点的像素大小不随分辨率变化
+int frameWidth = 320;
+int frameHeight = 240;
+
+struct FramePair {
+    std::vector<uint8_t> bgr;
+    std::vector<uint8_t> i420;
+    std::vector<uint8_t> raw;
+};
+
+// 原始 Bayer 的格式：合成帧和非 Bayer 录像用 10 位打包 RGGB
+struct RawLayout {
+    vision::PixelFormat format = vision::PIXEL_BAYER10P;
+    vision::BayerOrder order = vision::BAYER_RGGB;
+    int stride = 0;
+    float redGain = 1.8f;
+    float blueGain = 1.5f;
+};
+
+void mosaic(FramePair& p, int width, int height, const RawLayout& raw) {
+    p.raw.resize(static_cast<size_t>(raw.stride) * height);
+    vision::bgrToBayer10(p.bgr.data(), width * 3, width, height, raw.format, raw.order, raw.redGain, raw.blueGain,
+                         p.raw.data(), raw.stride);
+}
+
+void blend(std::vector<uint8_t>& img, float cx, float cy, float radius, const uint8_t (&color)[3]) {
+    int r = static_cast<int>(radius) + 2;
+    for (int y = static_cast<int>(cy) - r; y <= static_cast<int>(cy) + r; y++) {
+        if (y < 0 || y >= frameHeight) continue;
+        for (int x = static_cast<int>(cx) - r; x <= static_cast<int>(cx) + r; x++) {
+            if (x < 0 || x >= frameWidth) continue;
+            float d = std::sqrt((x - cx) * (x - cx) + (y - cy) * (y - cy));
+            float a = std::min(1.0f, std::max(0.0f, radius + 0.5f - d));   // 1 像素宽的软边
+            uint8_t* p = &img[(static_cast<size_t>(y) * frameWidth + x) * 3];
+            for (int c = 0; c < 3; c++) p[c] = static_cast<uint8_t>(p[c] * (1.0f - a) + color[c] * a + 0.5f);
+        }
+    }
+}
+
+// 镜头模糊 (3x3 [1 2 1] 核)：没有它时色块边缘是理想阶跃，Bayer 单元会出现真实光学下不存在的假色
+void lensBlur(std::vector<uint8_t>& img) {
+    std::vector<uint8_t> src = img;
+    for (int y = 1; y < frameHeight - 1; y++) {
+        for (int x = 1; x < frameWidth - 1; x++) {
+            for (int c = 0; c < 3; c++) {
+                int sum = 0;
+                for (int dy = -1; dy <= 1; dy++) {
+                    for (int dx = -1; dx <= 1; dx++) {
+                        int w = (dx ? 1 : 2) * (dy ? 1 : 2);
+                        sum += w * src[(static_cast<size_t>(y + dy) * frameWidth + x + dx) * 3 + c];
+                    }
+                }
+                img[(static_cast<size_t>(y) * frameWidth + x) * 3 + c] = static_cast<uint8_t>((sum + 8) / 16);
+            }
+        }
+    }
+}
+
+void synthesize(int frames, const RawLayout& raw, std::vector<FramePair>& out) {
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<int> noise(0, 40);
+    std::vector<uint8_t> background(static_cast<size_t>(frameWidth) * frameHeight * 3);
+    for (size_t i = 0; i < background.size(); i++) background[i] = static_cast<uint8_t>(noise(rng));
+
+    const uint8_t green[3] = {40, 235, 60};
+    const uint8_t white[3] = {250, 255, 250};
+    const uint8_t yellow[3] = {30, 240, 220};
+    const uint8_t cyan[3] = {230, 240, 40};
+    const uint8_t dimGreen[3] = {20, 150, 30};
+
+    out.resize(frames);
+    for (int k = 0; k < frames; k++) {
+        double t = k / 120.0;
+        float sx = frameWidth / 320.0f, sy = frameHeight / 240.0f;
+        std::vector<uint8_t> img = background;
+        float radius = 1.5f + 6.5f * static_cast<float>(0.5 + 0.5 * std::sin(2.0 * M_PI * 0.3 * t));
+        blend(img, sx * static_cast<float>(160 + 120 * std::sin(2.0 * M_PI * 0.5 * t)),
+              sy * static_cast<float>(120 + 90 * std::cos(2.0 * M_PI * 0.4 * t)), radius, green);
+        blend(img, sx * 60, sy * 50, 6, white);
+        blend(img, sx * 260, sy * 60, 4, yellow);
+        blend(img, sx * 80, sy * 190, 4, cyan);
+        blend(img, sx * 250, sy * 200, 5, dimGreen);
+        lensBlur(img);
+
+        out[k].bgr.swap(img);
+        out[k].i420.resize(vision::frameBytes(vision::PIXEL_I420, frameWidth, frameHeight));
+        vision::bgrToI420(out[k].bgr.data(), frameWidth * 3, frameWidth, frameHeight, out[k].i420.data(), frameWidth);
+        mosaic(out[k], frameWidth, frameHeight, raw);
+    }
+}
+
+bool loadReplay(const std::string& path, std::vector<FramePair>& out, int& width, int& height, RawLayout& raw) {
+    vision::ReplayFrameSource src(path);
+    if (!src.open()) return false;
+    width = src.width();
+    height = src.height();
+    bool rawSource = src.format() == vision::PIXEL_BAYER10 || src.format() == vision::PIXEL_BAYER10P;
+    if (rawSource) raw.format = src.format();
+    raw.stride = vision::minStride(raw.format, width);
+    vision::Frame f;
+    while (src.grab(f)) {
+        FramePair p;
+        p.bgr.resize(static_cast<size_t>(width) * height * 3);
+        p.i420.resize(vision::frameBytes(vision::PIXEL_I420, width, height));
+        if (f.format == vision::PIXEL_BGR24) {
+            for (int y = 0; y < height; y++) {
+                std::memcpy(&p.bgr[static_cast<size_t>(y) * width * 3], f.data + static_cast<size_t>(y) * f.stride,
+                            width * 3);
+            }
+            vision::bgrToI420(p.bgr.data(), width * 3, width, height, p.i420.data(), width);
+            mosaic(p, width, height, raw);
+        } else if (rawSource) {
+            raw.order = f.bayer;
+            p.raw.resize(static_cast<size_t>(raw.stride) * height);
+            for (int y = 0; y < height; y++) {
+                std::memcpy(&p.raw[static_cast<size_t>(y) * raw.stride], f.data + static_cast<size_t>(y) * f.stride,
+                            raw.stride);
+            }
+            vision::bayer10ToBgr(p.raw.data(), raw.stride, width, height, raw.format, raw.order, raw.redGain,
+                                 raw.blueGain, p.bgr.data(), width * 3);
+            vision::bgrToI420(p.bgr.data(), width * 3, width, height, p.i420.data(), width);
+        } else {
+            for (int y = 0; y < height; y++) {
+                std::memcpy(&p.i420[static_cast<size_t>(y) * width], f.data + static_cast<size_t>(y) * f.stride, width);
+            }
+            for (int y = 0; y < height; y++) {
+                std::memcpy(&p.i420[static_cast<size_t>(width) * height + static_cast<size_t>(y) * (width / 2)],
+                            f.planeU() + static_cast<size_t>(y) * (f.stride / 2), width / 2);
+            }
+            vision::i420ToBgr(p.i420.data(), width, width, height, p.bgr.data(), width * 3);
+            mosaic(p, width, height, raw);
+        }
+        out.push_back(p);
+    }
+    return !out.empty();
+}
+
+bool recordFrames(const std::string& path, const std::vector<FramePair>& frames) {
+    vision::FrameRecorder rec;
+    if (!rec.open(path, vision::PIXEL_BGR24, frameWidth, frameHeight, frameWidth * 3)) return false;
+    for (size_t k = 0; k < frames.size(); k++) {
+        vision::Frame f;
+        f.format = vision::PIXEL_BGR24;
+        f.width = frameWidth;
+        f.height = frameHeight;
+        f.stride = frameWidth * 3;
+        f.data = frames[k].bgr.data();
+        f.captureNs = static_cast<int64_t>(k) * 1000000000LL / 120;
+        f.id = static_cast<uint32_t>(k);
+        if (!rec.write(f)) return false;
+    }
+    return true;
+}
+
+bool sameBlobs(const vision::BlobList& a, const vision::BlobList& b) {
+    if (a.count != b.count) return false;
+    for (int i = 0; i < a.count; i++) {
+        const vision::Blob& p = a.blobs[i];
+        const vision::Blob& q = b.blobs[i];
+        if (p.cx != q.cx || p.cy != q.cy || p.area != q.area || p.x0 != q.x0 || p.y0 != q.y0 || p.x1 != q.x1 ||
+            p.y1 != q.y1) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename F>
+double nsPerFrame(size_t frames, int repeats, F fn) {
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; r++) {
+        for (size_t k = 0; k < frames; k++) fn(k);
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(t1 - t0).count() / (frames * repeats);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string replayPath, recordPath;
+    int frames = 600;
+    int maxThreads = 4;
+    std::string classifierExpr = "g > 200 && 2*g - 2*r > 200 && g - b > 100";
+    RawLayout raw;
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--replay") && hasValue) {
+            replayPath = argv[++i];
+        } else if (!std::strcmp(argv[i], "--record") && hasValue) {
+            recordPath = argv[++i];
+        } else if (!std::strcmp(argv[i], "--frames") && hasValue) {
+            frames = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--size") && hasValue) {
+            if (std::sscanf(argv[++i], "%dx%d", &frameWidth, &frameHeight) != 2) return 2;
+        } else if (!std::strcmp(argv[i], "--classifier") && hasValue) {
+            classifierExpr = argv[++i];
+        } else if (!std::strcmp(argv[i], "--threads") && hasValue) {
+            maxThreads = std::max(1, std::atoi(argv[++i]));
+        } else if (!std::strcmp(argv[i], "--raw-gains") && i + 2 < argc) {
+            raw.redGain = static_cast<float>(std::atof(argv[++i]));
+            raw.blueGain = static_cast<float>(std::atof(argv[++i]));
+        } else {
+            std::fprintf(stderr, "未知参数: %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    int width = frameWidth, height = frameHeight;
+    std::vector<FramePair> set;
+    if (!replayPath.empty()) {
+        if (!loadReplay(replayPath, set, width, height, raw)) {
+            std::fprintf(stderr, "无法读取录像 %s\n", replayPath.c_str());
+            return 1;
+        }
+    } else {
+        raw.stride = vision::minStride(raw.format, width);
+        synthesize(frames, raw, set);
+        if (!recordPath.empty() && !recordFrames(recordPath, set)) {
+            std::fprintf(stderr, "无法写入 %s\n", recordPath.c_str());
+            return 1;
+        }
+    }
+
+    vision::GreenRule rawRule;
+    rawRule.rawRedGain = raw.redGain;
+    rawRule.rawBlueGain = raw.blueGain;
+    vision::LightDetector bgrDet(width, height), yuvDet(width, height), rawDet(width, height, rawRule);
+    const int cStride = width / 2;
+    const size_t lumaBytes = static_cast<size_t>(width) * height;
+
+    // 精度：逐像素掩码一致性 + 最大连通域
+    uint64_t both = 0, onlyBgr = 0, onlyYuv = 0, candidates = 0;
+    size_t countMatch = 0, presenceMatch = 0, paired = 0;
+    double sumErr = 0.0, maxErr = 0.0, sumAreaRatio = 0.0;
+    size_t rawExtra = 0, rawPaired = 0, withTarget = 0;
+    double rawSumErr = 0.0, rawMaxErr = 0.0;
+    uint64_t upsampledMismatch = 0;
+    std::vector<uint8_t> bgrMask(lumaBytes), upsampled(lumaBytes * 3);
+    vision::LightDetector refDet(width, height);
+    for (size_t k = 0; k < set.size(); k++) {
+        vision::BlobList a, b;
+        bgrDet.detectBgr(set[k].bgr.data(), width * 3, a);
+        std::memcpy(bgrMask.data(), bgrDet.mask(), lumaBytes);
+        const uint8_t* y = set[k].i420.data();
+        yuvDet.detectI420(y, width, y + lumaBytes, y + lumaBytes + lumaBytes / 4, cStride, b);
+        candidates += yuvDet.candidateBlocks();
+
+        const uint8_t* m = yuvDet.mask();
+        for (size_t i = 0; i < lumaBytes; i++) {
+            both += bgrMask[i] && m[i];
+            onlyBgr += bgrMask[i] && !m[i];
+            onlyYuv += !bgrMask[i] && m[i];
+        }
+
+        // 同一 I420 帧上采样成 BGR 后跑 BGR 判据，两者应逐像素一致（仅有定点舍入差异）
+        vision::BlobList c;
+        vision::i420ToBgr(y, width, width, height, upsampled.data(), width * 3);
+        refDet.detectBgr(upsampled.data(), width * 3, c);
+        for (size_t i = 0; i < lumaBytes; i++) upsampledMismatch += (refDet.mask()[i] != 0) != (m[i] != 0);
+
+        countMatch += a.count == b.count;
+        const vision::Blob* la = a.largest();
+        const vision::Blob* lb = b.largest();
+        presenceMatch += (la != nullptr) == (lb != nullptr);
+        withTarget += la != nullptr;
+        if (la && lb) {
+            double err = std::hypot(la->cx - lb->cx, la->cy - lb->cy);
+            sumErr += err;
+            maxErr = std::max(maxErr, err);
+            sumAreaRatio += static_cast<double>(lb->area) / la->area;
+            paired++;
+        }
+
+        // 原始 Bayer：半分辨率结果换算回全分辨率后，取离 BGR 最大连通域最近的一个比较
+        // 没有去马赛克，饱和色块边缘的 2x2 单元可能产生假绿色，单独统计
+        vision::BlobList d;
+        rawDet.detectBayer(set[k].raw.data(), raw.stride, raw.format, raw.order, d);
+        rawExtra += d.count > a.count;
+        if (la) {
+            double best = -1.0;
+            for (int i = 0; i < d.count; i++) {
+                double err = std::hypot(la->cx - d.blobs[i].cx, la->cy - d.blobs[i].cy);
+                if (best < 0.0 || err < best) best = err;
+            }
+            if (best >= 0.0) {
+                rawSumErr += best;
+                rawMaxErr = std::max(rawMaxErr, best);
+                rawPaired++;
+            }
+        }
+    }
+
+    size_t n = set.size();
+    std::printf("%zu frames %dx%d (%s)\n", n, width, height, replayPath.empty() ? "synthetic" : replayPath.c_str());
+    std::printf("mask pixels: both %llu, bgr only %llu, i420 only %llu, IoU %.4f\n",
+                static_cast<unsigned long long>(both), static_cast<unsigned long long>(onlyBgr),
+                static_cast<unsigned long long>(onlyYuv),
+                both ? static_cast<double>(both) / (both + onlyBgr + onlyYuv) : 1.0);
+    std::printf("i420 rule vs bgr rule on upsampled i420: %llu mismatched pixels\n",
+                static_cast<unsigned long long>(upsampledMismatch));
+    std::printf("blob count match %.2f%%, largest blob presence match %.2f%%\n", 100.0 * countMatch / n,
+                100.0 * presenceMatch / n);
+    if (paired) {
+        std::printf("largest blob centroid error mean %.3f px max %.3f px, area ratio i420/bgr %.3f\n",
+                    sumErr / paired, maxErr, sumAreaRatio / paired);
+    }
+
+    std::printf("bayer target found %.2f%%", withTarget ? 100.0 * rawPaired / withTarget : 100.0);
+    if (rawPaired) std::printf(", nearest centroid error mean %.3f px max %.3f px", rawSumErr / rawPaired, rawMaxErr);
+    std::printf(", frames with extra blobs %.2f%%\n", 100.0 * rawExtra / n);
+
+    // 耗时；读入字节：BGR 每像素 3 字节，I420 为 0.5 字节色度 + 候选块的亮度
+    vision::BlobList out;
+    int repeats = std::max(1, 3000 / static_cast<int>(n));
+    double tBgr = nsPerFrame(n, repeats, [&](size_t k) { bgrDet.detectBgr(set[k].bgr.data(), width * 3, out); });
+    double tYuv = nsPerFrame(n, repeats, [&](size_t k) {
+        const uint8_t* y = set[k].i420.data();
+        yuvDet.detectI420(y, width, y + lumaBytes, y + lumaBytes + lumaBytes / 4, cStride, out);
+    });
+    double tRaw = nsPerFrame(n, repeats, [&](size_t k) {
+        rawDet.detectBayer(set[k].raw.data(), raw.stride, raw.format, raw.order, out);
+    });
+    double lumaRead = 4.0 * candidates / n;
+    std::printf("bgr  %8.1f us/frame, read %.2f B/px\n", tBgr / 1000.0, 3.0);
+    std::printf("i420 %8.1f us/frame, read %.2f B/px (%.1f candidate blocks/frame), speedup %.2fx\n",
+                tYuv / 1000.0, 0.5 + lumaRead / lumaBytes, static_cast<double>(candidates) / n, tBgr / tYuv);
+    // 两级检测与整帧检测：连通域逐字段一致，耗时随目标大小而不是帧大小变化
+    vision::DetectorOptions fullFrame;
+    fullFrame.tiled = false;
+    vision::LightDetector bgrFull(width, height, vision::GreenRule(), fullFrame);
+    vision::LightDetector yuvFull(width, height, vision::GreenRule(), fullFrame);
+    size_t bgrSame = 0, yuvSame = 0;
+    uint64_t tiles = 0;
+    for (size_t k = 0; k < n; k++) {
+        vision::BlobList a, b;
+        bgrDet.detectBgr(set[k].bgr.data(), width * 3, a);
+        tiles += bgrDet.candidateTiles();
+        bgrFull.detectBgr(set[k].bgr.data(), width * 3, b);
+        bgrSame += sameBlobs(a, b);
+        const uint8_t* y = set[k].i420.data();
+        yuvDet.detectI420(y, width, y + lumaBytes, y + lumaBytes + lumaBytes / 4, cStride, a);
+        yuvFull.detectI420(y, width, y + lumaBytes, y + lumaBytes + lumaBytes / 4, cStride, b);
+        yuvSame += sameBlobs(a, b);
+    }
+    double tBgrFull = nsPerFrame(n, repeats, [&](size_t k) { bgrFull.detectBgr(set[k].bgr.data(), width * 3, out); });
+    double tYuvFull = nsPerFrame(n, repeats, [&](size_t k) {
+        const uint8_t* y = set[k].i420.data();
+        yuvFull.detectI420(y, width, y + lumaBytes, y + lumaBytes + lumaBytes / 4, cStride, out);
+    });
+
+    std::printf("raw  %8.1f us/frame, read %.2f B/px (%s, half-resolution labels), speedup %.2fx\n", tRaw / 1000.0,
+                static_cast<double>(raw.stride) / width, raw.format == vision::PIXEL_BAYER10P ? "raw10 packed" : "raw10",
+                tBgr / tRaw);
+    std::printf("tiled vs full frame (%.1f candidate 8x8 tiles/frame of %d):\n", static_cast<double>(tiles) / n,
+                ((width + 7) / 8) * ((height + 7) / 8));
+    std::printf("  bgr  full %8.1f us tiled %8.1f us, speedup %.2fx, identical %.2f%%\n", tBgrFull / 1000.0,
+                tBgr / 1000.0, tBgrFull / tBgr, 100.0 * bgrSame / n);
+    std::printf("  i420 full %8.1f us tiled %8.1f us, speedup %.2fx, identical %.2f%%\n", tYuvFull / 1000.0,
+                tYuv / 1000.0, tYuvFull / tYuv, 100.0 * yuvSame / n);
+
+    // 颜色判据查表：与阈值路径逐帧比较，另一个线程在运行中切换判据
+    vision::ColorClassifier lut;
+    std::string err;
+    auto c0 = std::chrono::steady_clock::now();
+    if (!lut.compile(classifierExpr, err)) {
+        std::fprintf(stderr, "%s\n", err.c_str());
+        return 2;
+    }
+    double compileMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - c0).count();
+    int dummy;
+    std::printf("classifier \"%s\": %s, compiled in %.2f ms, %.2f%% boundary cells\n", classifierExpr.c_str(),
+                lut.simple(dummy, dummy, dummy) ? "simple (threshold path)" : "lookup table", compileMs,
+                100.0 * lut.mixedFraction());
+    {
+        vision::LightDetector bgrLut(width, height), yuvLut(width, height), rawLut(width, height, rawRule);
+        vision::DetectorOptions fullOpts;
+        fullOpts.tiled = false;
+        vision::LightDetector bgrLutFull(width, height, vision::GreenRule(), fullOpts);
+        bgrLut.setClassifier(lut);
+        yuvLut.setClassifier(lut);
+        rawLut.setClassifier(lut);
+        bgrLutFull.setClassifier(lut);
+        size_t same[4] = {0, 0, 0, 0};
+        for (size_t k = 0; k < n; k++) {
+            vision::BlobList a, b;
+            bgrDet.detectBgr(set[k].bgr.data(), width * 3, a);
+            bgrLut.detectBgr(set[k].bgr.data(), width * 3, b);
+            same[0] += sameBlobs(a, b);
+            bgrLutFull.detectBgr(set[k].bgr.data(), width * 3, b);
+            same[1] += sameBlobs(a, b);
+            const uint8_t* y = set[k].i420.data();
+            yuvDet.detectI420(y, width, y + lumaBytes, y + lumaBytes + lumaBytes / 4, cStride, a);
+            yuvLut.detectI420(y, width, y + lumaBytes, y + lumaBytes + lumaBytes / 4, cStride, b);
+            same[2] += sameBlobs(a, b);
+            rawDet.detectBayer(set[k].raw.data(), raw.stride, raw.format, raw.order, a);
+            rawLut.detectBayer(set[k].raw.data(), raw.stride, raw.format, raw.order, b);
+            same[3] += sameBlobs(a, b);
+        }
+        double tBgrLut = nsPerFrame(n, repeats, [&](size_t k) { bgrLut.detectBgr(set[k].bgr.data(), width * 3, out); });
+        double tBgrLutFull =
+            nsPerFrame(n, repeats, [&](size_t k) { bgrLutFull.detectBgr(set[k].bgr.data(), width * 3, out); });
+        double tYuvLut = nsPerFrame(n, repeats, [&](size_t k) {
+            const uint8_t* y = set[k].i420.data();
+            yuvLut.detectI420(y, width, y + lumaBytes, y + lumaBytes + lumaBytes / 4, cStride, out);
+        });
+        double tRawLut = nsPerFrame(n, repeats, [&](size_t k) {
+            rawLut.detectBayer(set[k].raw.data(), raw.stride, raw.format, raw.order, out);
+        });
+        std::printf("  bgr  tiled %8.1f us (threshold %8.1f us), same as green rule %.2f%%\n", tBgrLut / 1000.0,
+                    tBgr / 1000.0, 100.0 * same[0] / n);
+        std::printf("  bgr  full  %8.1f us (threshold %8.1f us), same as green rule %.2f%%\n", tBgrLutFull / 1000.0,
+                    tBgrFull / 1000.0, 100.0 * same[1] / n);
+        std::printf("  i420 tiled %8.1f us (threshold %8.1f us), same as green rule %.2f%%\n", tYuvLut / 1000.0,
+                    tYuv / 1000.0, 100.0 * same[2] / n);
+        std::printf("  raw        %8.1f us (threshold %8.1f us), same as green rule %.2f%%\n", tRawLut / 1000.0,
+                    tRaw / 1000.0, 100.0 * same[3] / n);
+
+        // 运行中切换：检测线程不停，另一个线程发布新判据，之后的帧应与直接设置新判据的检测器一致
+        vision::LightDetector live(width, height);
+        std::atomic<bool> published(false);
+        std::thread tuner([&] {
+            live.retune(lut);
+            published = true;
+        });
+        size_t frame = 0;
+        while (!published) live.detectBgr(set[frame++ % n].bgr.data(), width * 3, out);
+        tuner.join();
+        size_t liveSame = 0;
+        for (size_t k = 0; k < n; k++) {
+            vision::BlobList a;
+            live.detectBgr(set[k].bgr.data(), width * 3, a);
+            bgrLut.detectBgr(set[k].bgr.data(), width * 3, out);
+            liveSame += sameBlobs(a, out);
+        }
+        std::printf("  retune while running: switched after %zu frames, same as lookup table %.2f%%\n", frame,
+                    100.0 * liveSame / n);
+    }
+
+    // 多线程：逐帧计时，结果与单线程逐字段比较
+    std::printf("threads (per-frame latency, us, %u cpus online):\n", std::thread::hardware_concurrency());
+    std::vector<vision::BlobList> reference(n);
+    for (int mode = 0; mode < 4; mode++) {
+        bool i420 = mode >= 2;
+        vision::DetectorOptions opts;
+        opts.tiled = mode % 2 == 0;
+        double single = 0.0;
+        for (int threads = 1; threads <= maxThreads; threads++) {
+            opts.threads = threads;
+            vision::LightDetector det(width, height, vision::GreenRule(), opts);
+            auto run = [&](size_t k, vision::BlobList& res) {
+                if (i420) {
+                    const uint8_t* y = set[k].i420.data();
+                    det.detectI420(y, width, y + lumaBytes, y + lumaBytes + lumaBytes / 4, cStride, res);
+                } else {
+                    det.detectBgr(set[k].bgr.data(), width * 3, res);
+                }
+            };
+            size_t same = 0;
+            for (size_t k = 0; k < n; k++) {
+                if (threads == 1) {
+                    run(k, reference[k]);
+                    same++;
+                } else {
+                    run(k, out);
+                    same += sameBlobs(out, reference[k]);
+                }
+            }
+            JitterStats latency;
+            for (int r = 0; r < repeats; r++) {
+                for (size_t k = 0; k < n; k++) {
+                    int64_t t0 = monotonicNs();
+                    run(k, out);
+                    latency.add(monotonicNs() - t0);
+                }
+            }
+            if (threads == 1) single = latency.meanUs();
+            std::printf("  %s %-5s x%d mean %8.1f p50 %6.0f p99 %6.0f max %8.1f, speedup %.2fx, identical %.2f%%\n",
+                        i420 ? "i420" : "bgr ", opts.tiled ? "tiled" : "full", threads, latency.meanUs(),
+                        latency.percentileUs(50), latency.percentileUs(99), latency.maxUs(),
+                        single / latency.meanUs(), 100.0 * same / n);
+        }
+    }
+    return 0;
+}
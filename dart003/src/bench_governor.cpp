@@ -0,0 +1,207 @@
+#include "jitter_stats.hpp"
+#include "light_detector.hpp"
+#include "quality_governor.hpp"
+#include "rt_clock.hpp"
+#include "sim_sources.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// 检测质量调节的离线验证：合成帧跑真实检测器，按温度曲线的频率把实测耗时换算成降频后的耗时，
+// 比较关闭 / 开启调节时的截止时间丢失、目标检出率和质心误差
+// 用法: bench_governor [--seconds 60] [--fps 120] [--size 宽x高] [--format bgr|i420] [--load 0.8]
+//                      [--trace 温度曲线.csv] [--levels "refine=1; roi=0; ..."]
+//   --load 为最高档在最高频率下的 p90 耗时占帧周期的比例，按它把实测耗时放大，模拟比本机慢的 CPU
+//   --trace 为 CSV (t_s,temp_c,freq_mhz)，不给时用合成曲线：升温到 85 度，80 度起降频到 2/3，最后散热
+//   温度/频率每 500 ms 采样一次，与运行时的 thermal 任务相同
+
+namespace {
+
+struct Options {
+    double seconds = 60.0;
+    int fps = 120;
+    int width = 640, height = 480;
+    vision::PixelFormat format = vision::PIXEL_BGR24;
+    double load = 0.8;
+    const char* trace = nullptr;
+    const char* levels = nullptr;
+};
+
+bool parseOptions(int argc, char** argv, Options& o) {
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (!std::strcmp(a, "--seconds") && hasValue) {
+            o.seconds = std::atof(argv[++i]);
+        } else if (!std::strcmp(a, "--fps") && hasValue) {
+            o.fps = std::atoi(argv[++i]);
+        } else if (!std::strcmp(a, "--size") && hasValue) {
+            if (std::sscanf(argv[++i], "%dx%d", &o.width, &o.height) != 2) return false;
+        } else if (!std::strcmp(a, "--format") && hasValue) {
+            std::string f = argv[++i];
+            if (f == "bgr") o.format = vision::PIXEL_BGR24;
+            else if (f == "i420") o.format = vision::PIXEL_I420;
+            else return false;
+        } else if (!std::strcmp(a, "--load") && hasValue) {
+            o.load = std::atof(argv[++i]);
+        } else if (!std::strcmp(a, "--trace") && hasValue) {
+            o.trace = argv[++i];
+        } else if (!std::strcmp(a, "--levels") && hasValue) {
+            o.levels = argv[++i];
+        } else {
+            std::cerr << "未知参数: " << a << std::endl;
+            return false;
+        }
+    }
+    return o.fps > 0 && o.seconds > 0 && o.width > 0 && o.height > 0;
+}
+
+// 预先生成一段帧循环使用，合成帧的渲染不计入检测耗时
+struct StoredFrame {
+    vision::Frame frame;
+    std::vector<uint8_t> bytes;
+    float truthX, truthY;
+};
+
+struct RunResult {
+    JitterStats scaled;                  // 换算后的单帧处理时间
+    uint64_t frames = 0, misses = 0, found = 0;
+    double errorSum = 0.0;
+    std::vector<uint64_t> framesAtLevel;
+};
+
+int64_t measure(vision::LightDetector& det, const StoredFrame& f, vision::BlobList& out) {
+    int64_t t0 = monotonicNs();
+    det.detect(f.frame, out);
+    return monotonicNs() - t0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parseOptions(argc, argv, opt)) return 2;
+
+    vision::GovernorConfig gov;
+    gov.enabled = true;
+    std::string err;
+    if (opt.levels && !vision::parseQualityLevels(opt.levels, gov.levels, err)) {
+        std::cerr << err << std::endl;
+        return 2;
+    }
+    vision::TraceThermalSource trace = vision::TraceThermalSource::synthetic(opt.seconds);
+    if (opt.trace && !trace.load(opt.trace, err)) {
+        std::cerr << err << std::endl;
+        return 2;
+    }
+
+    vision::CameraConfig cam;
+    cam.format = opt.format;
+    cam.width = opt.width;
+    cam.height = opt.height;
+    cam.fps = opt.fps;
+    sim::Scene scene;
+    sim::SyntheticFrameSource source(cam, 62.2f, scene, 0, false);
+    if (!source.open()) return 1;
+    std::vector<StoredFrame> frames(std::min(opt.fps * 4, static_cast<int>(opt.seconds * opt.fps)));
+    for (size_t k = 0; k < frames.size(); k++) {
+        vision::Frame f;
+        if (!source.grab(f)) return 1;
+        StoredFrame& s = frames[k];
+        s.bytes.assign(f.data, f.data + vision::frameBytes(f.format, f.stride, f.height));
+        s.frame = f;
+        s.frame.data = s.bytes.data();
+        source.truthPixel(static_cast<uint32_t>(k), s.truthX, s.truthY);
+    }
+
+    const int64_t periodNs = 1000000000LL / opt.fps;
+    vision::DetectorOptions base;
+    vision::LightDetector det(opt.width, opt.height, vision::GreenRule(), base);
+
+    // 最高档 p90 换算到 --load x 帧周期
+    vision::QualityGovernor probe(gov, periodNs, base);
+    probe.apply(det, nullptr);
+    JitterStats calib;
+    vision::BlobList blobs;
+    for (size_t k = 0; k < frames.size(); k++) calib.add(measure(det, frames[k], blobs));
+    double slow = opt.load * periodNs / (calib.percentileUs(90.0) * 1000.0);
+
+    const int64_t thermalPeriodNs = 500000000LL;
+    const int64_t total = static_cast<int64_t>(opt.seconds * opt.fps);
+    std::printf("%dx%d %s %d fps, %.0f s, deadline %lld us, top level p90 %.1f us here x %.1f = %.0f%% of frame\n",
+                opt.width, opt.height, opt.format == vision::PIXEL_I420 ? "i420" : "bgr", opt.fps, opt.seconds,
+                static_cast<long long>(periodNs / 1000), calib.percentileUs(90.0), slow, opt.load * 100.0);
+
+    RunResult results[2];
+    for (int governed = 0; governed < 2; governed++) {
+        RunResult& r = results[governed];
+        vision::QualityGovernor governor(gov, periodNs, base);
+        r.framesAtLevel.assign(governor.levelCount(), 0);
+        det.setOptions(base);
+        det.clearRoi();
+        std::printf("%s:\n", governed ? "governor on" : "governor off (top level)");
+        if (!governed) governor.apply(det, nullptr);
+
+        vision::ThermalSample th = vision::ThermalSample();
+        float nominalMHz = 0.0f;
+        int64_t nextThermal = 0;
+        vision::Blob target = vision::Blob();
+        bool hasTarget = false;
+        for (int64_t k = 0; k < total; k++) {
+            int64_t t = k * periodNs;
+            if (t >= nextThermal) {
+                trace.at(t * 1e-9, th);
+                th.tNs = t;
+                nominalMHz = std::max(nominalMHz, th.freqMHz);
+                nextThermal += thermalPeriodNs;
+            }
+            const StoredFrame& f = frames[k % frames.size()];
+            if (governed) governor.apply(det, hasTarget ? &target : nullptr);
+            double speed = th.freqMHz > 0.0f ? th.freqMHz / nominalMHz : 1.0;
+            int64_t cost = static_cast<int64_t>(measure(det, f, blobs) * slow / speed);
+
+            r.frames++;
+            r.scaled.add(cost);
+            r.misses += cost > periodNs;
+            r.framesAtLevel[governor.level()]++;
+            const vision::Blob* b = blobs.largest();
+            hasTarget = b != nullptr;
+            if (b) {
+                target = *b;
+                double e = std::hypot(b->cx - f.truthX, b->cy - f.truthY);
+                if (e < 3.0) {
+                    r.found++;
+                    r.errorSum += e;
+                }
+            }
+            if (governed) {
+                governor.update(t + cost, cost, th);
+                vision::QualityEvent e;
+                while (governor.pollEvent(e)) {
+                    std::printf("  %6.2f s ", e.tNs * 1e-9);
+                    vision::printQualityEvent(e);
+                }
+            }
+        }
+    }
+
+    std::printf("%-24s %10s %10s %10s %8s %9s %12s\n", "", "mean us", "p99 us", "max us", "misses", "found", "centroid px");
+    for (int governed = 0; governed < 2; governed++) {
+        const RunResult& r = results[governed];
+        std::printf("%-24s %10.0f %10.0f %10.0f %7.2f%% %8.2f%% %12.3f\n", governed ? "governor on" : "governor off",
+                    r.scaled.meanUs(), r.scaled.percentileUs(99.0), r.scaled.maxUs(), 100.0 * r.misses / r.frames,
+                    100.0 * r.found / r.frames, r.found ? r.errorSum / r.found : 0.0);
+    }
+    std::printf("frames per level (governor on):");
+    for (size_t i = 0; i < results[1].framesAtLevel.size(); i++) {
+        std::printf(" %zu: %.1f%%", i, 100.0 * results[1].framesAtLevel[i] / results[1].frames);
+    }
+    std::printf("\n");
+    return 0;
+}
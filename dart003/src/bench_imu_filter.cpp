@@ -0,0 +1,221 @@
+#include "imu_filter.hpp"
+#include "jitter_stats.hpp"
+#include "rt_clock.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// IMU 滤波器基准 (不需要硬件)：
+//   1. 同一组级联分别用逐通道标量、SIMD 单样本、SIMD 批量处理，比较每个样本的耗时和输出差异
+//   2. 合成陀螺：机动 + 频率扫动的电机振动 + 白噪声，比较 仅低通 / 固定陷波 / 动态陷波 后残留的扰动
+//      (扰动 = 全信号的输出 - 纯机动信号经同一滤波器的输出)
+// 用法: bench_imu_filter [--hz 2000] [--seconds 10] [--vib-from 150] [--vib-to 250] [--vib-amp 0.3]
+//                        [--stages "lpf gyro 150; lpf accel 40"] [--fft 256]
+
+namespace {
+
+struct Options {
+    float hz = 2000.0f;
+    double seconds = 10.0;
+    float vibFrom = 150.0f;
+    float vibTo = 250.0f;
+    float vibAmp = 0.3f;                 // rad/s
+    std::string stages = "lpf gyro 150; lpf accel 40";
+    int fft = 256;
+};
+
+struct Signal {
+    std::vector<sensor::ImuSample> clean, noisy;
+    std::vector<float> vibHz;
+};
+
+Signal synth(const Options& o) {
+    Signal s;
+    int n = static_cast<int>(o.seconds * o.hz);
+    std::mt19937 rng(7);
+    std::normal_distribution<float> noise(0.0f, 0.01f);
+    double phase = 0.0;
+    for (int i = 0; i < n; i++) {
+        double t = i / o.hz;
+        double f = o.vibFrom + (o.vibTo - o.vibFrom) * t / o.seconds;
+        phase += 2.0 * M_PI * f / o.hz;
+        sensor::ImuSample c;
+        c.clear();
+        c.tNs = static_cast<int64_t>(t * 1e9);
+        c.flags = sensor::SAMPLE_GYRO | sensor::SAMPLE_ACCEL;
+        c.gyro[0] = static_cast<float>(0.5 * std::sin(2.0 * M_PI * 2.0 * t));
+        c.gyro[1] = static_cast<float>(0.3 * std::sin(2.0 * M_PI * 0.7 * t + 1.0));
+        c.gyro[2] = static_cast<float>(0.2 * std::cos(2.0 * M_PI * 1.3 * t));
+        c.accel[2] = 9.80665f;
+        sensor::ImuSample v = c;
+        // 振动在三轴上的相位不同，x 最强
+        for (int a = 0; a < 3; a++) {
+            v.gyro[a] += static_cast<float>(o.vibAmp * (1.0 - 0.3 * a) * std::sin(phase + a)) + noise(rng);
+            v.accel[a] += static_cast<float>(2.0 * std::sin(phase + 0.5 * a)) + noise(rng);
+        }
+        s.clean.push_back(c);
+        s.noisy.push_back(v);
+        s.vibHz.push_back(static_cast<float>(f));
+    }
+    return s;
+}
+
+// 扰动 RMS (陀螺三轴合计)，跳过前 0.5 s 的暂态
+double disturbanceRms(const std::vector<sensor::ImuSample>& out, const std::vector<sensor::ImuSample>& ref, float hz) {
+    size_t skip = static_cast<size_t>(0.5f * hz);
+    double sum = 0.0;
+    size_t n = 0;
+    for (size_t i = skip; i < out.size(); i++, n++) {
+        for (int a = 0; a < 3; a++) {
+            double d = out[i].gyro[a] - ref[i].gyro[a];
+            sum += d * d;
+        }
+    }
+    return n ? std::sqrt(sum / n) : 0.0;
+}
+
+// 对一段样本跑一组滤波器；peak 非空时按振动峰重调 harmonic > 0 的陷波
+std::vector<sensor::ImuSample> run(const std::vector<sensor::ImuSample>& in, const std::vector<imufilter::StageConfig>& st,
+                                   float hz, imufilter::PeakFinder* peak, JitterStats* feedCost) {
+    imufilter::FilterBank bank;
+    std::string err;
+    bank.configure(st, hz, err);
+    std::vector<sensor::ImuSample> out(in);
+    for (sensor::ImuSample& s : out) {
+        if (peak) {
+            int64_t t0 = monotonicNs();
+            bool updated = peak->feed(s.gyro);
+            if (feedCost) feedCost->add(monotonicNs() - t0);
+            if (updated) {
+                for (int i = 0; i < bank.size(); i++) {
+                    if (bank.stage(i).harmonic > 0) bank.retune(i, bank.stage(i).harmonic * peak->peakHz());
+                }
+            }
+        }
+        bank.process(s.gyro, s.accel);
+    }
+    return out;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options o;
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--hz") && hasValue) {
+            o.hz = static_cast<float>(std::atof(argv[++i]));
+        } else if (!std::strcmp(argv[i], "--seconds") && hasValue) {
+            o.seconds = std::atof(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--vib-from") && hasValue) {
+            o.vibFrom = static_cast<float>(std::atof(argv[++i]));
+        } else if (!std::strcmp(argv[i], "--vib-to") && hasValue) {
+            o.vibTo = static_cast<float>(std::atof(argv[++i]));
+        } else if (!std::strcmp(argv[i], "--vib-amp") && hasValue) {
+            o.vibAmp = static_cast<float>(std::atof(argv[++i]));
+        } else if (!std::strcmp(argv[i], "--stages") && hasValue) {
+            o.stages = argv[++i];
+        } else if (!std::strcmp(argv[i], "--fft") && hasValue) {
+            o.fft = std::atoi(argv[++i]);
+        } else {
+            std::cerr << "未知参数: " << argv[i] << std::endl;
+            return 2;
+        }
+    }
+
+    std::vector<imufilter::StageConfig> base;
+    std::string err;
+    if (!imufilter::parseStages(o.stages, base, err) || o.hz <= 0.0f || o.seconds <= 1.0) {
+        std::cerr << (err.empty() ? "--hz 为正，--seconds 大于 1" : err) << std::endl;
+        return 2;
+    }
+    Signal sig = synth(o);
+    int n = static_cast<int>(sig.noisy.size());
+
+    // 1. 耗时：低通 + 两个陷波，共三种实现
+    std::vector<imufilter::StageConfig> full = base;
+    imufilter::StageConfig notch;
+    notch.type = imufilter::STAGE_NOTCH;
+    notch.axes = imufilter::AXES_ALL;
+    notch.q = 3.0f;
+    notch.hz = 0.5f * (o.vibFrom + o.vibTo);
+    full.push_back(notch);
+    notch.hz *= 2.0f;
+    full.push_back(notch);
+    imufilter::FilterBank scalar, single, batch;
+    scalar.configure(full, o.hz, err);
+    single.configure(full, o.hz, err);
+    batch.configure(full, o.hz, err);
+    std::vector<sensor::ImuSample> a(sig.noisy), b(sig.noisy), c(sig.noisy);
+    int64_t t0 = monotonicNs();
+    for (sensor::ImuSample& s : a) scalar.processScalar(s.gyro, s.accel);
+    int64_t t1 = monotonicNs();
+    for (sensor::ImuSample& s : b) single.process(s.gyro, s.accel);
+    int64_t t2 = monotonicNs();
+    batch.process(c.data(), n);
+    int64_t t3 = monotonicNs();
+    float maxDiff = 0.0f;
+    for (int i = 0; i < n; i++) {
+        for (int k = 0; k < 3; k++) {
+            maxDiff = std::max(maxDiff, std::fabs(a[i].gyro[k] - b[i].gyro[k]));
+            maxDiff = std::max(maxDiff, std::fabs(a[i].gyro[k] - c[i].gyro[k]));
+            maxDiff = std::max(maxDiff, std::fabs(a[i].accel[k] - c[i].accel[k]));
+        }
+    }
+    std::printf("%d samples @ %.0f Hz, %d stages x 6 axes (SIMD %s)\n", n, o.hz, static_cast<int>(full.size()),
+                SIMD_F32_AVAILABLE ? "on" : "off");
+    std::printf("%-14s %10s\n", "path", "ns/sample");
+    std::printf("%-14s %10.1f\n", "scalar", static_cast<double>(t1 - t0) / n);
+    std::printf("%-14s %10.1f\n", "simd single", static_cast<double>(t2 - t1) / n);
+    std::printf("%-14s %10.1f\n", "simd batch", static_cast<double>(t3 - t2) / n);
+    std::printf("max |scalar - simd| %.3g\n\n", maxDiff);
+
+    // 2. 振动抑制
+    std::vector<imufilter::StageConfig> fixed = base, dynamic = base;
+    notch.axes = imufilter::AXES_GYRO;
+    notch.hz = 0.5f * (o.vibFrom + o.vibTo);
+    fixed.push_back(notch);
+    notch.harmonic = 1;
+    dynamic.push_back(notch);
+
+    imufilter::PeakConfig pc;
+    pc.fftSize = o.fft;
+    imufilter::PeakFinder peak, peakRef;
+    if (!peak.configure(pc, o.hz, err) || !peakRef.configure(pc, o.hz, err)) {
+        std::cerr << err << std::endl;
+        return 2;
+    }
+    JitterStats feedCost;
+    double rawRms = disturbanceRms(sig.noisy, sig.clean, o.hz);
+    double lpfRms = disturbanceRms(run(sig.noisy, base, o.hz, nullptr, nullptr), run(sig.clean, base, o.hz, nullptr, nullptr), o.hz);
+    double fixedRms =
+        disturbanceRms(run(sig.noisy, fixed, o.hz, nullptr, nullptr), run(sig.clean, fixed, o.hz, nullptr, nullptr), o.hz);
+    // 参考支路用同一串重调频率：峰值检测只看带振动的信号，结果对两条支路相同
+    std::vector<sensor::ImuSample> dynOut = run(sig.noisy, dynamic, o.hz, &peak, &feedCost);
+    std::vector<float> notchHz;
+    {
+        imufilter::FilterBank bank;
+        bank.configure(dynamic, o.hz, err);
+        std::vector<sensor::ImuSample> ref(sig.clean);
+        for (int i = 0; i < n; i++) {
+            if (peakRef.feed(sig.noisy[i].gyro)) bank.retune(bank.size() - 1, peakRef.peakHz());
+            bank.process(ref[i].gyro, ref[i].accel);
+        }
+        std::printf("%-22s %14s %10s\n", "gyro filter", "vib+noise rms", "vs raw");
+        std::printf("%-22s %14.4f %9.1f dB\n", "none", rawRms, 0.0);
+        std::printf("%-22s %14.4f %9.1f dB\n", "lowpass", lpfRms, 20.0 * std::log10(lpfRms / rawRms));
+        std::printf("%-22s %14.4f %9.1f dB\n", "lowpass + fixed notch", fixedRms, 20.0 * std::log10(fixedRms / rawRms));
+        double dynRms = disturbanceRms(dynOut, ref, o.hz);
+        std::printf("%-22s %14.4f %9.1f dB\n", "lowpass + dyn notch", dynRms, 20.0 * std::log10(dynRms / rawRms));
+    }
+    std::printf("\npeak finder: %llu updates, final %.1f Hz (true %.1f Hz, snr %.1f)\n",
+                static_cast<unsigned long long>(peak.updates()), peak.peakHz(), sig.vibHz.back(), peak.snr());
+    feedCost.print("peak feed");
+    return 0;
+}
@@ -0,0 +1,199 @@
+#include "jitter_stats.hpp"
+#include "rt_clock.hpp"
+#include "shm_topic.hpp"
+
+#include <sched.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+// 进程间话题基准：
+//   1. 同进程内读最新值、入队出队的单次开销
+//   2. 写进程按固定频率发布 IMU 样本，子进程分别用最新值话题、数据流话题和管道接收，
+//      统计发布到收到的延迟和丢失（管道为对照）
+// 用法: bench_ipc [--seconds 2] [--hz 1000]
+
+namespace {
+
+const char* const kLatestName = "/milkyway.bench_latest";
+const char* const kStreamName = "/milkyway.bench_stream";
+const uint32_t kStreamSize = 256;
+const uint32_t kDone = 0xffffffffu;
+
+typedef ipc::StreamWriter<ipc::ImuSample, kStreamSize> BenchStreamWriter;
+typedef ipc::StreamReader<ipc::ImuSample, kStreamSize> BenchStreamReader;
+
+enum Mode { MODE_LATEST, MODE_STREAM, MODE_PIPE };
+const char* const kModeNames[] = {"shm latest", "shm stream", "pipe"};
+
+// 子进程：收到样本即记下延迟，读到结束标记后打印统计
+struct Receiver {
+    JitterStats latency;
+    uint32_t received = 0, gaps = 0, lastSeq = 0;
+
+    bool take(const ipc::ImuSample& s) {
+        if (s.seq == kDone) return false;
+        latency.add(monotonicNs() - s.tNs);
+        if (received && s.seq != lastSeq + 1) gaps += s.seq - lastSeq - 1;
+        lastSeq = s.seq;
+        received++;
+        return true;
+    }
+
+    void print(const char* name, uint32_t sent) const {
+        std::printf("  %-10s p50 %6.1f p99 %7.1f max %8.1f us, received %u of %u, skipped %u\n", name,
+                    latency.percentileUs(50), latency.percentileUs(99), latency.maxUs(), received, sent, gaps);
+    }
+};
+
+int receive(Mode mode, int pipeFd, uint32_t sent) {
+    Receiver rx;
+    ipc::ImuSample s;
+    std::string err;
+    if (mode == MODE_LATEST) {
+        ipc::LatestReader<ipc::ImuSample> reader;
+        if (!reader.open(kLatestName, err)) {
+            std::cerr << err << std::endl;
+            return 1;
+        }
+        // 打开前留下的旧值不算；最新值只保证看到最后一次写入，忙等 + 让出 CPU
+        reader.poll(s);
+        for (;;) {
+            if (reader.poll(s) && !rx.take(s)) break;
+            sched_yield();
+        }
+    } else if (mode == MODE_STREAM) {
+        BenchStreamReader reader;
+        if (!reader.open(kStreamName, err)) {
+            std::cerr << err << std::endl;
+            return 1;
+        }
+        bool running = true;
+        while (running) {
+            while (running && reader.pop(s)) running = rx.take(s);
+            if (running) sched_yield();
+        }
+    } else {
+        for (;;) {
+            ssize_t n = read(pipeFd, &s, sizeof(s));
+            if (n != static_cast<ssize_t>(sizeof(s)) || !rx.take(s)) break;
+        }
+    }
+    rx.print(kModeNames[mode], sent);
+    return 0;
+}
+
+// 同进程内的单次开销
+void measureLocal() {
+    std::string err;
+    ipc::LatestWriter<ipc::ImuSample> writer;
+    ipc::LatestReader<ipc::ImuSample> reader;
+    BenchStreamWriter streamWriter;
+    BenchStreamReader streamReader;
+    if (!writer.open(kLatestName, err) || !reader.open(kLatestName, err) || !streamWriter.open(kStreamName, err) ||
+        !streamReader.open(kStreamName, err)) {
+        std::cerr << err << std::endl;
+        std::exit(1);
+    }
+    const int n = 1000000;
+    ipc::ImuSample s = ipc::ImuSample();
+    uint64_t sink = 0;
+
+    int64_t t0 = monotonicNs();
+    for (int i = 0; i < n; i++) {
+        s.seq = i;
+        writer.publish(s);
+    }
+    int64_t t1 = monotonicNs();
+    for (int i = 0; i < n; i++) sink += reader.read(s);
+    int64_t t2 = monotonicNs();
+    for (int i = 0; i < n; i++) {
+        s.seq = i;
+        streamWriter.push(s);
+        streamReader.pop(s);
+        sink += s.seq;
+    }
+    int64_t t3 = monotonicNs();
+    std::printf("in process: publish %.1f ns, read %.1f ns, push+pop %.1f ns (%llu)\n",
+                static_cast<double>(t1 - t0) / n, static_cast<double>(t2 - t1) / n, static_cast<double>(t3 - t2) / n,
+                static_cast<unsigned long long>(sink % 10));
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    double seconds = 2.0;
+    int hz = 1000;
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--seconds") && hasValue) {
+            seconds = std::atof(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--hz") && hasValue) {
+            hz = std::atoi(argv[++i]);
+        } else {
+            std::cerr << "未知参数: " << argv[i] << std::endl;
+            return 2;
+        }
+    }
+
+    measureLocal();
+
+    const uint32_t count = static_cast<uint32_t>(seconds * hz);
+    const int64_t period = 1000000000LL / hz;
+    std::printf("cross process, %d Hz x %u samples:\n", hz, count);
+    std::fflush(stdout);
+    int failures = 0;
+    for (int m = MODE_LATEST; m <= MODE_PIPE; m++) {
+        Mode mode = static_cast<Mode>(m);
+        std::string err;
+        ipc::LatestWriter<ipc::ImuSample> latest;
+        BenchStreamWriter stream;
+        int fds[2] = {-1, -1};
+        if ((mode == MODE_LATEST && !latest.open(kLatestName, err)) ||
+            (mode == MODE_STREAM && !stream.open(kStreamName, err)) || (mode == MODE_PIPE && pipe(fds) != 0)) {
+            std::cerr << (err.empty() ? "pipe failed" : err) << std::endl;
+            return 1;
+        }
+
+        pid_t child = fork();
+        if (child == 0) {
+            if (fds[1] >= 0) close(fds[1]);
+            int rc = receive(mode, fds[0], count);
+            std::fflush(stdout);
+            std::_Exit(rc);
+        }
+        if (fds[0] >= 0) close(fds[0]);
+
+        // 等子进程打开话题
+        sleepUntilNs(monotonicNs() + 50000000LL);
+        ipc::ImuSample s = ipc::ImuSample();
+        int64_t next = monotonicNs();
+        for (uint32_t k = 0; k <= count; k++) {
+            next += period;
+            sleepUntilNs(next);
+            s.seq = k == count ? kDone : k;
+            s.gyro[2] = 0.001f * k;
+            s.tNs = monotonicNs();
+            if (mode == MODE_LATEST) {
+                latest.publish(s);
+            } else if (mode == MODE_STREAM) {
+                while (!stream.push(s) && s.seq == kDone) sleepUntilNs(monotonicNs() + 1000000LL);
+            } else if (write(fds[1], &s, sizeof(s)) != static_cast<ssize_t>(sizeof(s))) {
+                break;
+            }
+        }
+        if (fds[1] >= 0) close(fds[1]);
+        int status = 0;
+        waitpid(child, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) failures++;
+        std::fflush(stdout);
+    }
+    shm_unlink(kLatestName);
+    shm_unlink(kStreamName);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,209 @@
+// 本基准替换全局 operator new，统计各任务稳定运行后的堆分配
+#define RTMEM_COUNT_ALLOCATIONS
+#include "rt_memory.hpp"
+
+#include "guidance_runtime.hpp"
+#include "rt_clock.hpp"
+#include "runtime_config.hpp"
+#include "servo_controller.hpp"
+#include "sim_sources.hpp"
+#include "trace_zone.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// 传感器到舵机的端到端延迟基准：合成相机帧 + 仿真 IMU + 模拟舵机后端，跑与 guidance_runtime 相同的任务链路
+// 用法: bench_pipeline [--config guidance.conf] [--seconds 10] [--load 线程数] [--fps 帧率]
+//                      [--servo-hz 频率] [--delivery-us 帧交付延迟] [--rt] [--max-p99-us 阈值] [--max-miss-pct 百分比]
+//                      [--record 飞行记录.mwfl] [--trace trace.json]
+// 默认去掉实时优先级和绑核，普通用户也能运行；--rt 使用配置里的调度参数
+// --record 同时写飞行记录，比较开关记录时的延迟
+// --trace 在 -DMILKYWAY_TRACE=ON 编译时把各线程的追踪事件写成 Chrome trace JSON
+// 任一任务在预热之后仍有堆分配时返回非零；配置里 [memory] lock 打开时同样 mlockall
+// 指定 --max-p99-us 时，capture->servo p99 超过阈值或任一任务截止时间丢失率超过 --max-miss-pct（默认 1%）则返回非零
+
+namespace {
+
+struct Options {
+    const char* configPath = nullptr;
+    const char* recordPath = nullptr;
+    const char* tracePath = nullptr;
+    double seconds = 10.0;
+    int loadThreads = 0;
+    int fps = 0;
+    int servoHz = 0;
+    int deliveryUs = 0;
+    bool rt = false;
+    double maxP99Us = 0.0;
+    double maxMissPct = 1.0;
+};
+
+bool parseOptions(int argc, char** argv, Options& o) {
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (!std::strcmp(a, "--rt")) {
+            o.rt = true;
+        } else if (!std::strcmp(a, "--config") && hasValue) {
+            o.configPath = argv[++i];
+        } else if (!std::strcmp(a, "--record") && hasValue) {
+            o.recordPath = argv[++i];
+        } else if (!std::strcmp(a, "--trace") && hasValue) {
+            o.tracePath = argv[++i];
+        } else if (!std::strcmp(a, "--seconds") && hasValue) {
+            o.seconds = std::atof(argv[++i]);
+        } else if (!std::strcmp(a, "--load") && hasValue) {
+            o.loadThreads = std::atoi(argv[++i]);
+        } else if (!std::strcmp(a, "--fps") && hasValue) {
+            o.fps = std::atoi(argv[++i]);
+        } else if (!std::strcmp(a, "--servo-hz") && hasValue) {
+            o.servoHz = std::atoi(argv[++i]);
+        } else if (!std::strcmp(a, "--delivery-us") && hasValue) {
+            o.deliveryUs = std::atoi(argv[++i]);
+        } else if (!std::strcmp(a, "--max-p99-us") && hasValue) {
+            o.maxP99Us = std::atof(argv[++i]);
+        } else if (!std::strcmp(a, "--max-miss-pct") && hasValue) {
+            o.maxMissPct = std::atof(argv[++i]);
+        } else {
+            std::cerr << "未知参数: " << a << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// 背景负载：遍历超过缓存大小的缓冲区，同时占 CPU 和内存带宽
+void loadWorker(const std::atomic<bool>& stop) {
+    std::vector<uint32_t> buf(4 << 20);
+    uint32_t acc = 1;
+    while (!stop.load(std::memory_order_relaxed)) {
+        for (size_t i = 0; i < buf.size(); i += 16) {
+            acc = acc * 1664525u + 1013904223u;
+            buf[i] += acc;
+        }
+    }
+}
+
+void dropRealtime(RtTaskConfig& t) {
+    t.cpu = -1;
+    t.priority = 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parseOptions(argc, argv, opt)) return 2;
+
+    RuntimeConfig cfg;
+    std::string err;
+    if (opt.configPath && !loadRuntimeConfig(opt.configPath, cfg, err)) {
+        std::cerr << err << std::endl;
+        return 2;
+    }
+    if (opt.fps > 0) cfg.camera.fps = opt.fps;
+    if (opt.servoHz > 0) {
+        cfg.servoBank.frameHz = opt.servoHz;
+        cfg.servoTask.periodNs = 1000000000LL / opt.servoHz;
+    }
+    if (cfg.visionTask.deadlineNs <= 0 || opt.fps > 0) cfg.visionTask.deadlineNs = 1500000000LL / cfg.camera.fps;
+    cfg.ahrsEnabled = false;
+    if (!opt.rt) {
+        dropRealtime(cfg.visionTask);
+        dropRealtime(cfg.imuTask);
+        dropRealtime(cfg.ahrsTask);
+        dropRealtime(cfg.fusionTask);
+        dropRealtime(cfg.servoTask);
+    }
+
+    if (cfg.memoryLock && !rtmem::lockMemory(err)) std::cerr << err << std::endl;
+
+    // 留出启动时间，首帧曝光时刻落在任务启动之后
+    int64_t origin = monotonicNs() + 20000000LL;
+    sim::Scene scene;
+    sim::SyntheticFrameSource camera(cfg.camera, cfg.control.hfovDeg, scene, origin, true, opt.deliveryUs);
+    sim::SimImuSource imu(scene, origin);
+    if (!camera.open()) return 1;
+
+    servo::SimServoBackend backend;
+    servo::ServoBank bank(backend, cfg.servoBank);
+    GuidanceRuntime runtime(cfg, bank, &camera, &imu, nullptr);
+    if (!runtime.begin()) return 1;
+    flight::FlightRecorder recorder;
+    if (opt.recordPath) {
+        if (cfg.memoryLock) recorder.lockWindow(static_cast<size_t>(cfg.recorderLockWindowKb) << 10);
+        if (!recorder.open(opt.recordPath, 64 << 20, err)) {
+            std::cerr << err << std::endl;
+            return 2;
+        }
+        runtime.attachRecorder(recorder);
+        recorder.start();
+    }
+    // 配置里 [ipc] publish 打开时同样发布话题，可以另开进程订阅
+    if (cfg.ipcPublish && !runtime.openTopics(err)) {
+        std::cerr << err << std::endl;
+        return 2;
+    }
+
+    std::atomic<bool> stopLoad(false);
+    std::vector<std::thread> load;
+    for (int i = 0; i < opt.loadThreads; i++) load.emplace_back(loadWorker, std::cref(stopLoad));
+
+    runtime.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<int64_t>(opt.seconds * 1000)));
+    runtime.stop();
+    runtime.end();
+
+    stopLoad = true;
+    for (auto& t : load) t.join();
+
+    std::printf("fps %d servo %d Hz load %d %s, %.1f s\n", cfg.camera.fps, cfg.servoBank.frameHz,
+                opt.loadThreads, opt.rt ? "rt" : "non-rt", opt.seconds);
+    runtime.printStats();
+    if (recorder.isOpen()) {
+        recorder.close();
+        std::printf("flight log %s: %llu records, %llu bytes, dropped %llu, lost %llu\n", opt.recordPath,
+                    static_cast<unsigned long long>(recorder.recordCount()),
+                    static_cast<unsigned long long>(recorder.bytesWritten()),
+                    static_cast<unsigned long long>(recorder.droppedCount()),
+                    static_cast<unsigned long long>(recorder.lostCount()));
+    }
+    if (opt.tracePath) {
+        if (!trace::kEnabled) std::printf("trace: 未用 -DMILKYWAY_TRACE=ON 编译，没有事件\n");
+        std::printf("trace %s: %ld events\n", opt.tracePath, trace::dumpChromeJson(opt.tracePath));
+    }
+
+    std::printf("deadline miss rate, steady-state allocations:\n");
+    double worstMissPct = 0.0;
+    uint64_t allocs = 0;
+    for (auto& t : runtime.allTasks()) {
+        uint64_t c = t->cycles(), m = t->misses();
+        double pct = c ? 100.0 * m / c : 0.0;
+        worstMissPct = std::max(worstMissPct, pct);
+        allocs += t->steadyAllocations();
+        std::printf("  %-8s %8llu / %8llu  %.4f%%  %llu allocs\n", t->config().name.c_str(),
+                    static_cast<unsigned long long>(m), static_cast<unsigned long long>(c), pct,
+                    static_cast<unsigned long long>(t->steadyAllocations()));
+    }
+    if (allocs) {
+        std::printf("gate: %llu heap allocations after warm-up -> FAIL\n", static_cast<unsigned long long>(allocs));
+        return 1;
+    }
+
+    if (opt.maxP99Us > 0) {
+        const JitterStats& e2e = runtime.latency().captureToServo;
+        double p99 = e2e.percentileUs(99.0);
+        bool ok = e2e.samples() > 0 && p99 <= opt.maxP99Us && worstMissPct <= opt.maxMissPct;
+        std::printf("gate: capture->servo p99 %.1f us (limit %.1f), worst miss %.4f%% (limit %.4f%%) -> %s\n", p99,
+                    opt.maxP99Us, worstMissPct, opt.maxMissPct, ok ? "PASS" : "FAIL");
+        if (!ok) return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,277 @@
+#include "preintegration.hpp"
+#include "rt_clock.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+// IMU 预积分基准 (不需要硬件)：
+//   合成真值运动 = 慢速偏航 + 高频圆锥摆动 + 同频线加速度 (产生划桨效应)，按 IMU 速率采样角速度和比力，
+//   慢速消费者 (默认 50 Hz) 用四种方式得到姿态和速度增量，与真值比较：
+//     slow sample       每个消费周期只取最近一个样本乘以周期 (不做预积分)
+//     small-angle sum   全速率逐轴累加 yaw/pitch (原 IMU 任务的写法)
+//     preint no comp    全速率梯形积分的四元数，不加圆锥 / 划桨补偿
+//     preint            全速率积分 + 圆锥 / 划桨补偿
+//   另外比较消费者拿到的角速度：最后一个样本的瞬时值 与 区间增量 / 区间时长
+// 用法: bench_preint [--hz 2000] [--rate 50] [--seconds 60] [--cone-hz 20] [--cone-deg 1.2] [--accel 5]
+
+namespace {
+
+struct Options {
+    double hz = 2000.0;
+    double rate = 50.0;
+    double seconds = 60.0;
+    double coneHz = 20.0;
+    double coneDeg = 1.2;
+    double accel = 5.0;                  // m/s^2，振荡线加速度幅值
+};
+
+const double kG = 9.80665;
+
+struct Truth {
+    const Options& o;
+    double omega;                        // 圆锥角频率
+    double beta;                         // 圆锥半角
+
+    explicit Truth(const Options& opt)
+        : o(opt), omega(2.0 * M_PI * opt.coneHz), beta(opt.coneDeg * M_PI / 180.0) {}
+
+    // 机体系到导航系 (z 向上)
+    void attitude(double t, double* q) const {
+        double yaw = 0.3 * t + 0.2 * std::sin(2.0 * M_PI * 0.5 * t);
+        double qz[4] = {std::cos(0.5 * yaw), 0.0, 0.0, std::sin(0.5 * yaw)};
+        double cone[3] = {beta * std::cos(omega * t), beta * std::sin(omega * t), 0.1 * std::sin(2.0 * M_PI * 0.2 * t)};
+        double qc[4];
+        preint::detail::qexp(cone, qc);
+        preint::detail::qmul(qz, qc, q);
+    }
+
+    // 导航系加速度和速度 (速度从 0 时刻的 0 起算)
+    void motion(double t, double* a, double* v) const {
+        double w = omega;
+        a[0] = o.accel * std::sin(w * t + 0.3);
+        a[1] = o.accel * std::cos(w * t);
+        a[2] = 0.5 * o.accel * std::sin(2.0 * w * t);
+        v[0] = o.accel * (std::cos(0.3) - std::cos(w * t + 0.3)) / w;
+        v[1] = o.accel * std::sin(w * t) / w;
+        v[2] = 0.5 * o.accel * (1.0 - std::cos(2.0 * w * t)) / (2.0 * w);
+    }
+
+    // 机体角速度：数值微分 2 q^-1 dq/dt
+    void gyro(double t, float* out) const {
+        const double h = 1e-6;
+        double a[4], b[4], q[4];
+        attitude(t - h, a);
+        attitude(t + h, b);
+        attitude(t, q);
+        double dq[4], conj[4] = {q[0], -q[1], -q[2], -q[3]}, r[4];
+        for (int i = 0; i < 4; i++) dq[i] = (b[i] - a[i]) / (2.0 * h);
+        preint::detail::qmul(conj, dq, r);
+        for (int i = 0; i < 3; i++) out[i] = static_cast<float>(2.0 * r[i + 1]);
+    }
+
+    // 机体系比力 = R^T (a - g)
+    void specificForce(double t, float* out) const {
+        double q[4], a[3], v[3];
+        attitude(t, q);
+        motion(t, a, v);
+        a[2] += kG;
+        double conj[4] = {q[0], -q[1], -q[2], -q[3]}, f[3];
+        preint::detail::rotate(conj, a, f);
+        for (int i = 0; i < 3; i++) out[i] = static_cast<float>(f[i]);
+    }
+
+    // 相对 0 时刻机体系的姿态和累计比力速度增量，与 Preintegrator 的累计量同定义
+    void relative(double t, double* q, double* vel) const {
+        double q0[4], qt[4], a[3], v[3];
+        attitude(0.0, q0);
+        attitude(t, qt);
+        double conj[4] = {q0[0], -q0[1], -q0[2], -q0[3]};
+        preint::detail::qmul(conj, qt, q);
+        motion(t, a, v);
+        v[2] += kG * t;
+        preint::detail::rotate(conj, v, vel);
+    }
+};
+
+// est 相对真值的姿态误差角 (rad)
+double angleError(const double* est, const double* truth) {
+    double conj[4] = {est[0], -est[1], -est[2], -est[3]}, d[4], phi[3];
+    preint::detail::qmul(conj, truth, d);
+    preint::detail::qlog(d, phi);
+    return std::sqrt(phi[0] * phi[0] + phi[1] * phi[1] + phi[2] * phi[2]);
+}
+
+double vecError(const double* a, const double* b) {
+    double s = 0.0;
+    for (int i = 0; i < 3; i++) s += (a[i] - b[i]) * (a[i] - b[i]);
+    return std::sqrt(s);
+}
+
+void eulerOf(const double* q, float& yaw, float& pitch) {
+    preint::Snapshot s;
+    std::memcpy(s.q, q, sizeof(s.q));
+    preint::yawPitch(s, yaw, pitch);
+}
+
+struct Row {
+    const char* name;
+    bool hasQuat;
+    double q[4], v[3];
+    float yaw, pitch;
+};
+
+void printRow(const Row& r, const double* qTrue, const double* vTrue) {
+    float ty, tp;
+    eulerOf(qTrue, ty, tp);
+    double dy = std::fabs(std::remainder(static_cast<double>(r.yaw) - ty, 2.0 * M_PI)) * 180.0 / M_PI;
+    double dp = std::fabs(static_cast<double>(r.pitch) - tp) * 180.0 / M_PI;
+    if (r.hasQuat) {
+        std::printf("%-16s %12.5f %12.5f %12.5f %12.5f\n", r.name, angleError(r.q, qTrue) * 180.0 / M_PI, dy, dp,
+                    vecError(r.v, vTrue));
+    } else {
+        std::printf("%-16s %12s %12.5f %12.5f %12s\n", r.name, "-", dy, dp, "-");
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options o;
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--hz") && hasValue) {
+            o.hz = std::atof(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--rate") && hasValue) {
+            o.rate = std::atof(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--seconds") && hasValue) {
+            o.seconds = std::atof(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--cone-hz") && hasValue) {
+            o.coneHz = std::atof(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--cone-deg") && hasValue) {
+            o.coneDeg = std::atof(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--accel") && hasValue) {
+            o.accel = std::atof(argv[++i]);
+        } else {
+            std::cerr << "未知参数: " << argv[i] << std::endl;
+            return 2;
+        }
+    }
+    if (o.hz <= 0.0 || o.rate <= 0.0 || o.rate > o.hz || o.seconds <= 0.0 || o.coneHz <= 0.0) {
+        std::cerr << "--hz、--rate、--seconds、--cone-hz 须为正，且 --rate 不超过 --hz" << std::endl;
+        return 2;
+    }
+
+    Truth truth(o);
+    int n = static_cast<int>(o.seconds * o.hz) + 1;
+    int perTick = static_cast<int>(std::lround(o.hz / o.rate));
+    int64_t periodNs = static_cast<int64_t>(std::llround(1e9 / o.hz));
+    std::vector<int64_t> tNs(n);
+    std::vector<float> gyro(3 * n), accel(3 * n);
+    for (int k = 0; k < n; k++) {
+        tNs[k] = k * periodNs;
+        truth.gyro(tNs[k] * 1e-9, &gyro[3 * k]);
+        truth.specificForce(tNs[k] * 1e-9, &accel[3 * k]);
+    }
+
+    Row slow = {"slow sample", true, {1, 0, 0, 0}, {0, 0, 0}, 0, 0};
+    Row small = {"small-angle sum", false, {1, 0, 0, 0}, {0, 0, 0}, 0, 0};
+    Row plain = {"preint no comp", true, {1, 0, 0, 0}, {0, 0, 0}, 0, 0};
+    Row full = {"preint", true, {1, 0, 0, 0}, {0, 0, 0}, 0, 0};
+    preint::Preintegrator plainInt(20000000, false), fullInt;
+    preint::Reader plainReader(plainInt), fullReader(fullInt);
+    preint::Delta d;
+    plainReader.fetch(d);
+    fullReader.fetch(d);
+
+    // 消费者角速度误差：最后一个样本 vs 区间平均，对照真值区间的等效旋转矢量 / 时长
+    double instSq = 0.0, meanSq = 0.0;
+    int ticks = 0;
+    double qPrevTick[4] = {1, 0, 0, 0};
+    int64_t addNs = 0;
+    for (int k = 0; k < n; k++) {
+        const float(&g)[3] = *reinterpret_cast<const float(*)[3]>(&gyro[3 * k]);
+        const float(&f)[3] = *reinterpret_cast<const float(*)[3]>(&accel[3 * k]);
+        if (k) {
+            double dt = (tNs[k] - tNs[k - 1]) * 1e-9;
+            small.yaw += g[2] * static_cast<float>(dt);
+            small.pitch += g[1] * static_cast<float>(dt);
+        }
+        plainInt.add(tNs[k], g, f);
+        int64_t t0 = monotonicNs();
+        fullInt.add(tNs[k], g, f);
+        addNs += monotonicNs() - t0;
+        if (k == 0 || k % perTick) continue;
+
+        // 慢速抽样：最近一个样本乘以消费周期
+        double P = perTick * periodNs * 1e-9;
+        double phi[3] = {g[0] * P, g[1] * P, g[2] * P}, nu[3] = {f[0] * P, f[1] * P, f[2] * P};
+        double dq[4], q[4], dvRef[3];
+        preint::detail::rotate(slow.q, nu, dvRef);
+        preint::detail::qexp(phi, dq);
+        preint::detail::qmul(slow.q, dq, q);
+        std::memcpy(slow.q, q, sizeof(q));
+        for (int i = 0; i < 3; i++) slow.v[i] += dvRef[i];
+
+        plainReader.fetch(d);
+        if (fullReader.fetch(d)) {
+            double qTick[4], vTick[3], rel[4], truePhi[3];
+            truth.relative(tNs[k] * 1e-9, qTick, vTick);
+            double conj[4] = {qPrevTick[0], -qPrevTick[1], -qPrevTick[2], -qPrevTick[3]};
+            preint::detail::qmul(conj, qTick, rel);
+            preint::detail::qlog(rel, truePhi);
+            double sec = d.seconds();
+            for (int i = 0; i < 3; i++) {
+                double trueRate = truePhi[i] / sec;
+                instSq += (g[i] - trueRate) * (g[i] - trueRate);
+                meanSq += (d.dTheta[i] / sec - trueRate) * (d.dTheta[i] / sec - trueRate);
+            }
+            std::memcpy(qPrevTick, qTick, sizeof(qTick));
+            ticks++;
+        }
+    }
+    std::memcpy(plain.q, plainReader.latest().q, sizeof(plain.q));
+    std::memcpy(plain.v, plainReader.latest().v, sizeof(plain.v));
+    std::memcpy(full.q, fullReader.latest().q, sizeof(full.q));
+    std::memcpy(full.v, fullReader.latest().v, sizeof(full.v));
+    eulerOf(slow.q, slow.yaw, slow.pitch);
+    eulerOf(plain.q, plain.yaw, plain.pitch);
+    eulerOf(full.q, full.yaw, full.pitch);
+
+    double qTrue[4], vTrue[3];
+    truth.relative(tNs[n - 1] * 1e-9, qTrue, vTrue);
+    std::printf("%d samples @ %.0f Hz over %.1f s, consumer %.0f Hz, coning %.2f deg @ %.1f Hz, accel %.1f m/s^2\n", n,
+                o.hz, o.seconds, o.rate, o.coneDeg, o.coneHz, o.accel);
+    std::printf("%-16s %12s %12s %12s %12s\n", "method", "att err deg", "yaw err deg", "pitch err deg", "vel err m/s");
+    printRow(slow, qTrue, vTrue);
+    printRow(small, qTrue, vTrue);
+    printRow(plain, qTrue, vTrue);
+    printRow(full, qTrue, vTrue);
+
+    std::printf("\nconsumer rate error over %d ticks (rms rad/s): last sample %.5f, interval mean %.5f\n", ticks,
+                std::sqrt(instSq / (3.0 * ticks)), std::sqrt(meanSq / (3.0 * ticks)));
+
+    // 读者开销：写者每发布一次，读者取一次
+    const int reps = 200000;
+    preint::Preintegrator costInt;
+    preint::Reader costReader(costInt);
+    int64_t writeOnly = 0, writeRead = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        costInt.reset();
+        int64_t t0 = monotonicNs();
+        for (int r = 0; r < reps; r++) {
+            int k = r % n;
+            costInt.add(static_cast<int64_t>(r) * periodNs,
+                        *reinterpret_cast<const float(*)[3]>(&gyro[3 * k]),
+                        *reinterpret_cast<const float(*)[3]>(&accel[3 * k]));
+            if (pass) costReader.fetch(d);
+        }
+        (pass ? writeRead : writeOnly) = monotonicNs() - t0;
+    }
+    std::printf("add %.1f ns/sample, fetch %.1f ns\n", static_cast<double>(addNs) / n,
+                static_cast<double>(writeRead - writeOnly) / reps);
+    return 0;
+}
@@ -0,0 +1,206 @@
+#include "flight_recorder.hpp"
+#include "jitter_stats.hpp"
+#include "rt_clock.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// 飞行记录基准：IMU 2 kHz、检测 120 Hz、舵机 333 Hz 三个线程同时写，统计单次 push 耗时、
+// 周期唤醒抖动（与不记录时对比），写完后解码并逐条比对
+// 用法: bench_recorder [--seconds 5] [--imu-hz 2000] [--out /tmp/bench_flight.mwfl]
+
+namespace {
+
+struct Options {
+    double seconds = 5.0;
+    int imuHz = 2000;
+    const char* out = "/tmp/bench_flight.mwfl";
+};
+
+// 一个周期线程：到点生成一条记录，记下唤醒延迟和 push 耗时
+struct Stream {
+    const char* name;
+    int type;
+    int hz;
+    flight::FlightProducer* producer = nullptr;
+    std::vector<flight::Record> sent;
+    JitterStats wake;
+    int64_t pushNsSum = 0, pushNsMax = 0;
+    uint64_t pushes = 0, rejected = 0;
+};
+
+flight::Record synth(int type, uint32_t k, int64_t tNs) {
+    flight::Record r;
+    std::memset(&r, 0, sizeof(r));
+    r.tNs = tNs;
+    r.type = static_cast<uint8_t>(type);
+    double t = tNs * 1e-9;
+    switch (type) {
+    case flight::REC_IMU:
+        // 机体振动 + 噪声量级的原始计数
+        for (int i = 0; i < 3; i++) {
+            r.imu.gyro[i] = static_cast<int16_t>(300.0 * std::sin(2.0 * M_PI * (3.0 + i) * t) + (k * 7 + i * 13) % 9 - 4);
+            r.imu.accel[i] = static_cast<int16_t>((i == 2 ? 2732 : 0) + 80.0 * std::sin(2.0 * M_PI * 40.0 * t + i) +
+                                                  (k * 5 + i * 11) % 7 - 3);
+        }
+        r.imu.temp = static_cast<int16_t>(740 + k / 20000);
+        break;
+    case flight::REC_DETECTION:
+        r.detection.captureNs = tNs - 4000000;
+        r.detection.frameId = k;
+        r.detection.count = 1 + k % 3;
+        r.detection.cx[0] = static_cast<float>(160.0 + 40.0 * std::sin(t));
+        r.detection.cy[0] = static_cast<float>(120.0 + 30.0 * std::cos(t));
+        r.detection.area[0] = 29;
+        break;
+    case flight::REC_SERVO:
+        for (int i = 0; i < 4; i++) {
+            r.servo.angle[i] = static_cast<float>(0.3 * std::sin(t + i));
+            r.servo.pulseUs[i] = static_cast<uint16_t>(1500 + 500 * r.servo.angle[i]);
+        }
+        break;
+    }
+    return r;
+}
+
+void runStream(Stream& s, int64_t startNs, int64_t endNs) {
+    const int64_t period = 1000000000LL / s.hz;
+    int64_t next = startNs;
+    for (uint32_t k = 0;; k++) {
+        next += period;
+        if (next >= endNs) break;
+        sleepUntilNs(next);
+        int64_t woke = monotonicNs();
+        s.wake.add(woke - next);
+        if (!s.producer) continue;
+        flight::Record r = synth(s.type, k, woke);
+        int64_t t0 = monotonicNs();
+        bool ok = s.producer->push(r);
+        int64_t dt = monotonicNs() - t0;
+        s.pushNsSum += dt;
+        s.pushNsMax = std::max(s.pushNsMax, dt);
+        s.pushes++;
+        if (ok) s.sent.push_back(r);
+        else s.rejected++;
+    }
+}
+
+void runAll(std::vector<Stream>& streams, double seconds) {
+    int64_t start = monotonicNs() + 10000000LL;
+    int64_t end = start + static_cast<int64_t>(seconds * 1e9);
+    std::vector<std::thread> threads;
+    for (Stream& s : streams) threads.emplace_back(runStream, std::ref(s), start, end);
+    for (auto& t : threads) t.join();
+}
+
+bool sameRecord(const flight::Record& a, const flight::Record& b) {
+    if (a.tNs != b.tNs || a.type != b.type || a.channel != b.channel) return false;
+    switch (a.type) {
+    case flight::REC_IMU: return std::memcmp(&a.imu, &b.imu, sizeof(a.imu)) == 0;
+    case flight::REC_DETECTION: return std::memcmp(&a.detection, &b.detection, sizeof(a.detection)) == 0;
+    case flight::REC_SERVO: return std::memcmp(&a.servo, &b.servo, sizeof(a.servo)) == 0;
+    }
+    return false;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--seconds") && hasValue) {
+            opt.seconds = std::atof(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--imu-hz") && hasValue) {
+            opt.imuHz = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--out") && hasValue) {
+            opt.out = argv[++i];
+        } else {
+            std::cerr << "未知参数: " << argv[i] << std::endl;
+            return 2;
+        }
+    }
+
+    const struct {
+        const char* name;
+        int type, hz;
+    } specs[] = {{"imu", flight::REC_IMU, opt.imuHz}, {"vision", flight::REC_DETECTION, 120},
+                 {"servo", flight::REC_SERVO, 333}};
+
+    for (int recording = 0; recording < 2; recording++) {
+        std::vector<Stream> streams(3);
+        flight::FlightRecorder rec;
+        std::string err;
+        for (int i = 0; i < 3; i++) {
+            streams[i].name = specs[i].name;
+            streams[i].type = specs[i].type;
+            streams[i].hz = specs[i].hz;
+            streams[i].sent.reserve(static_cast<size_t>(opt.seconds * specs[i].hz) + 16);
+        }
+        if (recording) {
+            if (!rec.open(opt.out, 64 << 20, err)) {
+                std::cerr << err << std::endl;
+                return 1;
+            }
+            for (Stream& s : streams) s.producer = rec.producer(s.name);
+            rec.start();
+        }
+        runAll(streams, opt.seconds);
+
+        std::printf("%s:\n", recording ? "recording" : "not recording");
+        for (Stream& s : streams) {
+            std::printf("  %-7s %5d Hz wake p50 %5.0f p99 %5.0f max %7.1f us", s.name, s.hz, s.wake.percentileUs(50),
+                        s.wake.percentileUs(99), s.wake.maxUs());
+            if (s.pushes) {
+                std::printf(", push mean %4.0f ns max %6lld ns, rejected %llu", static_cast<double>(s.pushNsSum) / s.pushes,
+                            static_cast<long long>(s.pushNsMax), static_cast<unsigned long long>(s.rejected));
+            }
+            std::printf("\n");
+        }
+        if (!recording) continue;
+
+        rec.close();
+        uint64_t sent = 0;
+        for (Stream& s : streams) sent += s.sent.size();
+        std::printf("  %llu records, %llu bytes (%.1f B/record, fixed records %zu B), lost %llu\n",
+                    static_cast<unsigned long long>(rec.recordCount()),
+                    static_cast<unsigned long long>(rec.bytesWritten()),
+                    static_cast<double>(rec.bytesWritten()) / std::max<uint64_t>(1, rec.recordCount()),
+                    sizeof(flight::Record), static_cast<unsigned long long>(rec.lostCount()));
+
+        // 解码后按流比对：同一生产者的记录保持顺序
+        flight::FlightReader reader;
+        if (!reader.open(opt.out, err)) {
+            std::cerr << err << std::endl;
+            return 1;
+        }
+        size_t next[flight::REC_TYPE_COUNT] = {0};
+        uint64_t decoded = 0, mismatched = 0, imuBytes = 0;
+        flight::Record r;
+        size_t before = reader.offset();
+        while (reader.next(r)) {
+            decoded++;
+            if (r.type == flight::REC_IMU) imuBytes += reader.offset() - before;
+            before = reader.offset();
+            Stream* s = nullptr;
+            for (Stream& c : streams) {
+                if (c.type == r.type) s = &c;
+            }
+            if (!s || next[r.type] >= s->sent.size() || !sameRecord(s->sent[next[r.type]++], r)) mismatched++;
+        }
+        std::printf("  decoded %llu of %llu, mismatched %llu, imu %.1f B/sample -> %s\n",
+                    static_cast<unsigned long long>(decoded), static_cast<unsigned long long>(sent),
+                    static_cast<unsigned long long>(mismatched),
+                    static_cast<double>(imuBytes) / std::max<size_t>(1, streams[0].sent.size()),
+                    decoded == sent && mismatched == 0 && !reader.truncated() ? "PASS" : "FAIL");
+        if (decoded != sent || mismatched) return 1;
+    }
+    return 0;
+}
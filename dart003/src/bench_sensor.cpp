@@ -0,0 +1,184 @@
+#include "flight_recorder.hpp"
+#include "imu_replay.hpp"
+#include "imu_sensor.hpp"
+#include "rt_clock.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+// 传感器接口基准：把一段 IMU 记录当作传感器全速回放，同一个模板消费者分别经
+// 编译期分派 (ReplayImuSensor 直接调用) 和虚函数接口读取，比较每个样本的开销，结果必须完全一致
+// 用法: bench_sensor [--log 记录.mwfl] [--channel 0] [--samples 200000] [--passes 20]
+//   不给 --log 时先用仿真传感器生成 /tmp/bench_sensor.mwfl (经 sensor::logSample 写入)
+
+namespace {
+
+struct Options {
+    std::string log;
+    int channel = 0;
+    int samples = 200000;
+    int passes = 20;
+};
+
+// 仿真 2 kHz IMU：锥运动的角速度 + 重力，时间戳按名义周期递增
+class SimSensor : public sensor::ImuSensor<SimSensor> {
+public:
+    explicit SimSensor(int count) : left(count), tNs(0) {}
+
+    sensor::SensorStatus readImpl(sensor::ImuSample& s) {
+        if (left-- <= 0) return sensor::SENSOR_END;
+        tNs += 500000;
+        double t = tNs * 1e-9;
+        s.clear();
+        s.tNs = tNs;
+        s.flags = sensor::SAMPLE_GYRO | sensor::SAMPLE_ACCEL;
+        s.gyro[0] = static_cast<float>(0.3 * std::cos(2 * M_PI * 3 * t));
+        s.gyro[1] = static_cast<float>(0.3 * std::sin(2 * M_PI * 3 * t));
+        s.gyro[2] = static_cast<float>(0.05 + 0.02 * std::sin(2 * M_PI * 0.7 * t));
+        s.accel[0] = static_cast<float>(0.4 * std::sin(2 * M_PI * 1.3 * t));
+        s.accel[1] = 0.0f;
+        s.accel[2] = 9.80665f;
+        return sensor::SENSOR_OK;
+    }
+
+    const char* nameImpl() const { return "sim"; }
+
+private:
+    int left;
+    int64_t tNs;
+};
+
+// 与编译期接口对照的运行时接口
+class VirtualImu {
+public:
+    virtual ~VirtualImu() {}
+    virtual sensor::SensorStatus read(sensor::ImuSample& s) = 0;
+};
+
+template <class S>
+class VirtualAdapter : public VirtualImu {
+public:
+    explicit VirtualAdapter(S& s) : dev(s) {}
+    sensor::SensorStatus read(sensor::ImuSample& s) override { return dev.read(s); }
+
+private:
+    S& dev;
+};
+
+// 只写一次的消费者：小角度陀螺积分 + 比力均值
+struct Attitude {
+    double angle[3];
+    double accelSum[3];
+    uint64_t count;
+};
+
+template <class Src>
+Attitude integrate(Src& src) {
+    Attitude a;
+    std::memset(&a, 0, sizeof(a));
+    sensor::ImuSample s;
+    int64_t last = 0;
+    while (src.read(s) == sensor::SENSOR_OK) {
+        double dt = last ? (s.tNs - last) * 1e-9 : 0.0;
+        last = s.tNs;
+        for (int i = 0; i < 3; i++) {
+            a.angle[i] += s.gyro[i] * dt;
+            a.accelSum[i] += s.accel[i];
+        }
+        a.count++;
+    }
+    return a;
+}
+
+bool writeSimLog(const std::string& path, int samples, std::string& err) {
+    flight::FlightRecorder recorder;
+    if (!recorder.open(path, static_cast<size_t>(samples) * 24 + (1 << 20), err)) return false;
+    flight::FlightProducer* log = recorder.producer("sim imu");
+    recorder.start(1000000);
+    SimSensor sim(samples);
+    sensor::ImuSample s;
+    while (sim.read(s) == sensor::SENSOR_OK) {
+        // 队列满时等后台线程取走，基准不能丢样本
+        while (!sensor::logSample(*log, s)) sleepUntilNs(monotonicNs() + 1000000);
+    }
+    recorder.close();
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options o;
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--log") && hasValue) {
+            o.log = argv[++i];
+        } else if (!std::strcmp(argv[i], "--channel") && hasValue) {
+            o.channel = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--samples") && hasValue) {
+            o.samples = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--passes") && hasValue) {
+            o.passes = std::atoi(argv[++i]);
+        } else {
+            std::cerr << "未知参数: " << argv[i] << std::endl;
+            return 2;
+        }
+    }
+    if (o.samples <= 0 || o.passes <= 0) {
+        std::cerr << "--samples、--passes 须为正" << std::endl;
+        return 2;
+    }
+
+    std::string err;
+    if (o.log.empty()) {
+        o.log = "/tmp/bench_sensor.mwfl";
+        if (!writeSimLog(o.log, o.samples, err)) {
+            std::cerr << err << std::endl;
+            return 1;
+        }
+    }
+
+    sensor::ReplayImuSensor replay(o.log, o.channel);
+    if (!replay.open(err)) {
+        std::cerr << err << std::endl;
+        return 1;
+    }
+    VirtualAdapter<sensor::ReplayImuSensor> adapter(replay);
+    // 经 volatile 指针取用，编译器无法把虚调用还原成直接调用
+    VirtualImu* volatile virt = &adapter;
+
+    Attitude direct = Attitude(), dynamic = Attitude();
+    int64_t directNs = 0, dynamicNs = 0;
+    // 第 0 轮只预热；之后交替先后顺序，抵消缓存和频率爬升的影响
+    for (int p = 0; p <= o.passes; p++) {
+        for (int k = 0; k < 2; k++) {
+            bool isDirect = (p + k) % 2 == 0;
+            replay.rewind();
+            int64_t t0 = monotonicNs();
+            if (isDirect) {
+                direct = integrate(replay);
+            } else {
+                dynamic = integrate(*virt);
+            }
+            int64_t dt = p ? monotonicNs() - t0 : 0;
+            (isDirect ? directNs : dynamicNs) += dt;
+        }
+    }
+
+    bool same = direct.count == dynamic.count;
+    for (int i = 0; i < 3; i++) same = same && direct.angle[i] == dynamic.angle[i];
+    double n = static_cast<double>(direct.count) * o.passes;
+    std::printf("%s: %zu samples over %.1f s, channel %d\n", o.log.c_str(), replay.size(), replay.spanNs() * 1e-9,
+                o.channel);
+    std::printf("%-10s %10s %14s\n", "dispatch", "ns/sample", "Msamples/s");
+    std::printf("%-10s %10.2f %14.1f\n", "static", directNs / n, n / directNs * 1e3);
+    std::printf("%-10s %10.2f %14.1f\n", "virtual", dynamicNs / n, n / dynamicNs * 1e3);
+    std::printf("angle %.4f %.4f %.4f rad, mean accel %.3f %.3f %.3f m/s^2, results %s\n", direct.angle[0],
+                direct.angle[1], direct.angle[2], direct.accelSum[0] / direct.count, direct.accelSum[1] / direct.count,
+                direct.accelSum[2] / direct.count, same ? "identical" : "DIFFER");
+    return same ? 0 : 1;
+}
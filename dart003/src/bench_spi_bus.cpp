@@ -0,0 +1,220 @@
+#include "bmi088.h"
+#include "bmi088_bus.h"
+#include "bmi088_sampler.h"
+#include "bmi088_sim.h"
+#include "jitter_stats.hpp"
+#include "pose_estimation.hpp"
+#include "rt_clock.hpp"
+#include "spi_bus.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// SPI 总线调度基准（仿真后端，不需要硬件）：
+//   IMU 线程按周期读若干片 BMI088 (10 MHz)，AHRS 线程轮询 BNO080 (1 MHz，模式 3，长包体)，共用一条总线
+//   依次比较三种策略：fifo（同优先级）、priority（IMU 优先）、reserve（IMU 优先并预约下一次突发）
+//   输出 IMU 突发完成时刻相对周期起点的延迟、截止时间丢失、BNO080 轮询次数，以及总线调度器的统计
+// 用法: bench_spi_bus [--seconds 2] [--imus 2] [--imu-hz 1000] [--deadline-us 250]
+//                     [--bno-payload 64] [--bno-hz 400] [--guard-us 50]
+
+namespace {
+
+struct Options {
+    double seconds = 2.0;
+    int imus = 2;
+    int imuHz = 1000;
+    int deadlineUs = 250;
+    int bnoPayload = 64;
+    int bnoHz = 400;
+    int guardUs = 50;
+};
+
+enum Policy { POLICY_FIFO, POLICY_PRIORITY, POLICY_RESERVE };
+const char* kPolicyNames[] = {"fifo", "priority", "reserve"};
+
+// BNO080 仿真：读头时给出一个旋转向量包的长度，读包体时给出基准时间戳 + 旋转向量（长度补足 payload）
+class SimBno080 {
+public:
+    explicit SimBno080(int payload) : payload(std::max(payload, 19)), seq(0), headerNext(true) {}
+
+    void respond(const uint8_t* tx, uint8_t* rx, uint32_t len) {
+        if (!rx || (tx && tx[0] != 0)) return;   // 主机发来的包（开启报告）不应答
+        if (headerNext && len == 4) {
+            uint16_t total = static_cast<uint16_t>(payload + 4);
+            rx[0] = total & 0xFF;
+            rx[1] = total >> 8;
+            rx[2] = SHTP_CHANNEL_REPORTS;
+            rx[3] = seq++;
+            headerNext = false;
+            return;
+        }
+        headerNext = true;
+        if (len < 19) return;
+        rx[0] = SH2_BASE_TIMESTAMP;
+        uint8_t* r = rx + 5;
+        r[0] = SH2_REPORT_ROTATION_VECTOR;
+        r[11] = 0x40;   // real = 1.0 (Q14)
+    }
+
+private:
+    int payload;
+    uint8_t seq;
+    bool headerNext;
+};
+
+struct Result {
+    JitterStats imuDone;   // 周期起点到突发完成
+    uint64_t imuMisses = 0;
+    uint64_t bnoPolls = 0;
+    uint64_t modeChanges = 0;
+};
+
+Result run(Policy policy, const Options& o) {
+    Result res;
+    spibus::SimBackend backend;
+    SimBmi088Bus model;
+    SimBno080 bno(o.bnoPayload);
+
+    spibus::SpiBus bus(backend);
+    std::string err;
+    std::vector<std::pair<int, int>> cs;
+    for (int i = 0; i < o.imus; i++) {
+        float bias[3] = {0, 0, 0};
+        int gyroCs = 10 + 2 * i, accelCs = 11 + 2 * i;
+        model.addDevice(gyroCs, accelCs, bias);
+        char name[32];
+        std::snprintf(name, sizeof(name), "imu%d gyro", i);
+        backend.setResponder(name, [&model, gyroCs](const uint8_t* tx, uint8_t* rx, uint32_t len, int64_t mid) {
+            model.respond(gyroCs, tx, rx, len, mid);
+        });
+        spibus::DeviceConfig g;
+        g.name = name;
+        g.speedHz = 10000000;
+        std::snprintf(name, sizeof(name), "imu%d accel", i);
+        backend.setResponder(name, [&model, accelCs](const uint8_t* tx, uint8_t* rx, uint32_t len, int64_t mid) {
+            model.respond(accelCs, tx, rx, len, mid);
+        });
+        spibus::DeviceConfig a = g;
+        a.name = name;
+        cs.push_back(std::make_pair(bus.addDevice(g, err), bus.addDevice(a, err)));
+    }
+    backend.setResponder("bno080", [&bno](const uint8_t* tx, uint8_t* rx, uint32_t len, int64_t) {
+        bno.respond(tx, rx, len);
+    });
+    spibus::DeviceConfig b;
+    b.name = "bno080";
+    b.speedHz = 1000000;
+    b.mode = SPI_MODE_3;
+    int bnoDevice = bus.addDevice(b, err);
+
+    bool prio = policy != POLICY_FIFO;
+    int imuClient = bus.addClient("imu", prio ? 10 : 0);
+    int ahrsClient = bus.addClient("ahrs", prio ? 1 : 0);
+
+    ScheduledBmi088Bus imuBus(bus, imuClient, false);
+    std::vector<std::unique_ptr<BMI088>> units;
+    std::vector<BMI088*> devs;
+    for (int i = 0; i < o.imus; i++) {
+        imuBus.mapCs(10 + 2 * i, cs[i].first);
+        imuBus.mapCs(11 + 2 * i, cs[i].second);
+        units.emplace_back(new BMI088(imuBus, 10 + 2 * i, 11 + 2 * i));
+        devs.push_back(units.back().get());
+    }
+    BNO080_SPI ahrs(bus, bnoDevice, ahrsClient);
+    ahrs.openDevice();
+    ahrs.enableReport(SH2_REPORT_ROTATION_VECTOR, 1000000 / o.bnoHz);
+    bus.resetStats();
+
+    std::atomic<bool> stop(false);
+    int64_t period = 1000000000LL / o.imuHz;
+    int64_t begin = monotonicNs() + 10000000;
+    int64_t end = begin + static_cast<int64_t>(o.seconds * 1e9);
+
+    std::thread ahrsThread([&] {
+        int64_t next = begin;
+        int64_t bnoPeriod = 1000000000LL / o.bnoHz;
+        while (!stop) {
+            sleepUntilNs(next);
+            next += bnoPeriod;
+            Quaternion q;
+            if (ahrs.pollRotationVector(q)) res.bnoPolls++;
+        }
+    });
+
+    Bmi088Sampler sampler(devs);
+    MultiImuSample s;
+    int64_t estimate = 0;
+    for (int64_t next = begin; next < end; next += period) {
+        if (policy == POLICY_RESERVE) {
+            int64_t guard = o.guardUs * 1000LL;
+            bus.reserve(imuClient, next - guard, guard + estimate + estimate / 2);
+        }
+        sleepUntilNs(next);
+        int64_t deadline = next + o.deadlineUs * 1000LL;
+        sampler.sample(s, deadline);
+        int64_t done = monotonicNs();
+        res.imuDone.add(done - next);
+        if (done > deadline) res.imuMisses++;
+        estimate = std::max(estimate, s.burstNs);
+    }
+    stop = true;
+    ahrsThread.join();
+
+    res.modeChanges = backend.modeChanges();
+    std::printf("--- %s\n", kPolicyNames[policy]);
+    bus.printStats();
+    return res;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options o;
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--seconds") && hasValue) {
+            o.seconds = std::atof(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--imus") && hasValue) {
+            o.imus = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--imu-hz") && hasValue) {
+            o.imuHz = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--deadline-us") && hasValue) {
+            o.deadlineUs = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--bno-payload") && hasValue) {
+            o.bnoPayload = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--bno-hz") && hasValue) {
+            o.bnoHz = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--guard-us") && hasValue) {
+            o.guardUs = std::atoi(argv[++i]);
+        } else {
+            std::cerr << "未知参数: " << argv[i] << std::endl;
+            return 2;
+        }
+    }
+    if (o.imus < 1 || o.imus > kMaxImus || o.imuHz <= 0 || o.bnoHz <= 0) {
+        std::cerr << "--imus 为 1 ~ " << kMaxImus << "，频率为正" << std::endl;
+        return 2;
+    }
+
+    Result r[3];
+    for (int p = POLICY_FIFO; p <= POLICY_RESERVE; p++) r[p] = run(static_cast<Policy>(p), o);
+
+    std::printf("\n%d x BMI088 @ %d Hz (deadline %d us) + BNO080 %d B @ %d Hz\n", o.imus, o.imuHz, o.deadlineUs,
+                o.bnoPayload, o.bnoHz);
+    std::printf("%-9s %28s %12s %10s %12s\n", "policy", "imu done p50/p99/max us", "imu misses", "bno polls",
+                "mode changes");
+    for (int p = POLICY_FIFO; p <= POLICY_RESERVE; p++) {
+        std::printf("%-9s %8.0f / %6.0f / %8.1f %12llu %10llu %12llu\n", kPolicyNames[p], r[p].imuDone.percentileUs(50),
+                    r[p].imuDone.percentileUs(99), r[p].imuDone.maxUs(), static_cast<unsigned long long>(r[p].imuMisses),
+                    static_cast<unsigned long long>(r[p].bnoPolls), static_cast<unsigned long long>(r[p].modeChanges));
+    }
+    return 0;
+}
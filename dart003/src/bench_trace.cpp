@@ -0,0 +1,94 @@
+#include "rt_clock.hpp"
+#include "rt_task.hpp"
+#include "trace_zone.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+// 追踪点开销基准（本目标总是定义 MILKYWAY_TRACE）：
+//   单次读时钟、空作用域 TRACE_ZONE、TRACE_SPAN 的平均耗时；
+//   再用几个周期任务跑一会儿嵌套的追踪点，写出 trace 检查事件数
+// 用法: bench_trace [--out /tmp/bench_trace.json] [--seconds 1]
+
+namespace {
+
+volatile uint32_t sink;
+
+// 模拟一次 SPI 读：几百纳秒的忙等
+void fakeTransfer() {
+    TRACE_ZONE("spi");
+    int64_t until = monotonicNs() + 300;
+    while (monotonicNs() < until) sink = sink + 1;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const char* out = "/tmp/bench_trace.json";
+    double seconds = 1.0;
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--out") && hasValue) {
+            out = argv[++i];
+        } else if (!std::strcmp(argv[i], "--seconds") && hasValue) {
+            seconds = std::atof(argv[++i]);
+        } else {
+            std::cerr << "未知参数: " << argv[i] << std::endl;
+            return 2;
+        }
+    }
+
+    const int n = 1000000;
+    int64_t acc = 0;
+    int64_t t0 = monotonicNs();
+    for (int i = 0; i < n; i++) acc += monotonicNs();
+    int64_t t1 = monotonicNs();
+    for (int i = 0; i < n; i++) {
+        TRACE_ZONE("empty");
+        sink = i;
+    }
+    int64_t t2 = monotonicNs();
+    for (int i = 0; i < n; i++) TRACE_SPAN("span", i, i + 1);
+    int64_t t3 = monotonicNs();
+    std::printf("clock read %.1f ns, TRACE_ZONE %.1f ns, TRACE_SPAN %.1f ns (%lld)\n",
+                static_cast<double>(t1 - t0) / n, static_cast<double>(t2 - t1) / n, static_cast<double>(t3 - t2) / n,
+                static_cast<long long>(acc % 10));
+
+    // 周期任务：RtTask 自己记每个周期和唤醒延迟，周期体里再嵌套 SPI 追踪点
+    std::vector<std::unique_ptr<RtTask>> tasks;
+    const struct {
+        const char* name;
+        int64_t periodNs;
+        int transfers;
+    } specs[] = {{"imu", 1000000, 3}, {"fusion", 2000000, 0}, {"servo", 3000000, 1}};
+    for (auto& s : specs) {
+        RtTaskConfig c;
+        c.name = s.name;
+        c.periodNs = s.periodNs;
+        int transfers = s.transfers;
+        tasks.emplace_back(new RtTask(c, [transfers](int64_t) {
+            TRACE_ZONE("body");
+            for (int k = 0; k < transfers; k++) fakeTransfer();
+        }));
+    }
+    for (auto& t : tasks) t->start();
+    sleepUntilNs(monotonicNs() + static_cast<int64_t>(seconds * 1e9));
+    for (auto& t : tasks) t->stop();
+    for (auto& t : tasks) t->join();
+
+    long expected = 0;
+    for (size_t i = 0; i < tasks.size(); i++) {
+        // 每周期：周期跨度 + 唤醒延迟 + body + transfers 次 spi，超过缓冲区的被覆盖
+        long perThread = static_cast<long>(tasks[i]->cycles()) * (3 + specs[i].transfers);
+        expected += std::min<long>(perThread, trace::kEventsPerThread);
+    }
+    expected += std::min<long>(3L * n, trace::kEventsPerThread); // 主线程
+    long written = trace::dumpChromeJson(out);
+    std::printf("%s: %ld events (expected %ld) -> %s\n", out, written, expected, written == expected ? "PASS" : "FAIL");
+    return written == expected ? 0 : 1;
+}
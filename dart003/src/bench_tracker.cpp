@@ -0,0 +1,121 @@
+#include "target_tracker.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+// 跟踪器离线基准：ns/update、ns/predict，以及延迟补偿前后的执行时刻误差
+
+namespace {
+
+const int64_t kFramePeriodNs = 1000000000LL / 120;   // 相机 120 fps
+const int64_t kServoPeriodNs = 20000000LL;           // 舵机 50 Hz
+const int64_t kActuationLatencyNs = 20000000LL;      // 指令到舵面响应
+
+float truthAz(double t) { return 0.20f * std::sin(2.0 * M_PI * 0.7 * t) + 0.05f * t; }
+float truthEl(double t) { return 0.10f * std::cos(2.0 * M_PI * 1.1 * t); }
+
+struct Arrival {
+    int64_t arriveNs;
+    tracker::BearingMeasurement m;
+};
+
+template <int N>
+void runAccuracy(const char* name, const std::vector<Arrival>& arrivals, int64_t endNs) {
+    tracker::TrackerConfig cfg;
+    cfg.actuationLatencyNs = kActuationLatencyNs;
+    tracker::TargetTracker<N> trk(cfg);
+
+    double sumRaw = 0.0, sumPred = 0.0;
+    int samples = 0;
+    size_t next = 0;
+    const tracker::BearingMeasurement* lastRaw = nullptr;
+
+    for (int64_t now = kServoPeriodNs; now < endNs; now += kServoPeriodNs) {
+        while (next < arrivals.size() && arrivals[next].arriveNs <= now) {
+            trk.update(arrivals[next].m);
+            lastRaw = &arrivals[next].m;
+            next++;
+        }
+        if (!lastRaw) continue;
+
+        double tAct = (now + kActuationLatencyNs) * 1e-9;
+        tracker::TargetState s = trk.predictForActuation(now);
+        double ea = lastRaw->az - truthAz(tAct), ee = lastRaw->el - truthEl(tAct);
+        sumRaw += ea * ea + ee * ee;
+        ea = s.az - truthAz(tAct);
+        ee = s.el - truthEl(tAct);
+        sumPred += ea * ea + ee * ee;
+        samples++;
+    }
+
+    const tracker::TrackerStats& st = trk.statistics();
+    std::printf("[%s] 执行时刻 RMS 误差: 直接使用测量 %.3f mrad, 预测补偿 %.3f mrad "
+                "(更新 %u, 乱序丢弃 %u, 门限丢弃 %u)\n",
+                name, 1e3 * std::sqrt(sumRaw / samples), 1e3 * std::sqrt(sumPred / samples),
+                st.updates, st.staleRejected, st.gateRejected);
+}
+
+template <int N>
+void runTiming(const char* name, const std::vector<Arrival>& arrivals, int rounds) {
+    tracker::TargetTracker<N> trk;
+    volatile float sink = 0.0f;
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+        trk.reset();
+        for (const Arrival& a : arrivals) trk.update(a.m);
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    int64_t lastNs = arrivals.back().m.captureNs;
+    for (int r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < arrivals.size(); i++) {
+            sink = sink + trk.predict(lastNs + static_cast<int64_t>(i) * 1000).az;
+        }
+    }
+    auto t2 = std::chrono::steady_clock::now();
+
+    double n = static_cast<double>(rounds) * arrivals.size();
+    double upd = std::chrono::duration<double, std::nano>(t1 - t0).count() / n;
+    double pre = std::chrono::duration<double, std::nano>(t2 - t1).count() / n;
+    std::printf("[%s] %.1f ns/update, %.1f ns/predict\n", name, upd, pre);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? std::atof(argv[1]) : 60.0;
+    int rounds = argc > 2 ? std::atoi(argv[2]) : 20;
+
+    std::mt19937 rng(42);
+    std::normal_distribution<float> noise(0.0f, 0.002f);
+    std::uniform_int_distribution<int64_t> latency(8000000LL, 15000000LL);
+
+    // 曝光时刻均匀，到达时刻带有 8~15 ms 的处理延迟
+    std::vector<Arrival> arrivals;
+    int64_t endNs = static_cast<int64_t>(seconds * 1e9);
+    for (int64_t t = 0; t < endNs; t += kFramePeriodNs) {
+        Arrival a;
+        a.m.captureNs = t;
+        a.m.az = truthAz(t * 1e-9) + noise(rng);
+        a.m.el = truthEl(t * 1e-9) + noise(rng);
+        a.m.sigma = 0.0f;
+        a.arriveNs = t + latency(rng);
+        arrivals.push_back(a);
+    }
+    // 处理延迟抖动可能导致乱序，按到达时间排序
+    for (size_t i = 1; i < arrivals.size(); i++) {
+        for (size_t j = i; j > 0 && arrivals[j].arriveNs < arrivals[j - 1].arriveNs; j--) {
+            std::swap(arrivals[j], arrivals[j - 1]);
+        }
+    }
+
+    runAccuracy<2>("CV", arrivals, endNs);
+    runAccuracy<3>("CA", arrivals, endNs);
+    runTiming<2>("CV", arrivals, rounds);
+    runTiming<3>("CA", arrivals, rounds);
+    return 0;
+}
@@ -0,0 +1,59 @@
+#include "pose_estimation.hpp"
+
+#include <iostream>
+#include <cstdio>
+#include <thread>
+#include <chrono>
+
+// 示例程序：解析SHTP数据包，打印内容
+int main() {
+    BNO080_SPI bno;
+    if (!bno.openDevice()) {
+        std::cerr << "Failed to open SPI device\n";
+        return -1;
+    }
+
+    // SHTP 包可能比这长，只打印前面一段
+    uint8_t payload[512];
+
+    while (true) {
+        uint16_t length = 0;
+        uint8_t channel = 0;
+        uint8_t seq = 0;
+
+        // 读包头
+        if (!bno.readHeader(length, channel, seq)) {
+            std::cerr << "Failed to read header\n";
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            continue;
+        }
+
+        if (length == 0) {
+            // 没有数据，短暂等待
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            continue;
+        }
+
+        // 包长度包含头4字节，减去头部得到数据长度
+        uint16_t payload_len = length - 4;
+        if (payload_len > sizeof(payload)) payload_len = sizeof(payload);
+
+        if (!bno.readPayload(payload, payload_len)) {
+            std::cerr << "Failed to read payload\n";
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            continue;
+        }
+
+        // 简单打印包信息
+        std::cout << "Packet from channel " << (int)channel << " seq " << (int)seq << " length " << length << " payload:";
+        for (uint16_t i = 0; i < payload_len; i++) {
+            printf(" %02X", payload[i]);
+        }
+        std::cout << std::endl;
+
+        // 适当延时，避免一直满循环
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+
+    return 0;
+}
@@ -0,0 +1,132 @@
+#include "camera_model.hpp"
+#include "ini_file.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace vision {
+
+CameraModel CameraModel::pinhole(int width, int height, double hfovDeg) {
+    CameraModel m;
+    m.width = width;
+    m.height = height;
+    m.cx = (width - 1) * 0.5;
+    m.cy = (height - 1) * 0.5;
+    m.fx = m.fy = (width * 0.5) / std::tan(hfovDeg * M_PI / 360.0);
+    return m;
+}
+
+bool CameraModel::load(const std::string& path, std::string& err) {
+    IniFile ini;
+    if (!ini.load(path, &err)) return false;
+    CameraModel m;
+    m.width = ini.getInt("calibration", "width", 0);
+    m.height = ini.getInt("calibration", "height", 0);
+    m.fx = ini.getDouble("calibration", "fx", 0.0);
+    m.fy = ini.getDouble("calibration", "fy", 0.0);
+    m.cx = ini.getDouble("calibration", "cx", 0.0);
+    m.cy = ini.getDouble("calibration", "cy", 0.0);
+    m.k1 = ini.getDouble("calibration", "k1", 0.0);
+    m.k2 = ini.getDouble("calibration", "k2", 0.0);
+    m.k3 = ini.getDouble("calibration", "k3", 0.0);
+    m.p1 = ini.getDouble("calibration", "p1", 0.0);
+    m.p2 = ini.getDouble("calibration", "p2", 0.0);
+    if (m.width <= 0 || m.height <= 0 || m.fx <= 0.0 || m.fy <= 0.0) {
+        err = path + ": 标定文件需要 width、height 和正的 fx、fy";
+        return false;
+    }
+    *this = m;
+    return true;
+}
+
+// 像素 i 覆盖 [i - 0.5, i + 0.5)，按传感器区域等比缩放
+CameraModel CameraModel::scaled(int w, int h) const {
+    CameraModel m = *this;
+    double sx = static_cast<double>(w) / width, sy = static_cast<double>(h) / height;
+    m.width = w;
+    m.height = h;
+    m.fx = fx * sx;
+    m.fy = fy * sy;
+    m.cx = (cx + 0.5) * sx - 0.5;
+    m.cy = (cy + 0.5) * sy - 0.5;
+    return m;
+}
+
+bool CameraModel::sameAspect(int w, int h, double tolerance) const {
+    double a = static_cast<double>(width) / height, b = static_cast<double>(w) / h;
+    return std::fabs(a / b - 1.0) <= tolerance;
+}
+
+void CameraModel::project(double x, double y, double& u, double& v) const {
+    double r2 = x * x + y * y;
+    double radial = 1.0 + r2 * (k1 + r2 * (k2 + r2 * k3));
+    double xd = x * radial + 2.0 * p1 * x * y + p2 * (r2 + 2.0 * x * x);
+    double yd = y * radial + p1 * (r2 + 2.0 * y * y) + 2.0 * p2 * x * y;
+    u = fx * xd + cx;
+    v = fy * yd + cy;
+}
+
+// 与 cv::undistortPoints 相同的不动点迭代，常见镜头几次迭代即收敛
+void CameraModel::undistort(double u, double v, double& x, double& y, int iterations) const {
+    double xd = (u - cx) / fx, yd = (v - cy) / fy;
+    x = xd;
+    y = yd;
+    for (int i = 0; i < iterations; i++) {
+        double r2 = x * x + y * y;
+        double radial = 1.0 + r2 * (k1 + r2 * (k2 + r2 * k3));
+        double dx = 2.0 * p1 * x * y + p2 * (r2 + 2.0 * x * x);
+        double dy = p1 * (r2 + 2.0 * y * y) + 2.0 * p2 * x * y;
+        x = (xd - dx) / radial;
+        y = (yd - dy) / radial;
+    }
+}
+
+// 格点 i 在像素 i * step，最后一列/行越过图像边缘，保证边缘像素也能插值
+BearingLut::BearingLut(const CameraModel& model, int step)
+    : cam(model), step(std::max(1, step)), cols((model.width - 1) / this->step + 2),
+      rows((model.height - 1) / this->step + 2), maxX(static_cast<float>(model.width - 1)),
+      maxY(static_cast<float>(model.height - 1)), table(static_cast<size_t>(cols) * rows * 2) {
+    for (int j = 0; j < rows; j++) {
+        for (int i = 0; i < cols; i++) {
+            double x, y;
+            cam.undistort(static_cast<double>(i) * this->step, static_cast<double>(j) * this->step, x, y);
+            float* p = &table[(static_cast<size_t>(j) * cols + i) * 2];
+            p[0] = static_cast<float>(x);
+            p[1] = static_cast<float>(y);
+        }
+    }
+}
+
+void BearingLut::normalized(float px, float py, float& x, float& y) const {
+    px = std::min(std::max(px, 0.0f), maxX) / step;
+    py = std::min(std::max(py, 0.0f), maxY) / step;
+    int i = std::min(static_cast<int>(px), cols - 2);
+    int j = std::min(static_cast<int>(py), rows - 2);
+    float ax = px - i, ay = py - j;
+    const float* p00 = &table[(static_cast<size_t>(j) * cols + i) * 2];
+    const float* p10 = p00 + 2;
+    const float* p01 = p00 + static_cast<size_t>(cols) * 2;
+    const float* p11 = p01 + 2;
+    float top0 = p00[0] + ax * (p10[0] - p00[0]), bottom0 = p01[0] + ax * (p11[0] - p01[0]);
+    float top1 = p00[1] + ax * (p10[1] - p00[1]), bottom1 = p01[1] + ax * (p11[1] - p01[1]);
+    x = top0 + ay * (bottom0 - top0);
+    y = top1 + ay * (bottom1 - top1);
+}
+
+void BearingLut::bearing(float px, float py, float (&dir)[3]) const {
+    float x, y;
+    normalized(px, py, x, y);
+    float n = 1.0f / std::sqrt(x * x + y * y + 1.0f);
+    dir[0] = x * n;
+    dir[1] = y * n;
+    dir[2] = n;
+}
+
+void BearingLut::angles(float px, float py, float& az, float& el) const {
+    float x, y;
+    normalized(px, py, x, y);
+    az = std::atan(x);
+    el = -std::atan(y);
+}
+
+} // namespace vision
@@ -0,0 +1,279 @@
+#include "color_classifier.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace vision {
+
+namespace {
+
+// 表达式的递归下降解析：
+//   expr  := group ('||' group)*
+//   group := term ('&&' term)*
+//   term  := linear ('>' | '>=' | '<' | '<=') integer
+//   linear:= ['-'] mono (('+' | '-') mono)*      mono := [integer ['*']] ('b' | 'g' | 'r')
+class Parser {
+public:
+    explicit Parser(const std::string& s) : s(s), pos(0) {}
+
+    bool eof() {
+        skip();
+        return pos >= s.size();
+    }
+
+    bool accept(const char* tok) {
+        skip();
+        size_t n = std::strlen(tok);
+        if (s.compare(pos, n, tok) != 0) return false;
+        pos += n;
+        return true;
+    }
+
+    bool integer(long& out) {
+        skip();
+        size_t start = pos;
+        while (pos < s.size() && std::isdigit(static_cast<unsigned char>(s[pos]))) pos++;
+        if (pos == start || pos - start > 6) return false;
+        out = std::strtol(s.c_str() + start, nullptr, 10);
+        return true;
+    }
+
+    int channel() {
+        skip();
+        if (pos >= s.size()) return -1;
+        const char* names = "bgr";
+        const char* c = std::strchr(names, s[pos]);
+        if (!c || !*c) return -1;
+        pos++;
+        return static_cast<int>(c - names);
+    }
+
+    std::string where() const { return "第 " + std::to_string(pos + 1) + " 个字符"; }
+
+private:
+    const std::string& s;
+    size_t pos;
+
+    void skip() {
+        while (pos < s.size() && std::isspace(static_cast<unsigned char>(s[pos]))) pos++;
+    }
+};
+
+} // namespace
+
+ColorClassifier::ColorClassifier() {
+    *this = green(200, 100, 100);
+}
+
+ColorClassifier::ColorClassifier(Empty) {
+    std::memset(this, 0, sizeof(*this));
+}
+
+ColorClassifier ColorClassifier::green(int threshold, int rDiff, int bDiff) {
+    ColorClassifier c{Empty()};
+    static const int16_t terms[3][3] = {{0, 1, 0}, {0, 1, -1}, {-1, 1, 0}};
+    const int bounds[3] = {threshold, rDiff, bDiff};
+    for (int i = 0; i < 3; i++) {
+        std::copy(terms[i], terms[i] + 3, c.coef[i]);
+        c.bound[i] = bounds[i];
+    }
+    c.groupEnd[0] = 3;
+    c.groupCount = 1;
+    c.build();
+    return c;
+}
+
+bool ColorClassifier::compile(const std::string& expr, std::string& err) {
+    ColorClassifier c{Empty()};
+    Parser p(expr);
+    int n = 0;
+
+    for (;;) {
+        // 一组
+        for (;;) {
+            if (n == kMaxTerms) {
+                err = "颜色判据最多 " + std::to_string(kMaxTerms) + " 条不等式";
+                return false;
+            }
+            int16_t* a = c.coef[n];
+            bool first = true, any = false;
+            for (;;) {
+                int sign = 1;
+                if (p.accept("-")) sign = -1;
+                else if (!first && !p.accept("+")) break;
+                long k = 1;
+                bool hasK = p.integer(k);
+                if (hasK) p.accept("*");
+                int ch = p.channel();
+                if (ch < 0) {
+                    err = "颜色判据" + p.where() + "应为通道 b/g/r";
+                    return false;
+                }
+                long v = a[ch] + sign * k;
+                if (v < -255 || v > 255) {
+                    err = "颜色判据系数超出 [-255, 255]";
+                    return false;
+                }
+                a[ch] = static_cast<int16_t>(v);
+                first = false;
+                any = true;
+            }
+            if (!any) {
+                err = "颜色判据" + p.where() + "缺少不等式";
+                return false;
+            }
+
+            // 统一成 > bound
+            int op;
+            if (p.accept(">=")) op = 0;
+            else if (p.accept(">")) op = 1;
+            else if (p.accept("<=")) op = 2;
+            else if (p.accept("<")) op = 3;
+            else {
+                err = "颜色判据" + p.where() + "应为 > >= < <=";
+                return false;
+            }
+            bool negative = p.accept("-");
+            long bound;
+            if (!p.integer(bound)) {
+                err = "颜色判据" + p.where() + "应为整数";
+                return false;
+            }
+            if (negative) bound = -bound;
+            if (op >= 2) {
+                for (int ch = 0; ch < 3; ch++) a[ch] = static_cast<int16_t>(-a[ch]);
+                bound = -bound;
+            }
+            if (op == 0 || op == 3) bound -= 1;
+            c.bound[n++] = static_cast<int32_t>(bound);
+
+            if (!p.accept("&&")) break;
+        }
+        if (c.groupCount == kMaxGroups) {
+            err = "颜色判据最多 " + std::to_string(kMaxGroups) + " 组";
+            return false;
+        }
+        c.groupEnd[c.groupCount++] = static_cast<uint8_t>(n);
+        if (!p.accept("||")) break;
+    }
+    if (!p.eof()) {
+        err = "颜色判据" + p.where() + "有多余内容";
+        return false;
+    }
+
+    c.build();
+    *this = c;
+    return true;
+}
+
+// 线性函数在单元 (8 个取值的立方体) 上的最值在顶点处取得，据此判断单元整体满足、整体不满足还是跨边界
+void ColorClassifier::build() {
+    std::memset(cells, 0, sizeof(cells));
+    int cellMin[3] = {32, 32, 32}, cellMax[3] = {-1, -1, -1};
+    for (int cb = 0; cb < 32; cb++)
+    for (int cg = 0; cg < 32; cg++)
+    for (int cr = 0; cr < 32; cr++) {
+        const int lo[3] = {cb * 8, cg * 8, cr * 8};
+        int state = kOutside;
+        int first = 0;
+        for (int k = 0; k < groupCount && state != kInside; k++) {
+            int group = kInside;
+            for (int i = first; i < groupEnd[k] && group != kOutside; i++) {
+                int minV = 0, maxV = 0;
+                for (int ch = 0; ch < 3; ch++) {
+                    int a = coef[i][ch];
+                    minV += a * (a > 0 ? lo[ch] : lo[ch] + 7);
+                    maxV += a * (a > 0 ? lo[ch] + 7 : lo[ch]);
+                }
+                if (maxV <= bound[i]) group = kOutside;
+                else if (minV <= bound[i]) group = kMixed;
+            }
+            if (group == kInside) state = kInside;
+            else if (group == kMixed) state = kMixed;
+            first = groupEnd[k];
+        }
+        int cell = cb << 10 | cg << 5 | cr;
+        cells[cell >> 5] |= static_cast<uint64_t>(state) << ((cell & 31) * 2);
+        if (state != kOutside) {
+            const int c[3] = {cb, cg, cr};
+            for (int ch = 0; ch < 3; ch++) {
+                cellMin[ch] = std::min(cellMin[ch], c[ch]);
+                cellMax[ch] = std::max(cellMax[ch], c[ch]);
+            }
+        }
+    }
+    // 空判据得到 lo > hi 的盒子，任何像素都不在盒内
+    for (int ch = 0; ch < 3; ch++) {
+        boxLo[ch] = static_cast<uint8_t>(std::min(255, cellMin[ch] * 8));
+        boxHi[ch] = static_cast<uint8_t>(cellMax[ch] < 0 ? 0 : cellMax[ch] * 8 + 7);
+    }
+
+    // 色度单元内的 (U, V) 在亮度 [y, y + 7] 下得到的颜色落在按偏移范围张成的盒子里，
+    // 盒子碰到非“全部不满足”的颜色单元即为候选；截断方式与检测器一致，所以是必要条件
+    std::memset(chroma, 0, sizeof(chroma));
+    for (int cu = 0; cu < 32; cu++)
+    for (int cv = 0; cv < 32; cv++) {
+        int offMin[3] = {255, 255, 255}, offMax[3] = {-255, -255, -255};
+        for (int corner = 0; corner < 4; corner++) {
+            int off[3];
+            chromaOffsets(cu * 8 + (corner & 1) * 7 - 128, cv * 8 + (corner >> 1) * 7 - 128, off[2], off[1], off[0]);
+            for (int ch = 0; ch < 3; ch++) {
+                offMin[ch] = std::min(offMin[ch], off[ch]);
+                offMax[ch] = std::max(offMax[ch], off[ch]);
+            }
+        }
+        bool possible = false;
+        for (int y = 0; y < 256 && !possible; y += 8) {
+            int c0[3], c1[3];
+            for (int ch = 0; ch < 3; ch++) {
+                c0[ch] = std::min(255, std::max(0, y + offMin[ch])) >> 3;
+                c1[ch] = std::min(255, std::max(0, y + 7 + offMax[ch])) >> 3;
+            }
+            for (int b = c0[0]; b <= c1[0] && !possible; b++)
+            for (int g = c0[1]; g <= c1[1] && !possible; g++)
+            for (int r = c0[2]; r <= c1[2] && !possible; r++) {
+                int cell = b << 10 | g << 5 | r;
+                possible = ((cells[cell >> 5] >> ((cell & 31) * 2)) & 3) != kOutside;
+            }
+        }
+        int cell = cu << 5 | cv;
+        if (possible) chroma[cell >> 6] |= 1ULL << (cell & 63);
+    }
+}
+
+bool ColorClassifier::simple(int& threshold, int& rDiff, int& bDiff) const {
+    if (groupCount != 1 || groupEnd[0] != 3) return false;
+    bool seen[3] = {false, false, false};
+    int bounds[3];
+    static const int16_t terms[3][3] = {{0, 1, 0}, {0, 1, -1}, {-1, 1, 0}};
+    for (int i = 0; i < 3; i++) {
+        int t = 0;
+        while (t < 3 && !std::equal(terms[t], terms[t] + 3, coef[i])) t++;
+        // 饱和减法要求阈值在 [0, 254]
+        if (t == 3 || seen[t] || bound[i] < 0 || bound[i] > 254) return false;
+        seen[t] = true;
+        bounds[t] = bound[i];
+    }
+    threshold = bounds[0];
+    rDiff = bounds[1];
+    bDiff = bounds[2];
+    return true;
+}
+
+void ColorClassifier::bounds(uint8_t (&lo)[3], uint8_t (&hi)[3]) const {
+    for (int ch = 0; ch < 3; ch++) {
+        lo[ch] = boxLo[ch];
+        hi[ch] = boxHi[ch];
+    }
+}
+
+double ColorClassifier::mixedFraction() const {
+    int mixed = 0;
+    for (int cell = 0; cell < 32 * 32 * 32; cell++) {
+        mixed += ((cells[cell >> 5] >> ((cell & 31) * 2)) & 3) == kMixed;
+    }
+    return mixed / 32768.0;
+}
+
+} // namespace vision
@@ -0,0 +1,672 @@
+#include "frame_replay.hpp"
+#include "image_convert.hpp"
+#include "light_detector.hpp"
+#include "rt_clock.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// 检测器整定：在带标注的录像上按 阈值 x 检测方式 的网格逐组回放，统计准确率和每帧耗时，
+// 打印 准确率-耗时 的 Pareto 前沿，按准确率目标选出最快的一组并写成配置文件
+// 用法: detector_tune --data 录像.mwfr [--labels 标注.csv] [--camera "exposure=1 gain=1"] [--data ...]
+//                     [--green 180,200,220] [--diff 60,80,100] [--area 1,4]
+//                     [--tiled 1] [--sub 1,2] [--roi 0,48,96] [--threads 1] [--refine 0]
+//                     [--tolerance 3] [--passes 3] [--target 0.98] [--csv 全部结果.csv]
+//                     [--config config/guidance.conf --out 整定结果.conf]
+//       detector_tune --synth 输出.mwfr [--frames 600] [--size 320x240] [--brightness 1.0]
+//   标注：每行 frame_id,cx,cy (全分辨率像素)，'#' 开头为注释，没有出现的帧表示画面中没有目标；
+//         默认取录像同名、扩展名换成 .labels.csv 的文件
+//   一帧判对：有目标时面积最大的连通域质心与标注相距不超过 --tolerance，没有目标时没有连通域
+//   (融合任务取面积最大的连通域当目标，所以没有目标时任何连通域都是虚警)
+//   roi > 0 时与运行时相同：以上一帧最大目标为中心检测，丢失后下一帧整帧
+//   --camera 给出其后 --data 的录制设置 (写入 [camera] 的键，如曝光、增益)，同一设置的录像为一组，
+//   各组分别评估；选中组的设置一并写入输出配置
+//   --synth 生成合成录像 (I420) 和标注：亮度随帧变化的绿色目标、间歇遮挡，加上白、黄、青、暗绿干扰点，
+//   --brightness 按比例放大所有颜色 (饱和截断)，近似更长曝光 / 更高增益
+
+namespace {
+
+struct Label {
+    bool present;
+    float cx, cy;
+};
+
+struct Dataset {
+    std::string path;
+    int group;
+    int width, height;
+    std::vector<vision::Frame> frames;
+    std::vector<std::vector<uint8_t>> pixels;
+    std::vector<Label> labels;
+    int positives;
+};
+
+// 一组参数：颜色阈值 + 检测方式
+struct Candidate {
+    int green, diff, area;
+    bool tiled;
+    int subsample, roi, threads;
+    bool refine;
+};
+
+struct Score {
+    Candidate c;
+    int group;
+    double accuracy;                     // 判对的帧 / 全部帧
+    double recall;                       // 有目标且判对 / 有目标
+    double falseRate;                    // 没有目标却有连通域 / 没有目标
+    double rmsPx;                        // 判对帧的质心误差
+    double usPerFrame;                   // 各轮平均耗时取最小
+    bool front;
+};
+
+struct Options {
+    std::vector<int> green = {180, 200, 220};
+    std::vector<int> diff = {60, 80, 100};
+    std::vector<int> area = {1, 4};
+    std::vector<int> tiled = {1};
+    std::vector<int> sub = {1, 2};
+    std::vector<int> roi = {0, 48, 96};
+    std::vector<int> threads = {1};
+    std::vector<int> refine = {0};
+    float tolerance = 3.0f;
+    int passes = 3;
+    double target = 0.98;
+    std::string csv, config, out;
+    // --synth
+    std::string synth;
+    int frames = 600;
+    int width = 320, height = 240;
+    float brightness = 1.0f;
+};
+
+bool parseList(const char* text, std::vector<int>& out) {
+    out.clear();
+    std::stringstream in(text);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        char* end = nullptr;
+        long v = std::strtol(item.c_str(), &end, 10);
+        if (item.empty() || *end) return false;
+        out.push_back(static_cast<int>(v));
+    }
+    return !out.empty();
+}
+
+// "exposure=1 gain=1" -> 键值对
+bool parseCamera(const std::string& text, std::vector<std::pair<std::string, std::string>>& out) {
+    out.clear();
+    std::stringstream in(text);
+    std::string item;
+    while (in >> item) {
+        size_t eq = item.find('=');
+        if (eq == std::string::npos || eq == 0 || eq + 1 == item.size()) return false;
+        out.push_back(std::make_pair(item.substr(0, eq), item.substr(eq + 1)));
+    }
+    return true;
+}
+
+std::string defaultLabels(const std::string& path) {
+    size_t dot = path.rfind('.');
+    size_t slash = path.rfind('/');
+    std::string stem = dot != std::string::npos && (slash == std::string::npos || dot > slash) ? path.substr(0, dot) : path;
+    return stem + ".labels.csv";
+}
+
+bool loadLabels(const std::string& path, Dataset& d, std::string& err) {
+    std::ifstream in(path.c_str());
+    if (!in) {
+        err = "无法打开标注 " + path;
+        return false;
+    }
+    std::map<uint32_t, Label> byId;
+    std::string line;
+    int lineNo = 0;
+    while (std::getline(in, line)) {
+        lineNo++;
+        if (line.empty() || line[0] == '#') continue;
+        unsigned long id;
+        float cx, cy;
+        if (std::sscanf(line.c_str(), "%lu,%f,%f", &id, &cx, &cy) != 3) {
+            err = path + ":" + std::to_string(lineNo) + " 应为 frame_id,cx,cy";
+            return false;
+        }
+        Label l = {true, cx, cy};
+        byId[static_cast<uint32_t>(id)] = l;
+    }
+    d.labels.resize(d.frames.size());
+    d.positives = 0;
+    for (size_t i = 0; i < d.frames.size(); i++) {
+        std::map<uint32_t, Label>::const_iterator it = byId.find(d.frames[i].id);
+        d.labels[i] = it == byId.end() ? Label{false, 0.0f, 0.0f} : it->second;
+        d.positives += d.labels[i].present;
+    }
+    return true;
+}
+
+// 整个录像读进内存，计时只含检测
+bool loadDataset(const std::string& path, const std::string& labels, int group, Dataset& d, std::string& err) {
+    vision::ReplayFrameSource src(path);
+    if (!src.open()) {
+        err = "无法打开录像 " + path;
+        return false;
+    }
+    d.path = path;
+    d.group = group;
+    d.width = src.width();
+    d.height = src.height();
+    vision::Frame f;
+    while (src.grab(f)) {
+        d.pixels.push_back(std::vector<uint8_t>(f.data, f.data + vision::frameBytes(f.format, f.stride, f.height)));
+        d.frames.push_back(f);
+    }
+    for (size_t i = 0; i < d.frames.size(); i++) d.frames[i].data = d.pixels[i].data();
+    if (d.frames.empty()) {
+        err = path + " 没有帧";
+        return false;
+    }
+    return loadLabels(labels.empty() ? defaultLabels(path) : labels, d, err);
+}
+
+// 一组参数在一个分组的全部录像上回放 passes 轮；第一轮统计准确率，各结果与线程数、分块方式无关
+void evaluate(const Candidate& c, const std::vector<Dataset>& data, int group, const Options& o, Score& s) {
+    s.c = c;
+    s.group = group;
+    int frames = 0, correct = 0, positives = 0, hits = 0, negatives = 0, falseAlarms = 0;
+    double errSq = 0.0;
+    double bestUs = 0.0;
+    vision::GreenRule rule;
+    rule.greenThreshold = static_cast<uint8_t>(c.green);
+    rule.minRbDiff = static_cast<uint8_t>(c.diff);
+    rule.minArea = c.area;
+    vision::DetectorOptions opts;
+    opts.tiled = c.tiled;
+    opts.subsample = c.subsample;
+    opts.threads = c.threads;
+    opts.refine = c.refine;
+    for (int pass = 0; pass < o.passes; pass++) {
+        int64_t totalNs = 0;
+        int timed = 0;
+        for (const Dataset& d : data) {
+            if (d.group != group) continue;
+            vision::LightDetector detector(d.width, d.height, rule, opts);
+            vision::Blob target = vision::Blob();
+            bool hasTarget = false;
+            for (size_t i = 0; i < d.frames.size(); i++) {
+                if (c.roi > 0 && hasTarget) {
+                    int cx = static_cast<int>(target.cx), cy = static_cast<int>(target.cy);
+                    detector.setRoi(cx - c.roi, cy - c.roi, cx + c.roi + 1, cy + c.roi + 1);
+                } else {
+                    detector.clearRoi();
+                }
+                vision::BlobList blobs;
+                int64_t t0 = monotonicNs();
+                detector.detect(d.frames[i], blobs);
+                totalNs += monotonicNs() - t0;
+                timed++;
+                const vision::Blob* b = blobs.largest();
+                hasTarget = b != nullptr;
+                if (b) target = *b;
+                if (pass) continue;
+
+                const Label& l = d.labels[i];
+                frames++;
+                if (l.present) {
+                    positives++;
+                    if (b) {
+                        double e2 = (b->cx - l.cx) * (b->cx - l.cx) + (b->cy - l.cy) * (b->cy - l.cy);
+                        if (e2 <= o.tolerance * o.tolerance) {
+                            hits++;
+                            correct++;
+                            errSq += e2;
+                        }
+                    }
+                } else {
+                    negatives++;
+                    if (b) {
+                        falseAlarms++;
+                    } else {
+                        correct++;
+                    }
+                }
+            }
+        }
+        double us = timed ? totalNs * 1e-3 / timed : 0.0;
+        if (pass == 0 || us < bestUs) bestUs = us;
+    }
+    s.accuracy = frames ? static_cast<double>(correct) / frames : 0.0;
+    s.recall = positives ? static_cast<double>(hits) / positives : 1.0;
+    s.falseRate = negatives ? static_cast<double>(falseAlarms) / negatives : 0.0;
+    s.rmsPx = hits ? std::sqrt(errSq / hits) : 0.0;
+    s.usPerFrame = bestUs;
+    s.front = false;
+}
+
+// 各组内按耗时升序，准确率严格高于所有更快的点才在前沿上
+void markFront(std::vector<Score>& scores, int group) {
+    std::vector<Score*> g;
+    for (Score& s : scores) {
+        if (s.group == group) g.push_back(&s);
+    }
+    std::sort(g.begin(), g.end(), [](const Score* a, const Score* b) {
+        return a->usPerFrame != b->usPerFrame ? a->usPerFrame < b->usPerFrame : a->accuracy > b->accuracy;
+    });
+    double best = -1.0;
+    for (Score* s : g) {
+        if (s->accuracy > best) {
+            s->front = true;
+            best = s->accuracy;
+        }
+    }
+}
+
+void printScore(const Score& s) {
+    const Candidate& c = s.c;
+    std::printf("%5d %4d %4d %4d %5d %3d %4d %7d %6d %8.4f %7.4f %7.4f %6.2f %9.1f\n", s.group, c.green, c.diff, c.area,
+                c.tiled, c.subsample, c.roi, c.threads, c.refine, s.accuracy, s.recall, s.falseRate, s.rmsPx,
+                s.usPerFrame);
+}
+
+void printHeader() {
+    std::printf("%5s %4s %4s %4s %5s %3s %4s %7s %6s %8s %7s %7s %6s %9s\n", "group", "thr", "diff", "area", "tiled",
+                "sub", "roi", "threads", "refine", "accuracy", "recall", "false", "rms px", "us/frame");
+}
+
+bool writeCsv(const std::string& path, const std::vector<Score>& scores) {
+    FILE* f = std::fopen(path.c_str(), "w");
+    if (!f) return false;
+    std::fprintf(f, "group,green_threshold,min_rb_diff,min_area,tiled,subsample,roi,threads,refine,"
+                    "accuracy,recall,false_rate,rms_px,us_per_frame,pareto\n");
+    for (const Score& s : scores) {
+        const Candidate& c = s.c;
+        std::fprintf(f, "%d,%d,%d,%d,%d,%d,%d,%d,%d,%.6f,%.6f,%.6f,%.4f,%.3f,%d\n", s.group, c.green, c.diff, c.area,
+                     c.tiled, c.subsample, c.roi, c.threads, c.refine, s.accuracy, s.recall, s.falseRate, s.rmsPx,
+                     s.usPerFrame, s.front ? 1 : 0);
+    }
+    return std::fclose(f) == 0;
+}
+
+typedef std::vector<std::pair<std::string, std::string>> KeyValues;
+
+std::string trim(const std::string& s) {
+    size_t b = s.find_first_not_of(" \t\r");
+    if (b == std::string::npos) return std::string();
+    size_t e = s.find_last_not_of(" \t\r");
+    return s.substr(b, e - b + 1);
+}
+
+// 复制基础配置，只改写给出的键：已有的键保留行尾注释和对齐，没有的键加在该节最后一个键之后，
+// 没有的节追加到文件末尾；[detector] 里生效的 classifier 会盖过阈值，注释掉
+bool writeConfig(const std::string& basePath, const std::string& outPath, const std::string& banner,
+                 const std::map<std::string, KeyValues>& edits, std::string& err) {
+    std::ifstream in(basePath.c_str());
+    if (!in) {
+        err = "无法打开配置文件 " + basePath;
+        return false;
+    }
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(in, line)) lines.push_back(line);
+
+    std::vector<std::string> out;
+    out.push_back(banner);
+    std::map<std::string, std::vector<bool>> done;
+    for (const auto& e : edits) done[e.first].assign(e.second.size(), false);
+    std::string section;
+    size_t lastKey = 0;                  // 当前节最后一个键在 out 中的下标 + 1
+    auto flush = [&]() {
+        auto it = edits.find(section);
+        if (it == edits.end()) return;
+        std::vector<std::string> extra;
+        for (size_t k = 0; k < it->second.size(); k++) {
+            if (!done[section][k]) extra.push_back(it->second[k].first + " = " + it->second[k].second);
+            done[section][k] = true;
+        }
+        out.insert(out.begin() + lastKey, extra.begin(), extra.end());
+    };
+    for (const std::string& raw : lines) {
+        std::string t = trim(raw);
+        if (!t.empty() && t[0] == '[') {
+            flush();
+            size_t end = t.find(']');
+            section = trim(t.substr(1, end == std::string::npos ? std::string::npos : end - 1));
+            out.push_back(raw);
+            lastKey = out.size();
+            continue;
+        }
+        size_t eq = raw.find('=');
+        if (t.empty() || t[0] == '#' || t[0] == ';' || eq == std::string::npos) {
+            out.push_back(raw);
+            continue;
+        }
+        std::string key = trim(raw.substr(0, eq));
+        std::string edited = raw;
+        auto it = edits.find(section);
+        if (section == "detector" && key == "classifier") {
+            edited = "# " + raw + "    # detector_tune: 阈值已整定，查表判据停用";
+        } else if (it != edits.end()) {
+            for (size_t k = 0; k < it->second.size(); k++) {
+                if (it->second[k].first != key) continue;
+                std::string head = key + " = " + it->second[k].second;
+                size_t hash = raw.find('#', eq);
+                if (hash != std::string::npos) {
+                    // 注释列对齐不变，放不下时空两格
+                    size_t pad = hash > head.size() + 1 ? hash - head.size() : 2;
+                    head += std::string(pad, ' ') + raw.substr(hash);
+                }
+                edited = head;
+                done[section][k] = true;
+            }
+        }
+        out.push_back(edited);
+        lastKey = out.size();
+    }
+    flush();
+    for (const auto& e : edits) {
+        bool any = false;
+        for (size_t k = 0; k < e.second.size(); k++) any = any || !done[e.first][k];
+        if (!any) continue;
+        out.push_back("");
+        out.push_back("[" + e.first + "]");
+        for (size_t k = 0; k < e.second.size(); k++) {
+            if (!done[e.first][k]) out.push_back(e.second[k].first + " = " + e.second[k].second);
+        }
+    }
+
+    std::ofstream f(outPath.c_str());
+    for (const std::string& l : out) f << l << '\n';
+    if (!f) {
+        err = "无法写入 " + outPath;
+        return false;
+    }
+    return true;
+}
+
+// ---- 合成录像 ----
+
+void blend(std::vector<uint8_t>& img, int width, int height, float cx, float cy, float radius, const float (&color)[3]) {
+    int r = static_cast<int>(radius) + 2;
+    for (int y = static_cast<int>(cy) - r; y <= static_cast<int>(cy) + r; y++) {
+        if (y < 0 || y >= height) continue;
+        for (int x = static_cast<int>(cx) - r; x <= static_cast<int>(cx) + r; x++) {
+            if (x < 0 || x >= width) continue;
+            float d = std::sqrt((x - cx) * (x - cx) + (y - cy) * (y - cy));
+            float a = std::min(1.0f, std::max(0.0f, radius + 0.5f - d));
+            uint8_t* p = &img[(static_cast<size_t>(y) * width + x) * 3];
+            for (int c = 0; c < 3; c++) {
+                float v = p[c] * (1.0f - a) + std::min(255.0f, color[c]) * a;
+                p[c] = static_cast<uint8_t>(v + 0.5f);
+            }
+        }
+    }
+}
+
+bool synthesize(const Options& o, std::string& err) {
+    vision::FrameRecorder rec;
+    int w = o.width, h = o.height;
+    if (!rec.open(o.synth, vision::PIXEL_I420, w, h, w)) {
+        err = "无法写入 " + o.synth;
+        return false;
+    }
+    std::string labelPath = defaultLabels(o.synth);
+    FILE* labels = std::fopen(labelPath.c_str(), "w");
+    if (!labels) {
+        err = "无法写入 " + labelPath;
+        return false;
+    }
+    std::fprintf(labels, "# frame_id,cx,cy  合成，brightness %.2f\n", o.brightness);
+
+    std::mt19937 rng(23);
+    std::uniform_int_distribution<int> noise(0, 40);
+    std::vector<uint8_t> i420(vision::frameBytes(vision::PIXEL_I420, w, h));
+    float sx = w / 320.0f, sy = h / 240.0f, k = o.brightness;
+    for (int f = 0; f < o.frames; f++) {
+        double t = f / 120.0;
+        std::vector<uint8_t> img(static_cast<size_t>(w) * h * 3);
+        for (size_t i = 0; i < img.size(); i++) img[i] = static_cast<uint8_t>(std::min(255.0f, noise(rng) * k));
+
+        // 目标亮度在暗、亮之间缓慢变化，每 2 s 遮挡 0.4 s
+        float level = static_cast<float>(0.88 + 0.1 * std::sin(2.0 * M_PI * 0.23 * t));
+        const float green[3] = {45 * level * k, 240 * level * k, 70 * level * k};
+        const float white[3] = {245 * k, 250 * k, 245 * k};
+        const float yellow[3] = {40 * k, 225 * k, 210 * k};
+        const float cyan[3] = {215 * k, 225 * k, 50 * k};
+        const float dimGreen[3] = {30 * k, 160 * k, 50 * k};
+        blend(img, w, h, sx * 60, sy * 50, 6, white);
+        blend(img, w, h, sx * 260, sy * 60, 4, yellow);
+        blend(img, w, h, sx * 80, sy * 190, 4, cyan);
+        blend(img, w, h, sx * 250, sy * 200, 5, dimGreen);
+        bool visible = std::fmod(t, 2.0) < 1.6;
+        float cx = sx * static_cast<float>(160 + 110 * std::sin(2.0 * M_PI * 0.5 * t));
+        float cy = sy * static_cast<float>(120 + 80 * std::cos(2.0 * M_PI * 0.4 * t));
+        float radius = 1.5f + 5.0f * static_cast<float>(0.5 + 0.5 * std::sin(2.0 * M_PI * 0.3 * t));
+        if (visible) {
+            blend(img, w, h, cx, cy, radius, green);
+            std::fprintf(labels, "%d,%.2f,%.2f\n", f, cx, cy);
+        }
+
+        vision::bgrToI420(img.data(), w * 3, w, h, i420.data(), w);
+        vision::Frame frame;
+        frame.format = vision::PIXEL_I420;
+        frame.width = w;
+        frame.height = h;
+        frame.stride = w;
+        frame.data = i420.data();
+        frame.captureNs = static_cast<int64_t>(t * 1e9);
+        frame.id = static_cast<uint32_t>(f);
+        frame.bayer = vision::BAYER_RGGB;
+        if (!rec.write(frame)) {
+            std::fclose(labels);
+            err = "写入 " + o.synth + " 失败";
+            return false;
+        }
+    }
+    rec.close();
+    std::fclose(labels);
+    std::printf("%d frames -> %s, labels -> %s\n", o.frames, o.synth.c_str(), labelPath.c_str());
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options o;
+    std::vector<std::pair<std::string, std::string>> inputs;    // 录像, 标注
+    std::vector<int> inputGroup;
+    std::vector<KeyValues> groups(1);
+    std::vector<std::string> groupText(1, "-");
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        bool ok = true;
+        if (!std::strcmp(argv[i], "--data") && hasValue) {
+            inputs.push_back(std::make_pair(std::string(argv[++i]), std::string()));
+            inputGroup.push_back(static_cast<int>(groups.size()) - 1);
+        } else if (!std::strcmp(argv[i], "--labels") && hasValue && !inputs.empty()) {
+            inputs.back().second = argv[++i];
+        } else if (!std::strcmp(argv[i], "--camera") && hasValue) {
+            KeyValues kv;
+            ok = parseCamera(argv[++i], kv);
+            groups.push_back(kv);
+            groupText.push_back(argv[i]);
+        } else if (!std::strcmp(argv[i], "--green") && hasValue) {
+            ok = parseList(argv[++i], o.green);
+        } else if (!std::strcmp(argv[i], "--diff") && hasValue) {
+            ok = parseList(argv[++i], o.diff);
+        } else if (!std::strcmp(argv[i], "--area") && hasValue) {
+            ok = parseList(argv[++i], o.area);
+        } else if (!std::strcmp(argv[i], "--tiled") && hasValue) {
+            ok = parseList(argv[++i], o.tiled);
+        } else if (!std::strcmp(argv[i], "--sub") && hasValue) {
+            ok = parseList(argv[++i], o.sub);
+        } else if (!std::strcmp(argv[i], "--roi") && hasValue) {
+            ok = parseList(argv[++i], o.roi);
+        } else if (!std::strcmp(argv[i], "--threads") && hasValue) {
+            ok = parseList(argv[++i], o.threads);
+        } else if (!std::strcmp(argv[i], "--refine") && hasValue) {
+            ok = parseList(argv[++i], o.refine);
+        } else if (!std::strcmp(argv[i], "--tolerance") && hasValue) {
+            o.tolerance = static_cast<float>(std::atof(argv[++i]));
+        } else if (!std::strcmp(argv[i], "--passes") && hasValue) {
+            o.passes = std::max(1, std::atoi(argv[++i]));
+        } else if (!std::strcmp(argv[i], "--target") && hasValue) {
+            o.target = std::atof(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--csv") && hasValue) {
+            o.csv = argv[++i];
+        } else if (!std::strcmp(argv[i], "--config") && hasValue) {
+            o.config = argv[++i];
+        } else if (!std::strcmp(argv[i], "--out") && hasValue) {
+            o.out = argv[++i];
+        } else if (!std::strcmp(argv[i], "--synth") && hasValue) {
+            o.synth = argv[++i];
+        } else if (!std::strcmp(argv[i], "--frames") && hasValue) {
+            o.frames = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--size") && hasValue) {
+            ok = std::sscanf(argv[++i], "%dx%d", &o.width, &o.height) == 2 && o.width >= 64 && o.height >= 64 &&
+                 o.width % 16 == 0 && o.height % 8 == 0;
+        } else if (!std::strcmp(argv[i], "--brightness") && hasValue) {
+            o.brightness = static_cast<float>(std::atof(argv[++i]));
+        } else {
+            std::cerr << "未知参数: " << argv[i] << std::endl;
+            return 2;
+        }
+        if (!ok) {
+            std::cerr << "参数格式错误: " << argv[i - 1] << " " << argv[i] << std::endl;
+            return 2;
+        }
+    }
+
+    std::string err;
+    if (!o.synth.empty()) {
+        if (o.frames <= 0 || o.brightness <= 0.0f) {
+            std::cerr << "--frames、--brightness 须为正" << std::endl;
+            return 2;
+        }
+        if (!synthesize(o, err)) {
+            std::cerr << err << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+    if (inputs.empty() || (o.out.empty() != o.config.empty())) {
+        std::cerr << "至少一个 --data；--config 与 --out 同时给出" << std::endl;
+        return 2;
+    }
+    for (int s : o.sub) {
+        if (s != 1 && s != 2) {
+            std::cerr << "--sub 只能是 1 或 2" << std::endl;
+            return 2;
+        }
+    }
+    // 阈值写进 uint8_t，超出范围会被截断成别的值
+    for (const std::vector<int>* list : {&o.green, &o.diff}) {
+        for (int v : *list) {
+            if (v < 0 || v > 255) {
+                std::cerr << "--green、--diff 须在 0 ~ 255 之间: " << v << std::endl;
+                return 2;
+            }
+        }
+    }
+
+    std::vector<Dataset> data(inputs.size());
+    std::vector<int> used;
+    for (size_t i = 0; i < inputs.size(); i++) {
+        if (!loadDataset(inputs[i].first, inputs[i].second, inputGroup[i], data[i], err)) {
+            std::cerr << err << std::endl;
+            return 1;
+        }
+        if (std::find(used.begin(), used.end(), inputGroup[i]) == used.end()) used.push_back(inputGroup[i]);
+        std::printf("%s: %zu frames %dx%d, %d labelled, group %d (%s)\n", data[i].path.c_str(), data[i].frames.size(),
+                    data[i].width, data[i].height, data[i].positives, inputGroup[i], groupText[inputGroup[i]].c_str());
+    }
+
+    // 网格：各组 x 阈值 x 检测方式；roi 与 sub 等价于运行时的质量档位
+    std::vector<Score> scores;
+    for (int g : used) {
+        for (int green : o.green)
+            for (int diff : o.diff)
+                for (int area : o.area)
+                    for (int tiled : o.tiled)
+                        for (int sub : o.sub)
+                            for (int roi : o.roi)
+                                for (int threads : o.threads)
+                                    for (int refine : o.refine) {
+                                        // 隔行取样不做亮度加权，两种取值结果相同，只评估一次
+                                        if (sub == 2 && refine) continue;
+                                        Candidate c = {green, diff, area, tiled != 0, sub, roi, std::max(1, threads),
+                                                       refine != 0};
+                                        Score s;
+                                        evaluate(c, data, g, o, s);
+                                        scores.push_back(s);
+                                    }
+        markFront(scores, g);
+    }
+    std::sort(scores.begin(), scores.end(), [](const Score& a, const Score& b) {
+        return a.group != b.group ? a.group < b.group : a.usPerFrame < b.usPerFrame;
+    });
+
+    std::printf("\n%zu settings, tolerance %.1f px, %d passes; Pareto front (accuracy vs us/frame):\n", scores.size(),
+                o.tolerance, o.passes);
+    printHeader();
+    for (const Score& s : scores) {
+        if (s.front) printScore(s);
+    }
+    if (!o.csv.empty() && !writeCsv(o.csv, scores)) {
+        std::cerr << "无法写入 " << o.csv << std::endl;
+        return 1;
+    }
+
+    // 满足准确率目标的最快一组；同样快时取准确率高的
+    const Score* pick = nullptr;
+    const Score* best = nullptr;
+    for (const Score& s : scores) {
+        if (!best || s.accuracy > best->accuracy) best = &s;
+        if (s.accuracy < o.target) continue;
+        if (!pick || s.usPerFrame < pick->usPerFrame ||
+            (s.usPerFrame == pick->usPerFrame && s.accuracy > pick->accuracy)) {
+            pick = &s;
+        }
+    }
+    if (!pick) {
+        std::printf("\nno setting reaches accuracy %.4f; best is %.4f:\n", o.target, best->accuracy);
+        printHeader();
+        printScore(*best);
+        return 1;
+    }
+    std::printf("\nfastest setting with accuracy >= %.4f:\n", o.target);
+    printHeader();
+    printScore(*pick);
+
+    if (!o.out.empty()) {
+        const Candidate& c = pick->c;
+        std::map<std::string, KeyValues> edits;
+        KeyValues& det = edits["detector"];
+        det.push_back(std::make_pair("green_threshold", std::to_string(c.green)));
+        det.push_back(std::make_pair("min_rb_diff", std::to_string(c.diff)));
+        det.push_back(std::make_pair("min_area", std::to_string(c.area)));
+        det.push_back(std::make_pair("tiled", std::string(c.tiled ? "true" : "false")));
+        det.push_back(std::make_pair("threads", std::to_string(c.threads)));
+        det.push_back(std::make_pair("subsample", std::to_string(c.subsample)));
+        det.push_back(std::make_pair("refine", std::string(c.refine ? "true" : "false")));
+        det.push_back(std::make_pair("roi", std::to_string(c.roi)));
+        if (!groups[pick->group].empty()) edits["camera"] = groups[pick->group];
+        char banner[160];
+        std::snprintf(banner, sizeof(banner), "# detector_tune: accuracy %.4f (target %.4f), %.1f us/frame, camera %s",
+                      pick->accuracy, o.target, pick->usPerFrame, groupText[pick->group].c_str());
+        if (!writeConfig(o.config, o.out, banner, edits, err)) {
+            std::cerr << err << std::endl;
+            return 1;
+        }
+        std::printf("wrote %s\n", o.out.c_str());
+    }
+    return 0;
+}
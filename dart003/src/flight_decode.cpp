@@ -0,0 +1,95 @@
+#include "flight_recorder.hpp"
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+// 飞行记录转 CSV，每种记录一个文件
+// 用法: flight_decode 记录.mwfl [输出前缀]
+//   输出 前缀_imu.csv、前缀_detection.csv、前缀_servo.csv、前缀_text.csv，前缀默认为输入文件名去掉扩展名
+//   IMU 按文件头的 LSB 换算成 rad/s、m/s^2，温度保留传感器原始值
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "用法: flight_decode 记录.mwfl [输出前缀]" << std::endl;
+        return 2;
+    }
+    std::string input = argv[1];
+    std::string prefix = argc > 2 ? argv[2] : input.substr(0, input.rfind('.'));
+
+    flight::FlightReader reader;
+    std::string err;
+    if (!reader.open(input, err)) {
+        std::cerr << err << std::endl;
+        return 1;
+    }
+    const flight::FileHeader& h = reader.header();
+
+    static const char* names[] = {nullptr, "imu", "detection", "servo", "text"};
+    static const char* columns[] = {
+        nullptr,
+        "t_ns,channel,gx,gy,gz,ax,ay,az,temp_raw",
+        "t_ns,channel,capture_ns,frame_id,count,cx0,cy0,area0,cx1,cy1,area1",
+        "t_ns,channel,angle0,angle1,angle2,angle3,pulse0,pulse1,pulse2,pulse3",
+        "t_ns,channel,text",
+    };
+    FILE* out[flight::REC_TYPE_COUNT] = {nullptr};
+    uint64_t counts[flight::REC_TYPE_COUNT] = {0};
+    for (int t = 1; t < flight::REC_TYPE_COUNT; t++) {
+        std::string path = prefix + "_" + names[t] + ".csv";
+        out[t] = std::fopen(path.c_str(), "w");
+        if (!out[t]) {
+            std::perror(path.c_str());
+            return 1;
+        }
+        std::fprintf(out[t], "%s\n", columns[t]);
+    }
+
+    flight::Record r;
+    while (reader.next(r)) {
+        FILE* f = out[r.type];
+        counts[r.type]++;
+        std::fprintf(f, "%lld,%d,", static_cast<long long>(r.tNs), r.channel);
+        switch (r.type) {
+        case flight::REC_IMU:
+            std::fprintf(f, "%.6f,%.6f,%.6f,%.5f,%.5f,%.5f,%d\n", r.imu.gyro[0] * h.gyroLsb, r.imu.gyro[1] * h.gyroLsb,
+                         r.imu.gyro[2] * h.gyroLsb, r.imu.accel[0] * h.accelLsb, r.imu.accel[1] * h.accelLsb,
+                         r.imu.accel[2] * h.accelLsb, r.imu.temp);
+            break;
+        case flight::REC_DETECTION: {
+            const flight::DetectionRecord& d = r.detection;
+            std::fprintf(f, "%lld,%u,%d,%.3f,%.3f,%d,%.3f,%.3f,%d\n", static_cast<long long>(d.captureNs), d.frameId,
+                         d.count, d.cx[0], d.cy[0], d.area[0], d.cx[1], d.cy[1], d.area[1]);
+            break;
+        }
+        case flight::REC_SERVO: {
+            const flight::ServoRecord& s = r.servo;
+            std::fprintf(f, "%.5f,%.5f,%.5f,%.5f,%u,%u,%u,%u\n", s.angle[0], s.angle[1], s.angle[2], s.angle[3],
+                         s.pulseUs[0], s.pulseUs[1], s.pulseUs[2], s.pulseUs[3]);
+            break;
+        }
+        case flight::REC_TEXT:
+            std::fprintf(f, "\"%.*s\"\n", static_cast<int>(sizeof(r.text.text)), r.text.text);
+            break;
+        }
+    }
+    for (int t = 1; t < flight::REC_TYPE_COUNT; t++) std::fclose(out[t]);
+
+    std::printf("%s: producers", input.c_str());
+    for (uint32_t i = 0; i < h.producerCount && i < static_cast<uint32_t>(flight::kMaxProducers); i++) {
+        std::printf(" %.16s", h.producers[i]);
+    }
+    std::printf("\n  imu %llu, detection %llu, servo %llu, text %llu records -> %s_*.csv\n",
+                static_cast<unsigned long long>(counts[flight::REC_IMU]),
+                static_cast<unsigned long long>(counts[flight::REC_DETECTION]),
+                static_cast<unsigned long long>(counts[flight::REC_SERVO]),
+                static_cast<unsigned long long>(counts[flight::REC_TEXT]), prefix.c_str());
+    if (h.dataBytes == 0) std::printf("  未正常关闭，解码到第一个空记录为止\n");
+    else std::printf("  header: %llu records, dropped %llu, lost %llu\n", static_cast<unsigned long long>(h.records),
+                     static_cast<unsigned long long>(h.dropped), static_cast<unsigned long long>(h.lost));
+    if (reader.truncated()) {
+        std::printf("  偏移 %zu 处数据不完整，之后的记录已忽略\n", reader.offset());
+        return 1;
+    }
+    return 0;
+}
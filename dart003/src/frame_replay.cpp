@@ -0,0 +1,108 @@
+#include "frame_replay.hpp"
+#include "rt_clock.hpp"
+
+#include <cstring>
+
+namespace vision {
+
+namespace {
+const uint32_t kFrameFileVersion = 2;      // 2: 增加 Bayer 排列
+}
+
+bool FrameRecorder::open(const std::string& path, PixelFormat format, int width, int height, int stride,
+                         BayerOrder bayer) {
+    close();
+    file = std::fopen(path.c_str(), "wb");
+    if (!file) return false;
+
+    std::memcpy(header.magic, "MWFR", 4);
+    header.version = kFrameFileVersion;
+    header.format = format;
+    header.width = width;
+    header.height = height;
+    header.stride = stride;
+    header.bayer = bayer;
+    if (std::fwrite(&header, sizeof(header), 1, file) != 1) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool FrameRecorder::write(const Frame& frame) {
+    if (!file || frame.format != static_cast<PixelFormat>(header.format) ||
+        frame.width != static_cast<int>(header.width) || frame.height != static_cast<int>(header.height) ||
+        frame.stride != static_cast<int>(header.stride)) {
+        return false;
+    }
+
+    FrameRecordHeader rec;
+    rec.captureNs = frame.captureNs;
+    rec.id = frame.id;
+    rec.bytes = static_cast<uint32_t>(frameBytes(frame.format, frame.stride, frame.height));
+    return std::fwrite(&rec, sizeof(rec), 1, file) == 1 && std::fwrite(frame.data, 1, rec.bytes, file) == rec.bytes;
+}
+
+void FrameRecorder::close() {
+    if (file) std::fclose(file);
+    file = nullptr;
+}
+
+ReplayFrameSource::ReplayFrameSource(const std::string& path, bool paced, bool loop)
+    : path(path), paced(paced), loop(loop) {
+    std::memset(&header, 0, sizeof(header));
+}
+
+bool ReplayFrameSource::open() {
+    close();
+    file = std::fopen(path.c_str(), "rb");
+    if (!file) return false;
+    if (std::fread(&header, sizeof(header), 1, file) != 1 || std::memcmp(header.magic, "MWFR", 4) != 0 ||
+        header.version != kFrameFileVersion) {
+        close();
+        return false;
+    }
+    firstRecord = std::ftell(file);
+    buffer.resize(frameBytes(format(), header.stride, header.height));
+    originNs = 0;
+    return true;
+}
+
+bool ReplayFrameSource::grab(Frame& frame) {
+    if (!file) return false;
+
+    FrameRecordHeader rec;
+    if (std::fread(&rec, sizeof(rec), 1, file) != 1) {
+        if (!loop) return false;
+        std::fseek(file, firstRecord, SEEK_SET);
+        originNs = 0;
+        if (std::fread(&rec, sizeof(rec), 1, file) != 1) return false;
+    }
+    if (rec.bytes != buffer.size() || std::fread(buffer.data(), 1, rec.bytes, file) != rec.bytes) return false;
+
+    frame.format = format();
+    frame.width = width();
+    frame.height = height();
+    frame.stride = static_cast<int>(header.stride);
+    frame.data = buffer.data();
+    frame.id = rec.id;
+    frame.bayer = static_cast<BayerOrder>(header.bayer);
+    frame.captureNs = rec.captureNs;
+
+    if (paced) {
+        if (originNs == 0) {
+            originNs = monotonicNs();
+            firstCaptureNs = rec.captureNs;
+        }
+        frame.captureNs = originNs + (rec.captureNs - firstCaptureNs);
+        sleepUntilNs(frame.captureNs);
+    }
+    return true;
+}
+
+void ReplayFrameSource::close() {
+    if (file) std::fclose(file);
+    file = nullptr;
+}
+
+} // namespace vision
@@ -0,0 +1,283 @@
+#include "frame_source.hpp"
+#include "rt_clock.hpp"
+#include "trace_zone.hpp"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <linux/videodev2.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#ifdef HAVE_RASPICAM
+#include <raspicam/raspicam.h>
+#endif
+
+namespace vision {
+
+size_t frameBytes(PixelFormat format, int stride, int height) {
+    size_t luma = static_cast<size_t>(stride) * height;
+    return format == PIXEL_I420 ? luma + 2 * static_cast<size_t>(stride / 2) * (height / 2) : luma;
+}
+
+int minStride(PixelFormat format, int width) {
+    switch (format) {
+    case PIXEL_BGR24:
+        return width * 3;
+    case PIXEL_I420:
+        return width;
+    case PIXEL_BAYER10:
+        return width * 2;
+    case PIXEL_BAYER10P:
+        return width * 5 / 4;
+    }
+    return 0;
+}
+
+#ifdef HAVE_RASPICAM
+namespace {
+
+// 与 RaspiCam_Cv 对 CAP_PROP_* 的换算保持一致
+int scale(double inMin, double inMax, double outMin, double outMax, double v) {
+    return static_cast<int>(outMin + (v - inMin) / (inMax - inMin) * (outMax - outMin));
+}
+
+} // namespace
+
+struct RaspicamFrameSource::Impl {
+    raspicam::RaspiCam camera;
+};
+
+RaspicamFrameSource::RaspicamFrameSource(const CameraConfig& config)
+    : impl(new Impl), cfg(config) {}
+
+RaspicamFrameSource::~RaspicamFrameSource() {
+    close();
+    delete impl;
+}
+
+bool RaspicamFrameSource::open() {
+    if (cfg.format != PIXEL_BGR24 && cfg.format != PIXEL_I420) return false;
+    raspicam::RaspiCam& cam = impl->camera;
+    // I420 直接取 ISP 输出，省去 BGR 转换
+    cam.setFormat(cfg.format == PIXEL_I420 ? raspicam::RASPICAM_FORMAT_YUV420 : raspicam::RASPICAM_FORMAT_BGR);
+    cam.setCaptureSize(cfg.width, cfg.height);
+    cam.setFrameRate(cfg.fps);
+
+    if (cfg.exposure > 0 && cfg.exposure <= 100) {
+        cam.setShutterSpeed(scale(0, 100, 0, 330000, cfg.exposure));
+    } else {
+        cam.setExposure(raspicam::RASPICAM_EXPOSURE_AUTO);
+        cam.setShutterSpeed(0);
+    }
+    if (cfg.wbRedGain > 0.0f && cfg.wbBlueGain > 0.0f) {
+        cam.setAWB(raspicam::RASPICAM_AWB_OFF);
+        cam.setAWB_RB(cfg.wbRedGain, cfg.wbBlueGain);
+    } else {
+        cam.setAWB(raspicam::RASPICAM_AWB_AUTO);
+    }
+    cam.setBrightness(cfg.brightness);
+    cam.setContrast(scale(0, 100, -100, 100, cfg.contrast));
+    cam.setSaturation(scale(0, 100, -100, 100, cfg.saturation));
+    cam.setSharpness(scale(0, 100, -100, 100, cfg.sharpness));
+    cam.setISO(scale(0, 100, 95, 800, cfg.gain));
+
+    return cam.open();
+}
+
+bool RaspicamFrameSource::grab(Frame& frame) {
+    TRACE_ZONE("camera grab");
+    raspicam::RaspiCam& cam = impl->camera;
+    if (!cam.grab()) return false;
+
+    frame.format = cfg.format;
+    frame.bayer = cfg.bayerOrder;
+    frame.width = static_cast<int>(cam.getWidth());
+    frame.height = static_cast<int>(cam.getHeight());
+    frame.stride = cfg.format == PIXEL_I420 ? frame.width : frame.width * 3;
+    frame.data = cam.getImageBufferData();
+    frame.captureNs = monotonicNs() - cfg.captureLatencyUs * 1000LL;
+    frame.id = frameId++;
+    return frame.data != nullptr;
+}
+
+void RaspicamFrameSource::close() {
+    if (impl) impl->camera.release();
+}
+#endif
+
+namespace {
+
+int xioctl(int fd, unsigned long request, void* arg) {
+    int r;
+    do {
+        r = ioctl(fd, request, arg);
+    } while (r == -1 && errno == EINTR);
+    return r;
+}
+
+uint32_t bayerFourcc(PixelFormat format, BayerOrder order) {
+    static const uint32_t unpacked[] = {V4L2_PIX_FMT_SRGGB10, V4L2_PIX_FMT_SBGGR10, V4L2_PIX_FMT_SGRBG10,
+                                        V4L2_PIX_FMT_SGBRG10};
+    static const uint32_t packed[] = {V4L2_PIX_FMT_SRGGB10P, V4L2_PIX_FMT_SBGGR10P, V4L2_PIX_FMT_SGRBG10P,
+                                      V4L2_PIX_FMT_SGBRG10P};
+    return format == PIXEL_BAYER10P ? packed[order] : unpacked[order];
+}
+
+} // namespace
+
+V4l2BayerFrameSource::V4l2BayerFrameSource(const CameraConfig& config) : cfg(config) {}
+
+V4l2BayerFrameSource::~V4l2BayerFrameSource() {
+    close();
+}
+
+void V4l2BayerFrameSource::setControl(uint32_t id, int32_t value) {
+    v4l2_control ctrl;
+    ctrl.id = id;
+    ctrl.value = value;
+    if (xioctl(fd, VIDIOC_S_CTRL, &ctrl) < 0) {
+        std::fprintf(stderr, "[v4l2] 设置控制 0x%x = %d 失败: %s\n", id, value, std::strerror(errno));
+    }
+}
+
+bool V4l2BayerFrameSource::open() {
+    if (cfg.format != PIXEL_BAYER10 && cfg.format != PIXEL_BAYER10P) return false;
+    fd = ::open(cfg.device.c_str(), O_RDWR | O_NONBLOCK);
+    if (fd < 0) {
+        std::fprintf(stderr, "[v4l2] 无法打开 %s: %s\n", cfg.device.c_str(), std::strerror(errno));
+        return false;
+    }
+
+    v4l2_format fmt;
+    std::memset(&fmt, 0, sizeof(fmt));
+    fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    fmt.fmt.pix.width = cfg.width;
+    fmt.fmt.pix.height = cfg.height;
+    fmt.fmt.pix.pixelformat = bayerFourcc(cfg.format, cfg.bayerOrder);
+    fmt.fmt.pix.field = V4L2_FIELD_NONE;
+    if (xioctl(fd, VIDIOC_S_FMT, &fmt) < 0 || fmt.fmt.pix.pixelformat != bayerFourcc(cfg.format, cfg.bayerOrder)) {
+        std::fprintf(stderr, "[v4l2] 设备不支持请求的 Bayer 格式\n");
+        close();
+        return false;
+    }
+    // 驱动会把尺寸调整到传感器支持的模式 (IMX219 原始模式没有 320x240)；检测器和相机模型按配置尺寸建立，
+    // 尺寸不同的帧一律被检测器拒绝，这里直接失败，而不是静默地检测不到任何东西
+    if (static_cast<int>(fmt.fmt.pix.width) != cfg.width || static_cast<int>(fmt.fmt.pix.height) != cfg.height) {
+        std::fprintf(stderr, "[v4l2] %s 不支持 %dx%d 的 Bayer 输出 (驱动给出 %ux%u)，camera.width/height 须改为传感器模式的尺寸\n",
+                     cfg.device.c_str(), cfg.width, cfg.height, fmt.fmt.pix.width, fmt.fmt.pix.height);
+        close();
+        return false;
+    }
+    width = static_cast<int>(fmt.fmt.pix.width);
+    height = static_cast<int>(fmt.fmt.pix.height);
+    stride = static_cast<int>(fmt.fmt.pix.bytesperline);
+
+    // 帧率、曝光、增益是否生效取决于驱动；失败只告警
+    v4l2_streamparm parm;
+    std::memset(&parm, 0, sizeof(parm));
+    parm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    parm.parm.capture.timeperframe.numerator = 1;
+    parm.parm.capture.timeperframe.denominator = cfg.fps;
+    xioctl(fd, VIDIOC_S_PARM, &parm);
+    if (cfg.rawExposureLines > 0) setControl(V4L2_CID_EXPOSURE, cfg.rawExposureLines);
+    if (cfg.rawAnalogGain > 0) setControl(V4L2_CID_ANALOGUE_GAIN, cfg.rawAnalogGain);
+
+    v4l2_requestbuffers req;
+    std::memset(&req, 0, sizeof(req));
+    req.count = 4;
+    req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    req.memory = V4L2_MEMORY_MMAP;
+    if (xioctl(fd, VIDIOC_REQBUFS, &req) < 0 || req.count < 2) {
+        close();
+        return false;
+    }
+    for (uint32_t i = 0; i < req.count; i++) {
+        v4l2_buffer buf;
+        std::memset(&buf, 0, sizeof(buf));
+        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index = i;
+        if (xioctl(fd, VIDIOC_QUERYBUF, &buf) < 0) {
+            close();
+            return false;
+        }
+        void* p = mmap(nullptr, buf.length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, buf.m.offset);
+        if (p == MAP_FAILED) {
+            close();
+            return false;
+        }
+        buffers.push_back(std::make_pair(p, static_cast<size_t>(buf.length)));
+        if (xioctl(fd, VIDIOC_QBUF, &buf) < 0) {
+            close();
+            return false;
+        }
+    }
+
+    v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (xioctl(fd, VIDIOC_STREAMON, &type) < 0) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool V4l2BayerFrameSource::grab(Frame& frame) {
+    if (fd < 0) return false;
+    TRACE_ZONE("camera grab");
+
+    // 上一帧的缓冲区此时才归还驱动，调用者处理期间数据不会被覆盖
+    if (held >= 0) {
+        v4l2_buffer buf;
+        std::memset(&buf, 0, sizeof(buf));
+        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index = held;
+        xioctl(fd, VIDIOC_QBUF, &buf);
+        held = -1;
+    }
+
+    pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    if (poll(&pfd, 1, 1000) <= 0) return false;
+
+    v4l2_buffer buf;
+    std::memset(&buf, 0, sizeof(buf));
+    buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buf.memory = V4L2_MEMORY_MMAP;
+    if (xioctl(fd, VIDIOC_DQBUF, &buf) < 0) return false;
+    held = static_cast<int>(buf.index);
+
+    frame.format = cfg.format;
+    frame.bayer = cfg.bayerOrder;
+    frame.width = width;
+    frame.height = height;
+    frame.stride = stride;
+    frame.data = static_cast<const uint8_t*>(buffers[buf.index].first);
+    if ((buf.flags & V4L2_BUF_FLAG_TIMESTAMP_MASK) == V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC) {
+        frame.captureNs = buf.timestamp.tv_sec * 1000000000LL + buf.timestamp.tv_usec * 1000LL;
+    } else {
+        frame.captureNs = monotonicNs() - cfg.captureLatencyUs * 1000LL;
+    }
+    frame.id = frameId++;
+    return true;
+}
+
+void V4l2BayerFrameSource::close() {
+    if (fd >= 0) {
+        v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        xioctl(fd, VIDIOC_STREAMOFF, &type);
+    }
+    for (auto& b : buffers) munmap(b.first, b.second);
+    buffers.clear();
+    held = -1;
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+}
+
+} // namespace vision
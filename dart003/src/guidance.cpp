@@ -0,0 +1,61 @@
+#include "guidance.hpp"
+#include "rt_clock.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace guidance {
+
+FusionStage::FusionStage(const tracker::TrackerConfig& trackerCfg, const vision::CameraModel& camera)
+    : trk(trackerCfg), bearing(camera) {}
+
+bool FusionStage::process(const vision::BlobList& blobs, const ImuState& imu, TrackSnapshot& out) {
+    const vision::Blob* b = blobs.largest();
+    if (!b) return false;
+
+    float az, el;
+    bearing.angles(b->cx, b->cy, az, el);
+
+    // IMU 状态比曝光时刻新，按角速度回推到曝光时刻的姿态
+    float back = (imu.tNs - blobs.captureNs) * 1e-9f;
+    float yaw = imu.yaw - imu.yawRate * back;
+    float pitch = imu.pitch - imu.pitchRate * back;
+
+    tracker::BearingMeasurement m;
+    m.captureNs = blobs.captureNs;
+    m.az = az + yaw;
+    m.el = el + pitch;
+    m.sigma = 0.0f;
+    if (!trk.update(m)) return false;
+
+    out.tracker = trk;
+    out.lastCaptureNs = blobs.captureNs;
+    out.lastDetectNs = blobs.detectNs;
+    out.fusedNs = monotonicNs();
+    out.frameId = blobs.frameId;
+    return true;
+}
+
+ControlStage::ControlStage(const ControlConfig& cfg) : cfg(cfg) {}
+
+bool ControlStage::compute(const TrackSnapshot& snap, const ImuState& imu, int64_t nowNs,
+                           float (&angles)[servo::kServoCount]) const {
+    for (float& a : angles) a = 0.0f;
+
+    tracker::TargetState s = snap.tracker.predictForActuation(nowNs);
+    if (!s.valid) return false;
+
+    float ahead = (s.tNs - imu.tNs) * 1e-9f;
+    float azBody = s.az - (imu.yaw + imu.yawRate * ahead);
+    float elBody = s.el - (imu.pitch + imu.pitchRate * ahead);
+
+    float yawCmd = cfg.kp * azBody + cfg.kn * s.azRate;
+    float pitchCmd = cfg.kp * elBody + cfg.kn * s.elRate;
+    for (int i = 0; i < servo::kServoCount; i++) {
+        float a = cfg.mix[i][0] * pitchCmd + cfg.mix[i][1] * yawCmd;
+        angles[i] = std::min(std::max(a, -cfg.maxFinRad), cfg.maxFinRad);
+    }
+    return true;
+}
+
+} // namespace guidance
@@ -0,0 +1,342 @@
+#include "guidance_runtime.hpp"
+#include "rt_clock.hpp"
+#include "trace_zone.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+
+// 帧周期；直接填写 RuntimeConfig、没经过 loadRuntimeConfig 检查的调用者可能给出 fps <= 0，按默认帧率
+int64_t framePeriodNs(const vision::CameraConfig& cam) {
+    int fps = cam.fps > 0 ? cam.fps : vision::CameraConfig().fps;
+    return 1000000000LL / fps;
+}
+
+} // namespace
+
+void PipelineLatency::print() const {
+    captureToDetect.print("capture->detect");
+    detectToFusion.print("detect->fusion");
+    fusionToServo.print("fusion->servo");
+    captureToServo.print("capture->servo");
+}
+
+GuidanceRuntime::GuidanceRuntime(const RuntimeConfig& config, servo::ServoBank& bank,
+                                 vision::FrameSource* camera, guidance::ImuSource* imu,
+                                 guidance::AhrsSource* ahrs, vision::ThermalSource* thermal)
+    : cfg(config), bank(bank), camera(camera), imu(imu), ahrs(ahrs), thermal(thermal), failsafeCount(0),
+      loop(bank, cfg.servoCal, setpoints, cfg.servoTask.periodNs), fusionImu(imuSlot), servoImu(imuSlot),
+      servoTrack(trackSlot), imuAhrs(ahrsSlot), visionThermal(thermalSlot),
+      detector(cfg.camera.width, cfg.camera.height, cfg.detector, cfg.detectorOptions),
+      governor(cfg.governor, framePeriodNs(cfg.camera), cfg.detectorOptions),
+      governed(camera && cfg.governor.enabled), target(), hasTarget(false), fusion(cfg.tracker, cfg.cameraModel),
+      control(cfg.control), imuState(), imuPeakTracking(false), yawUnwrapped(0.0f), lastYaw(0.0f), yawTrim(0.0f),
+      pitchTrim(0.0f), ahrsSeen(0), fusionPreint(imuPreint), servoPreint(imuPreint), lastServoCapture(0),
+      imuLog(nullptr), visionLog(nullptr), servoLog(nullptr), imuTask(nullptr), fusionTask(nullptr) {
+    for (auto& a : setpoints) a = 0.0f;
+    detector.setClassifier(cfg.classifier);
+
+    // 滤波器按每个 IMU 周期一个样本设计；话题来源的样本按发布者的节拍到达，采样率未知
+    if (imu && cfg.imuFilterEnabled && !cfg.imuFilterStages.empty() && cfg.ipcImu) {
+        std::fprintf(stderr, "IMU 来自话题，采样率不是 1 / imu.period_us，IMU 不滤波\n");
+    } else if (imu && cfg.imuFilterEnabled && !cfg.imuFilterStages.empty()) {
+        std::string err;
+        float fs = cfg.imuTask.periodNs > 0 ? 1e9f / cfg.imuTask.periodNs : 0.0f;
+        if (!imuFilter.configure(cfg.imuFilterStages, fs, err)) {
+            std::fprintf(stderr, "%s，IMU 不滤波\n", err.c_str());
+        } else if (cfg.imuPeakTracking && !imuPeak.configure(cfg.imuPeak, fs, err)) {
+            std::fprintf(stderr, "%s，陷波不重调\n", err.c_str());
+        } else {
+            imuPeakTracking = cfg.imuPeakTracking;
+        }
+    }
+
+    if (camera) {
+        tasks.emplace_back(new RtTask(cfg.visionTask, [this](int64_t now) { visionCycle(now); }));
+        if (governed && thermal) {
+            tasks.emplace_back(new RtTask(cfg.thermalTask, [this](int64_t now) { thermalCycle(now); }));
+        }
+    }
+    if (ahrs) {
+        tasks.emplace_back(new RtTask(cfg.ahrsTask, [this](int64_t now) { ahrsCycle(now); }));
+    }
+    if (imu) {
+        tasks.emplace_back(new RtTask(cfg.imuTask, [this](int64_t now) { imuCycle(now); }));
+        imuTask = tasks.back().get();
+    }
+    tasks.emplace_back(new RtTask(cfg.fusionTask, [this](int64_t now) { fusionCycle(now); }));
+    fusionTask = tasks.back().get();
+    tasks.emplace_back(new RtTask(cfg.servoTask, [this](int64_t now) { servoCycle(now); }));
+
+    watchdog.reset(new Watchdog(cfg.watchdogPeriodMs * 1000000LL, cfg.watchdogStaleFactor,
+                                [this](const RtTask& t, bool stale) {
+                                    // IMU 或融合停止更新时舵面回中
+                                    if (&t == imuTask || &t == fusionTask) failsafeCount += stale ? 1 : -1;
+                                }));
+    for (auto& t : tasks) watchdog->watch(t.get());
+}
+
+GuidanceRuntime::~GuidanceRuntime() {
+    stop();
+}
+
+bool GuidanceRuntime::begin() {
+    return loop.begin();
+}
+
+void GuidanceRuntime::start() {
+    for (auto& t : tasks) t->start();
+    watchdog->start();
+}
+
+void GuidanceRuntime::stop() {
+    watchdog->stop();
+    for (auto& t : tasks) t->stop();
+    for (auto& t : tasks) t->join();
+}
+
+void GuidanceRuntime::end() {
+    loop.neutral();
+    loop.end();
+}
+
+void GuidanceRuntime::attachRecorder(flight::FlightRecorder& rec) {
+    if (imu) imuLog = rec.producer("imu");
+    if (camera) visionLog = rec.producer("vision");
+    servoLog = rec.producer("servo");
+}
+
+bool GuidanceRuntime::openTopics(std::string& err) {
+    return (!camera || blobTopic.open(ipc::kBlobTopic, err)) && servoTopic.open(ipc::kServoTopic, err);
+}
+
+void GuidanceRuntime::visionCycle(int64_t) {
+    vision::Frame frame;
+    if (!camera->grab(frame)) return;
+    if (governed) {
+        governor.apply(detector, hasTarget ? &target : nullptr);
+    } else if (cfg.detectorRoi > 0) {
+        if (hasTarget) {
+            int cx = static_cast<int>(target.cx), cy = static_cast<int>(target.cy), r = cfg.detectorRoi;
+            detector.setRoi(cx - r, cy - r, cx + r + 1, cy + r + 1);
+        } else {
+            detector.clearRoi();
+        }
+    }
+    int64_t start = monotonicNs();
+    vision::BlobList blobs;
+    if (!detector.detect(frame, blobs)) return;
+    blobs.captureNs = frame.captureNs;
+    blobs.frameId = frame.id;
+    blobRing.push(blobs);
+
+    if (blobTopic.isOpen()) {
+        ipc::BlobList out;
+        out.captureNs = blobs.captureNs;
+        out.detectNs = blobs.detectNs;
+        out.frameId = blobs.frameId;
+        out.count = std::min(blobs.count, ipc::kMaxBlobs);
+        out.width = static_cast<uint16_t>(frame.width);
+        out.height = static_cast<uint16_t>(frame.height);
+        for (int i = 0; i < out.count; i++) {
+            const vision::Blob& b = blobs.blobs[i];
+            ipc::Blob& o = out.blobs[i];
+            o.cx = b.cx;
+            o.cy = b.cy;
+            o.area = b.area;
+            o.x0 = b.x0;
+            o.y0 = b.y0;
+            o.x1 = b.x1;
+            o.y1 = b.y1;
+        }
+        blobTopic.publish(out);
+    }
+
+    if (visionLog) {
+        // 面积最大的两个
+        flight::DetectionRecord d = flight::DetectionRecord();
+        d.captureNs = blobs.captureNs;
+        d.frameId = blobs.frameId;
+        d.count = blobs.count;
+        int best[2] = {-1, -1};
+        for (int i = 0; i < blobs.count; i++) {
+            if (best[0] < 0 || blobs.blobs[i].area > blobs.blobs[best[0]].area) {
+                best[1] = best[0];
+                best[0] = i;
+            } else if (best[1] < 0 || blobs.blobs[i].area > blobs.blobs[best[1]].area) {
+                best[1] = i;
+            }
+        }
+        for (int k = 0; k < 2 && best[k] >= 0; k++) {
+            d.cx[k] = blobs.blobs[best[k]].cx;
+            d.cy[k] = blobs.blobs[best[k]].cy;
+            d.area[k] = blobs.blobs[best[k]].area;
+        }
+        visionLog->detection(blobs.detectNs, 0, d);
+    }
+
+    if (governed) {
+        visionThermal.poll();
+        if (governor.update(blobs.detectNs, blobs.detectNs - start, visionThermal.value()) && visionLog) {
+            char text[40];
+            std::snprintf(text, sizeof(text), "quality %d", governor.level());
+            visionLog->text(blobs.detectNs, 0, text);
+        }
+    }
+    if (governed || cfg.detectorRoi > 0) {
+        const vision::Blob* b = blobs.largest();
+        hasTarget = b != nullptr;
+        if (b) target = *b;
+    }
+}
+
+void GuidanceRuntime::thermalCycle(int64_t) {
+    vision::ThermalSample s;
+    if (thermal->read(s)) thermalSlot.write(s);
+}
+
+void GuidanceRuntime::ahrsCycle(int64_t now) {
+    guidance::AhrsState s;
+    if (!ahrs->poll(s)) return;
+    s.tNs = now;
+    ahrsSlot.write(s);
+}
+
+void GuidanceRuntime::imuCycle(int64_t now) {
+    guidance::ImuState& state = imuState;
+    // 来源失效 (总线断开、全部器件失效、话题停止更新) 时不更新心跳，持续失效由看门狗触发舵面回中；
+    // 只是还没有新样本 (话题比本任务慢) 时照常算作运行
+    sensor::SensorStatus st = imu->read(state.gyro, state.accel);
+    if (st != sensor::SENSOR_OK) {
+        if (st != sensor::SENSOR_NO_DATA) imuTask->stalled();
+        return;
+    }
+    // 记录原始读数，离线调滤波器时可以重放
+    if (imuLog) imuLog->imu(now, 0, state.gyro, state.accel);
+    if (imuPeakTracking && imuPeak.feed(state.gyro)) {
+        for (int i = 0; i < imuFilter.size(); i++) {
+            const imufilter::StageConfig& s = imuFilter.stage(i);
+            if (s.harmonic > 0) imuFilter.retune(i, s.harmonic * imuPeak.peakHz());
+        }
+    }
+    if (imuFilter.size()) imuFilter.process(state.gyro, state.accel);
+
+    // 每个样本都进预积分；姿态由累计四元数换算，不再逐轴累加小角度
+    imuPreint.add(now, state.gyro, state.accel);
+    float yaw, pitch;
+    preint::yawPitch(imuPreint.snapshot(), yaw, pitch);
+    yawUnwrapped += std::remainder(yaw - lastYaw, 2.0f * static_cast<float>(M_PI));
+    lastYaw = yaw;
+    state.tNs = now;
+    state.yawRate = state.gyro[2];
+    state.pitchRate = state.gyro[1];
+    state.yaw = yawUnwrapped + yawTrim;
+    state.pitch = pitch + pitchTrim;
+
+    // 有 AHRS 时用其绝对姿态缓慢修正陀螺积分漂移
+    uint32_t v = imuAhrs.poll();
+    if (v != 0 && v != ahrsSeen) {
+        const guidance::AhrsState& a = imuAhrs.value();
+        ahrsSeen = v;
+        float ahrsYaw = std::atan2(2.0f * (a.w * a.z + a.x * a.y), 1.0f - 2.0f * (a.y * a.y + a.z * a.z));
+        float ahrsPitch = std::asin(std::max(-1.0f, std::min(1.0f, 2.0f * (a.w * a.y - a.z * a.x))));
+        float dy = 0.02f * std::remainder(ahrsYaw - state.yaw, 2.0f * static_cast<float>(M_PI));
+        float dp = 0.02f * (ahrsPitch - state.pitch);
+        yawTrim += dy;
+        pitchTrim += dp;
+        state.yaw += dy;
+        state.pitch += dp;
+    }
+    imuSlot.write(state);
+}
+
+namespace {
+
+// 用本周期内的预积分角增量换算平均角速度，代替最后一个样本的瞬时值 (不受振动混叠)
+void applyIntervalRates(preint::Reader& r, guidance::ImuState& s) {
+    preint::Delta d;
+    if (!r.fetch(d) || d.t1Ns <= d.t0Ns) return;
+    float inv = 1.0f / d.seconds();
+    s.yawRate = d.dTheta[2] * inv;
+    s.pitchRate = d.dTheta[1] * inv;
+}
+
+} // namespace
+
+void GuidanceRuntime::fusionCycle(int64_t) {
+    fusionImu.poll();
+    guidance::ImuState s = fusionImu.value();
+    applyIntervalRates(fusionPreint, s);
+    vision::BlobList blobs;
+    while (blobRing.pop(blobs)) {
+        TRACE_ZONE("track update");
+        if (fusion.process(blobs, s, fusionSnap)) trackSlot.write(fusionSnap);
+    }
+}
+
+void GuidanceRuntime::servoCycle(int64_t now) {
+    float angles[servo::kServoCount] = {0, 0, 0, 0};
+    servoImu.poll();
+    guidance::ImuState s = servoImu.value();
+    applyIntervalRates(servoPreint, s);
+    bool written = servoTrack.poll() != 0;
+    const guidance::TrackSnapshot& snap = servoTrack.value();
+    bool tracking = written && failsafeCount.load() == 0 &&
+                    control.compute(snap, s, now, angles);
+    for (int i = 0; i < servo::kServoCount; i++) {
+        setpoints[i].store(angles[i], std::memory_order_relaxed);
+    }
+    loop.step(cfg.servoTask.periodNs * 1e-9f);
+    if (servoLog) {
+        flight::ServoRecord r;
+        for (int i = 0; i < servo::kServoCount; i++) {
+            r.angle[i] = loop.angle(i);
+            r.pulseUs[i] = static_cast<uint16_t>(loop.pulse(i));
+        }
+        servoLog->servo(now, 0, r);
+    }
+    if (servoTopic.isOpen()) {
+        ipc::ServoSetpoint sp;
+        sp.tNs = now;
+        for (int i = 0; i < servo::kServoCount; i++) {
+            sp.angle[i] = angles[i];
+            sp.pulseUs[i] = static_cast<uint16_t>(loop.pulse(i));
+        }
+        sp.tracking = tracking ? 1 : 0;
+        servoTopic.publish(sp);
+    }
+
+    // 某次曝光第一次影响舵面输出时记录各级延迟
+    if (tracking && snap.lastCaptureNs != lastServoCapture) {
+        int64_t committed = monotonicNs();
+        lastServoCapture = snap.lastCaptureNs;
+        hops.captureToDetect.add(snap.lastDetectNs - snap.lastCaptureNs);
+        hops.detectToFusion.add(snap.fusedNs - snap.lastDetectNs);
+        hops.fusionToServo.add(committed - snap.fusedNs);
+        hops.captureToServo.add(committed - snap.lastCaptureNs);
+    }
+}
+
+void GuidanceRuntime::printStats() const {
+    for (auto& t : tasks) t->printStats();
+    hops.print();
+    std::printf("servo commit %llu skip %llu fail %llu, blob drop %u\n",
+                static_cast<unsigned long long>(bank.commits()),
+                static_cast<unsigned long long>(bank.skipped()),
+                static_cast<unsigned long long>(bank.failures()), blobRing.droppedCount());
+    if (imu) {
+        std::printf("imu preint %llu samples, %llu gaps\n",
+                    static_cast<unsigned long long>(imuPreint.snapshot().samples),
+                    static_cast<unsigned long long>(imuPreint.gapCount()));
+    }
+    if (imuPeakTracking) {
+        std::printf("imu vibration peak %.1f Hz (snr %.1f, %llu updates)\n", imuPeak.peakHz(), imuPeak.snr(),
+                    static_cast<unsigned long long>(imuPeak.updates()));
+    }
+    if (governed) {
+        std::printf("quality level %d of %d, %u changes (budget %lld us)\n", governor.level(), governor.levelCount(),
+                    governor.changes(), static_cast<long long>(governor.budgetNs() / 1000));
+    }
+}
@@ -0,0 +1,135 @@
+#include "image_convert.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace vision {
+
+namespace {
+
+uint8_t clamp8(float v) {
+    return static_cast<uint8_t>(std::min(255.0f, std::max(0.0f, std::round(v))));
+}
+
+// 2x2 单元内红、蓝的位置：0 左上，1 右上，2 左下，3 右下
+void bayerSites(BayerOrder order, int& red, int& blue) {
+    static const int sites[][2] = {{0, 3}, {3, 0}, {1, 2}, {2, 1}};
+    red = sites[order][0];
+    blue = sites[order][1];
+}
+
+void putRaw10(uint8_t* row, PixelFormat format, int x, int v) {
+    if (format == PIXEL_BAYER10) {
+        row[x * 2] = static_cast<uint8_t>(v & 0xFF);
+        row[x * 2 + 1] = static_cast<uint8_t>(v >> 8);
+    } else {
+        uint8_t* group = row + (x / 4) * 5;
+        int k = x % 4;
+        group[k] = static_cast<uint8_t>(v >> 2);
+        group[4] = static_cast<uint8_t>((group[4] & ~(3 << (k * 2))) | ((v & 3) << (k * 2)));
+    }
+}
+
+int getRaw10(const uint8_t* row, PixelFormat format, int x) {
+    if (format == PIXEL_BAYER10) return row[x * 2] | (row[x * 2 + 1] << 8);
+    const uint8_t* group = row + (x / 4) * 5;
+    int k = x % 4;
+    return (group[k] << 2) | ((group[4] >> (k * 2)) & 3);
+}
+
+} // namespace
+
+void bgrToI420(const uint8_t* bgr, int bgrStride, int width, int height, uint8_t* i420, int yStride) {
+    int cStride = yStride / 2;
+    uint8_t* yPlane = i420;
+    uint8_t* uPlane = i420 + static_cast<size_t>(yStride) * height;
+    uint8_t* vPlane = uPlane + static_cast<size_t>(cStride) * (height / 2);
+
+    for (int y = 0; y < height; y += 2) {
+        for (int x = 0; x < width; x += 2) {
+            float sumU = 0.0f, sumV = 0.0f;
+            for (int dy = 0; dy < 2; dy++) {
+                for (int dx = 0; dx < 2; dx++) {
+                    const uint8_t* p = bgr + static_cast<size_t>(y + dy) * bgrStride + (x + dx) * 3;
+                    float b = p[0], g = p[1], r = p[2];
+                    float luma = 0.299f * r + 0.587f * g + 0.114f * b;
+                    yPlane[static_cast<size_t>(y + dy) * yStride + x + dx] = clamp8(luma);
+                    sumU += 0.564f * (b - luma);
+                    sumV += 0.713f * (r - luma);
+                }
+            }
+            size_t c = static_cast<size_t>(y / 2) * cStride + x / 2;
+            uPlane[c] = clamp8(128.0f + sumU * 0.25f);
+            vPlane[c] = clamp8(128.0f + sumV * 0.25f);
+        }
+    }
+}
+
+void i420ToBgr(const uint8_t* i420, int yStride, int width, int height, uint8_t* bgr, int bgrStride) {
+    int cStride = yStride / 2;
+    const uint8_t* yPlane = i420;
+    const uint8_t* uPlane = i420 + static_cast<size_t>(yStride) * height;
+    const uint8_t* vPlane = uPlane + static_cast<size_t>(cStride) * (height / 2);
+
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            size_t c = static_cast<size_t>(y / 2) * cStride + x / 2;
+            float luma = yPlane[static_cast<size_t>(y) * yStride + x];
+            float u = uPlane[c] - 128.0f, v = vPlane[c] - 128.0f;
+            uint8_t* p = bgr + static_cast<size_t>(y) * bgrStride + x * 3;
+            p[0] = clamp8(luma + 1.772f * u);
+            p[1] = clamp8(luma - 0.344136f * u - 0.714136f * v);
+            p[2] = clamp8(luma + 1.402f * v);
+        }
+    }
+}
+
+void bgrToBayer10(const uint8_t* bgr, int bgrStride, int width, int height, PixelFormat format, BayerOrder order,
+                  float redGain, float blueGain, uint8_t* raw, int rawStride) {
+    int red, blue;
+    bayerSites(order, red, blue);
+    for (int y = 0; y < height; y++) {
+        const uint8_t* src = bgr + static_cast<size_t>(y) * bgrStride;
+        uint8_t* row = raw + static_cast<size_t>(y) * rawStride;
+        for (int x = 0; x < width; x++) {
+            int site = (y & 1) * 2 + (x & 1);
+            float v;
+            if (site == red) {
+                v = src[x * 3 + 2] / redGain;
+            } else if (site == blue) {
+                v = src[x * 3] / blueGain;
+            } else {
+                v = src[x * 3 + 1];
+            }
+            putRaw10(row, format, x, static_cast<int>(std::min(1023.0f, std::round(v * 4.0f))));
+        }
+    }
+}
+
+void bayer10ToBgr(const uint8_t* raw, int rawStride, int width, int height, PixelFormat format, BayerOrder order,
+                  float redGain, float blueGain, uint8_t* bgr, int bgrStride) {
+    int red, blue;
+    bayerSites(order, red, blue);
+    for (int y = 0; y < height; y += 2) {
+        const uint8_t* rows[2] = {raw + static_cast<size_t>(y) * rawStride, raw + static_cast<size_t>(y + 1) * rawStride};
+        for (int x = 0; x < width; x += 2) {
+            int q[4];
+            for (int site = 0; site < 4; site++) q[site] = getRaw10(rows[site / 2], format, x + (site & 1)) >> 2;
+            int g = 0;
+            for (int site = 0; site < 4; site++) {
+                if (site != red && site != blue) g += q[site];
+            }
+            uint8_t b8 = clamp8(q[blue] * blueGain), g8 = static_cast<uint8_t>((g + 1) / 2), r8 = clamp8(q[red] * redGain);
+            for (int dy = 0; dy < 2; dy++) {
+                for (int dx = 0; dx < 2; dx++) {
+                    uint8_t* p = bgr + static_cast<size_t>(y + dy) * bgrStride + (x + dx) * 3;
+                    p[0] = b8;
+                    p[1] = g8;
+                    p[2] = r8;
+                }
+            }
+        }
+    }
+}
+
+} // namespace vision
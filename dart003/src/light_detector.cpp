@@ -0,0 +1,828 @@
+#include "light_detector.hpp"
+#include "rt_clock.hpp"
+#include "simd_u8.hpp"
+#include "trace_zone.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace vision {
+
+namespace {
+
+// 逐像素判别；在各循环里作为局部变量使用，写掩码时编译器不必重新读取成员
+struct PixelRule {
+    const ColorClassifier* lut;
+    bool simple;
+    int thr, rDiff, bDiff;
+
+    bool operator()(int b, int g, int r) const {
+        return simple ? g > thr && g - r > rDiff && g - b > bDiff : lut->match(b, g, r);
+    }
+};
+
+} // namespace
+
+const Blob* BlobList::largest() const {
+    const Blob* best = nullptr;
+    for (int i = 0; i < count; i++) {
+        if (!best || blobs[i].area > best->area) best = &blobs[i];
+    }
+    return best;
+}
+
+BlobLabeler::BlobLabeler(int width, int height) : width(width), height(height), stripeCount(0) {
+    size_t maxRuns = static_cast<size_t>((width + 1) / 2) * height;
+    runX0.resize(maxRuns);
+    runX1.resize(maxRuns);
+    runY.resize(maxRuns);
+    parent.resize(maxRuns);
+    sumX.resize(maxRuns);
+    sumY.resize(maxRuns);
+    area.resize(maxRuns);
+    bx0.resize(maxRuns);
+    by0.resize(maxRuns);
+    bx1.resize(maxRuns);
+    by1.resize(maxRuns);
+    roots.resize(maxRuns);
+    slot.assign(maxRuns, -1);
+    above.resize(maxRuns);
+    below.resize(maxRuns);
+}
+
+int32_t BlobLabeler::find(int32_t i) {
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+// 根节点取较小的下标，即光栅顺序上最早的行程
+void BlobLabeler::unite(int32_t a, int32_t b) {
+    a = find(a);
+    b = find(b);
+    if (a == b) return;
+    if (a < b) parent[b] = a;
+    else parent[a] = b;
+}
+
+bool BlobLabeler::rasterBefore(int32_t a, int32_t b) const {
+    return runY[a] != runY[b] ? runY[a] < runY[b] : runX0[a] < runX0[b];
+}
+
+void BlobLabeler::label(const uint8_t* mask, int stride, int y0, int y1, int minArea, BlobList& out) {
+    begin();
+    addRect(0, mask, stride, 0, width, y0, y1);
+    finish(minArea, out);
+}
+
+// 条带 s 最多有 ((width + 1) / 2) * 行数 个行程，按条带顺序分配下标区间
+void BlobLabeler::begin(const int* rowStarts, int stripes) {
+    const int full[2] = {0, height};
+    if (!rowStarts) {
+        rowStarts = full;
+        stripes = 1;
+    }
+    stripeCount = std::min(stripes, static_cast<int>(kMaxStripes));
+    int32_t base = 0;
+    for (int s = 0; s < stripeCount; s++) {
+        stripeRow[s] = rowStarts[s];
+        stripeBegin[s] = stripeEnd[s] = base;
+        base += static_cast<int32_t>((width + 1) / 2) * (rowStarts[s + 1] - rowStarts[s]);
+    }
+    stripeRow[stripeCount] = rowStarts[stripeCount];
+}
+
+void BlobLabeler::addRect(int stripe, const uint8_t* mask, int stride, int x0, int x1, int y0, int y1) {
+    int32_t n = stripeEnd[stripe];
+    int32_t prevBegin = n, prevEnd = n;
+
+    for (int y = y0; y < y1; y++) {
+        const uint8_t* row = mask + static_cast<size_t>(y) * stride;
+        int32_t rowBegin = n;
+        int32_t p = prevBegin;
+        int x = x0;
+        while (x < x1) {
+            // 背景占绝大多数，按 8 字节跳过
+            if (x + 8 <= x1) {
+                uint64_t word;
+                std::memcpy(&word, row + x, sizeof(word));
+                if (word == 0) {
+                    x += 8;
+                    continue;
+                }
+            }
+            if (!row[x]) {
+                x++;
+                continue;
+            }
+            int xs = x;
+            while (x < x1 && row[x]) x++;
+
+            runX0[n] = static_cast<int16_t>(xs);
+            runX1[n] = static_cast<int16_t>(x);
+            runY[n] = static_cast<int16_t>(y);
+            parent[n] = n;
+
+            // 上一行中与 [xs-1, x] 相交的行程属于同一连通域
+            while (p < prevEnd && runX1[p] < xs) p++;
+            for (int32_t q = p; q < prevEnd && runX0[q] <= x; q++) unite(n, q);
+            n++;
+        }
+        prevBegin = rowBegin;
+        prevEnd = n;
+    }
+    stripeEnd[stripe] = n;
+}
+
+// 条带边界上下两行的行程按 x 排序后，与条带内相同的方式连接
+void BlobLabeler::mergeStripes() {
+    for (int s = 0; s + 1 < stripeCount; s++) {
+        int boundary = stripeRow[s + 1];
+        int32_t na = 0, nb = 0;
+        for (int32_t i = stripeBegin[s]; i < stripeEnd[s]; i++) {
+            if (runY[i] == boundary - 1) above[na++] = i;
+        }
+        for (int32_t i = stripeBegin[s + 1]; i < stripeEnd[s + 1]; i++) {
+            if (runY[i] == boundary) below[nb++] = i;
+        }
+        if (na == 0 || nb == 0) continue;
+
+        auto byX = [this](int32_t a, int32_t b) { return runX0[a] < runX0[b]; };
+        std::sort(above.begin(), above.begin() + na, byX);
+        std::sort(below.begin(), below.begin() + nb, byX);
+        int32_t p = 0;
+        for (int32_t k = 0; k < nb; k++) {
+            int32_t q = below[k];
+            while (p < na && runX1[above[p]] < runX0[q]) p++;
+            for (int32_t j = p; j < na && runX0[above[j]] <= runX1[q]; j++) unite(q, above[j]);
+        }
+    }
+}
+
+void BlobLabeler::finish(int minArea, BlobList& out, const uint8_t* weights, int weightStride, int weightBytes) {
+    mergeStripes();
+
+    // 根节点是下标最小的行程，总在其子节点之前出现，按条带顺序一遍完成累加
+    int32_t rootCount = 0;
+    for (int s = 0; s < stripeCount; s++)
+    for (int32_t i = stripeBegin[s]; i < stripeEnd[s]; i++) {
+        int32_t r = find(i);
+        int32_t len = runX1[i] - runX0[i];
+        int64_t sx = static_cast<int64_t>(runX0[i] + runX1[i] - 1) * len / 2;
+        if (r == i) {
+            sumX[i] = sx;
+            sumY[i] = static_cast<int64_t>(runY[i]) * len;
+            area[i] = len;
+            bx0[i] = runX0[i];
+            bx1[i] = static_cast<int16_t>(runX1[i] - 1);
+            by0[i] = by1[i] = runY[i];
+            roots[rootCount++] = i;
+        } else {
+            sumX[r] += sx;
+            sumY[r] += static_cast<int64_t>(runY[i]) * len;
+            area[r] += len;
+            bx0[r] = std::min(bx0[r], runX0[i]);
+            bx1[r] = std::max(bx1[r], static_cast<int16_t>(runX1[i] - 1));
+            by1[r] = std::max(by1[r], runY[i]);
+        }
+    }
+
+    // 根节点是连通域的第一个行程；分块标记时下标顺序不是光栅顺序，按行程坐标排序
+    int32_t kept = 0;
+    for (int32_t k = 0; k < rootCount; k++) {
+        if (area[roots[k]] >= minArea) roots[kept++] = roots[k];
+    }
+    if (kept > kMaxBlobs) {
+        std::nth_element(roots.begin(), roots.begin() + kMaxBlobs, roots.begin() + kept, [this](int32_t a, int32_t b) {
+            return area[a] != area[b] ? area[a] > area[b] : rasterBefore(a, b);
+        });
+        kept = kMaxBlobs;
+    }
+    std::sort(roots.begin(), roots.begin() + kept, [this](int32_t a, int32_t b) { return rasterBefore(a, b); });
+
+    out.count = kept;
+    for (int32_t k = 0; k < kept; k++) {
+        int32_t r = roots[k];
+        Blob& b = out.blobs[k];
+        b.area = area[r];
+        b.cx = static_cast<float>(static_cast<double>(sumX[r]) / area[r]);
+        b.cy = static_cast<float>(static_cast<double>(sumY[r]) / area[r]);
+        b.x0 = bx0[r];
+        b.y0 = by0[r];
+        b.x1 = bx1[r];
+        b.y1 = by1[r];
+    }
+    if (!weights) return;
+
+    // 加权质心：再扫一遍行程，只累加保留的连通域
+    int64_t wSum[kMaxBlobs] = {}, wX[kMaxBlobs] = {}, wY[kMaxBlobs] = {};
+    for (int32_t k = 0; k < kept; k++) slot[roots[k]] = static_cast<int8_t>(k);
+    for (int s = 0; s < stripeCount; s++)
+    for (int32_t i = stripeBegin[s]; i < stripeEnd[s]; i++) {
+        int k = slot[find(i)];
+        if (k < 0) continue;
+        const uint8_t* row = weights + static_cast<size_t>(runY[i]) * weightStride;
+        int64_t rowSum = 0;
+        for (int x = runX0[i]; x < runX1[i]; x++) {
+            const uint8_t* p = row + static_cast<size_t>(x) * weightBytes;
+            int w = 0;
+            for (int c = 0; c < weightBytes; c++) w += p[c];
+            rowSum += w;
+            wX[k] += static_cast<int64_t>(w) * x;
+        }
+        wSum[k] += rowSum;
+        wY[k] += rowSum * runY[i];
+    }
+    for (int32_t k = 0; k < kept; k++) {
+        slot[roots[k]] = -1;
+        if (wSum[k] == 0) continue;
+        out.blobs[k].cx = static_cast<float>(static_cast<double>(wX[k]) / wSum[k]);
+        out.blobs[k].cy = static_cast<float>(static_cast<double>(wY[k]) / wSum[k]);
+    }
+}
+
+LightDetector::LightDetector(int width, int height, const GreenRule& rule, const DetectorOptions& options)
+    : width(width), height(height), rule(rule), opts(options),
+      maskBuf(static_cast<size_t>(width) * height), labeler(width, height),
+      classifier(ColorClassifier::green(rule.greenThreshold, rule.minRbDiff, rule.minRbDiff)),
+      retunedSeen(0), retunedScratch(classifier),
+      tilesX((width + kTileSize - 1) / kTileSize), tilesY((height + kTileSize - 1) / kTileSize),
+      tileFlags(static_cast<size_t>(tilesX) * tilesY), tileCount(0), dirtyX0(0), dirtyY0(0), dirtyX1(0),
+      dirtyY1(0), roiX0(0), roiY0(0), roiX1(width), roiY1(height), colX0(0), colX1(width), activeStripes(0),
+      blockCount(0),
+      quadMask(static_cast<size_t>(width / 2) * (height / 2)), rowTop(width), rowBottom(width),
+      quadLabeler(width / 2, height / 2) {
+    simpleRule = classifier.simple(thr, rDiff, bDiff);
+    configure();
+}
+
+void LightDetector::setRule(const GreenRule& r) {
+    rule = r;
+    setClassifier(ColorClassifier::green(r.greenThreshold, r.minRbDiff, r.minRbDiff));
+}
+
+void LightDetector::setClassifier(const ColorClassifier& c) {
+    classifier = c;
+    simpleRule = classifier.simple(thr, rDiff, bDiff);
+}
+
+// 写者 (SIGHUP 后的主线程) 是普通调度，可能在写到一半时被检测线程抢占；有限次读取，读不到下一帧再试
+void LightDetector::pollRetune() {
+    if (retuned.version() == retunedSeen) return;
+    uint32_t v;
+    if (!retuned.tryRead(retunedScratch, v)) return;
+    retunedSeen = v;
+    setClassifier(retunedScratch);
+}
+
+void LightDetector::setOptions(const DetectorOptions& o) {
+    opts = o;
+    configure();
+}
+
+void LightDetector::setRoi(int x0, int y0, int x1, int y1) {
+    x0 = std::max(0, x0);
+    y0 = std::max(0, y0);
+    x1 = std::min(width, x1);
+    y1 = std::min(height, y1);
+    if (x0 >= x1 || y0 >= y1) {
+        clearRoi();
+        return;
+    }
+    roiX0 = x0;
+    roiY0 = y0;
+    roiX1 = x1;
+    roiY1 = y1;
+}
+
+void LightDetector::clearRoi() {
+    roiX0 = roiY0 = 0;
+    roiX1 = width;
+    roiY1 = height;
+}
+
+// 条带缓冲按整帧一次分配，区域变化时每帧重新切分不用再分配
+void LightDetector::configure() {
+    int n = std::max(1, std::min(std::min(opts.threads, tilesY), static_cast<int>(BlobLabeler::kMaxStripes)));
+    // 要丢弃的条带还记着上一帧的候选块，先清掉
+    for (Stripe& st : stripes) clearMask(st);
+    stripes.resize(n);
+    size_t tileSlots = static_cast<size_t>(tilesX) * tilesY;
+    for (Stripe& st : stripes) {
+        st.tiles.resize(tileSlots);
+        st.stack.resize(tileSlots);
+        st.regions.reserve(tileSlots * 4);
+        st.candidate.resize(width / 2);
+        st.tileCount = 0;
+        st.blockCount = 0;
+    }
+    if (n > 1 && (!pool || pool->size() < n)) pool.reset(new WorkerPool(n - 1, "detect"));
+    tileCount = 0;
+}
+
+// 清掉上一帧写过的掩码，再把区域的块行按线程数切分；清理在切分前串行完成，所以条带划分每帧可以不同
+// x 范围对齐到 16 像素，SIMD 粗检的 48 字节块正好从块边界开始
+void LightDetector::beginFrame() {
+    for (Stripe& st : stripes) clearMask(st);
+    for (int y = dirtyY0; y < dirtyY1; y++) {
+        std::memset(&maskBuf[static_cast<size_t>(y) * width + dirtyX0], 0, dirtyX1 - dirtyX0);
+    }
+    dirtyY0 = dirtyY1 = 0;
+
+    colX0 = roiX0 / 16 * 16;
+    colX1 = std::min(width, (roiX1 + 15) / 16 * 16);
+    int ty0 = roiY0 / kTileSize, ty1 = (roiY1 + kTileSize - 1) / kTileSize;
+    int n = std::min(static_cast<int>(stripes.size()), ty1 - ty0);
+    for (int s = 0; s < n; s++) {
+        Stripe& st = stripes[s];
+        st.ty0 = ty0 + s * (ty1 - ty0) / n;
+        st.ty1 = ty0 + (s + 1) * (ty1 - ty0) / n;
+        st.y0 = st.ty0 * kTileSize;
+        st.y1 = std::min(height, st.ty1 * kTileSize);
+        stripeRows[s] = st.y0;
+    }
+    stripeRows[n] = stripes[n - 1].y1;
+    activeStripes = n;
+    labeler.begin(stripeRows, n);
+}
+
+// fn(stripe, index) 在各条带上并行执行；交给线程池的闭包只带两个指针，不会分配内存
+template <class Fn> void LightDetector::runStripes(const Fn& fn) {
+    TRACE_ZONE("threshold+label");
+    int n = activeStripes;
+    if (n == 1) {
+        fn(stripes[0], 0);
+    } else {
+        pool->run(n, [this, &fn](int s) { fn(stripes[s], s); });
+    }
+    tileCount = 0;
+    for (int s = 0; s < n; s++) tileCount += stripes[s].tileCount;
+}
+
+// 清掉条带上一帧写过的候选块
+void LightDetector::clearMask(Stripe& st) {
+    for (int32_t k = 0; k < st.tileCount; k++) {
+        int tx = st.tiles[k] % tilesX, ty = st.tiles[k] / tilesX;
+        int x0 = tx * kTileSize, x1 = std::min(width, x0 + kTileSize);
+        int y0 = ty * kTileSize, y1 = std::min(height, y0 + kTileSize);
+        for (int y = y0; y < y1; y++) std::memset(&maskBuf[static_cast<size_t>(y) * width + x0], 0, x1 - x0);
+    }
+    st.tileCount = 0;
+}
+
+void LightDetector::detectBgr(const uint8_t* bgr, int stride, BlobList& out) {
+    pollRetune();
+    if (opts.subsample > 1) {
+        subsampleBgr(bgr, stride, out);
+        return;
+    }
+    beginFrame();
+    if (opts.tiled) {
+        runStripes([this, bgr, stride](Stripe& st, int s) {
+            coarseBgr(bgr, stride, st);
+            collectTiles(st);
+            fineBgr(bgr, stride, st);
+            labelTiles(st, s);
+        });
+    } else {
+        const PixelRule test{&classifier, simpleRule, thr, rDiff, bDiff};
+        runStripes([&](Stripe& st, int s) {
+            for (int y = st.y0; y < st.y1; y++) {
+                const uint8_t* px = bgr + static_cast<size_t>(y) * stride;
+                uint8_t* m = &maskBuf[static_cast<size_t>(y) * width];
+                for (int x = colX0; x < colX1; x++) {
+                    int b = px[x * 3], g = px[x * 3 + 1], r = px[x * 3 + 2];
+                    m[x] = test(b, g, r) ? 255 : 0;
+                }
+            }
+            st.tileCount = 0;
+            labeler.addRect(s, maskBuf.data(), width, colX0, colX1, st.y0, st.y1);
+        });
+        dirtyX0 = colX0;
+        dirtyX1 = colX1;
+        dirtyY0 = stripes[0].y0;
+        dirtyY1 = stripes[activeStripes - 1].y1;
+    }
+    {
+        TRACE_ZONE("blob finish");
+        labeler.finish(rule.minArea, out, opts.refine ? bgr : nullptr, stride, 3);
+    }
+    out.detectNs = monotonicNs();
+}
+
+// 粗检：每行求出哪些 8 像素段里有满足判据的像素，按行 OR 进 8x8 块标志
+// SIMD 按字节处理打包 BGR：第 i 字节为 g 时，i-1 是 b、i+1 是 r，判据变成
+//   min(g -sat thr, (g -sat r) -sat diff, (g -sat b) -sat diff) != 0
+// 只保留 g 所在的字节；48 字节 = 16 像素 = 2 个块
+// 查表的判据在 SIMD 下改用外接盒：每个字节先换成“在本通道范围内”(1/0)，g 字节与前后两个字节取 min，
+// 盒外的像素一定不满足，所以仍是必要条件；没有 SIMD 时逐块查表到第一个满足的像素为止
+void LightDetector::coarseBgr(const uint8_t* bgr, int stride, Stripe& st) {
+    const PixelRule test{&classifier, simpleRule, thr, rDiff, bDiff};
+    std::fill(tileFlags.begin() + static_cast<size_t>(st.ty0) * tilesX,
+              tileFlags.begin() + static_cast<size_t>(st.ty1) * tilesX, 0);
+
+#if SIMD_U8_AVAILABLE
+    const bool vectorized = width % 16 == 0;
+    static const struct GreenLanes {
+        uint8_t lane[3][16];
+        uint8_t low[16], high[16];
+        GreenLanes() {
+            for (int i = 0; i < 48; i++) lane[i / 16][i % 16] = (i % 3 == 1) ? 0xFF : 0;
+            for (int i = 0; i < 16; i++) {
+                low[i] = i < 8 ? 0xFF : 0;
+                high[i] = i < 8 ? 0 : 0xFF;
+            }
+        }
+    } lanes;
+    const simd::U8x16 vThr = simd::splat(static_cast<uint8_t>(thr));
+    const simd::U8x16 vDiffR = simd::splat(static_cast<uint8_t>(rDiff));
+    const simd::U8x16 vDiffB = simd::splat(static_cast<uint8_t>(bDiff));
+    const simd::U8x16 g0 = simd::load(lanes.lane[0]), g1 = simd::load(lanes.lane[1]), g2 = simd::load(lanes.lane[2]);
+    const simd::U8x16 lowHalf = simd::load(lanes.low), highHalf = simd::load(lanes.high);
+    const int rowBegin = colX0 * 3, rowEnd = colX1 * 3;
+
+    auto pass = [&](simd::U8x16 v, simd::U8x16 prev, simd::U8x16 next) {
+        simd::U8x16 b = simd::shiftInPrev(v, prev), r = simd::shiftInNext(v, next);
+        simd::U8x16 gr = simd::subs(simd::subs(v, r), vDiffR);
+        simd::U8x16 gb = simd::subs(simd::subs(v, b), vDiffB);
+        return simd::min(simd::subs(v, vThr), simd::min(gr, gb));
+    };
+
+    uint8_t lo[3], hi[3], laneLo[3][16], laneHi[3][16];
+    classifier.bounds(lo, hi);
+    for (int i = 0; i < 48; i++) {
+        laneLo[i / 16][i % 16] = lo[i % 3];
+        laneHi[i / 16][i % 16] = hi[i % 3];
+    }
+    const simd::U8x16 one = simd::splat(1);
+    const simd::U8x16 lo0 = simd::load(laneLo[0]), lo1 = simd::load(laneLo[1]), lo2 = simd::load(laneLo[2]);
+    const simd::U8x16 hi0 = simd::load(laneHi[0]), hi1 = simd::load(laneHi[1]), hi2 = simd::load(laneHi[2]);
+    auto inBox = [&](simd::U8x16 v, simd::U8x16 l, simd::U8x16 h) {
+        return simd::subs(one, simd::bitOr(simd::subs(l, v), simd::subs(v, h)));
+    };
+    auto boxPass = [&](simd::U8x16 v, simd::U8x16 prev, simd::U8x16 next) {
+        return simd::min(v, simd::min(simd::shiftInPrev(v, prev), simd::shiftInNext(v, next)));
+    };
+#endif
+
+    for (int y = st.y0; y < st.y1; y++) {
+        const uint8_t* px = bgr + static_cast<size_t>(y) * stride;
+        uint8_t* flags = &tileFlags[static_cast<size_t>(y / kTileSize) * tilesX];
+
+#if SIMD_U8_AVAILABLE
+        if (vectorized && !simpleRule) {
+            simd::U8x16 prev = simd::zero();
+            simd::U8x16 v0 = inBox(simd::load(px + rowBegin), lo0, hi0);
+            for (int o = rowBegin; o < rowEnd; o += 48) {
+                simd::U8x16 v1 = inBox(simd::load(px + o + 16), lo1, hi1);
+                simd::U8x16 v2 = inBox(simd::load(px + o + 32), lo2, hi2);
+                simd::U8x16 next = o + 48 < rowEnd ? inBox(simd::load(px + o + 48), lo0, hi0) : simd::zero();
+                simd::U8x16 p0 = simd::bitAnd(boxPass(v0, prev, v1), g0);
+                simd::U8x16 p1 = simd::bitAnd(boxPass(v1, v0, v2), g1);
+                simd::U8x16 p2 = simd::bitAnd(boxPass(v2, v1, next), g2);
+                int tx = o / 24;
+                flags[tx] |= simd::any(simd::bitOr(p0, simd::bitAnd(p1, lowHalf)));
+                flags[tx + 1] |= simd::any(simd::bitOr(simd::bitAnd(p1, highHalf), p2));
+                prev = v2;
+                v0 = next;
+            }
+            continue;
+        }
+        if (vectorized) {
+            simd::U8x16 prev = simd::zero();
+            simd::U8x16 v0 = simd::load(px + rowBegin);
+            for (int o = rowBegin; o < rowEnd; o += 48) {
+                simd::U8x16 v1 = simd::load(px + o + 16), v2 = simd::load(px + o + 32);
+                simd::U8x16 next = o + 48 < rowEnd ? simd::load(px + o + 48) : simd::zero();
+                simd::U8x16 p0 = simd::bitAnd(pass(v0, prev, v1), g0);
+                simd::U8x16 p1 = simd::bitAnd(pass(v1, v0, v2), g1);
+                simd::U8x16 p2 = simd::bitAnd(pass(v2, v1, next), g2);
+                int tx = o / 24;
+                flags[tx] |= simd::any(simd::bitOr(p0, simd::bitAnd(p1, lowHalf)));
+                flags[tx + 1] |= simd::any(simd::bitOr(simd::bitAnd(p1, highHalf), p2));
+                prev = v2;
+                v0 = next;
+            }
+            continue;
+        }
+#endif
+        // 已经是候选的块不用再看
+        for (int tx = colX0 / kTileSize; tx < (colX1 + kTileSize - 1) / kTileSize; tx++) {
+            if (flags[tx]) continue;
+            for (int x = tx * kTileSize; x < std::min(colX1, (tx + 1) * kTileSize); x++) {
+                int b = px[x * 3], g = px[x * 3 + 1], r = px[x * 3 + 2];
+                if (test(b, g, r)) {
+                    flags[tx] = 1;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+void LightDetector::collectTiles(Stripe& st) {
+    st.tileCount = 0;
+    for (int32_t i = st.ty0 * tilesX; i < st.ty1 * tilesX; i++) {
+        if (tileFlags[i]) st.tiles[st.tileCount++] = i;
+    }
+}
+
+// 细检：候选块内逐像素写掩码
+void LightDetector::fineBgr(const uint8_t* bgr, int stride, Stripe& st) {
+    const PixelRule test{&classifier, simpleRule, thr, rDiff, bDiff};
+    for (int32_t k = 0; k < st.tileCount; k++) {
+        int tx = st.tiles[k] % tilesX, ty = st.tiles[k] / tilesX;
+        int x0 = tx * kTileSize, x1 = std::min(width, x0 + kTileSize);
+        int y0 = ty * kTileSize, y1 = std::min(height, y0 + kTileSize);
+        for (int y = y0; y < y1; y++) {
+            const uint8_t* px = bgr + static_cast<size_t>(y) * stride;
+            uint8_t* m = &maskBuf[static_cast<size_t>(y) * width];
+            for (int x = x0; x < x1; x++) {
+                int b = px[x * 3], g = px[x * 3 + 1], r = px[x * 3 + 2];
+                m[x] = test(b, g, r) ? 255 : 0;
+            }
+        }
+    }
+}
+
+// 候选块按 8 邻域分成连通区域，每个区域的外接矩形单独标记
+// 前景像素只在候选块内，相邻的候选块落在同一区域，所以连通域不会跨区域；
+// 外接矩形重叠的区域合并，保证每个像素只被扫描一次
+// 区域不跨条带，跨条带的连通域由标记器在 finish() 时连接
+void LightDetector::labelTiles(Stripe& st, int index) {
+    std::vector<int16_t>& regions = st.regions;
+    regions.clear();
+    for (int32_t k = 0; k < st.tileCount; k++) {
+        int32_t seed = st.tiles[k];
+        if (tileFlags[seed] != 1) continue;
+        tileFlags[seed] = 2;
+        int32_t top = 0;
+        st.stack[top++] = seed;
+        int16_t rx0 = static_cast<int16_t>(seed % tilesX), ry0 = static_cast<int16_t>(seed / tilesX);
+        int16_t rx1 = rx0, ry1 = ry0;
+        while (top > 0) {
+            int32_t t = st.stack[--top];
+            int tx = t % tilesX, ty = t / tilesX;
+            rx0 = std::min<int16_t>(rx0, static_cast<int16_t>(tx));
+            rx1 = std::max<int16_t>(rx1, static_cast<int16_t>(tx));
+            ry0 = std::min<int16_t>(ry0, static_cast<int16_t>(ty));
+            ry1 = std::max<int16_t>(ry1, static_cast<int16_t>(ty));
+            for (int ny = std::max(st.ty0, ty - 1); ny <= std::min(st.ty1 - 1, ty + 1); ny++) {
+                for (int nx = std::max(0, tx - 1); nx <= std::min(tilesX - 1, tx + 1); nx++) {
+                    int32_t ni = ny * tilesX + nx;
+                    if (tileFlags[ni] == 1) {
+                        tileFlags[ni] = 2;
+                        st.stack[top++] = ni;
+                    }
+                }
+            }
+        }
+        int16_t box[4] = {rx0, ry0, rx1, ry1};
+        regions.insert(regions.end(), box, box + 4);
+    }
+
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (size_t i = 0; i < regions.size() && !merged; i += 4) {
+            for (size_t j = i + 4; j < regions.size(); j += 4) {
+                if (regions[i] > regions[j + 2] || regions[j] > regions[i + 2] || regions[i + 1] > regions[j + 3] ||
+                    regions[j + 1] > regions[i + 3]) {
+                    continue;
+                }
+                regions[i] = std::min(regions[i], regions[j]);
+                regions[i + 1] = std::min(regions[i + 1], regions[j + 1]);
+                regions[i + 2] = std::max(regions[i + 2], regions[j + 2]);
+                regions[i + 3] = std::max(regions[i + 3], regions[j + 3]);
+                regions.erase(regions.begin() + j, regions.begin() + j + 4);
+                merged = true;
+                break;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < regions.size(); i += 4) {
+        labeler.addRect(index, maskBuf.data(), width, regions[i] * kTileSize,
+                        std::min(width, (regions[i + 2] + 1) * kTileSize), regions[i + 1] * kTileSize,
+                        std::min(height, (regions[i + 3] + 1) * kTileSize));
+    }
+}
+
+// 色度换算见 chromaOffsets()。简单绿色判据下 g - r、g - b 只取决于色度，2x2 块共用；截断到 [0, 255]
+// 只会缩小这两个差值，所以不截断的色度判别（留 1 个灰度的舍入余量）是必要条件；
+// 查表的判据用色度单元预筛表。候选块内再逐像素按 BGR 判据细化
+void LightDetector::detectI420(const uint8_t* yPlane, int yStride, const uint8_t* uPlane, const uint8_t* vPlane,
+                               int cStride, BlobList& out) {
+    pollRetune();
+    if (opts.subsample > 1) {
+        subsampleI420(yPlane, yStride, uPlane, vPlane, cStride, out);
+        return;
+    }
+    beginFrame();
+    runStripes([&](Stripe& st, int s) {
+        i420Stripe(yPlane, yStride, uPlane, vPlane, cStride, st);
+        collectTiles(st);
+        if (opts.tiled) {
+            labelTiles(st, s);
+        } else {
+            labeler.addRect(s, maskBuf.data(), width, colX0, colX1, st.y0, st.y1);
+        }
+    });
+    blockCount = 0;
+    for (int s = 0; s < activeStripes; s++) blockCount += stripes[s].blockCount;
+    {
+        TRACE_ZONE("blob finish");
+        labeler.finish(rule.minArea, out, opts.refine ? yPlane : nullptr, yStride, 1);
+    }
+    out.detectNs = monotonicNs();
+}
+
+void LightDetector::i420Stripe(const uint8_t* yPlane, int yStride, const uint8_t* uPlane, const uint8_t* vPlane,
+                               int cStride, Stripe& st) {
+    const PixelRule test{&classifier, simpleRule, thr, rDiff, bDiff};
+    const int limitR = (rDiff - 1) * 1024, limitB = (bDiff - 1) * 1024;
+    const int cx0 = colX0 / 2, cx1 = colX1 / 2;
+
+    std::fill(tileFlags.begin() + static_cast<size_t>(st.ty0) * tilesX,
+              tileFlags.begin() + static_cast<size_t>(st.ty1) * tilesX, 0);
+    st.blockCount = 0;
+
+    uint8_t* cand = st.candidate.data();
+    for (int by = st.y0 / 2; by < st.y1 / 2; by++) {
+        const uint8_t* ur = uPlane + static_cast<size_t>(by) * cStride;
+        const uint8_t* vr = vPlane + static_cast<size_t>(by) * cStride;
+        if (simpleRule) {
+            for (int bx = cx0; bx < cx1; bx++) {
+                int u = ur[bx] - 128, v = vr[bx] - 128;
+                int gr = -(352 * u + 2167 * v);
+                int gb = -(2167 * u + 731 * v);
+                cand[bx] = (gr > limitR) & (gb > limitB);
+            }
+        } else {
+            for (int bx = cx0; bx < cx1; bx++) cand[bx] = classifier.chromaPossible(ur[bx], vr[bx]);
+        }
+
+        for (int bx = cx0; bx < cx1; bx++) {
+            if (!cand[bx]) continue;
+            int rOff, gOff, bOff;
+            chromaOffsets(ur[bx] - 128, vr[bx] - 128, rOff, gOff, bOff);
+
+            st.blockCount++;
+            tileFlags[static_cast<size_t>(by * 2 / kTileSize) * tilesX + bx * 2 / kTileSize] = 1;
+            for (int dy = 0; dy < 2; dy++) {
+                const uint8_t* yr = yPlane + static_cast<size_t>(by * 2 + dy) * yStride + bx * 2;
+                uint8_t* m = &maskBuf[static_cast<size_t>(by * 2 + dy) * width + bx * 2];
+                for (int dx = 0; dx < 2; dx++) {
+                    int luma = yr[dx];
+                    int r = std::min(255, std::max(0, luma + rOff));
+                    int g = std::min(255, std::max(0, luma + gOff));
+                    int b = std::min(255, std::max(0, luma + bOff));
+                    m[dx] = test(b, g, r) ? 255 : 0;
+                }
+            }
+        }
+    }
+}
+
+namespace {
+
+// 取一行 10 位原始数据的高 8 位
+void decodeRaw8(const uint8_t* row, PixelFormat format, int width, uint8_t* out) {
+    if (format == PIXEL_BAYER10P) {
+        // MIPI RAW10：每组前 4 字节就是 4 个像素的高 8 位，第 5 字节是低 2 位
+        for (int x = 0; x < width; x += 4, row += 5) {
+            out[x] = row[0];
+            out[x + 1] = row[1];
+            out[x + 2] = row[2];
+            out[x + 3] = row[3];
+        }
+    } else {
+        for (int x = 0; x < width; x++) out[x] = static_cast<uint8_t>((row[x * 2] | (row[x * 2 + 1] << 8)) >> 2);
+    }
+}
+
+} // namespace
+
+void LightDetector::detectBayer(const uint8_t* raw, int stride, PixelFormat format, BayerOrder order,
+                                BlobList& out) {
+    pollRetune();
+    const PixelRule test{&classifier, simpleRule, thr, rDiff, bDiff};
+    const int redGain = static_cast<int>(rule.rawRedGain * 256.0f + 0.5f);
+    const int blueGain = static_cast<int>(rule.rawBlueGain * 256.0f + 0.5f);
+    const int qw = width / 2;
+    int qx0, qy0, qx1, qy1;
+    quadRange(qx0, qy0, qx1, qy1);
+
+    // 2x2 单元内红、蓝、两个绿的位置：0 左上，1 右上，2 左下，3 右下
+    static const int sites[][4] = {{0, 3, 1, 2}, {3, 0, 1, 2}, {1, 2, 0, 3}, {2, 1, 0, 3}};
+    const int* site = sites[order];
+
+    for (int qy = qy0; qy < qy1; qy++) {
+        decodeRaw8(raw + static_cast<size_t>(qy * 2) * stride, format, width, rowTop.data());
+        decodeRaw8(raw + static_cast<size_t>(qy * 2 + 1) * stride, format, width, rowBottom.data());
+        const uint8_t* rows[2] = {rowTop.data(), rowBottom.data()};
+        uint8_t* m = &quadMask[static_cast<size_t>(qy) * qw];
+        for (int qx = qx0; qx < qx1; qx++) {
+            int x = qx * 2;
+            int r = (rows[site[0] >> 1][x + (site[0] & 1)] * redGain) >> 8;
+            int b = (rows[site[1] >> 1][x + (site[1] & 1)] * blueGain) >> 8;
+            int g = (rows[site[2] >> 1][x + (site[2] & 1)] + rows[site[3] >> 1][x + (site[3] & 1)] + 1) >> 1;
+            m[qx] = test(b, g, r) ? 255 : 0;
+        }
+    }
+
+    labelQuads(qx0, qy0, qx1, qy1, out);
+}
+
+void LightDetector::quadRange(int& qx0, int& qy0, int& qx1, int& qy1) const {
+    qx0 = roiX0 / 2;
+    qy0 = roiY0 / 2;
+    qx1 = std::min(width / 2, (roiX1 + 1) / 2);
+    qy1 = std::min(height / 2, (roiY1 + 1) / 2);
+}
+
+void LightDetector::labelQuads(int qx0, int qy0, int qx1, int qy1, BlobList& out) {
+    quadLabeler.begin();
+    quadLabeler.addRect(0, quadMask.data(), width / 2, qx0, qx1, qy0, qy1);
+    quadLabeler.finish(std::max(1, (rule.minArea + 3) / 4), out);
+
+    // 单元 i 覆盖全分辨率像素 2i、2i+1，中心为 2i + 0.5
+    for (int k = 0; k < out.count; k++) {
+        Blob& b = out.blobs[k];
+        b.cx = b.cx * 2.0f + 0.5f;
+        b.cy = b.cy * 2.0f + 0.5f;
+        b.area *= 4;
+        b.x0 = static_cast<int16_t>(b.x0 * 2);
+        b.y0 = static_cast<int16_t>(b.y0 * 2);
+        b.x1 = static_cast<int16_t>(b.x1 * 2 + 1);
+        b.y1 = static_cast<int16_t>(b.y1 * 2 + 1);
+    }
+    out.detectNs = monotonicNs();
+}
+
+// 隔行隔列取样：每个 2x2 单元只判别左上角像素，半分辨率的掩码和标记与 Bayer 路径共用
+void LightDetector::subsampleBgr(const uint8_t* bgr, int stride, BlobList& out) {
+    const PixelRule test{&classifier, simpleRule, thr, rDiff, bDiff};
+    const int qw = width / 2;
+    int qx0, qy0, qx1, qy1;
+    quadRange(qx0, qy0, qx1, qy1);
+    for (int qy = qy0; qy < qy1; qy++) {
+        const uint8_t* px = bgr + static_cast<size_t>(qy * 2) * stride;
+        uint8_t* m = &quadMask[static_cast<size_t>(qy) * qw];
+        for (int qx = qx0; qx < qx1; qx++) {
+            const uint8_t* p = px + qx * 6;
+            m[qx] = test(p[0], p[1], p[2]) ? 255 : 0;
+        }
+    }
+    tileCount = 0;
+    labelQuads(qx0, qy0, qx1, qy1, out);
+}
+
+// 色度正好是半分辨率，每个单元取左上角亮度
+void LightDetector::subsampleI420(const uint8_t* yPlane, int yStride, const uint8_t* uPlane, const uint8_t* vPlane,
+                                  int cStride, BlobList& out) {
+    const PixelRule test{&classifier, simpleRule, thr, rDiff, bDiff};
+    const int qw = width / 2;
+    int qx0, qy0, qx1, qy1;
+    quadRange(qx0, qy0, qx1, qy1);
+    for (int qy = qy0; qy < qy1; qy++) {
+        const uint8_t* yr = yPlane + static_cast<size_t>(qy * 2) * yStride;
+        const uint8_t* ur = uPlane + static_cast<size_t>(qy) * cStride;
+        const uint8_t* vr = vPlane + static_cast<size_t>(qy) * cStride;
+        uint8_t* m = &quadMask[static_cast<size_t>(qy) * qw];
+        for (int qx = qx0; qx < qx1; qx++) {
+            int rOff, gOff, bOff;
+            chromaOffsets(ur[qx] - 128, vr[qx] - 128, rOff, gOff, bOff);
+            int luma = yr[qx * 2];
+            int r = std::min(255, std::max(0, luma + rOff));
+            int g = std::min(255, std::max(0, luma + gOff));
+            int b = std::min(255, std::max(0, luma + bOff));
+            m[qx] = test(b, g, r) ? 255 : 0;
+        }
+    }
+    tileCount = 0;
+    blockCount = 0;
+    labelQuads(qx0, qy0, qx1, qy1, out);
+}
+
+bool LightDetector::detect(const Frame& frame, BlobList& out) {
+    TRACE_ZONE("detect");
+    if (frame.width != width || frame.height != height) return false;
+    switch (frame.format) {
+    case PIXEL_BGR24:
+        detectBgr(frame.data, frame.stride, out);
+        return true;
+    case PIXEL_I420:
+        detectI420(frame.data, frame.stride, frame.planeU(), frame.planeV(), frame.stride / 2, out);
+        return true;
+    case PIXEL_BAYER10:
+    case PIXEL_BAYER10P:
+        detectBayer(frame.data, frame.stride, frame.format, frame.bayer, out);
+        return true;
+    }
+    return false;
+}
+
+} // namespace vision
@@ -1,29 +1,258 @@
+#include "bmi088.h"
+#include "bmi088_sensor.h"
+#include "bno080_sensor.hpp"
+#include "frame_source.hpp"
+#include "guidance.hpp"
+#include "guidance_runtime.hpp"
+#include "pose_estimation.hpp"
+#include "rt_memory.hpp"
+#include "rt_clock.hpp"
+#include "runtime_config.hpp"
+#include "servo_controller.hpp"
+#include "shm_topic.hpp"
+#include "spi_bus.hpp"
+#include "trace_zone.hpp"
+
 #include <pigpio.h>
 #include <thread>
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
 #include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+std::atomic<bool> stopRequested(false);
+std::atomic<bool> reloadRequested(false);
+
+void onSignal(int) {
+    stopRequested = true;
+}
 
-std::atomic<float> servo_angle[4];
+void onReload(int) {
+    reloadRequested = true;
+}
 
-int servoPins[4] = {17, 18, 22, 23};
+// bmi088_reader 发布的 IMU 话题 -> ImuSource。发布周期通常比 IMU 任务长，没有新样本时为 SENSOR_NO_DATA；
+// 最近的样本 (或打开以来一直没有样本) 超过 maxAgeNs 时为 SENSOR_FAULT
+class TopicImuSource : public guidance::ImuSource {
+public:
+    explicit TopicImuSource(int64_t maxAgeNs) : maxAgeNs(maxAgeNs), lastNs(0) {}
 
-void servoController() {
-    gpioInitialise();
-    while (true) {
-        int pulseWidth = 1500;
-        for (int pin : servoPins) {
-            gpioServo(pin, pulseWidth);
+    bool open(std::string& err) {
+        lastNs = monotonicNs();
+        return topic.open(ipc::kImuTopic, err);
+    }
+
+    sensor::SensorStatus read(float (&gyro)[3], float (&accel)[3]) override {
+        ipc::ImuSample s;
+        if (!topic.poll(s)) return monotonicNs() - lastNs > maxAgeNs ? sensor::SENSOR_FAULT : sensor::SENSOR_NO_DATA;
+        lastNs = std::max(lastNs, s.tNs);
+        if (monotonicNs() - s.tNs > maxAgeNs) return sensor::SENSOR_FAULT;
+        for (int i = 0; i < 3; i++) {
+            gyro[i] = s.gyro[i];
+            accel[i] = s.accel[i];
         }
-        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        return sensor::SENSOR_OK;
+    }
+
+private:
+    ipc::LatestReader<ipc::ImuSample> topic;
+    int64_t maxAgeNs;
+    int64_t lastNs;                      // 最近一个样本的采样时刻
+};
+
+int main(int argc, char** argv) {
+    const char* configPath = argc > 1 ? argv[1] : "guidance.conf";
+    RuntimeConfig cfg;
+    std::string err;
+    // 加载失败时 cfg 已被部分改写，不是默认配置，其中可能正是被拒绝的值；不带着它起飞
+    if (!loadRuntimeConfig(configPath, cfg, err)) {
+        std::cerr << err << std::endl;
+        return 1;
     }
-    gpioTerminate();
-}
 
-int main() {
-    // std::thread spiThread(spiReadLoop);
-    std::thread servoThread(servoController);
+    // 在创建任何线程和大缓冲区之前锁定，之后分配的页也一起锁住
+    if (cfg.memoryLock && !rtmem::lockMemory(err)) {
+        std::cerr << err << std::endl;
+    }
+
+    // 禁止 pigpio 接管 SIGINT/SIGTERM，退出前由本程序负责回中
+    gpioCfgSetInternals(gpioCfgGetInternals() | PI_CFG_NOSIGHANDLER);
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    std::signal(SIGHUP, onReload);
+
+    // 舵机组和 BMI088 总线各持有一份 pigpio 引用，最后关闭的一方才终止 pigpio
+    servo::PigpioWaveBackend servoBackend;
+    servo::ServoBank bank(servoBackend, cfg.servoBank);
+    if (!bank.open()) {
+        std::cerr << "pigpio 初始化失败" << std::endl;
+        return -1;
+    }
+
+    // 传感器；使用调度器时 BMI088 和 BNO080 都经它访问 spidev
+    spibus::SpidevBackend spiBackend;
+    std::unique_ptr<spibus::SpiBus> spi;
+    int imuClient = -1, ahrsClient = -1;
+    if (cfg.spiScheduler) {
+        spi.reset(new spibus::SpiBus(spiBackend));
+        imuClient = spi->addClient("imu", cfg.spiImuPriority);
+        ahrsClient = spi->addClient("ahrs", cfg.spiAhrsPriority);
+    }
+
+    std::unique_ptr<Bmi088Bus> imuBus;
+    std::vector<std::unique_ptr<BMI088>> bmi;
+    std::unique_ptr<guidance::ImuSource> imu;
+    if (cfg.imuEnabled && cfg.ipcImu) {
+        std::unique_ptr<TopicImuSource> topic(new TopicImuSource(cfg.ipcImuMaxAgeMs * 1000000LL));
+        if (!topic->open(err)) {
+            std::cerr << err << std::endl;
+            return 1;
+        }
+        imu.reset(topic.release());
+    } else if (cfg.imuEnabled) {
+        std::vector<BMI088*> units;
+        try {
+            if (spi) {
+                std::unique_ptr<ScheduledBmi088Bus> scheduled(new ScheduledBmi088Bus(*spi, imuClient));
+                for (const ImuUnitConfig& u : cfg.imuUnits) {
+                    spibus::DeviceConfig g, a;
+                    g.name = "bmi088 gyro";
+                    g.path = u.gyroDevice;
+                    g.speedHz = cfg.imuSpiBaud;
+                    a = g;
+                    a.name = "bmi088 accel";
+                    a.path = u.accelDevice;
+                    int gd = spi->addDevice(g, err), ad = gd < 0 ? -1 : spi->addDevice(a, err);
+                    if (ad < 0) throw std::runtime_error(err);
+                    scheduled->mapCs(u.csGyro, gd);
+                    scheduled->mapCs(u.csAccel, ad);
+                }
+                imuBus.reset(scheduled.release());
+            } else {
+                imuBus.reset(new PigpioBmi088Bus(cfg.imuSpiChannel, cfg.imuSpiBaud, 0));
+            }
+            for (const ImuUnitConfig& u : cfg.imuUnits) {
+                bmi.emplace_back(new BMI088(*imuBus, u.csGyro, u.csAccel, static_cast<unsigned>(cfg.imuOdrHz)));
+                units.push_back(bmi.back().get());
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "[ERROR] " << e.what() << std::endl;
+            return 1;
+        }
+        std::unique_ptr<guidance::SensorImuSource<Bmi088ArraySensor>> source(
+            new guidance::SensorImuSource<Bmi088ArraySensor>(units, cfg.imuAlign));
+        if (spi) source->get().reserveOn(*spi, imuClient, cfg.imuTask.periodNs, cfg.spiGuardUs * 1000LL);
+        imu.reset(source.release());
+    }
 
-    // spiThread.join();
-    servoThread.join();
+    std::unique_ptr<BNO080_SPI> bno;
+    std::unique_ptr<guidance::SensorAhrsSource<Bno080Sensor>> ahrs;
+    if (cfg.ahrsEnabled) {
+        if (spi) {
+            spibus::DeviceConfig d;
+            d.name = "bno080";
+            d.path = cfg.ahrsDevice;
+            d.speedHz = cfg.ahrsSpeedHz;
+            d.mode = static_cast<uint8_t>(cfg.ahrsMode);
+            int dev = spi->addDevice(d, err);
+            if (dev >= 0) {
+                bno.reset(new BNO080_SPI(*spi, dev, ahrsClient));
+            } else {
+                std::cerr << err << std::endl;
+            }
+        } else {
+            bno.reset(new BNO080_SPI(cfg.ahrsDevice.c_str(), cfg.ahrsSpeedHz));
+        }
+        if (bno) {
+            uint32_t intervalUs = static_cast<uint32_t>(cfg.ahrsTask.periodNs / 1000);
+            ahrs.reset(new guidance::SensorAhrsSource<Bno080Sensor>(*bno, intervalUs));
+            if (!ahrs->get().open(err)) {
+                std::cerr << err << "，关闭 AHRS" << std::endl;
+                ahrs.reset();
+            }
+        }
+    }
+
+    std::unique_ptr<vision::FrameSource> camera;
+    bool raw = cfg.camera.format == vision::PIXEL_BAYER10 || cfg.camera.format == vision::PIXEL_BAYER10P;
+    if (cfg.cameraEnabled && raw) {
+        camera.reset(new vision::V4l2BayerFrameSource(cfg.camera));
+    }
+#ifdef HAVE_RASPICAM
+    else if (cfg.cameraEnabled) {
+        camera.reset(new vision::RaspicamFrameSource(cfg.camera));
+    }
+#else
+    else if (cfg.cameraEnabled) {
+        std::cerr << "未编译 raspicam 支持，视觉任务关闭" << std::endl;
+    }
+#endif
+    if (camera && !camera->open()) {
+        std::cerr << "无法打开摄像头!" << std::endl;
+        camera.reset();
+    }
+
+    vision::SysfsThermalSource thermal(cfg.thermalTempPath, cfg.thermalFreqPath);
+    GuidanceRuntime runtime(cfg, bank, camera.get(), imu.get(), ahrs.get(), &thermal);
+    if (!runtime.begin()) {
+        std::cerr << "舵机组初始化失败" << std::endl;
+        return -1;
+    }
+    flight::FlightRecorder recorder;
+    if (cfg.recorderEnabled) {
+        // 上面的 mlockall(MCL_FUTURE) 不锁整个记录文件映射，只锁写入窗口
+        if (cfg.memoryLock) recorder.lockWindow(static_cast<size_t>(cfg.recorderLockWindowKb) << 10);
+        if (recorder.open(cfg.recorderPath, static_cast<size_t>(cfg.recorderCapacityMb) << 20, err)) {
+            runtime.attachRecorder(recorder);
+            recorder.start();
+        } else {
+            std::cerr << err << "，不记录飞行数据" << std::endl;
+        }
+    }
+    if (cfg.ipcPublish && !runtime.openTopics(err)) {
+        std::cerr << err << "，不发布进程间话题" << std::endl;
+    }
+    runtime.start();
+
+    while (!stopRequested) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        vision::QualityEvent qe;
+        while (runtime.pollQualityEvent(qe)) vision::printQualityEvent(qe);
+
+        // SIGHUP：重新读取配置，只有颜色判据在运行中生效，其余改动需要重启
+        if (reloadRequested.exchange(false)) {
+            RuntimeConfig fresh;
+            if (loadRuntimeConfig(configPath, fresh, err)) {
+                runtime.retuneDetector(fresh.classifier);
+                std::cerr << "已重新加载颜色判据" << std::endl;
+            } else {
+                std::cerr << err << "，保持原判据" << std::endl;
+            }
+        }
+    }
+
+    runtime.stop();
+    runtime.end();
+    if (camera) camera->close();
+    runtime.printStats();
+    if (spi) spi->printStats();
+    if (trace::kEnabled) {
+        long n = trace::dumpChromeJson(cfg.tracePath);
+        if (n < 0) std::cerr << "无法写入 " << cfg.tracePath << std::endl;
+        else std::printf("trace %s: %ld events\n", cfg.tracePath.c_str(), n);
+    }
+    if (recorder.isOpen()) {
+        recorder.close();
+        std::printf("flight log %s: %llu records, %llu bytes, dropped %llu, lost %llu\n", cfg.recorderPath.c_str(),
+                    static_cast<unsigned long long>(recorder.recordCount()),
+                    static_cast<unsigned long long>(recorder.bytesWritten()),
+                    static_cast<unsigned long long>(recorder.droppedCount()),
+                    static_cast<unsigned long long>(recorder.lostCount()));
+    }
     return 0;
 }
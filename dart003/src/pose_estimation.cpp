@@ -1,3 +1,7 @@
+#include "pose_estimation.hpp"
+#include "spi_bus.hpp"
+#include "trace_zone.hpp"
+
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/ioctl.h>
@@ -5,149 +9,152 @@
 #include <cstring>
 #include <iostream>
 #include <cerrno>
-#include <vector>
-#include <thread>
-#include <chrono>
-
-// BNO080 SPI接口类（简化）
-class BNO080_SPI {
-public:
-    BNO080_SPI(const char* device = "/dev/spidev0.0", uint32_t speed = 1000000)
-        : fd(-1), spi_speed(speed) {
-        strncpy(spi_device, device, sizeof(spi_device));
-        spi_device[sizeof(spi_device)-1] = '\0';
-    }
+#include <cstdio>
+
+BNO080_SPI::BNO080_SPI(const char* device, uint32_t speed)
+    : fd(-1), spi_speed(speed), bus(nullptr), busDevice(-1), busClient(-1), failed(0) {
+    strncpy(spi_device, device, sizeof(spi_device));
+    spi_device[sizeof(spi_device)-1] = '\0';
+    memset(txSeq, 0, sizeof(txSeq));
+}
+
+BNO080_SPI::BNO080_SPI(spibus::SpiBus& bus, int device, int client)
+    : fd(-1), spi_speed(bus.device(device).speedHz), bus(&bus), busDevice(device), busClient(client), failed(0) {
+    strncpy(spi_device, bus.device(device).path.c_str(), sizeof(spi_device));
+    spi_device[sizeof(spi_device)-1] = '\0';
+    memset(txSeq, 0, sizeof(txSeq));
+}
+
+BNO080_SPI::~BNO080_SPI() {
+    if (fd >= 0) close(fd);
+}
 
-    ~BNO080_SPI() {
-        if (fd >= 0) close(fd);
+bool BNO080_SPI::openDevice() {
+    if (bus) return true;
+    fd = open(spi_device, O_RDWR);
+    if (fd < 0) {
+        std::cerr << "Failed to open SPI device: " << spi_device << " Error: " << strerror(errno) << "\n";
+        return false;
     }
 
-    bool openDevice() {
-        fd = open(spi_device, O_RDWR);
-        if (fd < 0) {
-            std::cerr << "Failed to open SPI device: " << spi_device << " Error: " << strerror(errno) << "\n";
-            return false;
-        }
-
-        uint8_t mode = SPI_MODE_0;
-        if (ioctl(fd, SPI_IOC_WR_MODE, &mode) < 0) {
-            perror("Can't set SPI mode");
-            return false;
-        }
-
-        uint8_t bits = 8;
-        if (ioctl(fd, SPI_IOC_WR_BITS_PER_WORD, &bits) < 0) {
-            perror("Can't set bits per word");
-            return false;
-        }
-
-        if (ioctl(fd, SPI_IOC_WR_MAX_SPEED_HZ, &spi_speed) < 0) {
-            perror("Can't set max speed hz");
-            return false;
-        }
-
-        return true;
+    uint8_t mode = SPI_MODE_0;
+    if (ioctl(fd, SPI_IOC_WR_MODE, &mode) < 0) {
+        perror("Can't set SPI mode");
+        return false;
     }
 
-    // SPI 全双工传输
-    bool transfer(const uint8_t* tx_buf, uint8_t* rx_buf, size_t len) {
-        struct spi_ioc_transfer tr;
-        memset(&tr, 0, sizeof(tr));
-        tr.tx_buf = reinterpret_cast<uint64_t>(tx_buf);
-        tr.rx_buf = reinterpret_cast<uint64_t>(rx_buf);
-        tr.len = len;
-        tr.speed_hz = spi_speed;
-        tr.bits_per_word = 8;
-        tr.delay_usecs = 0;
-
-        int ret = ioctl(fd, SPI_IOC_MESSAGE(1), &tr);
-        if (ret < 1) {
-            perror("SPI transfer failed");
-            return false;
-        }
-        return true;
+    uint8_t bits = 8;
+    if (ioctl(fd, SPI_IOC_WR_BITS_PER_WORD, &bits) < 0) {
+        perror("Can't set bits per word");
+        return false;
     }
 
-    // 读取SHTP包头，返回包长度，通道号，序号
-    bool readHeader(uint16_t& length, uint8_t& channel, uint8_t& seq) {
-        uint8_t tx[4] = {0, 0, 0, 0};
-        uint8_t rx[4] = {0};
-        if (!transfer(tx, rx, 4)) return false;
+    if (ioctl(fd, SPI_IOC_WR_MAX_SPEED_HZ, &spi_speed) < 0) {
+        perror("Can't set max speed hz");
+        return false;
+    }
 
-        length = rx[0] | (rx[1] << 8);
-        channel = rx[2];
-        seq = rx[3];
+    return true;
+}
 
-        return true;
+bool BNO080_SPI::transfer(const uint8_t* tx_buf, uint8_t* rx_buf, size_t len) {
+    TRACE_ZONE("bno080 spi");
+    if (bus) {
+        // 头和包体分两次提交，中间允许 IMU 突发插进来
+        spibus::Transfer t = {busDevice, tx_buf, rx_buf, static_cast<uint32_t>(len)};
+        if (bus->submit(busClient, &t, 1)) return true;
+        failed++;
+        return false;
     }
+    struct spi_ioc_transfer tr;
+    memset(&tr, 0, sizeof(tr));
+    tr.tx_buf = reinterpret_cast<uint64_t>(tx_buf);
+    tr.rx_buf = reinterpret_cast<uint64_t>(rx_buf);
+    tr.len = len;
+    tr.speed_hz = spi_speed;
+    tr.bits_per_word = 8;
+    tr.delay_usecs = 0;
+
+    // 实时 AHRS 任务里调用，失败不打印，只计数，由 failedTransfers() / 传感器接口的 fault() 报告
+    int ret = ioctl(fd, SPI_IOC_MESSAGE(1), &tr);
+    if (ret < 1) {
+        failed++;
+        return false;
+    }
+    return true;
+}
 
-    // 读取包体数据
-    bool readPayload(uint8_t* buffer, size_t len) {
-        std::vector<uint8_t> tx(len, 0);
-        std::vector<uint8_t> rx(len, 0);
+bool BNO080_SPI::readHeader(uint16_t& length, uint8_t& channel, uint8_t& seq) {
+    uint8_t tx[4] = {0, 0, 0, 0};
+    uint8_t rx[4] = {0};
+    if (!transfer(tx, rx, 4)) return false;
 
-        if (!transfer(tx.data(), rx.data(), len)) return false;
+    // 最高位是续传标志，不属于长度
+    length = (rx[0] | (rx[1] << 8)) & 0x7FFF;
+    channel = rx[2];
+    seq = rx[3];
 
-        memcpy(buffer, rx.data(), len);
-        return true;
-    }
-
-private:
-    char spi_device[64];
-    int fd;
-    uint32_t spi_speed;
-};
+    return true;
+}
 
+// tx 为空时 spidev 发送全 0，直接收进调用者的缓冲区
+bool BNO080_SPI::readPayload(uint8_t* buffer, size_t len) {
+    return transfer(nullptr, buffer, len);
+}
 
-// 示例程序：解析SHTP数据包，打印内容
-int main() {
-    BNO080_SPI bno;
-    if (!bno.openDevice()) {
-        std::cerr << "Failed to open SPI device\n";
-        return -1;
-    }
+bool BNO080_SPI::sendPacket(uint8_t channel, const uint8_t* data, size_t len) {
+    uint8_t tx[64];
+    uint8_t rx[64];
+    if (len + 4 > sizeof(tx) || channel >= sizeof(txSeq)) return false;
+
+    uint16_t total = static_cast<uint16_t>(len + 4);
+    tx[0] = total & 0xFF;
+    tx[1] = total >> 8;
+    tx[2] = channel;
+    tx[3] = txSeq[channel]++;
+    memcpy(tx + 4, data, len);
+    return transfer(tx, rx, total);
+}
 
-    while (true) {
-        uint16_t length = 0;
-        uint8_t channel = 0;
-        uint8_t seq = 0;
-
-        // 读包头
-        if (!bno.readHeader(length, channel, seq)) {
-            std::cerr << "Failed to read header\n";
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
-            continue;
-        }
-
-        if (length == 0) {
-            // 没有数据，短暂等待
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
-            continue;
-        }
-
-        // 包长度包含头4字节，减去头部得到数据长度
-        uint16_t payload_len = length - 4;
-        std::vector<uint8_t> payload(payload_len);
-
-        if (!bno.readPayload(payload.data(), payload_len)) {
-            std::cerr << "Failed to read payload\n";
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
-            continue;
-        }
-
-        // 简单打印包信息
-        std::cout << "Packet from channel " << (int)channel << " seq " << (int)seq << " length " << length << " payload:";
-        for (auto b : payload) {
-            printf(" %02X", b);
-        }
-        std::cout << std::endl;
-
-        // TODO: 根据 channel 和 payload 解析具体传感器数据
-        // 例如：channel 2 通常是传感器报告，解析其格式
-
-        // 适当延时，避免一直满循环
-        std::this_thread::sleep_for(std::chrono::milliseconds(5));
-    }
+bool BNO080_SPI::enableReport(uint8_t reportId, uint32_t intervalUs) {
+    uint8_t cmd[17];
+    memset(cmd, 0, sizeof(cmd));
+    cmd[0] = SH2_SET_FEATURE_COMMAND;
+    cmd[1] = reportId;
+    cmd[5] = intervalUs & 0xFF;
+    cmd[6] = (intervalUs >> 8) & 0xFF;
+    cmd[7] = (intervalUs >> 16) & 0xFF;
+    cmd[8] = (intervalUs >> 24) & 0xFF;
+    return sendPacket(SHTP_CHANNEL_CONTROL, cmd, sizeof(cmd));
+}
 
-    return 0;
+bool BNO080_SPI::pollRotationVector(Quaternion& q) {
+    TRACE_ZONE("bno080 poll");
+    uint16_t length = 0;
+    uint8_t channel = 0;
+    uint8_t seq = 0;
+    if (!readHeader(length, channel, seq) || length <= 4) return false;
+
+    uint8_t payload[256];
+    uint16_t payload_len = length - 4;
+    if (payload_len > sizeof(payload)) payload_len = sizeof(payload);
+    if (!readPayload(payload, payload_len)) return false;
+
+    if (channel != SHTP_CHANNEL_REPORTS && channel != SHTP_CHANNEL_WAKE_REPORTS) return false;
+
+    // 0xFB 基准时间戳 (5 字节) 之后才是传感器报告
+    size_t off = 0;
+    if (payload_len >= 5 && payload[0] == SH2_BASE_TIMESTAMP) off = 5;
+    if (payload_len < off + 14) return false;
+
+    const uint8_t* r = payload + off;
+    if (r[0] != SH2_REPORT_ROTATION_VECTOR && r[0] != SH2_REPORT_GAME_ROTATION_VECTOR) return false;
+
+    // i, j, k, real 为 Q14 定点数
+    const float q14 = 1.0f / (1 << 14);
+    q.x = static_cast<int16_t>(r[4] | (r[5] << 8)) * q14;
+    q.y = static_cast<int16_t>(r[6] | (r[7] << 8)) * q14;
+    q.z = static_cast<int16_t>(r[8] | (r[9] << 8)) * q14;
+    q.w = static_cast<int16_t>(r[10] | (r[11] << 8)) * q14;
+    return true;
 }
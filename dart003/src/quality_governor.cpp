@@ -0,0 +1,277 @@
+#include "quality_governor.hpp"
+#include "rt_clock.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace vision {
+
+std::vector<QualityLevel> GovernorConfig::defaultLevels() {
+    std::vector<QualityLevel> v(5);
+    v[0].refine = true;
+    v[2].roiHalfSize = 96;
+    v[3].roiHalfSize = 96;
+    v[3].subsample = 2;
+    v[4].roiHalfSize = 48;
+    v[4].subsample = 2;
+    return v;
+}
+
+bool parseQualityLevels(const std::string& text, std::vector<QualityLevel>& levels, std::string& err) {
+    std::vector<QualityLevel> out;
+    std::stringstream all(text);
+    std::string item;
+    while (std::getline(all, item, ';')) {
+        std::stringstream fields(item);
+        std::string kv;
+        QualityLevel q;
+        bool any = false;
+        while (fields >> kv) {
+            size_t eq = kv.find('=');
+            std::string key = kv.substr(0, eq);
+            char* end = nullptr;
+            long v = eq == std::string::npos ? 0 : std::strtol(kv.c_str() + eq + 1, &end, 10);
+            if (eq == std::string::npos || *end || v < 0) {
+                err = "质量档位 \"" + kv + "\" 应为 键=非负整数";
+                return false;
+            }
+            if (key == "roi") q.roiHalfSize = static_cast<int>(v);
+            else if (key == "sub" && (v == 1 || v == 2)) q.subsample = static_cast<int>(v);
+            else if (key == "threads") q.threads = static_cast<int>(v);
+            else if (key == "refine") q.refine = v != 0;
+            else {
+                err = "质量档位 \"" + kv + "\"：只支持 roi、sub (1 或 2)、threads、refine";
+                return false;
+            }
+            any = true;
+        }
+        if (any) out.push_back(q);
+    }
+    if (out.empty()) {
+        err = "质量档位表为空";
+        return false;
+    }
+    levels.swap(out);
+    return true;
+}
+
+namespace {
+
+// 读整数形式的 sysfs 属性
+bool readSysfs(int fd, long& value) {
+    if (fd < 0) return false;
+    char buf[32];
+    ssize_t n = pread(fd, buf, sizeof(buf) - 1, 0);
+    if (n <= 0) return false;
+    buf[n] = 0;
+    value = std::strtol(buf, nullptr, 10);
+    return true;
+}
+
+} // namespace
+
+SysfsThermalSource::SysfsThermalSource(const std::string& tempPath, const std::string& freqPath)
+    : tempFd(::open(tempPath.c_str(), O_RDONLY)), freqFd(::open(freqPath.c_str(), O_RDONLY)) {}
+
+SysfsThermalSource::~SysfsThermalSource() {
+    if (tempFd >= 0) ::close(tempFd);
+    if (freqFd >= 0) ::close(freqFd);
+}
+
+bool SysfsThermalSource::read(ThermalSample& s) {
+    long milliC = 0, kHz = 0;
+    bool hasTemp = readSysfs(tempFd, milliC), hasFreq = readSysfs(freqFd, kHz);
+    s.tNs = monotonicNs();
+    s.tempC = hasTemp ? milliC / 1000.0f : 0.0f;
+    s.freqMHz = hasFreq ? kHz / 1000.0f : 0.0f;
+    return hasTemp || hasFreq;
+}
+
+bool TraceThermalSource::load(const std::string& path, std::string& err) {
+    std::ifstream in(path.c_str());
+    if (!in) {
+        err = "无法打开温度曲线 " + path;
+        return false;
+    }
+    std::vector<Point> pts;
+    std::string line;
+    int lineNo = 0;
+    while (std::getline(in, line)) {
+        lineNo++;
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#') continue;
+        Point p;
+        if (std::sscanf(line.c_str(), "%lf,%f,%f", &p.t, &p.tempC, &p.freqMHz) != 3 ||
+            (!pts.empty() && p.t <= pts.back().t)) {
+            err = path + " 第 " + std::to_string(lineNo) + " 行应为递增的 t_s,temp_c,freq_mhz";
+            return false;
+        }
+        pts.push_back(p);
+    }
+    if (pts.empty()) {
+        err = path + " 没有数据";
+        return false;
+    }
+    points.swap(pts);
+    originNs = 0;
+    return true;
+}
+
+TraceThermalSource TraceThermalSource::synthetic(double durationS) {
+    TraceThermalSource trace;
+    const int steps = 200;
+    const double heatEnd = durationS * 0.7;
+    bool throttled = false;
+    for (int i = 0; i <= steps; i++) {
+        Point p;
+        p.t = durationS * i / steps;
+        double temp = p.t < heatEnd ? 55.0 + 30.0 * p.t / heatEnd
+                                    : 85.0 - 30.0 * (1.0 - std::exp(-(p.t - heatEnd) / (durationS * 0.08)));
+        // 与固件一样带回差：80 度降频，75 度以下恢复
+        if (temp >= 80.0) throttled = true;
+        else if (temp < 75.0) throttled = false;
+        p.tempC = static_cast<float>(temp);
+        p.freqMHz = throttled ? 1000.0f : 1500.0f;
+        trace.points.push_back(p);
+    }
+    return trace;
+}
+
+void TraceThermalSource::at(double tS, ThermalSample& s) const {
+    s.tempC = s.freqMHz = 0.0f;
+    if (points.empty()) return;
+    size_t i = std::upper_bound(points.begin(), points.end(), tS, [](double t, const Point& p) { return t < p.t; }) -
+               points.begin();
+    if (i == 0) {
+        s.tempC = points[0].tempC;
+        s.freqMHz = points[0].freqMHz;
+    } else if (i == points.size()) {
+        s.tempC = points.back().tempC;
+        s.freqMHz = points.back().freqMHz;
+    } else {
+        const Point& a = points[i - 1];
+        const Point& b = points[i];
+        s.tempC = static_cast<float>(a.tempC + (b.tempC - a.tempC) * (tS - a.t) / (b.t - a.t));
+        s.freqMHz = a.freqMHz;
+    }
+}
+
+bool TraceThermalSource::read(ThermalSample& s) {
+    s.tNs = monotonicNs();
+    if (originNs == 0) originNs = s.tNs;
+    at((s.tNs - originNs) * 1e-9, s);
+    return !points.empty();
+}
+
+const char* qualityReasonName(int reason) {
+    static const char* names[] = {"deadline miss", "load", "thermal", "headroom"};
+    return reason >= 0 && reason < 4 ? names[reason] : "?";
+}
+
+void printQualityEvent(const QualityEvent& e) {
+    std::printf("quality %d -> %d (%s): %.0f us, %.1f C, %.0f MHz\n", e.from, e.to, qualityReasonName(e.reason),
+                e.costUs, e.tempC, e.freqMHz);
+}
+
+QualityGovernor::QualityGovernor(const GovernorConfig& config, int64_t frameDeadlineNs, const DetectorOptions& base)
+    : cfg(config), levels(config.levels.empty() ? GovernorConfig::defaultLevels() : config.levels), base(base),
+      deadline(config.deadlineNs > 0 ? config.deadlineNs : frameDeadlineNs),
+      budget(static_cast<int64_t>(deadline * config.budgetFraction)), current(0),
+      samples(std::max(1, config.window)), scratch(samples.size()), sampleCount(0), sampleNext(0),
+      levelCost(levels.size(), 0), nominalMHz(0.0f), framesAtLevel(0), idleFrames(0), changeCount(0) {}
+
+int64_t QualityGovernor::windowP90() {
+    std::copy(samples.begin(), samples.begin() + sampleCount, scratch.begin());
+    std::vector<int64_t>::iterator k = scratch.begin() + sampleCount * 9 / 10;
+    std::nth_element(scratch.begin(), k, scratch.begin() + sampleCount);
+    return *k;
+}
+
+bool QualityGovernor::update(int64_t nowNs, int64_t processNs, const ThermalSample& thermal) {
+    nominalMHz = std::max(nominalMHz, thermal.freqMHz);
+    // 当前频率 / 最高频率；频率未知时按 1
+    double speed = thermal.freqMHz > 0.0f && nominalMHz > 0.0f ? thermal.freqMHz / nominalMHz : 1.0;
+    samples[sampleNext] = static_cast<int64_t>(processNs * speed);
+    sampleNext = (sampleNext + 1) % static_cast<int>(samples.size());
+    sampleCount = std::min(sampleCount + 1, static_cast<int>(samples.size()));
+    framesAtLevel++;
+
+    bool settled = sampleCount * 2 >= static_cast<int>(samples.size());
+    int64_t p90Nominal = settled ? windowP90() : 0;
+    double p90 = p90Nominal / speed;
+    bool hot = thermal.tempC >= cfg.hotC;
+    bool throttled = speed < cfg.throttleRatio;
+    int last = static_cast<int>(levels.size()) - 1;
+
+    int reason = -1;
+    if (processNs > deadline) reason = QUALITY_MISS;
+    else if (settled && p90 > budget) reason = QUALITY_LOAD;
+    else if (hot && framesAtLevel >= cfg.holdFrames) reason = QUALITY_THERMAL;
+    if (reason >= 0) {
+        idleFrames = 0;
+        if (current == last || framesAtLevel < 2) return false;
+        // 因负载离开时记下这一档的耗时，之后据此判断能不能升回来
+        if (reason != QUALITY_THERMAL) {
+            levelCost[current] = std::max(p90Nominal, static_cast<int64_t>(processNs * speed));
+        }
+        change(nowNs, current + 1, reason, reason == QUALITY_MISS ? processNs : p90, thermal);
+        return true;
+    }
+
+    bool headroom = settled && p90 < budget * cfg.upFraction && thermal.tempC < cfg.coolC && !throttled;
+    if (current == 0 || !headroom) {
+        idleFrames = 0;
+        return false;
+    }
+    if (++idleFrames < cfg.holdFrames) return false;
+    int64_t known = levelCost[current - 1];
+    if (known > 0 && known / speed > budget * cfg.upFraction && idleFrames < cfg.probeFrames) return false;
+    levelCost[current - 1] = 0;
+    change(nowNs, current - 1, QUALITY_HEADROOM, p90, thermal);
+    return true;
+}
+
+// 换档后窗口里是旧档位的耗时，清空重新统计
+void QualityGovernor::change(int64_t nowNs, int to, int reason, double costNs, const ThermalSample& thermal) {
+    QualityEvent e;
+    e.tNs = nowNs;
+    e.from = static_cast<int16_t>(current);
+    e.to = static_cast<int16_t>(to);
+    e.reason = static_cast<int16_t>(reason);
+    e.costUs = static_cast<float>(costNs / 1000.0);
+    e.tempC = thermal.tempC;
+    e.freqMHz = thermal.freqMHz;
+    events.push(e);
+
+    current = to;
+    changeCount++;
+    sampleCount = sampleNext = 0;
+    framesAtLevel = idleFrames = 0;
+}
+
+void QualityGovernor::apply(LightDetector& detector, const Blob* target) const {
+    const QualityLevel& q = levels[current];
+    DetectorOptions o = base;
+    o.subsample = q.subsample;
+    o.refine = q.refine;
+    if (q.threads > 0) o.threads = q.threads;
+    const DetectorOptions& now = detector.getOptions();
+    if (o.tiled != now.tiled || o.threads != now.threads || o.subsample != now.subsample || o.refine != now.refine) {
+        detector.setOptions(o);
+    }
+    if (q.roiHalfSize > 0 && target) {
+        int cx = static_cast<int>(target->cx), cy = static_cast<int>(target->cy);
+        detector.setRoi(cx - q.roiHalfSize, cy - q.roiHalfSize, cx + q.roiHalfSize + 1, cy + q.roiHalfSize + 1);
+    } else {
+        detector.clearRoi();
+    }
+}
+
+} // namespace vision
@@ -0,0 +1,309 @@
+#include "runtime_config.hpp"
+#include "ini_file.hpp"
+
+#include <algorithm>
+#include <sstream>
+
+namespace {
+
+RtTaskConfig taskDefaults(const char* name, int64_t periodUs, int cpu, int priority) {
+    RtTaskConfig t;
+    t.name = name;
+    t.periodNs = periodUs * 1000;
+    t.cpu = cpu;
+    t.priority = priority;
+    return t;
+}
+
+void loadTask(const IniFile& ini, const std::string& section, RtTaskConfig& t) {
+    t.periodNs = ini.getInt(section, "period_us", static_cast<int>(t.periodNs / 1000)) * 1000LL;
+    t.deadlineNs = ini.getInt(section, "deadline_us", static_cast<int>(t.deadlineNs / 1000)) * 1000LL;
+    t.cpu = ini.getInt(section, "cpu", t.cpu);
+    t.priority = ini.getInt(section, "priority", t.priority);
+}
+
+// "7:8, 25:24" -> 每片的陀螺:加速度计片选
+bool parseImuUnits(const std::string& text, std::vector<ImuUnitConfig>& units, std::string& err) {
+    std::vector<ImuUnitConfig> parsed;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        ImuUnitConfig u;
+        char colon = 0;
+        std::stringstream is(item);
+        if (!(is >> u.csGyro >> colon >> u.csAccel) || colon != ':' || !(is >> std::ws).eof()) {
+            err = "imu.units: 无法解析 \"" + item + "\"，格式为 陀螺片选:加速度计片选, ...";
+            return false;
+        }
+        parsed.push_back(u);
+    }
+    if (parsed.empty() || parsed.size() > 4) {
+        err = "imu.units: 需要 1 ~ 4 片";
+        return false;
+    }
+    units = parsed;
+    return true;
+}
+
+// "/dev/spidev0.1:/dev/spidev0.0, ..." -> 每片的陀螺、加速度计 spidev 节点，片数与 units 一致
+bool parseImuDevices(const std::string& text, std::vector<ImuUnitConfig>& units, std::string& err) {
+    std::stringstream ss(text);
+    std::string item;
+    size_t k = 0;
+    while (std::getline(ss, item, ',')) {
+        size_t b = item.find_first_not_of(" \t"), e = item.find_last_not_of(" \t");
+        item = b == std::string::npos ? "" : item.substr(b, e - b + 1);
+        size_t colon = item.find(':');
+        if (colon == std::string::npos || colon == 0 || colon + 1 == item.size() || k >= units.size()) {
+            err = "imu.devices: 无法解析 \"" + item + "\"，格式为 陀螺节点:加速度计节点, ...，片数与 units 相同";
+            return false;
+        }
+        units[k].gyroDevice = item.substr(0, colon);
+        units[k].accelDevice = item.substr(colon + 1);
+        k++;
+    }
+    if (k != units.size()) {
+        err = "imu.devices: 片数与 units 不一致";
+        return false;
+    }
+    return true;
+}
+
+// 每个 spidev 节点对应一个片选，只能接一个器件。IMU 各片的节点只在 [spi] scheduler 下打开，
+// 不用调度器时多片共用默认值，不检查；BNO080 的节点始终不能与 IMU 的片选相同
+bool checkSpiDevices(const RuntimeConfig& cfg, std::string& err) {
+    std::vector<std::string> used;
+    bool imuLocal = cfg.imuEnabled && !cfg.ipcImu;
+    for (const ImuUnitConfig& u : cfg.imuUnits) {
+        for (const std::string* path : {&u.gyroDevice, &u.accelDevice}) {
+            if (imuLocal && cfg.spiScheduler && std::find(used.begin(), used.end(), *path) != used.end()) {
+                err = "imu.devices: " + *path + " 重复使用，每个片选只能接一个器件";
+                return false;
+            }
+            used.push_back(*path);
+        }
+    }
+    if (imuLocal && cfg.ahrsEnabled && std::find(used.begin(), used.end(), cfg.ahrsDevice) != used.end()) {
+        err = "ahrs.device: " + cfg.ahrsDevice + " 已被 BMI088 占用，BNO080 需要单独的片选";
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+RuntimeConfig::RuntimeConfig() {
+    imuUnits.push_back(ImuUnitConfig());
+
+    servo::defaultCalibration(servoCal);
+    cameraModel = vision::CameraModel::pinhole(camera.width, camera.height, control.hfovDeg);
+
+    // 相机任务由 grab() 阻塞驱动；截止时间默认 1.5 帧
+    visionTask = taskDefaults("vision", 0, 3, 60);
+    visionTask.deadlineNs = 1500000000LL / camera.fps;
+    imuTask = taskDefaults("imu", 1000, 2, 80);
+    ahrsTask = taskDefaults("ahrs", 10000, 2, 50);
+    fusionTask = taskDefaults("fusion", 2000, 1, 70);
+    servoTask = taskDefaults("servo", 1000000 / servoBank.frameHz, 1, 75);
+    thermalTask = taskDefaults("thermal", 500000, -1, 0);
+}
+
+bool loadRuntimeConfig(const std::string& path, RuntimeConfig& cfg, std::string& err) {
+    IniFile ini;
+    if (!ini.load(path, &err)) return false;
+
+    cfg.cameraEnabled = ini.getBool("camera", "enabled", cfg.cameraEnabled);
+    vision::CameraConfig& cam = cfg.camera;
+    static const char* formats[] = {"bgr", "i420", "bayer10", "bayer10p"};
+    static const char* orders[] = {"rggb", "bggr", "grbg", "gbrg"};
+    std::string format = ini.getString("camera", "format", formats[cam.format]);
+    std::string order = ini.getString("camera", "bayer_order", orders[cam.bayerOrder]);
+    int f = 0, o = 0;
+    while (f < 4 && format != formats[f]) f++;
+    while (o < 4 && order != orders[o]) o++;
+    if (f == 4 || o == 4) {
+        err = "camera.format 只支持 bgr/i420/bayer10/bayer10p，bayer_order 只支持 rggb/bggr/grbg/gbrg";
+        return false;
+    }
+    cam.format = static_cast<vision::PixelFormat>(f);
+    cam.bayerOrder = static_cast<vision::BayerOrder>(o);
+    cam.device = ini.getString("camera", "device", cam.device);
+    cam.width = ini.getInt("camera", "width", cam.width);
+    cam.height = ini.getInt("camera", "height", cam.height);
+    cam.fps = ini.getInt("camera", "fps", cam.fps);
+    if (cam.fps <= 0) {
+        err = "camera.fps 必须大于 0";
+        return false;
+    }
+    cam.exposure = ini.getInt("camera", "exposure", cam.exposure);
+    cam.gain = ini.getInt("camera", "gain", cam.gain);
+    cam.brightness = ini.getInt("camera", "brightness", cam.brightness);
+    cam.contrast = ini.getInt("camera", "contrast", cam.contrast);
+    cam.saturation = ini.getInt("camera", "saturation", cam.saturation);
+    cam.sharpness = ini.getInt("camera", "sharpness", cam.sharpness);
+    cam.wbRedGain = static_cast<float>(ini.getDouble("camera", "wb_red_gain", cam.wbRedGain));
+    cam.wbBlueGain = static_cast<float>(ini.getDouble("camera", "wb_blue_gain", cam.wbBlueGain));
+    cam.captureLatencyUs = ini.getInt("camera", "capture_latency_us", cam.captureLatencyUs);
+    cam.rawExposureLines = ini.getInt("camera", "raw_exposure_lines", cam.rawExposureLines);
+    cam.rawAnalogGain = ini.getInt("camera", "raw_analog_gain", cam.rawAnalogGain);
+    cfg.visionTask.deadlineNs = 1500000000LL / cam.fps;
+
+    vision::GreenRule& rule = cfg.detector;
+    rule.greenThreshold = static_cast<uint8_t>(ini.getInt("detector", "green_threshold", rule.greenThreshold));
+    rule.minRbDiff = static_cast<uint8_t>(ini.getInt("detector", "min_rb_diff", rule.minRbDiff));
+    rule.minArea = ini.getInt("detector", "min_area", rule.minArea);
+    rule.rawRedGain = static_cast<float>(ini.getDouble("detector", "raw_red_gain", rule.rawRedGain));
+    rule.rawBlueGain = static_cast<float>(ini.getDouble("detector", "raw_blue_gain", rule.rawBlueGain));
+    std::string expr = ini.getString("detector", "classifier", "");
+    if (expr.empty()) {
+        cfg.classifier = vision::ColorClassifier::green(rule.greenThreshold, rule.minRbDiff, rule.minRbDiff);
+    } else if (!cfg.classifier.compile(expr, err)) {
+        err = "detector.classifier: " + err;
+        return false;
+    }
+    cfg.detectorOptions.tiled = ini.getBool("detector", "tiled", cfg.detectorOptions.tiled);
+    cfg.detectorOptions.threads = std::max(1, ini.getInt("detector", "threads", cfg.detectorOptions.threads));
+    cfg.detectorOptions.subsample = ini.getInt("detector", "subsample", cfg.detectorOptions.subsample) == 2 ? 2 : 1;
+    cfg.detectorOptions.refine = ini.getBool("detector", "refine", cfg.detectorOptions.refine);
+    cfg.detectorRoi = std::max(0, ini.getInt("detector", "roi", cfg.detectorRoi));
+
+    vision::GovernorConfig& gov = cfg.governor;
+    gov.enabled = ini.getBool("governor", "enabled", gov.enabled);
+    gov.deadlineNs = ini.getInt("governor", "deadline_us", static_cast<int>(gov.deadlineNs / 1000)) * 1000LL;
+    gov.budgetFraction = ini.getDouble("governor", "budget_fraction", gov.budgetFraction);
+    gov.upFraction = ini.getDouble("governor", "up_fraction", gov.upFraction);
+    gov.window = std::max(4, ini.getInt("governor", "window", gov.window));
+    gov.holdFrames = ini.getInt("governor", "hold_frames", gov.holdFrames);
+    gov.probeFrames = ini.getInt("governor", "probe_frames", gov.probeFrames);
+    gov.hotC = static_cast<float>(ini.getDouble("governor", "hot_c", gov.hotC));
+    gov.coolC = static_cast<float>(ini.getDouble("governor", "cool_c", gov.coolC));
+    std::string levels = ini.getString("governor", "levels", "");
+    if (!levels.empty() && !vision::parseQualityLevels(levels, gov.levels, err)) {
+        err = "governor.levels: " + err;
+        return false;
+    }
+    cfg.thermalTempPath = ini.getString("governor", "temp_path", cfg.thermalTempPath);
+    cfg.thermalFreqPath = ini.getString("governor", "freq_path", cfg.thermalFreqPath);
+
+    tracker::TrackerConfig& trk = cfg.tracker;
+    trk.processNoise = static_cast<float>(ini.getDouble("tracker", "process_noise", trk.processNoise));
+    trk.measurementSigma = static_cast<float>(ini.getDouble("tracker", "measurement_sigma", trk.measurementSigma));
+    trk.gateSigma = static_cast<float>(ini.getDouble("tracker", "gate_sigma", trk.gateSigma));
+    trk.actuationLatencyNs = ini.getInt("tracker", "actuation_latency_us", static_cast<int>(trk.actuationLatencyNs / 1000)) * 1000LL;
+    trk.maxCoastNs = ini.getInt("tracker", "max_coast_ms", static_cast<int>(trk.maxCoastNs / 1000000)) * 1000000LL;
+
+    guidance::ControlConfig& ctl = cfg.control;
+    ctl.hfovDeg = static_cast<float>(ini.getDouble("control", "hfov_deg", ctl.hfovDeg));
+    ctl.kp = static_cast<float>(ini.getDouble("control", "kp", ctl.kp));
+    ctl.kn = static_cast<float>(ini.getDouble("control", "kn", ctl.kn));
+    ctl.maxFinRad = static_cast<float>(ini.getDouble("control", "max_fin_rad", ctl.maxFinRad));
+
+    std::string calibration = ini.getString("camera", "calibration", "");
+    if (calibration.empty()) {
+        cfg.cameraModel = vision::CameraModel::pinhole(cam.width, cam.height, ctl.hfovDeg);
+    } else {
+        // 相对路径相对于配置文件所在目录
+        size_t slash = path.rfind('/');
+        if (calibration[0] != '/' && slash != std::string::npos) calibration = path.substr(0, slash + 1) + calibration;
+        vision::CameraModel model;
+        if (!model.load(calibration, err)) return false;
+        if (!model.sameAspect(cam.width, cam.height)) {
+            err = calibration + ": 标定分辨率 " + std::to_string(model.width) + "x" + std::to_string(model.height) +
+                  " 与采集 " + std::to_string(cam.width) + "x" + std::to_string(cam.height) +
+                  " 宽高比不同 (传感器裁切模式)，需要按采集宽高比标定";
+            return false;
+        }
+        cfg.cameraModel = model.scaled(cam.width, cam.height);
+    }
+
+    cfg.servoBank.frameHz = ini.getInt("servo", "frame_hz", cfg.servoBank.frameHz);
+    if (cfg.servoBank.frameHz <= 0) {
+        err = "servo.frame_hz 必须大于 0";
+        return false;
+    }
+    cfg.servoTask.periodNs = 1000000000LL / cfg.servoBank.frameHz;
+    for (int i = 0; i < servo::kServoCount; i++) {
+        std::string sec = "servo" + std::to_string(i);
+        servo::ServoCalibration& c = cfg.servoCal[i];
+        cfg.servoBank.pins[i] = ini.getInt(sec, "pin", cfg.servoBank.pins[i]);
+        c.centerUs = static_cast<float>(ini.getDouble(sec, "center_us", c.centerUs));
+        c.usPerRad = static_cast<float>(ini.getDouble(sec, "us_per_rad", c.usPerRad));
+        c.minUs = static_cast<float>(ini.getDouble(sec, "min_us", c.minUs));
+        c.maxUs = static_cast<float>(ini.getDouble(sec, "max_us", c.maxUs));
+        c.maxRateRadS = static_cast<float>(ini.getDouble(sec, "max_rate_rad_s", c.maxRateRadS));
+        c.maxSlewUs = static_cast<float>(ini.getDouble(sec, "max_slew_us", c.maxSlewUs));
+        ctl.mix[i][0] = static_cast<float>(ini.getDouble(sec, "mix_pitch", ctl.mix[i][0]));
+        ctl.mix[i][1] = static_cast<float>(ini.getDouble(sec, "mix_yaw", ctl.mix[i][1]));
+    }
+    // 帧周期要放得下最宽的标定脉宽，否则 ServoBank 会把所有脉冲截短到周期以内
+    float widestUs = 0.0f;
+    for (const servo::ServoCalibration& c : cfg.servoCal) widestUs = std::max(widestUs, c.maxUs);
+    if (widestUs + servo::kPulseMarginUs > cfg.servoBank.periodUs()) {
+        err = "servo.frame_hz = " + std::to_string(cfg.servoBank.frameHz) + " 的周期 " +
+              std::to_string(cfg.servoBank.periodUs()) + " us 放不下 max_us " +
+              std::to_string(static_cast<int>(widestUs)) + " us 的脉冲 (另需 " +
+              std::to_string(servo::kPulseMarginUs) + " us 间隔)";
+        return false;
+    }
+
+    cfg.imuEnabled = ini.getBool("imu", "enabled", cfg.imuEnabled);
+    std::string units = ini.getString("imu", "units", "");
+    if (!units.empty() && !parseImuUnits(units, cfg.imuUnits, err)) return false;
+    cfg.imuSpiChannel = ini.getInt("imu", "spi_channel", cfg.imuSpiChannel);
+    cfg.imuSpiBaud = ini.getInt("imu", "spi_baud", cfg.imuSpiBaud);
+    cfg.imuAlign = ini.getBool("imu", "align", cfg.imuAlign);
+    cfg.imuOdrHz = ini.getInt("imu", "odr_hz", cfg.imuOdrHz);
+    cfg.imuFilterEnabled = ini.getBool("imu_filter", "enabled", cfg.imuFilterEnabled);
+    std::string stages = ini.getString("imu_filter", "stages", "");
+    if (!stages.empty() && !imufilter::parseStages(stages, cfg.imuFilterStages, err)) {
+        err = "imu_filter.stages: " + err;
+        return false;
+    }
+    imufilter::PeakConfig& peak = cfg.imuPeak;
+    cfg.imuPeakTracking = ini.getBool("imu_filter", "peak_tracking", cfg.imuPeakTracking);
+    peak.fftSize = ini.getInt("imu_filter", "fft_size", peak.fftSize);
+    peak.hop = ini.getInt("imu_filter", "fft_hop", peak.hop);
+    peak.minHz = static_cast<float>(ini.getDouble("imu_filter", "peak_min_hz", peak.minHz));
+    peak.maxHz = static_cast<float>(ini.getDouble("imu_filter", "peak_max_hz", peak.maxHz));
+    peak.minSnr = static_cast<float>(ini.getDouble("imu_filter", "peak_min_snr", peak.minSnr));
+    peak.smoothing = static_cast<float>(ini.getDouble("imu_filter", "peak_smoothing", peak.smoothing));
+    std::string devices = ini.getString("imu", "devices", "");
+    if (!devices.empty() && !parseImuDevices(devices, cfg.imuUnits, err)) return false;
+    cfg.ahrsDevice = ini.getString("ahrs", "device", cfg.ahrsDevice);
+    cfg.ahrsSpeedHz = ini.getInt("ahrs", "speed_hz", cfg.ahrsSpeedHz);
+    cfg.ahrsMode = ini.getInt("ahrs", "spi_mode", cfg.ahrsMode);
+    cfg.spiScheduler = ini.getBool("spi", "scheduler", cfg.spiScheduler);
+    cfg.spiImuPriority = ini.getInt("spi", "imu_priority", cfg.spiImuPriority);
+    cfg.spiAhrsPriority = ini.getInt("spi", "ahrs_priority", cfg.spiAhrsPriority);
+    cfg.spiGuardUs = ini.getInt("spi", "guard_us", cfg.spiGuardUs);
+    cfg.ahrsEnabled = ini.getBool("ahrs", "enabled", cfg.ahrsEnabled);
+    loadTask(ini, "vision", cfg.visionTask);
+    loadTask(ini, "imu", cfg.imuTask);
+    loadTask(ini, "ahrs", cfg.ahrsTask);
+    loadTask(ini, "fusion", cfg.fusionTask);
+    loadTask(ini, "servo", cfg.servoTask);
+    loadTask(ini, "thermal", cfg.thermalTask);
+
+    cfg.recorderEnabled = ini.getBool("recorder", "enabled", cfg.recorderEnabled);
+    cfg.recorderPath = ini.getString("recorder", "path", cfg.recorderPath);
+    cfg.recorderCapacityMb = std::max(1, ini.getInt("recorder", "capacity_mb", cfg.recorderCapacityMb));
+    cfg.recorderLockWindowKb = std::max(4, ini.getInt("recorder", "lock_window_kb", cfg.recorderLockWindowKb));
+
+    cfg.ipcPublish = ini.getBool("ipc", "publish", cfg.ipcPublish);
+    cfg.ipcImu = ini.getBool("ipc", "imu_topic", cfg.ipcImu);
+    cfg.ipcImuMaxAgeMs = std::max(1, ini.getInt("ipc", "imu_max_age_ms", cfg.ipcImuMaxAgeMs));
+
+    cfg.tracePath = ini.getString("trace", "path", cfg.tracePath);
+
+    cfg.memoryLock = ini.getBool("memory", "lock", cfg.memoryLock);
+    size_t stackBytes = static_cast<size_t>(std::max(0, ini.getInt("memory", "stack_prefault_kb", 256))) << 10;
+    size_t arenaBytes = static_cast<size_t>(std::max(0, ini.getInt("memory", "arena_kb", 64))) << 10;
+    for (RtTaskConfig* t : {&cfg.visionTask, &cfg.imuTask, &cfg.ahrsTask, &cfg.fusionTask, &cfg.servoTask}) {
+        t->stackPrefaultBytes = stackBytes;
+        t->arenaBytes = arenaBytes;
+    }
+
+    cfg.watchdogPeriodMs = ini.getInt("watchdog", "period_ms", cfg.watchdogPeriodMs);
+    cfg.watchdogStaleFactor = ini.getDouble("watchdog", "stale_factor", cfg.watchdogStaleFactor);
+    return checkSpiDevices(cfg, err);
+}
@@ -1,29 +1,294 @@
-#include <pigpio.h>
-#include <thread>
-#include <atomic>
-#include <iostream>
+#include "servo_controller.hpp"
+#include "rt_clock.hpp"
+#include "trace_zone.hpp"
 
-std::atomic<float> servo_angle[4];
+#ifdef HAVE_PIGPIO
+#include "pigpio_ref.h"
+#endif
 
-int servoPins[4] = {17, 18, 22, 23};
+#include <algorithm>
+#include <cmath>
 
-void servoController() {
-    gpioInitialise();
-    while (true) {
-        int pulseWidth = 1500;
-        for (int pin : servoPins) {
-            gpioServo(pin, pulseWidth);
+namespace servo {
+
+void defaultCalibration(ServoCalibration (&cal)[kServoCount]) {
+    for (int i = 0; i < kServoCount; i++) {
+        cal[i].centerUs = 1500.0f;
+        cal[i].usPerRad = 500.0f / static_cast<float>(M_PI / 4.0);
+        cal[i].minUs = 1000.0f;
+        cal[i].maxUs = 2000.0f;
+        cal[i].maxRateRadS = 6.0f;
+        cal[i].maxSlewUs = 0.0f;
+    }
+}
+
+#ifdef HAVE_PIGPIO
+bool PigpioWaveBackend::open(const ServoBankConfig& config) {
+    cfg = config;
+    if (!pigpioAcquire()) return false;
+
+    pinMask = 0;
+    for (int pin : cfg.pins) {
+        gpioSetMode(pin, PI_OUTPUT);
+        gpioWrite(pin, 0);
+        pinMask |= 1u << pin;
+    }
+    gpioWaveClear();
+    currentWave = -1;
+    retiredCount = 0;
+    opened = true;
+    return true;
+}
+
+bool PigpioWaveBackend::apply(const PulseFrame& frame) {
+    if (!opened) return false;
+    TRACE_ZONE("servo wave");
+    reapRetired();
+    if (retiredCount >= kMaxRetired) return false;   // 旧波形还没切换完，丢弃这一帧
+
+    // 按脉宽排序生成下降沿，所有通道在周期起点同时上升
+    int order[kServoCount];
+    for (int i = 0; i < kServoCount; i++) order[i] = i;
+    std::sort(order, order + kServoCount,
+              [&frame](int a, int b) { return frame.us[a] < frame.us[b]; });
+
+    // 固定布局：一个公共上升沿 + 每路一个下降沿，共 kServoCount + 1 个脉冲，
+    // 同宽的通道之间延时为 0；每帧的波形长度和 DMA 控制块数都一样
+    gpioPulse_t pulses[kServoCount + 1];
+    pulses[0].gpioOn = pinMask;
+    pulses[0].gpioOff = 0;
+    pulses[0].usDelay = frame.us[order[0]];
+    for (int k = 0; k < kServoCount; k++) {
+        uint32_t w = frame.us[order[k]];
+        uint32_t nextEdge = (k + 1 < kServoCount) ? frame.us[order[k + 1]] : cfg.periodUs();
+        pulses[k + 1].gpioOn = 0;
+        pulses[k + 1].gpioOff = 1u << cfg.pins[order[k]];
+        pulses[k + 1].usDelay = nextEdge - w;
+    }
+
+    gpioWaveAddNew();
+    if (gpioWaveAddGeneric(kServoCount + 1, pulses) < 0) return false;
+    int wave = gpioWaveCreate();
+    if (wave < 0) return false;
+    if (gpioWaveTxSend(wave, PI_WAVE_MODE_REPEAT_SYNC) < 0) {
+        gpioWaveDelete(wave);
+        return false;
+    }
+    if (currentWave >= 0) retired[retiredCount++] = currentWave;
+    currentWave = wave;
+    return true;
+}
+
+void PigpioWaveBackend::idle() {
+    if (opened) reapRetired();
+}
+
+// 删除已被替换的旧波形。REPEAT_SYNC 在当前周期结束时才切换，
+// 只有确认后来的波形已经在发送，排在它之前的旧波形才能删
+void PigpioWaveBackend::reapRetired() {
+    if (retiredCount == 0) return;
+    int active = gpioWaveTxAt();
+    int drop = 0;
+    if (active == currentWave || active == PI_NO_TX_WAVE) {
+        drop = retiredCount;                          // 最新波形在发送，或已全部停止
+    } else {
+        for (int i = 0; i < retiredCount; i++) {
+            if (retired[i] == active) {
+                drop = i;                             // 仍在发送 retired[i]，它之前的都已退出
+                break;
+            }
         }
-        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        // PI_WAVE_NOT_FOUND 等无法确认的情况一个都不删，下个周期再查
     }
-    gpioTerminate();
+    for (int i = 0; i < drop; i++) gpioWaveDelete(retired[i]);
+    for (int i = drop; i < retiredCount; i++) retired[i - drop] = retired[i];
+    retiredCount -= drop;
 }
 
-int main() {
-    // std::thread spiThread(spiReadLoop);
-    std::thread servoThread(servoController);
+void PigpioWaveBackend::close() {
+    if (!opened) return;
+    gpioWaveTxStop();
+    gpioWaveClear();
+    for (int pin : cfg.pins) gpioWrite(pin, 0);
+    pigpioRelease();
+    opened = false;
+}
 
-    // spiThread.join();
-    servoThread.join();
-    return 0;
+bool PigpioServoBackend::open(const ServoBankConfig& config) {
+    cfg = config;
+    if (!pigpioAcquire()) return false;
+    for (int pin : cfg.pins) gpioSetMode(pin, PI_OUTPUT);
+    opened = true;
+    return true;
 }
+
+bool PigpioServoBackend::apply(const PulseFrame& frame) {
+    if (!opened) return false;
+    for (int i = 0; i < kServoCount; i++) {
+        if (gpioServo(cfg.pins[i], frame.us[i]) != 0) return false;
+    }
+    return true;
+}
+
+void PigpioServoBackend::close() {
+    if (!opened) return;
+    for (int pin : cfg.pins) gpioServo(pin, 0);
+    pigpioRelease();
+    opened = false;
+}
+#endif
+
+bool SimServoBackend::open(const ServoBankConfig& config) {
+    cfg = config;
+    count = 0;
+    lastNs = 0;
+    interval.reset();
+    return true;
+}
+
+bool SimServoBackend::apply(const PulseFrame& frame) {
+    int64_t now = monotonicNs();
+    if (count > 0) interval.add(now - lastNs);
+    lastNs = now;
+
+    Record& r = ring[count % kHistory];
+    r.tNs = now;
+    r.frame = frame;
+    lastFrame = frame;
+    count++;
+    return true;
+}
+
+void SimServoBackend::close() {
+}
+
+ServoBank::ServoBank(ServoBackend& backend, const ServoBankConfig& config)
+    : backend(backend), cfg(config) {
+    for (int i = 0; i < kServoCount; i++) last.us[i] = 0;
+}
+
+ServoBank::~ServoBank() {
+    close();
+}
+
+bool ServoBank::open() {
+    if (opened) return true;
+    if (cfg.frameHz <= 0 || cfg.periodUs() <= kPulseMarginUs) return false;
+    opened = backend.open(cfg);
+    primed = false;
+    return opened;
+}
+
+void ServoBank::close() {
+    if (!opened) return;
+    backend.close();
+    opened = false;
+}
+
+bool ServoBank::commit(const PulseFrame& frame) {
+    TRACE_ZONE("servo commit");
+    if (!opened) return false;
+    // 脉宽不能超过帧周期；限幅后再比较和保存，current() 与实际输出一致
+    PulseFrame f = frame;
+    int maxUs = cfg.periodUs() - kPulseMarginUs;
+    for (int i = 0; i < kServoCount; i++) {
+        if (f.us[i] > maxUs) f.us[i] = static_cast<uint16_t>(maxUs);
+    }
+    if (primed && f == last) {
+        backend.idle();
+        skipCount++;
+        return false;
+    }
+    if (!backend.apply(f)) {
+        failCount++;
+        return false;
+    }
+    last = f;
+    primed = true;
+    commitCount++;
+    return true;
+}
+
+ServoLoop::ServoLoop(ServoBank& bank, const ServoCalibration (&calibration)[kServoCount],
+                     const std::atomic<float>* setpoints, int64_t periodNs)
+    : bank(bank), setpoints(setpoints), periodNs(periodNs) {
+    for (int i = 0; i < kServoCount; i++) {
+        cal[i] = calibration[i];
+        cmdAngle[i] = 0.0f;
+        pulseUs[i] = cal[i].centerUs;
+    }
+}
+
+bool ServoLoop::begin() {
+    if (!bank.open()) return false;
+    neutral();
+    return true;
+}
+
+void ServoLoop::end() {
+    bank.close();
+}
+
+void ServoLoop::neutral() {
+    PulseFrame f;
+    for (int i = 0; i < kServoCount; i++) {
+        cmdAngle[i] = 0.0f;
+        pulseUs[i] = cal[i].centerUs;
+        f.us[i] = static_cast<uint16_t>(std::lround(cal[i].centerUs));
+    }
+    bank.commit(f);
+}
+
+void ServoLoop::step(float dt) {
+    PulseFrame f;
+    for (int i = 0; i < kServoCount; i++) {
+        const ServoCalibration& c = cal[i];
+        float target = setpoints[i].load(std::memory_order_relaxed);
+        if (!std::isfinite(target)) target = 0.0f;
+
+        // 角度限幅到机械范围
+        float a0 = (c.minUs - c.centerUs) / c.usPerRad;
+        float a1 = (c.maxUs - c.centerUs) / c.usPerRad;
+        target = std::min(std::max(target, std::min(a0, a1)), std::max(a0, a1));
+
+        // 角速度限幅
+        if (c.maxRateRadS > 0.0f) {
+            float step = c.maxRateRadS * dt;
+            target = std::min(std::max(target, cmdAngle[i] - step), cmdAngle[i] + step);
+        }
+        cmdAngle[i] = target;
+
+        // 脉宽斜率限幅
+        float p = c.centerUs + c.usPerRad * target;
+        if (c.maxSlewUs > 0.0f) {
+            p = std::min(std::max(p, pulseUs[i] - c.maxSlewUs), pulseUs[i] + c.maxSlewUs);
+        }
+        pulseUs[i] = std::min(std::max(p, c.minUs), c.maxUs);
+        f.us[i] = static_cast<uint16_t>(std::lround(pulseUs[i]));
+    }
+    bank.commit(f);
+}
+
+void ServoLoop::run(const std::atomic<bool>& stop) {
+    const float dt = periodNs * 1e-9f;
+    int64_t next = monotonicNs() + periodNs;
+
+    while (!stop.load(std::memory_order_relaxed)) {
+        sleepUntilNs(next);
+        int64_t now = monotonicNs();
+        wakeJitter.add(now - next);
+
+        step(dt);
+        tickCount++;
+
+        next += periodNs;
+        // 错过整周期时重新对齐，不补发积压的 tick
+        if (monotonicNs() > next) {
+            overrunCount++;
+            int64_t behind = (monotonicNs() - next) / periodNs + 1;
+            next += behind * periodNs;
+        }
+    }
+}
+
+} // namespace servo
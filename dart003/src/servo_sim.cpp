@@ -0,0 +1,62 @@
+#include "servo_controller.hpp"
+#include "rt_clock.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+// PC 上运行舵机控制环：模拟舵机组后端 + 正弦/阶跃指令，输出调度抖动、提交间隔和写入统计
+// 用法: servo_sim [秒数] [帧率 Hz，数字舵机 333]
+
+int main(int argc, char** argv) {
+    double seconds = argc > 1 ? std::atof(argv[1]) : 5.0;
+    int frameHz = argc > 2 ? std::atoi(argv[2]) : 50;
+
+    std::atomic<float> setpoints[servo::kServoCount];
+    for (auto& s : setpoints) s = 0.0f;
+
+    servo::ServoCalibration cal[servo::kServoCount];
+    servo::defaultCalibration(cal);
+    cal[3].maxSlewUs = 10.0f;
+
+    servo::ServoBankConfig bankCfg;
+    bankCfg.frameHz = frameHz;
+    servo::SimServoBackend backend;
+    servo::ServoBank bank(backend, bankCfg);
+    servo::ServoLoop loop(bank, cal, setpoints, 1000LL * bankCfg.periodUs());
+    if (!loop.begin()) return 1;
+
+    std::atomic<bool> stop(false);
+    std::thread servoThread([&] { loop.run(stop); });
+
+    // 指令源：通道 0/1 正弦，通道 2 阶跃（测试速率限幅），通道 3 阶跃（测试斜率限幅）
+    int64_t t0 = monotonicNs();
+    int64_t end = t0 + static_cast<int64_t>(seconds * 1e9);
+    while (monotonicNs() < end) {
+        double t = (monotonicNs() - t0) * 1e-9;
+        setpoints[0] = static_cast<float>(0.5 * std::sin(2.0 * M_PI * 1.0 * t));
+        setpoints[1] = static_cast<float>(0.3 * std::sin(2.0 * M_PI * 3.0 * t));
+        setpoints[2] = (static_cast<int>(t) % 2) ? 0.6f : -0.6f;
+        setpoints[3] = (static_cast<int>(t) % 2) ? 0.6f : -0.6f;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    stop = true;
+    servoThread.join();
+    loop.end();
+
+    loop.jitter().print("servo wakeup");
+    backend.intervals().print("apply interval");
+    std::printf("tick %llu overrun %llu commit %llu skip %llu fail %llu\n",
+                static_cast<unsigned long long>(loop.ticks()),
+                static_cast<unsigned long long>(loop.overruns()),
+                static_cast<unsigned long long>(bank.commits()),
+                static_cast<unsigned long long>(bank.skipped()),
+                static_cast<unsigned long long>(bank.failures()));
+    for (int i = 0; i < servo::kServoCount; i++) {
+        std::printf("ch%d pin %d angle %.3f pulse %d\n", i, bankCfg.pins[i], loop.angle(i), loop.pulse(i));
+    }
+    return 0;
+}
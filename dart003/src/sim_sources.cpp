@@ -0,0 +1,117 @@
+#include "sim_sources.hpp"
+#include "image_convert.hpp"
+#include "rt_clock.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <random>
+
+namespace sim {
+
+namespace {
+const double kTwoPi = 2.0 * M_PI;
+}
+
+float Scene::targetAz(double t) const { return targetAzAmp * std::sin(kTwoPi * targetAzHz * t); }
+float Scene::targetEl(double t) const { return targetElAmp * std::cos(kTwoPi * targetElHz * t); }
+float Scene::bodyYaw(double t) const { return bodyYawAmp * std::sin(kTwoPi * bodyYawHz * t); }
+float Scene::bodyPitch(double t) const { return bodyPitchAmp * std::sin(kTwoPi * bodyPitchHz * t); }
+float Scene::bodyYawRate(double t) const {
+    return bodyYawAmp * kTwoPi * bodyYawHz * std::cos(kTwoPi * bodyYawHz * t);
+}
+float Scene::bodyPitchRate(double t) const {
+    return bodyPitchAmp * kTwoPi * bodyPitchHz * std::cos(kTwoPi * bodyPitchHz * t);
+}
+
+SyntheticFrameSource::SyntheticFrameSource(const vision::CameraConfig& cam, float hfovDeg, const Scene& scene,
+                                           int64_t originNs, bool realtime, int deliveryUs)
+    : cam(cam), scene(scene), originNs(originNs), periodNs(1000000000LL / cam.fps),
+      realtime(realtime), deliveryNs(deliveryUs * 1000LL) {
+    cx = (cam.width - 1) * 0.5f;
+    cy = (cam.height - 1) * 0.5f;
+    f = (cam.width * 0.5f) / std::tan(hfovDeg * static_cast<float>(M_PI) / 360.0f);
+}
+
+bool SyntheticFrameSource::open() {
+    size_t bytes = static_cast<size_t>(cam.width) * cam.height * 3;
+    background.resize(bytes);
+    image.resize(bytes);
+    if (cam.format != vision::PIXEL_BGR24) {
+        converted.resize(vision::frameBytes(cam.format, vision::minStride(cam.format, cam.width), cam.height));
+    }
+
+    // 暗背景加少量噪声和偏绿的干扰点（不满足判据）
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> noise(0, 40);
+    for (size_t i = 0; i < bytes; i += 3) {
+        background[i] = static_cast<uint8_t>(noise(rng));
+        background[i + 1] = static_cast<uint8_t>(noise(rng) + 20);
+        background[i + 2] = static_cast<uint8_t>(noise(rng));
+    }
+    next = 0;
+    return true;
+}
+
+void SyntheticFrameSource::truthPixel(uint32_t k, float& px, float& py) const {
+    double t = k * periodNs * 1e-9;
+    float az = scene.targetAz(t) - scene.bodyYaw(t);
+    float el = scene.targetEl(t) - scene.bodyPitch(t);
+    px = cx + f * std::tan(az);
+    py = cy - f * std::tan(el);
+}
+
+void SyntheticFrameSource::render(uint32_t k) {
+    std::memcpy(image.data(), background.data(), image.size());
+
+    float px, py;
+    truthPixel(k, px, py);
+    int r = scene.targetRadiusPx;
+    for (int y = static_cast<int>(py) - r; y <= static_cast<int>(py) + r; y++) {
+        if (y < 0 || y >= cam.height) continue;
+        for (int x = static_cast<int>(px) - r; x <= static_cast<int>(px) + r; x++) {
+            if (x < 0 || x >= cam.width) continue;
+            float dx = x - px, dy = y - py;
+            if (dx * dx + dy * dy > r * r) continue;
+            uint8_t* p = &image[(static_cast<size_t>(y) * cam.width + x) * 3];
+            p[0] = 30;
+            p[1] = 240;
+            p[2] = 40;
+        }
+    }
+}
+
+bool SyntheticFrameSource::grab(vision::Frame& frame) {
+    uint32_t k = next++;
+    int64_t captureNs = originNs + k * periodNs;
+    render(k);
+    int stride = vision::minStride(cam.format, cam.width);
+    if (cam.format == vision::PIXEL_I420) {
+        vision::bgrToI420(image.data(), cam.width * 3, cam.width, cam.height, converted.data(), stride);
+    } else if (cam.format != vision::PIXEL_BGR24) {
+        vision::bgrToBayer10(image.data(), cam.width * 3, cam.width, cam.height, cam.format, cam.bayerOrder, 1.0f,
+                             1.0f, converted.data(), stride);
+    }
+    if (realtime) sleepUntilNs(captureNs + deliveryNs);
+
+    frame.format = cam.format;
+    frame.bayer = cam.bayerOrder;
+    frame.width = cam.width;
+    frame.height = cam.height;
+    frame.stride = stride;
+    frame.data = cam.format == vision::PIXEL_BGR24 ? image.data() : converted.data();
+    frame.captureNs = captureNs;
+    frame.id = k;
+    return true;
+}
+
+sensor::SensorStatus SimImuSource::read(float (&gyro)[3], float (&accel)[3]) {
+    double t = (monotonicNs() - originNs) * 1e-9;
+    gyro[0] = 0.0f;
+    gyro[1] = scene.bodyPitchRate(t);
+    gyro[2] = scene.bodyYawRate(t);
+    accel[0] = accel[1] = 0.0f;
+    accel[2] = 9.81f;
+    return sensor::SENSOR_OK;
+}
+
+} // namespace sim
@@ -1,6 +1,8 @@
 #ifndef BMI088_H
 #define BMI088_H
 
+#include "bmi088_bus.h"
+
 #include <cstdint>
 
 typedef struct {
@@ -18,10 +20,19 @@ typedef struct {
     float time;
 } bmi088_real_data_t;
 
+// One BMI088 (gyro + accel dies) on a shared bus. The bus must outlive the
+// device; several devices can share a bus as long as their CS lines differ.
+// Self-test and init run in the constructor, which throws std::runtime_error
+// on failure.
+//
+// odrHz picks the output data rate: the gyro gets the nearest supported rate
+// (100, 200, 400, 1000, 2000 Hz) with the wider of its two bandwidths where
+// there is a choice, the accel the lowest ODR at or above it (capped at
+// 1600 Hz). The default keeps the on-chip filtering of the original driver;
+// at 1-2 kHz vibration rejection is left to software (imu_filter.hpp).
 class BMI088 {
 public:
-    BMI088();
-    ~BMI088();
+    explicit BMI088(Bmi088Bus& bus, int csGyro = 7, int csAccel = 8, unsigned odrHz = 100);
 
     uint8_t readAccelRegister(uint8_t reg);
     uint8_t writeAccelRegister(uint8_t reg, uint8_t cmd);
@@ -43,10 +54,20 @@ public:
     const bmi088_raw_data_t& getRawData() const { return raw_data; }
     const bmi088_real_data_t& getRealData() const { return real_data; }
 
+    Bmi088Bus& getBus() { return bus; }
+    int gyroCs() const { return csGyro; }
+    int accelCs() const { return csAccel; }
+    unsigned gyroOdrHz() const { return gyroOdr; }
+    unsigned accelOdrHz() const { return accelOdr; }
+
 private:
-    int spiHandle;
+    Bmi088Bus& bus;
     int csGyro;
     int csAccel;
+    uint8_t accelConf;          // BMI088_ACC_CONF value for accelInit
+    uint8_t gyroBandwidth;      // BMI088_GYRO_BANDWIDTH value for gyroInit
+    unsigned gyroOdr;
+    unsigned accelOdr;
 
     bmi088_raw_data_t raw_data;
     bmi088_real_data_t real_data;
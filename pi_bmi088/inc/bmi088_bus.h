@@ -0,0 +1,77 @@
+#ifndef BMI088_BUS_H
+#define BMI088_BUS_H
+
+#include "spi_bus.hpp"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// SPI bus shared by one or more BMI088 units. Each unit only knows its two
+// chip-select lines; the bus owns the SPI handle (and pigpio, for the
+// hardware bus), so several BMI088 objects can live on it at once.
+class Bmi088Bus {
+public:
+    virtual ~Bmi088Bus() {}
+
+    // Configure a chip-select line as an output, idle high.
+    virtual void claimCs(int pin) = 0;
+
+    // Pull cs low, clock len bytes full duplex, release cs.
+    virtual bool transfer(int cs, const uint8_t* tx, uint8_t* rx, unsigned len) = 0;
+
+    // Register settle delays during init; simulated buses may skip them.
+    virtual void sleepUs(unsigned us) = 0;
+
+    // Transfers between these two run back to back with nothing else on the
+    // bus in between (a multi-IMU burst). No-op on an exclusive bus.
+    virtual void beginBurst(int64_t deadlineNs) { (void)deadlineNs; }
+    virtual void endBurst() {}
+};
+
+// Hardware bus: pigpio SPI with software chip selects (SPI flag bits from
+// spiOpen(), e.g. mode 0 = 0). Throws std::runtime_error if pigpio or the
+// SPI channel cannot be opened.
+class PigpioBmi088Bus : public Bmi088Bus {
+public:
+    explicit PigpioBmi088Bus(unsigned channel = 0, unsigned baud = 10000000, unsigned flags = 0);
+    ~PigpioBmi088Bus();
+
+    PigpioBmi088Bus(const PigpioBmi088Bus&) = delete;
+    PigpioBmi088Bus& operator=(const PigpioBmi088Bus&) = delete;
+
+    void claimCs(int pin) override;
+    bool transfer(int cs, const uint8_t* tx, uint8_t* rx, unsigned len) override;
+    void sleepUs(unsigned us) override;
+
+private:
+    int spiHandle;
+};
+
+// BMI088 on a bus shared with other drivers through spibus::SpiBus. Each
+// chip select is a scheduler device (one spidev node each, e.g. CE0/CE1 on
+// SPI0 for accel/gyro); single transfers are submitted one at a time, a
+// burst holds the bus for its whole length. With realDelays off the init
+// delays are skipped (simulated backends).
+class ScheduledBmi088Bus : public Bmi088Bus {
+public:
+    ScheduledBmi088Bus(spibus::SpiBus& bus, int client, bool realDelays = true);
+
+    // cs pin number as passed to BMI088 -> scheduler device id
+    void mapCs(int pin, int device);
+
+    void claimCs(int) override {}
+    bool transfer(int cs, const uint8_t* tx, uint8_t* rx, unsigned len) override;
+    void sleepUs(unsigned us) override;
+    void beginBurst(int64_t deadlineNs) override;
+    void endBurst() override;
+
+private:
+    spibus::SpiBus& bus;
+    int client;
+    bool realDelays;
+    bool inBurst;
+    std::vector<std::pair<int, int>> csDevices;
+};
+
+#endif
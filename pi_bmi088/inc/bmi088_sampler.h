@@ -0,0 +1,76 @@
+#ifndef BMI088_SAMPLER_H
+#define BMI088_SAMPLER_H
+
+#include "bmi088.h"
+
+#include <cstdint>
+#include <vector>
+
+const int kMaxImus = 4;
+
+// A unit whose raw gyro + accel words stay bit-identical for this many of
+// its (slower) output periods is treated as stale: wedged chip, floating
+// MISO. A live sensor's noise changes some word every period; counting
+// periods rather than bursts keeps oversampling from looking stale.
+const int kStalePeriods = 8;
+
+struct ImuReading {
+    int64_t gyroNs;             // midpoint of the gyro / accel transfers (CLOCK_MONOTONIC)
+    int64_t accelNs;
+    float gyro[3];              // rad/s
+    float accel[3];             // m/s^2
+    uint8_t status;             // BMI088_NO_ERROR, or why this unit was left out of the vote
+};
+
+// One burst over every unit on the bus.
+struct MultiImuSample {
+    int64_t tNs;                // common time all readings are aligned to (mean gyro time)
+    int64_t skewNs;             // spread of the gyro read times within the burst
+    int64_t burstNs;            // first transfer start to last transfer end
+    uint32_t seq;
+    int count;
+    int validCount;             // units with status BMI088_NO_ERROR; 0 means nothing fresh this burst
+    ImuReading imu[kMaxImus];   // per unit, in constructor order; valid values aligned to tNs
+    float gyroMedian[3];        // per-axis median over valid units (mean of the middle two for an even count)
+    float accelMedian[3];
+    float gyroMean[3];
+    float accelMean[3];
+};
+
+// Reads all units back to back once per call: every gyro first, then every
+// accel, with nothing else between transfers. The starting unit rotates each
+// call so no unit is always read last.
+//
+// With alignment on, each unit's reading is linearly extrapolated from its
+// own previous reading to tNs, which removes most of the read-order skew for
+// voting and averaging; the first burst is passed through unaligned.
+//
+// A unit whose transfer failed or whose output is stale gets a non-zero
+// status and is left out of tNs, the median, the mean and the alignment
+// history; its next good reading is passed through unaligned. With no valid
+// unit the votes are zero and tNs is the burst start.
+// No allocation after construction.
+class Bmi088Sampler {
+public:
+    // devices share one bus (the first unit's); only the first kMaxImus are used
+    explicit Bmi088Sampler(const std::vector<BMI088*>& devices, bool align = true);
+
+    // The burst holds the bus (Bmi088Bus::beginBurst) so other drivers on a
+    // shared bus cannot interleave; deadlineNs is passed to the scheduler.
+    void sample(MultiImuSample& out, int64_t deadlineNs = 0);
+
+    int size() const { return count; }
+
+private:
+    BMI088* dev[kMaxImus];
+    int count;
+    bool align;
+    uint32_t seq;
+    bool havePrev[kMaxImus];
+    ImuReading prev[kMaxImus];   // previous valid raw (unaligned) readings
+    int16_t lastWords[kMaxImus][6];
+    int64_t changedNs[kMaxImus]; // when the raw words last changed, -1 before the first reading
+    int64_t staleNs[kMaxImus];
+};
+
+#endif
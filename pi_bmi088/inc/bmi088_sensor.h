@@ -0,0 +1,97 @@
+#ifndef BMI088_SENSOR_H
+#define BMI088_SENSOR_H
+
+#include "bmi088.h"
+#include "bmi088_sampler.h"
+#include "bmi088def.h"
+#include "imu_sensor.hpp"
+#include "rt_clock.hpp"
+#include "spi_bus.hpp"
+
+#include <algorithm>
+#include <vector>
+
+// sensor::ImuSensor adapters. Everything is inline so a template consumer
+// compiles down to direct calls into BMI088 / Bmi088Sampler.
+
+// One unit: gyro then accel, stamped at the end of the pair. Driver error
+// codes (BMI088_*_ERROR) come back as SENSOR_FAULT with fault() set.
+class Bmi088Sensor : public sensor::ImuSensor<Bmi088Sensor> {
+public:
+    explicit Bmi088Sensor(BMI088& imu, int channel = 0) : imu(imu), channel(channel) {}
+
+    sensor::SensorStatus readImpl(sensor::ImuSample& s) {
+        uint8_t err = imu.readGyro();
+        if (err == BMI088_NO_ERROR) err = imu.readAccel();
+        if (err != BMI088_NO_ERROR) return failWith(err);
+        const bmi088_real_data_t& d = imu.getRealData();
+        s.tNs = monotonicNs();
+        s.flags = sensor::SAMPLE_GYRO | sensor::SAMPLE_ACCEL;
+        s.channel = static_cast<uint16_t>(channel);
+        s.gyro[0] = static_cast<float>(d.gyro_x);
+        s.gyro[1] = static_cast<float>(d.gyro_y);
+        s.gyro[2] = static_cast<float>(d.gyro_z);
+        s.accel[0] = static_cast<float>(d.accel_x);
+        s.accel[1] = static_cast<float>(d.accel_y);
+        s.accel[2] = static_cast<float>(d.accel_z);
+        return sensor::SENSOR_OK;
+    }
+
+    const char* nameImpl() const { return "bmi088"; }
+
+private:
+    BMI088& imu;
+    int channel;
+};
+
+// Several units on one bus through Bmi088Sampler; the sample carries the
+// per-axis median of the valid units, stamped at the burst's common time.
+// Fails (SENSOR_FAULT) only when no unit produced a fresh reading. When the bus goes
+// through a spibus::SpiBus, reserveOn() books the next burst after each read.
+class Bmi088ArraySensor : public sensor::ImuSensor<Bmi088ArraySensor> {
+public:
+    Bmi088ArraySensor(const std::vector<BMI088*>& units, bool align = true, int channel = 0)
+        : sampler(units, align), channel(channel), bus(nullptr), client(-1), periodNs(0), guardNs(0), burstNs(0) {}
+
+    void reserveOn(spibus::SpiBus& b, int c, int64_t period, int64_t guard) {
+        bus = &b;
+        client = c;
+        periodNs = period;
+        guardNs = guard;
+    }
+
+    sensor::SensorStatus readImpl(sensor::ImuSample& s) {
+        int64_t start = monotonicNs();
+        sampler.sample(burst);
+        if (bus && guardNs > 0 && periodNs > 0) {
+            burstNs = std::max(burstNs, burst.burstNs);
+            bus->reserve(client, start + periodNs - guardNs, guardNs + burstNs + burstNs / 2);
+        }
+        // no unit produced a fresh reading: report the first unit's error so
+        // the consumer's failure handling (IMU watchdog) sees a dead bus
+        if (!burst.validCount) return failWith(burst.count ? burst.imu[0].status : static_cast<int>(BMI088_NO_SENSOR));
+        s.tNs = burst.tNs;
+        s.flags = sensor::SAMPLE_GYRO | sensor::SAMPLE_ACCEL;
+        s.channel = static_cast<uint16_t>(channel);
+        for (int i = 0; i < 3; i++) {
+            s.gyro[i] = burst.gyroMedian[i];
+            s.accel[i] = burst.accelMedian[i];
+        }
+        return sensor::SENSOR_OK;
+    }
+
+    const char* nameImpl() const { return "bmi088 array"; }
+
+    // the full burst behind the last sample (per-unit readings, skew)
+    const MultiImuSample& lastBurst() const { return burst; }
+
+private:
+    Bmi088Sampler sampler;
+    MultiImuSample burst;
+    int channel;
+    spibus::SpiBus* bus;
+    int client;
+    int64_t periodNs, guardNs, burstNs;
+};
+
+#endif
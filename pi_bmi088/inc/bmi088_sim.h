@@ -0,0 +1,61 @@
+#ifndef BMI088_SIM_H
+#define BMI088_SIM_H
+
+#include "bmi088_bus.h"
+
+#include <cstdint>
+#include <vector>
+
+// Register-level model of BMI088 units on one SPI bus, for benches and
+// bring-up without hardware. It answers the chip-id, config read-back and
+// self-test sequences the driver runs, using the same framing as the driver
+// (no accel dummy byte), and skips the init delays.
+//
+// Each transfer busy-waits for cs overhead + 8 * len / baud, so read order
+// costs real time. Data registers are latched at the middle of the transfer
+// from truth() plus a per-unit gyro bias, quantised to the driver's scale.
+class SimBmi088Bus : public Bmi088Bus {
+public:
+    explicit SimBmi088Bus(unsigned baud = 10000000, int csOverheadNs = 3000);
+
+    // A unit answering on these two chip selects.
+    void addDevice(int csGyro, int csAccel, const float (&gyroBias)[3]);
+
+    void claimCs(int) override {}
+    bool transfer(int cs, const uint8_t* tx, uint8_t* rx, unsigned len) override;
+    void sleepUs(unsigned) override {}
+
+    // The register model alone, latched at latchNs, without the wire-time
+    // wait: for use as a spibus::SimBackend responder, which does its own
+    // timing. Returns false if no unit answers on cs.
+    bool respond(int cs, const uint8_t* tx, uint8_t* rx, unsigned len, int64_t latchNs);
+
+    // Motion seen by every unit, t in seconds since the bus was created.
+    static void truth(double t, float (&gyro)[3], float (&accel)[3]);
+    double secondsAt(int64_t ns) const { return (ns - originNs) * 1e-9; }
+
+    uint64_t transfers() const { return transferCount; }
+
+private:
+    struct Chip {
+        int cs;
+        bool accel;
+        int device;
+        uint8_t reg[128];
+    };
+    struct Device {
+        float gyroBias[3];
+    };
+
+    unsigned baud;
+    int csOverheadNs;
+    int64_t originNs;
+    uint64_t transferCount;
+    std::vector<Chip> chips;
+    std::vector<Device> devices;
+
+    static void reset(Chip& c);
+    void latch(Chip& c, int64_t ns);
+};
+
+#endif
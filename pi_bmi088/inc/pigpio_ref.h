@@ -0,0 +1,34 @@
+#ifndef PIGPIO_REF_H
+#define PIGPIO_REF_H
+
+#include <pigpio.h>
+
+#include <mutex>
+
+// pigpio is process-global: gpioInitialise() may be called again once it is
+// up, but a single gpioTerminate() tears it down for every user. Everything
+// that needs pigpio (SPI buses, servo backends) goes through this count so
+// the last owner to close is the one that terminates.
+inline std::mutex& pigpioRefMutex() {
+    static std::mutex m;
+    return m;
+}
+
+inline int& pigpioRefCount() {
+    static int count = 0;
+    return count;
+}
+
+inline bool pigpioAcquire() {
+    std::lock_guard<std::mutex> lock(pigpioRefMutex());
+    if (pigpioRefCount() == 0 && gpioInitialise() < 0) return false;
+    pigpioRefCount()++;
+    return true;
+}
+
+inline void pigpioRelease() {
+    std::lock_guard<std::mutex> lock(pigpioRefMutex());
+    if (pigpioRefCount() > 0 && --pigpioRefCount() == 0) gpioTerminate();
+}
+
+#endif
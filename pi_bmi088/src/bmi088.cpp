@@ -1,40 +1,85 @@
 #include "bmi088.h"
 #include "bmi088def.h"
 #include "bmi088reg.h"
+#include "trace_zone.hpp"
 
-#include <pigpio.h>
+#include <cstdlib>
 #include <stdexcept>
-#include <unistd.h>
 #include <iostream>
 
 double bmi088_accel_sen = BMI088_ACCEL_12G_SEN;
 double bmi088_gyro_sen = BMI088_GYRO_2000_SEN;
 
-BMI088::BMI088() {
-    // initialize pigpio library
-    if (gpioInitialise() < 0)  throw std::runtime_error("pigpio initialization failed");
-
-    // set CS pins
-    csGyro = 7;
-    csAccel = 8;
-
-    // configure CS pins
-    gpioSetMode(csGyro, PI_OUTPUT);
-    gpioSetMode(csAccel, PI_OUTPUT);
-    gpioWrite(csGyro, 1);
-    gpioWrite(csAccel, 1);
-
-    // open SPI interface 10MHz, mode 0
-    spiHandle = spiOpen(0, 10000000, 0);
-    if (spiHandle < 0) {
-        throw std::runtime_error("spiOpen failed");
+namespace {
+
+struct GyroRate {
+    unsigned hz;
+    uint8_t bandwidth;
+};
+
+// per ODR, the wider bandwidth setting
+const GyroRate kGyroRates[] = {
+    {100, BMI088_GYRO_100_32_HZ},   {200, BMI088_GYRO_200_64_HZ},     {400, BMI088_GYRO_400_47_HZ},
+    {1000, BMI088_GYRO_1000_116_HZ}, {2000, BMI088_GYRO_2000_230_HZ},
+};
+
+struct AccelRate {
+    unsigned hz;
+    uint8_t odr;
+};
+
+const AccelRate kAccelRates[] = {
+    {100, BMI088_ACC_100_HZ}, {200, BMI088_ACC_200_HZ},  {400, BMI088_ACC_400_HZ},
+    {800, BMI088_ACC_800_HZ}, {1600, BMI088_ACC_1600_HZ},
+};
+
+// register, value, error code returned when the read-back differs
+const uint8_t write_BMI088_accel_reg_data_error[BMI088_WRITE_ACCEL_REG_NUM][3] = {
+    {BMI088_ACC_PWR_CTRL, BMI088_ACC_ENABLE_ACC_ON, BMI088_ACC_PWR_CTRL_ERROR},
+    {BMI088_ACC_PWR_CONF, BMI088_ACC_PWR_ACTIVE_MODE, BMI088_ACC_PWR_CONF_ERROR},
+    {BMI088_ACC_CONF,  BMI088_ACC_NORMAL| BMI088_ACC_100_HZ | BMI088_ACC_CONF_MUST_Set, BMI088_ACC_CONF_ERROR},
+    {BMI088_ACC_RANGE, BMI088_ACC_RANGE_3G, BMI088_ACC_RANGE_ERROR},
+    {BMI088_INT1_IO_CTRL, BMI088_ACC_INT1_IO_ENABLE | BMI088_ACC_INT1_GPIO_PP | BMI088_ACC_INT1_GPIO_LOW, BMI088_INT1_IO_CTRL_ERROR},
+    {BMI088_INT_MAP_DATA, BMI088_ACC_INT1_DRDY_INTERRUPT, BMI088_INT_MAP_DATA_ERROR}
+};
+
+const uint8_t write_BMI088_gyro_reg_data_error[BMI088_WRITE_GYRO_REG_NUM][3] = {
+    {BMI088_GYRO_RANGE, BMI088_GYRO_2000, BMI088_GYRO_RANGE_ERROR},
+    {BMI088_GYRO_BANDWIDTH, BMI088_GYRO_100_32_HZ | BMI088_GYRO_BANDWIDTH_MUST_Set, BMI088_GYRO_BANDWIDTH_ERROR},
+    {BMI088_GYRO_LPM1, BMI088_GYRO_NORMAL_MODE, BMI088_GYRO_LPM1_ERROR},
+    {BMI088_GYRO_CTRL, BMI088_DRDY_ON, BMI088_GYRO_CTRL_ERROR},
+    {BMI088_GYRO_INT3_INT4_IO_CONF, BMI088_GYRO_INT3_GPIO_PP | BMI088_GYRO_INT3_GPIO_LOW, BMI088_GYRO_INT3_INT4_IO_CONF_ERROR},
+    {BMI088_GYRO_INT3_INT4_IO_MAP, BMI088_GYRO_DRDY_IO_INT3, BMI088_GYRO_INT3_INT4_IO_MAP_ERROR}
+};
+
+} // namespace
+
+BMI088::BMI088(Bmi088Bus& bus, int csGyro, int csAccel, unsigned odrHz)
+    : bus(bus), csGyro(csGyro), csAccel(csAccel) {
+    const GyroRate* g = &kGyroRates[0];
+    for (const GyroRate& r : kGyroRates) {
+        if (std::labs(static_cast<long>(r.hz) - static_cast<long>(odrHz)) <
+            std::labs(static_cast<long>(g->hz) - static_cast<long>(odrHz))) {
+            g = &r;
+        }
+    }
+    gyroBandwidth = g->bandwidth | BMI088_GYRO_BANDWIDTH_MUST_Set;
+    gyroOdr = g->hz;
+    const int accelRates = sizeof(kAccelRates) / sizeof(kAccelRates[0]);
+    const AccelRate* a = &kAccelRates[accelRates - 1];
+    for (int i = accelRates - 1; i >= 0; i--) {
+        if (kAccelRates[i].hz >= odrHz) a = &kAccelRates[i];
     }
+    accelConf = BMI088_ACC_NORMAL | a->odr | BMI088_ACC_CONF_MUST_Set;
+    accelOdr = a->hz;
+
+    // configure CS pins; the bus owns pigpio and the SPI handle
+    bus.claimCs(csGyro);
+    bus.claimCs(csAccel);
 
     // accel self test
     uint8_t accel_error_code = accelSelfTest();
     if(accel_error_code != BMI088_NO_ERROR) {
-        spiClose(spiHandle);
-        gpioTerminate();
         if(accel_error_code == BMI088_NO_SENSOR) {
             throw std::runtime_error("BMI088 accel not detected");
         } else if(accel_error_code == BMI088_ACC_SELF_TEST_ERROR) {
@@ -55,8 +100,6 @@ BMI088::BMI088() {
     // gyro self test
     uint8_t gyro_error_code = gyroSelfTest();
     if(gyro_error_code != BMI088_NO_ERROR) {
-        spiClose(spiHandle);
-        gpioTerminate();
         if(gyro_error_code == BMI088_NO_SENSOR) {
             throw std::runtime_error("BMI088 gyro not detected");
         } else if(gyro_error_code == BMI088_SELF_TEST_GYRO_ERROR) {
@@ -67,8 +110,6 @@ BMI088::BMI088() {
     // accel init
     accel_error_code = accelInit();
     if(accel_error_code != BMI088_NO_ERROR) {
-        spiClose(spiHandle);
-        gpioTerminate();
         if(accel_error_code == BMI088_NO_SENSOR) {
             throw std::runtime_error("BMI088 accel not detected");
         } else if(accel_error_code == BMI088_ACC_SELF_TEST_ERROR) {
@@ -94,8 +135,6 @@ BMI088::BMI088() {
     // gyro init
     gyro_error_code = gyroInit();
     if(gyro_error_code != BMI088_NO_ERROR) {
-        spiClose(spiHandle);
-        gpioTerminate();
         if(gyro_error_code == BMI088_NO_SENSOR) {
             throw std::runtime_error("BMI088 gyro not detected");
         } else if(gyro_error_code == BMI088_SELF_TEST_GYRO_ERROR) {
@@ -119,14 +158,10 @@ BMI088::BMI088() {
     std::cout << "BMI088 gyro init done" << std::endl;
 }
 
-BMI088::~BMI088() {
-    spiClose(spiHandle);
-    gpioTerminate();
-}
-
 uint8_t BMI088::readAccel(void) {
+    TRACE_ZONE("bmi088 accel");
     uint8_t buf[6] = {0};
-    readAccelMultiRegister(BMI088_ACCEL_XOUT_L, buf, 6);
+    if (readAccelMultiRegister(BMI088_ACCEL_XOUT_L, buf, 6) != BMI088_NO_ERROR) return BMI088_SPI_ERROR;
     raw_data.accel_x = (int16_t)((buf[1] << 8) | buf[0]);
     raw_data.accel_y = (int16_t)((buf[3] << 8) | buf[2]);
     raw_data.accel_z = (int16_t)((buf[5] << 8) | buf[4]);
@@ -139,8 +174,9 @@ uint8_t BMI088::readAccel(void) {
 }
 
 uint8_t BMI088::readGyro(void) {
+    TRACE_ZONE("bmi088 gyro");
     uint8_t buf[6] = {0};
-    readGyroMultiRegister(BMI088_GYRO_X_L, buf, 6);
+    if (readGyroMultiRegister(BMI088_GYRO_X_L, buf, 6) != BMI088_NO_ERROR) return BMI088_SPI_ERROR;
     raw_data.gyro_x = (int16_t)((buf[1] << 8) | buf[0]);
     raw_data.gyro_y = (int16_t)((buf[3] << 8) | buf[2]);
     raw_data.gyro_z = (int16_t)((buf[5] << 8) | buf[4]);
@@ -153,6 +189,7 @@ uint8_t BMI088::readGyro(void) {
 }
 
 uint8_t BMI088::readTempture(void) {
+    TRACE_ZONE("bmi088 temp");
     uint8_t buf[2] = {0};
     readAccelMultiRegister(BMI088_TEMP_M, buf, 2);
     raw_data.temperature = (int16_t)((buf[1] << 3) | (buf[0] >> 5));
@@ -185,13 +222,15 @@ uint8_t BMI088::accelInit(void) {
     }
     
     for(write_reg_num = 0; write_reg_num < BMI088_WRITE_ACCEL_REG_NUM; write_reg_num++) {
-        writeAccelRegister(write_BMI088_accel_reg_data_error[write_reg_num][0], write_BMI088_accel_reg_data_error[write_reg_num][1]);
+        uint8_t reg = write_BMI088_accel_reg_data_error[write_reg_num][0];
+        uint8_t value = reg == BMI088_ACC_CONF ? accelConf : write_BMI088_accel_reg_data_error[write_reg_num][1];
+        writeAccelRegister(reg, value);
         bmi088SleepUs(BMI088_WAIT_TIME);
 
-        res = readAccelRegister(write_BMI088_accel_reg_data_error[write_reg_num][0]);
+        res = readAccelRegister(reg);
         bmi088SleepUs(BMI088_WAIT_TIME);
 
-        if(res != write_BMI088_accel_reg_data_error[write_reg_num][1]) {
+        if(res != value) {
             return write_BMI088_accel_reg_data_error[write_reg_num][2];
         }
     }
@@ -219,13 +258,15 @@ uint8_t BMI088::gyroInit(void) {
     }
 
     for(write_reg_num = 0; write_reg_num < BMI088_WRITE_GYRO_REG_NUM; write_reg_num++) {
-        writeGyroRegister(write_BMI088_gyro_reg_data_error[write_reg_num][0], write_BMI088_gyro_reg_data_error[write_reg_num][1]);
+        uint8_t reg = write_BMI088_gyro_reg_data_error[write_reg_num][0];
+        uint8_t value = reg == BMI088_GYRO_BANDWIDTH ? gyroBandwidth : write_BMI088_gyro_reg_data_error[write_reg_num][1];
+        writeGyroRegister(reg, value);
         bmi088SleepUs(BMI088_WAIT_TIME); 
 
-        res = readGyroRegister(write_BMI088_gyro_reg_data_error[write_reg_num][0]);
+        res = readGyroRegister(reg);
         bmi088SleepUs(BMI088_WAIT_TIME);   
 
-        if(res != write_BMI088_gyro_reg_data_error[write_reg_num][1]) {
+        if(res != value) {
             return write_BMI088_gyro_reg_data_error[write_reg_num][2];
         }
     }
@@ -358,12 +399,10 @@ uint8_t BMI088::gyroSelfTest(void) {
 }
 
 uint8_t BMI088::readRegister(int csPin, uint8_t reg) {
-    uint8_t tx[2] = {(reg | 0x80), 0x00};
+    uint8_t tx[2] = {static_cast<uint8_t>(reg | 0x80), 0x00};
     uint8_t rx[2] = {0};
 
-    gpioWrite(csPin, 0);
-    spiXfer(spiHandle, tx, rx, 2);
-    gpioWrite(csPin, 1);
+    bus.transfer(csPin, tx, rx, 2);
 
     return rx[1];
 }
@@ -372,9 +411,7 @@ uint8_t BMI088::writeRegister(int csPin, uint8_t reg, uint8_t cmd) {
     uint8_t tx[2] = {reg, cmd};
     uint8_t rx[2] = {0};
 
-    gpioWrite(csPin, 0);
-    spiXfer(spiHandle, tx, rx, 2);
-    gpioWrite(csPin, 1);
+    bus.transfer(csPin, tx, rx, 2);
 
     return 0x00;
 }
@@ -388,15 +425,16 @@ uint8_t BMI088::readMultiRegister(int csPin, uint8_t reg, uint8_t *bufp, uint8_t
         tx[i] = 0x00;
     }
 
-    gpioWrite(csPin, 0); 
-    spiXfer(spiHandle, tx, rx, len + 1);
-    gpioWrite(csPin, 1);
+    // on failure bufp is left as it was, so the caller keeps its last reading
+    if (!bus.transfer(csPin, tx, rx, len + 1)) {
+        return BMI088_SPI_ERROR;
+    }
 
     for (int i = 0; i < len; i++) {
         bufp[i] = rx[i + 1];
     }
 
-    return 0x00;
+    return BMI088_NO_ERROR;
 }
 
 uint8_t BMI088::readAccelRegister(uint8_t reg) {
@@ -424,9 +462,9 @@ uint8_t BMI088::readGyroMultiRegister(uint8_t reg, uint8_t *bufp, uint8_t len) {
 }
 
 void BMI088::bmi088SleepMs(unsigned int ms) {
-    usleep(ms * 1000);
+    bus.sleepUs(ms * 1000);
 }
 
 void BMI088::bmi088SleepUs(unsigned int us) {
-    usleep(us);
+    bus.sleepUs(us);
 }
@@ -0,0 +1,38 @@
+#include "bmi088_bus.h"
+#include "pigpio_ref.h"
+#include "trace_zone.hpp"
+
+#include <stdexcept>
+#include <unistd.h>
+
+PigpioBmi088Bus::PigpioBmi088Bus(unsigned channel, unsigned baud, unsigned flags) {
+    if (!pigpioAcquire()) throw std::runtime_error("pigpio initialization failed");
+
+    spiHandle = spiOpen(channel, baud, flags);
+    if (spiHandle < 0) {
+        pigpioRelease();
+        throw std::runtime_error("spiOpen failed");
+    }
+}
+
+PigpioBmi088Bus::~PigpioBmi088Bus() {
+    spiClose(spiHandle);
+    pigpioRelease();
+}
+
+void PigpioBmi088Bus::claimCs(int pin) {
+    gpioSetMode(pin, PI_OUTPUT);
+    gpioWrite(pin, 1);
+}
+
+bool PigpioBmi088Bus::transfer(int cs, const uint8_t* tx, uint8_t* rx, unsigned len) {
+    TRACE_ZONE("bmi088 spi");
+    gpioWrite(cs, 0);
+    int n = spiXfer(spiHandle, reinterpret_cast<char*>(const_cast<uint8_t*>(tx)), reinterpret_cast<char*>(rx), len);
+    gpioWrite(cs, 1);
+    return n == static_cast<int>(len);
+}
+
+void PigpioBmi088Bus::sleepUs(unsigned us) {
+    usleep(us);
+}
@@ -0,0 +1,131 @@
+#include "bmi088_sampler.h"
+#include "bmi088def.h"
+#include "rt_clock.hpp"
+#include "trace_zone.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// v at t -> estimate at target, using the slope from the previous reading
+void extrapolate(float (&v)[3], const float (&prev)[3], int64_t t, int64_t tPrev, int64_t target) {
+    if (t <= tPrev) return;
+    float k = static_cast<float>(target - t) / static_cast<float>(t - tPrev);
+    for (int a = 0; a < 3; a++) v[a] += (v[a] - prev[a]) * k;
+}
+
+float median(float* v, int n) {
+    std::sort(v, v + n);
+    return (n & 1) ? v[n / 2] : 0.5f * (v[n / 2 - 1] + v[n / 2]);
+}
+
+} // namespace
+
+Bmi088Sampler::Bmi088Sampler(const std::vector<BMI088*>& devices, bool align)
+    : count(0), align(align), seq(0), prev() {
+    for (BMI088* d : devices) {
+        if (count < kMaxImus) dev[count++] = d;
+    }
+    for (int i = 0; i < kMaxImus; i++) {
+        havePrev[i] = false;
+        changedNs[i] = -1;
+        staleNs[i] = 0;
+    }
+    for (int i = 0; i < count; i++) {
+        unsigned hz = std::max(1u, std::min(dev[i]->gyroOdrHz(), dev[i]->accelOdrHz()));
+        staleNs[i] = kStalePeriods * (1000000000LL / hz);
+    }
+    std::memset(lastWords, 0, sizeof(lastWords));
+}
+
+void Bmi088Sampler::sample(MultiImuSample& out, int64_t deadlineNs) {
+    TRACE_ZONE("imu burst");
+    ImuReading raw[kMaxImus];
+    int start = count ? static_cast<int>(seq % count) : 0;
+    if (count) dev[0]->getBus().beginBurst(deadlineNs);
+
+    int64_t burstBegin = monotonicNs();
+    int64_t t0 = burstBegin;
+    for (int k = 0; k < count; k++) {
+        int i = (start + k) % count;
+        raw[i].status = dev[i]->readGyro();
+        int64_t t1 = monotonicNs();
+        raw[i].gyroNs = t0 + (t1 - t0) / 2;
+        t0 = t1;
+    }
+    for (int k = 0; k < count; k++) {
+        int i = (start + k) % count;
+        uint8_t err = dev[i]->readAccel();
+        if (raw[i].status == BMI088_NO_ERROR) raw[i].status = err;
+        int64_t t1 = monotonicNs();
+        raw[i].accelNs = t0 + (t1 - t0) / 2;
+        t0 = t1;
+    }
+    if (count) dev[0]->getBus().endBurst();
+
+    int64_t first = INT64_MAX, last = INT64_MIN, sum = 0;
+    int valid = 0;
+    for (int i = 0; i < count; i++) {
+        const bmi088_real_data_t& d = dev[i]->getRealData();
+        raw[i].gyro[0] = static_cast<float>(d.gyro_x);
+        raw[i].gyro[1] = static_cast<float>(d.gyro_y);
+        raw[i].gyro[2] = static_cast<float>(d.gyro_z);
+        raw[i].accel[0] = static_cast<float>(d.accel_x);
+        raw[i].accel[1] = static_cast<float>(d.accel_y);
+        raw[i].accel[2] = static_cast<float>(d.accel_z);
+        if (raw[i].status == BMI088_NO_ERROR) {
+            const bmi088_raw_data_t& r = dev[i]->getRawData();
+            int16_t words[6] = {r.gyro_x, r.gyro_y, r.gyro_z, r.accel_x, r.accel_y, r.accel_z};
+            if (changedNs[i] < 0 || std::memcmp(words, lastWords[i], sizeof(words))) {
+                std::memcpy(lastWords[i], words, sizeof(words));
+                changedNs[i] = raw[i].gyroNs;
+            } else if (raw[i].gyroNs - changedNs[i] > staleNs[i]) {
+                raw[i].status = BMI088_STALE_DATA;
+            }
+        }
+        if (raw[i].status != BMI088_NO_ERROR) continue;
+        first = std::min(first, raw[i].gyroNs);
+        last = std::max(last, raw[i].gyroNs);
+        sum += raw[i].gyroNs - burstBegin;
+        valid++;
+    }
+
+    out.tNs = valid ? burstBegin + sum / valid : burstBegin;
+    out.skewNs = valid ? last - first : 0;
+    out.burstNs = t0 - burstBegin;
+    out.seq = seq++;
+    out.count = count;
+    out.validCount = valid;
+    for (int i = 0; i < count; i++) {
+        out.imu[i] = raw[i];
+        if (raw[i].status != BMI088_NO_ERROR) {
+            havePrev[i] = false;
+            continue;
+        }
+        if (align && havePrev[i]) {
+            extrapolate(out.imu[i].gyro, prev[i].gyro, raw[i].gyroNs, prev[i].gyroNs, out.tNs);
+            extrapolate(out.imu[i].accel, prev[i].accel, raw[i].accelNs, prev[i].accelNs, out.tNs);
+        }
+        prev[i] = raw[i];
+        havePrev[i] = true;
+    }
+
+    for (int a = 0; a < 3; a++) {
+        float g[kMaxImus], acc[kMaxImus];
+        float gs = 0.0f, as = 0.0f;
+        int n = 0;
+        for (int i = 0; i < count; i++) {
+            if (out.imu[i].status != BMI088_NO_ERROR) continue;
+            g[n] = out.imu[i].gyro[a];
+            acc[n] = out.imu[i].accel[a];
+            gs += g[n];
+            as += acc[n];
+            n++;
+        }
+        out.gyroMean[a] = n ? gs / n : 0.0f;
+        out.accelMean[a] = n ? as / n : 0.0f;
+        out.gyroMedian[a] = n ? median(g, n) : 0.0f;
+        out.accelMedian[a] = n ? median(acc, n) : 0.0f;
+    }
+}
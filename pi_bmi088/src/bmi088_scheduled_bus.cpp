@@ -0,0 +1,34 @@
+#include "bmi088_bus.h"
+
+#include <unistd.h>
+
+ScheduledBmi088Bus::ScheduledBmi088Bus(spibus::SpiBus& bus, int client, bool realDelays)
+    : bus(bus), client(client), realDelays(realDelays), inBurst(false) {}
+
+void ScheduledBmi088Bus::mapCs(int pin, int device) {
+    csDevices.push_back(std::make_pair(pin, device));
+}
+
+bool ScheduledBmi088Bus::transfer(int cs, const uint8_t* tx, uint8_t* rx, unsigned len) {
+    int device = -1;
+    for (auto& m : csDevices) {
+        if (m.first == cs) device = m.second;
+    }
+    if (device < 0) return false;
+    spibus::Transfer t = {device, tx, rx, len};
+    return inBurst ? bus.transfer(client, &t, 1) : bus.submit(client, &t, 1);
+}
+
+void ScheduledBmi088Bus::sleepUs(unsigned us) {
+    if (realDelays) usleep(us);
+}
+
+void ScheduledBmi088Bus::beginBurst(int64_t deadlineNs) {
+    bus.acquire(client, deadlineNs);
+    inBurst = true;
+}
+
+void ScheduledBmi088Bus::endBurst() {
+    inBurst = false;
+    bus.release(client);
+}
@@ -0,0 +1,117 @@
+#include "bmi088_sim.h"
+#include "bmi088def.h"
+#include "rt_clock.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// self-test excitation in raw accel counts; the driver needs +/- differences
+// of at least 1365 (x, y) and 680 (z)
+const int16_t kSelfTestX = 1000, kSelfTestY = 1000, kSelfTestZ = 500;
+
+void putRaw(uint8_t* r, double value, double sen) {
+    double q = std::round(value / sen);
+    int16_t v = static_cast<int16_t>(std::max(-32768.0, std::min(32767.0, q)));
+    r[0] = static_cast<uint8_t>(v & 0xFF);
+    r[1] = static_cast<uint8_t>((v >> 8) & 0xFF);
+}
+
+} // namespace
+
+SimBmi088Bus::SimBmi088Bus(unsigned baud, int csOverheadNs)
+    : baud(baud), csOverheadNs(csOverheadNs), originNs(monotonicNs()), transferCount(0) {}
+
+void SimBmi088Bus::addDevice(int csGyro, int csAccel, const float (&gyroBias)[3]) {
+    Device d;
+    for (int a = 0; a < 3; a++) d.gyroBias[a] = gyroBias[a];
+    devices.push_back(d);
+
+    Chip g, a;
+    g.cs = csGyro;
+    g.accel = false;
+    g.device = static_cast<int>(devices.size()) - 1;
+    reset(g);
+    a.cs = csAccel;
+    a.accel = true;
+    a.device = g.device;
+    reset(a);
+    chips.push_back(g);
+    chips.push_back(a);
+}
+
+void SimBmi088Bus::truth(double t, float (&gyro)[3], float (&accel)[3]) {
+    const double w = 2.0 * M_PI;
+    gyro[0] = static_cast<float>(5.0 * std::sin(w * 20.0 * t));
+    gyro[1] = static_cast<float>(3.0 * std::sin(w * 13.0 * t + 1.0));
+    gyro[2] = static_cast<float>(2.0 * std::cos(w * 7.0 * t));
+    accel[0] = static_cast<float>(20.0 * std::sin(w * 15.0 * t));
+    accel[1] = static_cast<float>(10.0 * std::cos(w * 9.0 * t));
+    accel[2] = static_cast<float>(9.81 + 5.0 * std::sin(w * 11.0 * t + 0.5));
+}
+
+void SimBmi088Bus::reset(Chip& c) {
+    std::memset(c.reg, 0, sizeof(c.reg));
+    c.reg[c.accel ? BMI088_ACC_CHIP_ID : BMI088_GYRO_CHIP_ID] =
+        c.accel ? BMI088_ACC_CHIP_ID_VALUE : BMI088_GYRO_CHIP_ID_VALUE;
+}
+
+void SimBmi088Bus::latch(Chip& c, int64_t ns) {
+    float gyro[3], accel[3];
+    truth(secondsAt(ns), gyro, accel);
+    if (c.accel) {
+        uint8_t* r = c.reg + BMI088_ACCEL_XOUT_L;
+        uint8_t st = c.reg[BMI088_ACC_SELF_TEST];
+        int sign = st == BMI088_ACC_SELF_TEST_POSITIVE_SIGNAL ? 1 : st == BMI088_ACC_SELF_TEST_NEGATIVE_SIGNAL ? -1 : 0;
+        putRaw(r, accel[0] + sign * kSelfTestX * BMI088_ACCEL_12G_SEN, BMI088_ACCEL_12G_SEN);
+        putRaw(r + 2, accel[1] + sign * kSelfTestY * BMI088_ACCEL_12G_SEN, BMI088_ACCEL_12G_SEN);
+        putRaw(r + 4, accel[2] + sign * kSelfTestZ * BMI088_ACCEL_12G_SEN, BMI088_ACCEL_12G_SEN);
+        // 25 degC, 11-bit two's complement split over TEMP_M / TEMP_L
+        int16_t temp = static_cast<int16_t>((25.0f - BMI088_TEMP_OFFSET) / BMI088_TEMP_FACTOR);
+        c.reg[BMI088_TEMP_M] = static_cast<uint8_t>(temp >> 3);
+        c.reg[BMI088_TEMP_M + 1] = static_cast<uint8_t>((temp & 0x7) << 5);
+    } else {
+        const Device& d = devices[c.device];
+        uint8_t* r = c.reg + BMI088_GYRO_X_L;
+        for (int a = 0; a < 3; a++) putRaw(r + 2 * a, gyro[a] + d.gyroBias[a], BMI088_GYRO_2000_SEN);
+    }
+}
+
+bool SimBmi088Bus::transfer(int cs, const uint8_t* tx, uint8_t* rx, unsigned len) {
+    int64_t begin = monotonicNs();
+    int64_t end = begin + csOverheadNs + static_cast<int64_t>(8ULL * len * 1000000000ULL / baud);
+    bool ok = respond(cs, tx, rx, len, begin + (end - begin) / 2);
+    while (monotonicNs() < end) {
+    }
+    return ok;
+}
+
+bool SimBmi088Bus::respond(int cs, const uint8_t* tx, uint8_t* rx, unsigned len, int64_t latchNs) {
+    transferCount++;
+    Chip* c = nullptr;
+    for (auto& chip : chips) {
+        if (chip.cs == cs) c = &chip;
+    }
+    std::memset(rx, 0xFF, len);  // nobody drives MISO
+    if (c && len > 0) {
+        uint8_t reg = tx[0] & 0x7F;
+        if (tx[0] & 0x80) {
+            latch(*c, latchNs);
+            if (!c->accel && reg == BMI088_GYRO_SELF_TEST) c->reg[reg] |= BMI088_GYRO_BIST_RDY;
+            rx[0] = 0;
+            for (unsigned i = 1; i < len; i++) rx[i] = c->reg[(reg + i - 1) & 0x7F];  // address auto-increment
+        } else if (len > 1) {
+            rx[0] = rx[1] = 0;
+            bool softReset = c->accel ? (reg == BMI088_ACC_SOFTRESET && tx[1] == BMI088_ACC_SOFTRESET_VALUE)
+                                      : (reg == BMI088_GYRO_SOFTRESET && tx[1] == BMI088_GYRO_SOFTRESET_VALUE);
+            if (softReset) {
+                reset(*c);
+            } else {
+                c->reg[reg] = tx[1];
+            }
+        }
+    }
+    return c != nullptr;
+}
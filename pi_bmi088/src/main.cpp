@@ -1,21 +1,98 @@
 #include "bmi088.h"
+#include "flight_recorder.hpp"
+#include "rt_memory.hpp"
+#include "shm_topic.hpp"
+#include "trace_zone.hpp"
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
 #include <unistd.h>
 
-int main() {
-    // try {
-    //     BMI088 imu;
-    // } catch (const std::exception& e) {
-    //     std::cerr << "[ERROR] " << e.what() << std::endl;
-    //     return 1;
-    // }
-    BMI088 imu;
+static std::atomic<bool> stopRequested(false);
 
-    while(1) {
+static void onSignal(int) {
+    stopRequested = true;
+}
+
+// Usage: bmi088_reader [log.mwfl [period_us]]
+//   With a log path the raw samples are written to a flight recorder file
+//   (decode with dart003's flight_decode); pass "-" to skip logging.
+//   The default period is 10000 us.
+//   Ctrl-C stops the loop; trace builds (-DMILKYWAY_TRACE=ON) then write
+//   bmi088_trace.json.
+// Every sample is also published to the shared memory topics
+// ipc::kImuTopic (latest value) and ipc::kImuStreamTopic (every sample).
+int main(int argc, char** argv) {
+    // SPI0 at 10 MHz, mode 0; the unit answers on CS 7 (gyro) / 8 (accel)
+    PigpioBmi088Bus bus;
+    BMI088 imu(bus);
+
+    // Lock everything set up so far (and later) into RAM; the loop below
+    // then never page-faults. The recorder mapping is the exception: only
+    // the window around its write position stays resident.
+    std::string memErr;
+    if (!rtmem::lockMemory(memErr)) std::cerr << "[WARN] " << memErr << std::endl;
+
+    flight::FlightRecorder recorder;
+    flight::FlightProducer* log = nullptr;
+    if (argc > 1 && std::string(argv[1]) != "-") {
+        std::string err;
+        recorder.lockWindow(4 << 20);
+        if (!recorder.open(argv[1], 64 << 20, err)) {
+            std::cerr << "[ERROR] " << err << std::endl;
+            return 1;
+        }
+        log = recorder.producer("bmi088");
+        recorder.start();
+    }
+    // Other processes (dart003 with [ipc] imu_topic) read the IMU from here,
+    // so the SPI bus has a single owner.
+    ipc::LatestWriter<ipc::ImuSample> latest;
+    ipc::StreamWriter<ipc::ImuSample, ipc::kImuStreamSize> stream;
+    std::string topicErr;
+    if (!latest.open(ipc::kImuTopic, topicErr) || !stream.open(ipc::kImuStreamTopic, topicErr)) {
+        std::cerr << "[WARN] " << topicErr << ", not publishing" << std::endl;
+    }
+    ipc::ImuSample sample = ipc::ImuSample();
+
+    useconds_t period = argc > 2 ? static_cast<useconds_t>(std::atoi(argv[2])) : 10000;
+
+    // pigpio installs its own handlers in gpioInitialise(), so ours go in after it
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    while(!stopRequested) {
         imu.readAccel();
         imu.readGyro();
         imu.readTempture();
 
+        // The recorder file stays valid if the process is killed; only the
+        // header counters are left at their last periodic update.
+        if (log) {
+            const bmi088_raw_data_t& raw = imu.getRawData();
+            flight::ImuRecord s = {{raw.gyro_x, raw.gyro_y, raw.gyro_z},
+                                   {raw.accel_x, raw.accel_y, raw.accel_z},
+                                   raw.temperature};
+            log->imu(monotonicNs(), 0, s);
+        }
+
+        if (latest.isOpen() && stream.isOpen()) {
+            const bmi088_real_data_t& real = imu.getRealData();
+            sample.tNs = monotonicNs();
+            sample.gyro[0] = static_cast<float>(real.gyro_x);
+            sample.gyro[1] = static_cast<float>(real.gyro_y);
+            sample.gyro[2] = static_cast<float>(real.gyro_z);
+            sample.accel[0] = static_cast<float>(real.accel_x);
+            sample.accel[1] = static_cast<float>(real.accel_y);
+            sample.accel[2] = static_cast<float>(real.accel_z);
+            sample.tempC = real.temperature;
+            latest.publish(sample);
+            stream.push(sample);
+            sample.seq++;
+        }
+
         // // 打印数据log
         // const auto& raw_data = imu.getRawData();
         // const auto& real_data = imu.getRealData();
@@ -23,8 +100,12 @@ int main() {
         // std::cout << "Accel: (" << raw_data.accel_x << ", " << raw_data.accel_y << ", " << raw_data.accel_z << ") "
         //           << "Gyro: (" << raw_data.gyro_x << ", " << raw_data.gyro_y << ", " << raw_data.gyro_z << ") "
         //           << "Temp: " << raw_data.temperature << std::endl;
-        usleep(10000); 
+        usleep(period); 
     }
 
+    if (recorder.isOpen()) recorder.close();
+    if (trace::kEnabled) {
+        std::printf("bmi088_trace.json: %ld events\n", trace::dumpChromeJson("bmi088_trace.json"));
+    }
     return 0;
 }